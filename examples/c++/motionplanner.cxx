@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <iostream>
+#include <signal.h>
+
+#include "motionplanner.hpp"
+#include "stepmotor.hpp"
+#include "upm_utilities.h"
+
+using namespace std;
+
+bool shouldRun = true;
+
+void
+sig_handler(int signo)
+{
+    if (signo == SIGINT)
+        shouldRun = false;
+}
+
+int
+main(int argc, char** argv)
+{
+    signal(SIGINT, sig_handler);
+
+    //! [Interesting]
+    // Two EasyDriver boards, dir/step on pins 2/3 and 4/5
+    upm::StepMotor x(2, 3);
+    upm::StepMotor y(4, 5);
+
+    upm::MotionPlanner planner;
+    planner.addAxis(x);
+    planner.addAxis(y);
+
+    planner.setMaxSpeed(800);
+    planner.setAcceleration(1600);
+    planner.setProfile(upm::MotionPlanner::PROFILE_SCURVE);
+
+    while (shouldRun) {
+        // queue a square, both motors arrive at each corner together
+        // on the diagonal moves
+        cout << "Drawing a square with a diagonal" << endl;
+        planner.moveTo({400, 0});
+        planner.moveTo({400, 400});
+        planner.moveTo({0, 0});
+        planner.moveTo({0, 400});
+        planner.moveTo({0, 0});
+
+        // the moves run in the background
+        while (shouldRun && !planner.wait(500))
+            cout << "  at " << planner.getPosition(0) << ", "
+                 << planner.getPosition(1) << endl;
+
+        upm_delay(1);
+    }
+
+    planner.stop();
+    //! [Interesting]
+
+    cout << "Exiting..." << endl;
+
+    return 0;
+}
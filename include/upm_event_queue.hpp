@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace upm {
+
+    /**
+     * Motion events detected by an accelerometer's embedded engines
+     */
+    typedef enum {
+        MOTION_EVENT_TAP = 0,       // single pulse
+        MOTION_EVENT_DOUBLE_TAP,    // double pulse
+        MOTION_EVENT_FREEFALL,      // all axes below a threshold
+        MOTION_EVENT_MOTION,        // an axis above a threshold
+        MOTION_EVENT_TRANSIENT,     // high-passed change over a threshold
+        MOTION_EVENT_SHAKE,
+        MOTION_EVENT_ORIENTATION    // landscape/portrait or back/front
+    } MOTION_EVENT_T;
+
+    /**
+     * @brief A motion event, as reported by the device
+     */
+    struct MotionEvent {
+        /** What was detected */
+        MOTION_EVENT_T type;
+        /** Driver specific source register contents (axes,
+         * direction, orientation), see the driver */
+        uint8_t source;
+        /** Time the interrupt was handled, in microseconds of the
+         * host's monotonic clock */
+        uint64_t timestamp;
+
+        /**
+         * Current time for timestamp.
+         *
+         * @return Microseconds of the monotonic clock
+         */
+        static uint64_t now()
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>
+                (std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    };
+
+    /**
+     * @brief Bounded queue of events from interrupt handlers
+     *
+     * Drivers that let a device detect events itself (taps, freefall,
+     * orientation changes, ...) push them from their interrupt
+     * handler, and the application waits for them with pop() instead
+     * of polling samples.  When the queue is full the oldest event is
+     * dropped and counted.
+     *
+     * Alternatively a callback can be set; events are then passed to
+     * it, on the interrupt thread, instead of being queued.
+     */
+    template <typename Event>
+    class EventQueue {
+    public:
+        typedef std::function<void(const Event &)> Callback;
+
+        /**
+         * Constructor
+         *
+         * @param capacity Number of events kept at most, at least 1
+         * @throws std::invalid_argument if capacity is 0
+         */
+        explicit EventQueue(size_t capacity = 64) :
+            m_capacity(capacity), m_dropped(0)
+        {
+            if (!capacity)
+                throw std::invalid_argument(std::string(__FUNCTION__) +
+                                            ": capacity must not be 0");
+        }
+
+        /**
+         * Set a callback receiving every event instead of the queue,
+         * or clear it with an empty function.
+         *
+         * @param cb Callback
+         */
+        void setCallback(Callback cb)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_callback = cb;
+        }
+
+        /**
+         * Add an event, or pass it to the callback.
+         *
+         * @param e Event
+         */
+        void push(const Event &e)
+        {
+            Callback cb;
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                cb = m_callback;
+                if (!cb)
+                {
+                    if (m_events.size() >= m_capacity)
+                    {
+                        m_events.pop_front();
+                        m_dropped++;
+                    }
+                    m_events.push_back(e);
+                }
+            }
+
+            if (cb)
+                cb(e);
+            else
+                m_cond.notify_all();
+        }
+
+        /**
+         * Take the oldest event.
+         *
+         * @param e Event
+         * @param timeoutMs Time to wait for an event in milliseconds,
+         * 0 to return at once, negative to wait forever
+         * @return True if an event was taken
+         */
+        bool pop(Event &e, int timeoutMs = 0)
+        {
+            std::unique_lock<std::mutex> guard(m_lock);
+            auto ready = [this]() { return !m_events.empty(); };
+
+            if (timeoutMs < 0)
+                m_cond.wait(guard, ready);
+            else if (timeoutMs > 0)
+                m_cond.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                                ready);
+
+            if (m_events.empty())
+                return false;
+
+            e = m_events.front();
+            m_events.pop_front();
+            return true;
+        }
+
+        /**
+         * Number of queued events.
+         *
+         * @return Count
+         */
+        size_t size()
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            return m_events.size();
+        }
+
+        /**
+         * Number of events dropped because the queue was full.
+         *
+         * @return Count
+         */
+        unsigned int dropped()
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            return m_dropped;
+        }
+
+        /**
+         * Discard all queued events.
+         */
+        void clear()
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_events.clear();
+        }
+
+    private:
+        std::mutex m_lock;
+        std::condition_variable m_cond;
+        std::deque<Event> m_events;
+        size_t m_capacity;
+        unsigned int m_dropped;
+        Callback m_callback;
+    };
+}
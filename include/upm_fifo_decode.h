@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef UPM_FIFO_DECODE_H_
+#define UPM_FIFO_DECODE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file upm_fifo_decode.h
+ * @brief Decoders for FIFO bursts of XYZ samples
+ *
+ * ST accelerometers (LIS2DS12, LIS3DH, LSM303AGR, ...) store each FIFO
+ * sample as a 6 byte frame: X, Y and Z as little endian 16 bit words,
+ * with the 8 to 14 bit result left justified.  A drain reads many
+ * frames in one burst, and decoding them is a loop over the axes that
+ * shifts out the unused low bits and applies the scale.
+ *
+ * UPM_FIFO_DECODER_XYZ16() generates one such loop per resolution, so
+ * the shift is a constant and the loop has no branches.  A driver
+ * instantiates the resolutions its part supports and picks one when
+ * the power mode changes:
+ *
+ *   UPM_FIFO_DECODER_XYZ16(_decode_8b, 8)
+ *   UPM_FIFO_DECODER_XYZ16(_decode_12b, 12)
+ *   ...
+ *   dev->fifoDecode = hires ? _decode_12b : _decode_8b;
+ */
+
+/**
+ * Decoder function: converts frames of 3 left justified 16 bit little
+ * endian words from buf into 3 floats each, scaled by scale per LSB
+ * of the actual resolution, in out.
+ */
+typedef void (*upm_fifo_decoder_t)(const uint8_t *buf, int frames,
+                                   float scale, float *out);
+
+/**
+ * Define a static decoder function called name for samples of the
+ * given resolution in bits (1 to 16).
+ */
+#define UPM_FIFO_DECODER_XYZ16(name, bits)                              \
+    static void name(const uint8_t *buf, int frames, float scale,     \
+                     float *out)                                        \
+    {                                                                   \
+        int i;                                                          \
+        for (i = 0; i < frames * 3; i++)                                \
+            out[i] = (float)((int16_t)(buf[2 * i]                       \
+                                       | (buf[2 * i + 1] << 8))         \
+                             >> (16 - (bits))) * scale;                 \
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPM_FIFO_DECODE_H_ */
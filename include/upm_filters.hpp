@@ -0,0 +1,611 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <interfaces/iAcceleration.hpp>
+#include <interfaces/iGyroscope.hpp>
+#include <interfaces/iMagnetometer.hpp>
+
+/*
+ * Streaming filters for multi-channel sensor data.
+ *
+ * Each filter is templated on the sample type T and the number of
+ * channels C (3 for x/y/z), keeps its state in fixed size members, and
+ * never allocates.  They share one interface:
+ *
+ *   void filter(const T *in, T *out);  // one sample of C channels,
+ *                                      // in and out may be the same
+ *   void reset();                      // forget the history
+ *
+ * Window filters take the largest window N as a template parameter
+ * and the window in use as a run time setting, at most N:
+ *
+ *   MovingMedian<T, C, N>   running median, O(log n) per sample
+ *   MovingAverage<T, C, N>  moving average, O(1) per sample
+ *
+ * The others are recursive:
+ *
+ *   Biquad<T, C>            second order IIR section (low/high pass)
+ *   OneEuro<T, C>           speed adaptive low pass (one euro filter)
+ *   AlphaBeta<T, C>         alpha-beta tracker (position and rate)
+ *
+ * Any acceleration, gyroscope or magnetometer driver can be filtered
+ * by wrapping it, e.g.:
+ *
+ *   upm::FilteredAcceleration<upm::MovingMedian<float, 3, 9>> f(sensor);
+ *   std::vector<float> a = f.getAcceleration();
+ */
+namespace upm {
+
+  namespace detail {
+    /*
+     * Running median of the last n of up to N values.  The window is
+     * split into a max-heap holding the lower half and a min-heap
+     * holding the upper half, both storing slots of the ring buffer;
+     * each slot knows its heap position, so the oldest value can be
+     * replaced in place with O(log n) sifting.
+     */
+    template <typename T, size_t N>
+    class RunningMedian {
+    public:
+      RunningMedian() { reset(); }
+
+      void reset()
+      {
+        m_count = 0;
+        m_next = 0;
+        m_nlo = 0;
+        m_nhi = 0;
+      }
+
+      /* add a value, drop the oldest if the window of n is full, and
+       * return the median; the lower one for an even count */
+      T push(T v, size_t n)
+      {
+        if (m_count < n)
+          {
+            size_t slot = m_count++;
+            m_val[slot] = v;
+            insert(slot);
+          }
+        else
+          {
+            size_t slot = m_next;
+            m_next = (m_next + 1 == n) ? 0 : m_next + 1;
+            replace(slot, v);
+          }
+
+        return m_val[m_lo[0]];
+      }
+
+    private:
+      T m_val[N];
+      /* heap entries, as slots */
+      size_t m_lo[N / 2 + 1];
+      size_t m_hi[N / 2 + 1];
+      /* position of each slot in its heap */
+      size_t m_pos[N];
+      bool m_inLo[N];
+      size_t m_count, m_next, m_nlo, m_nhi;
+
+      /* heap order: parent before child */
+      bool before(bool lo, size_t a, size_t b) const
+      {
+        return lo ? m_val[a] > m_val[b] : m_val[a] < m_val[b];
+      }
+
+      void place(bool lo, size_t i, size_t slot)
+      {
+        (lo ? m_lo : m_hi)[i] = slot;
+        m_pos[slot] = i;
+        m_inLo[slot] = lo;
+      }
+
+      void siftUp(bool lo, size_t i)
+      {
+        size_t *h = lo ? m_lo : m_hi;
+        size_t slot = h[i];
+
+        while (i > 0 && before(lo, slot, h[(i - 1) / 2]))
+          {
+            place(lo, i, h[(i - 1) / 2]);
+            i = (i - 1) / 2;
+          }
+        place(lo, i, slot);
+      }
+
+      void siftDown(bool lo, size_t i)
+      {
+        size_t *h = lo ? m_lo : m_hi;
+        size_t n = lo ? m_nlo : m_nhi;
+        size_t slot = h[i];
+
+        for (;;)
+          {
+            size_t c = 2 * i + 1;
+            if (c >= n)
+              break;
+            if (c + 1 < n && before(lo, h[c + 1], h[c]))
+              c++;
+            if (!before(lo, h[c], slot))
+              break;
+            place(lo, i, h[c]);
+            i = c;
+          }
+        place(lo, i, slot);
+      }
+
+      void pushHeap(bool lo, size_t slot)
+      {
+        size_t i = lo ? m_nlo++ : m_nhi++;
+        place(lo, i, slot);
+        siftUp(lo, i);
+      }
+
+      size_t popHeap(bool lo)
+      {
+        size_t *h = lo ? m_lo : m_hi;
+        size_t top = h[0];
+        size_t last = h[lo ? --m_nlo : --m_nhi];
+
+        if (lo ? m_nlo : m_nhi)
+          {
+            place(lo, 0, last);
+            siftDown(lo, 0);
+          }
+        return top;
+      }
+
+      /* the lower half gets the extra value of an odd count */
+      void insert(size_t slot)
+      {
+        if (m_nlo == m_nhi)
+          {
+            if (m_nhi && m_val[slot] > m_val[m_hi[0]])
+              {
+                pushHeap(false, slot);
+                pushHeap(true, popHeap(false));
+              }
+            else
+              pushHeap(true, slot);
+          }
+        else
+          {
+            if (m_val[slot] < m_val[m_lo[0]])
+              {
+                pushHeap(true, slot);
+                pushHeap(false, popHeap(true));
+              }
+            else
+              pushHeap(false, slot);
+          }
+      }
+
+      void replace(size_t slot, T v)
+      {
+        bool lo = m_inLo[slot];
+        size_t i = m_pos[slot];
+
+        m_val[slot] = v;
+        siftUp(lo, i);
+        siftDown(lo, m_pos[slot]);
+
+        // restore max(lower) <= min(upper) by swapping the tops
+        if (m_nhi && m_val[m_lo[0]] > m_val[m_hi[0]])
+          {
+            size_t a = m_lo[0], b = m_hi[0];
+            place(true, 0, b);
+            place(false, 0, a);
+            siftDown(true, 0);
+            siftDown(false, 0);
+          }
+      }
+    };
+
+    inline void checkWindow(size_t window, size_t max)
+    {
+      if (window < 1 || window > max)
+        throw std::invalid_argument(std::string("filter")
+                                    + ": window must be 1 to "
+                                    + std::to_string(max));
+    }
+  }
+
+  /**
+   * Running median over the last window samples of each channel.
+   * Removes spikes while keeping edges.  For an even number of
+   * samples, the lower of the two middle values is returned.
+   */
+  template <typename T, size_t C, size_t N>
+  class MovingMedian {
+  public:
+    explicit MovingMedian(size_t window = N) { setWindow(window); }
+
+    /* change the window, at most N samples, and reset */
+    void setWindow(size_t window)
+    {
+      detail::checkWindow(window, N);
+      m_window = window;
+      reset();
+    }
+
+    size_t getWindow() const { return m_window; }
+
+    static size_t maxWindow() { return N; }
+
+    void reset()
+    {
+      for (size_t c = 0; c < C; c++)
+        m_ch[c].reset();
+    }
+
+    void filter(const T *in, T *out)
+    {
+      for (size_t c = 0; c < C; c++)
+        out[c] = m_ch[c].push(in[c], m_window);
+    }
+
+  private:
+    detail::RunningMedian<T, N> m_ch[C];
+    size_t m_window;
+  };
+
+  /**
+   * Mean of the last window samples of each channel.  Until the window
+   * has filled, the mean of the samples seen so far.
+   */
+  template <typename T, size_t C, size_t N>
+  class MovingAverage {
+  public:
+    explicit MovingAverage(size_t window = N) { setWindow(window); }
+
+    /* change the window, at most N samples, and reset */
+    void setWindow(size_t window)
+    {
+      detail::checkWindow(window, N);
+      m_window = window;
+      reset();
+    }
+
+    size_t getWindow() const { return m_window; }
+
+    static size_t maxWindow() { return N; }
+
+    void reset()
+    {
+      m_count = 0;
+      m_next = 0;
+      for (size_t c = 0; c < C; c++)
+        m_sum[c] = 0;
+    }
+
+    void filter(const T *in, T *out)
+    {
+      bool full = (m_count == m_window);
+      T *slot = m_hist[m_next];
+
+      if (!full)
+        m_count++;
+
+      for (size_t c = 0; c < C; c++)
+        {
+          if (full)
+            m_sum[c] -= slot[c];
+          slot[c] = in[c];
+          m_sum[c] += in[c];
+        }
+
+      if (++m_next == m_window)
+        {
+          m_next = 0;
+          // sum again once per window, so floating point rounding in
+          // the running sum does not accumulate
+          for (size_t c = 0; c < C; c++)
+            {
+              m_sum[c] = 0;
+              for (size_t i = 0; i < m_count; i++)
+                m_sum[c] += m_hist[i][c];
+            }
+        }
+
+      for (size_t c = 0; c < C; c++)
+        out[c] = m_sum[c] / (T)m_count;
+    }
+
+  private:
+    T m_hist[N][C];
+    T m_sum[C];
+    size_t m_window, m_count, m_next;
+  };
+
+  /**
+   * Second order IIR section, transposed direct form II:
+   *
+   *   y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2]
+   *
+   * Coefficients are normalized to a0 = 1.  lowPass() and highPass()
+   * design Butterworth-like sections from the usual audio cookbook
+   * formulas.
+   */
+  template <typename T, size_t C>
+  class Biquad {
+  public:
+    /* pass through until designed */
+    Biquad() { setCoefficients(1, 0, 0, 0, 0); }
+
+    Biquad(T b0, T b1, T b2, T a1, T a2)
+    {
+      setCoefficients(b0, b1, b2, a1, a2);
+    }
+
+    void setCoefficients(T b0, T b1, T b2, T a1, T a2)
+    {
+      m_b0 = b0; m_b1 = b1; m_b2 = b2; m_a1 = a1; m_a2 = a2;
+      reset();
+    }
+
+    /* low pass at cutoffHz for a sample rate of rateHz, q = 0.7071
+     * for a maximally flat response */
+    static Biquad lowPass(double rateHz, double cutoffHz, double q = M_SQRT1_2)
+    {
+      double w = 2 * M_PI * cutoffHz / rateHz;
+      double alpha = std::sin(w) / (2 * q);
+      double cw = std::cos(w);
+      double a0 = 1 + alpha;
+
+      return Biquad((1 - cw) / 2 / a0, (1 - cw) / a0, (1 - cw) / 2 / a0,
+                    -2 * cw / a0, (1 - alpha) / a0);
+    }
+
+    /* high pass at cutoffHz for a sample rate of rateHz */
+    static Biquad highPass(double rateHz, double cutoffHz, double q = M_SQRT1_2)
+    {
+      double w = 2 * M_PI * cutoffHz / rateHz;
+      double alpha = std::sin(w) / (2 * q);
+      double cw = std::cos(w);
+      double a0 = 1 + alpha;
+
+      return Biquad((1 + cw) / 2 / a0, -(1 + cw) / a0, (1 + cw) / 2 / a0,
+                    -2 * cw / a0, (1 - alpha) / a0);
+    }
+
+    void reset()
+    {
+      for (size_t c = 0; c < C; c++)
+        m_z1[c] = m_z2[c] = 0;
+    }
+
+    void filter(const T *in, T *out)
+    {
+      for (size_t c = 0; c < C; c++)
+        {
+          T x = in[c];
+          T y = m_b0 * x + m_z1[c];
+          m_z1[c] = m_b1 * x - m_a1 * y + m_z2[c];
+          m_z2[c] = m_b2 * x - m_a2 * y;
+          out[c] = y;
+        }
+    }
+
+  private:
+    T m_b0, m_b1, m_b2, m_a1, m_a2;
+    T m_z1[C], m_z2[C];
+  };
+
+  /**
+   * One euro filter (Casiez et al.): a first order low pass whose
+   * cutoff rises with the speed of the signal, smoothing jitter at
+   * rest while following fast motion with little lag.  minCutoff sets
+   * the smoothing at rest, beta how fast the cutoff rises with speed.
+   */
+  template <typename T, size_t C>
+  class OneEuro {
+  public:
+    OneEuro(T rateHz, T minCutoff = 1, T beta = 0, T dCutoff = 1) :
+      m_minCutoff(minCutoff), m_beta(beta), m_dCutoff(dCutoff)
+    {
+      setRate(rateHz);
+    }
+
+    void setRate(T rateHz)
+    {
+      if (!(rateHz > 0))
+        throw std::invalid_argument(std::string("OneEuro")
+                                    + ": rate must be positive");
+      m_rate = rateHz;
+      reset();
+    }
+
+    void setParameters(T minCutoff, T beta, T dCutoff = 1)
+    {
+      m_minCutoff = minCutoff;
+      m_beta = beta;
+      m_dCutoff = dCutoff;
+    }
+
+    void reset() { m_primed = false; }
+
+    void filter(const T *in, T *out)
+    {
+      if (!m_primed)
+        {
+          for (size_t c = 0; c < C; c++)
+            {
+              m_x[c] = in[c];
+              m_dx[c] = 0;
+              out[c] = in[c];
+            }
+          m_primed = true;
+          return;
+        }
+
+      T ad = alpha(m_dCutoff);
+      for (size_t c = 0; c < C; c++)
+        {
+          T dx = (in[c] - m_x[c]) * m_rate;
+          m_dx[c] += ad * (dx - m_dx[c]);
+
+          T cutoff = m_minCutoff + m_beta * std::fabs(m_dx[c]);
+          m_x[c] += alpha(cutoff) * (in[c] - m_x[c]);
+          out[c] = m_x[c];
+        }
+    }
+
+  private:
+    T m_rate, m_minCutoff, m_beta, m_dCutoff;
+    bool m_primed;
+    T m_x[C], m_dx[C];
+
+    /* smoothing factor of a first order low pass at cutoff Hz */
+    T alpha(T cutoff) const
+    {
+      T tau = 1 / (2 * (T)M_PI * cutoff);
+      return 1 / (1 + tau * m_rate);
+    }
+  };
+
+  /**
+   * Alpha-beta tracker: estimates each channel's value and rate of
+   * change, predicting from the rate and correcting by alpha (value)
+   * and beta (rate) times the prediction error.  getRate() returns
+   * the rate estimate in units per second.
+   */
+  template <typename T, size_t C>
+  class AlphaBeta {
+  public:
+    AlphaBeta(T rateHz, T alpha, T beta) :
+      m_alpha(alpha), m_beta(beta)
+    {
+      setRate(rateHz);
+    }
+
+    void setRate(T rateHz)
+    {
+      if (!(rateHz > 0))
+        throw std::invalid_argument(std::string("AlphaBeta")
+                                    + ": rate must be positive");
+      m_dt = 1 / rateHz;
+      reset();
+    }
+
+    void setParameters(T alpha, T beta)
+    {
+      m_alpha = alpha;
+      m_beta = beta;
+    }
+
+    void reset() { m_primed = false; }
+
+    void filter(const T *in, T *out)
+    {
+      for (size_t c = 0; c < C; c++)
+        {
+          if (!m_primed)
+            {
+              m_x[c] = in[c];
+              m_v[c] = 0;
+            }
+          else
+            {
+              T x = m_x[c] + m_v[c] * m_dt;
+              T r = in[c] - x;
+              m_x[c] = x + m_alpha * r;
+              m_v[c] += m_beta * r / m_dt;
+            }
+          out[c] = m_x[c];
+        }
+      m_primed = true;
+    }
+
+    T getRate(size_t channel) const { return m_v[channel]; }
+
+  private:
+    T m_dt, m_alpha, m_beta;
+    bool m_primed;
+    T m_x[C], m_v[C];
+  };
+
+  /**
+   * Acceleration source passed through a 3 channel float filter.
+   */
+  template <class Filter>
+  class FilteredAcceleration : public iAcceleration {
+  public:
+    FilteredAcceleration(iAcceleration &source, const Filter &f = Filter()) :
+      m_source(source), m_filter(f) {}
+
+    std::vector<float> getAcceleration()
+    {
+      std::vector<float> v = m_source.getAcceleration();
+      m_filter.filter(v.data(), v.data());
+      return v;
+    }
+
+    Filter &filter() { return m_filter; }
+
+  private:
+    iAcceleration &m_source;
+    Filter m_filter;
+  };
+
+  /**
+   * Gyroscope source passed through a 3 channel float filter.
+   */
+  template <class Filter>
+  class FilteredGyroscope : public iGyroscope {
+  public:
+    FilteredGyroscope(iGyroscope &source, const Filter &f = Filter()) :
+      m_source(source), m_filter(f) {}
+
+    std::vector<float> getGyroscope()
+    {
+      std::vector<float> v = m_source.getGyroscope();
+      m_filter.filter(v.data(), v.data());
+      return v;
+    }
+
+    Filter &filter() { return m_filter; }
+
+  private:
+    iGyroscope &m_source;
+    Filter m_filter;
+  };
+
+  /**
+   * Magnetometer source passed through a 3 channel float filter.
+   */
+  template <class Filter>
+  class FilteredMagnetometer : public iMagnetometer {
+  public:
+    FilteredMagnetometer(iMagnetometer &source, const Filter &f = Filter()) :
+      m_source(source), m_filter(f) {}
+
+    std::vector<float> getMagnetometer()
+    {
+      std::vector<float> v = m_source.getMagnetometer();
+      m_filter.filter(v.data(), v.data());
+      return v;
+    }
+
+    Filter &filter() { return m_filter; }
+
+  private:
+    iMagnetometer &m_source;
+    Filter m_filter;
+  };
+}
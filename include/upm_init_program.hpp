@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/*
+ * Compiled init strings.
+ *
+ * The part of an init string that MraaIo does not consume is a comma
+ * separated list of commands with colon separated arguments:
+ *
+ *   "i:0:0x40,writeByte:0xfe:0x1e,writeByte:0xff:0x00,modeSleep:0"
+ *
+ * A driver describes the commands it accepts in a table, and compiles
+ * the string into a list of operations once.  Every token is checked
+ * against the table and its arguments converted up front, so a bad
+ * token throws before anything is written to the device.  Commands
+ * that are plain register writes are merged with the writes to the
+ * registers right after them into burst writes, if the device accepts
+ * them.
+ *
+ * Compiled programs are cached by string, so instantiating many devices
+ * from the same configuration only parses it once:
+ *
+ *   static const InitCommand cmds[] = {
+ *     { "writeByte", "ii", INIT_WRITE8, 0 },
+ *     { "modeSleep", "i", INIT_CALL, CMD_MODE_SLEEP },
+ *   };
+ *
+ *   InitProgram::compile(leftover, cmds, 32)->run(
+ *     [this](uint8_t reg, const uint8_t *data, size_t len) { ... },
+ *     [this](const InitOp &op) { ... });
+ */
+namespace upm {
+
+  /* How a command is executed */
+  enum InitWrite {
+    /* by the driver, see InitProgram::run() */
+    INIT_CALL,
+    /* as a write of its second argument to the register given by the
+     * first: one byte, or a 16-bit word in either byte order */
+    INIT_WRITE8,
+    INIT_WRITE16LE,
+    INIT_WRITE16BE
+  };
+
+  struct InitCommand {
+    /* token name, without the colon */
+    const char *name;
+    /* one character per argument, 'i' for an integer (decimal, hex or
+     * octal) and 'f' for a float */
+    const char *args;
+    InitWrite write;
+    /* driver defined, passed back for INIT_CALL commands */
+    int id;
+  };
+
+  struct InitOp {
+    /* command id, or -1 for a register write */
+    int id;
+    /* register writes: first register and the bytes to write */
+    uint8_t reg;
+    std::vector<uint8_t> data;
+    /* commands: the converted arguments */
+    std::vector<double> args;
+
+    long intArg(size_t i) const { return (long)args.at(i); }
+    float floatArg(size_t i) const { return (float)args.at(i); }
+  };
+
+  class InitProgram {
+  public:
+    typedef std::shared_ptr<const InitProgram> Ptr;
+
+    /*
+     * Compile an init string.  Register writes are merged into bursts
+     * of up to maxBurst bytes, 0 or 1 to keep them separate.  Throws
+     * std::invalid_argument on unknown tokens or bad arguments.
+     */
+    InitProgram(const std::string &str, const InitCommand *cmds,
+                size_t ncmds, size_t maxBurst = 0)
+    {
+      size_t start = 0;
+
+      while (start < str.size())
+        {
+          size_t end = str.find(',', start);
+          if (end == std::string::npos)
+            end = str.size();
+
+          if (end > start)
+            add(str.substr(start, end - start), cmds, ncmds, maxBurst);
+          start = end + 1;
+        }
+    }
+
+    /*
+     * Compile an init string, or return the program compiled for the
+     * same string and command table before.
+     */
+    template <size_t N>
+    static Ptr compile(const std::string &str, const InitCommand (&cmds)[N],
+                       size_t maxBurst = 0)
+    {
+      typedef std::tuple<const InitCommand *, size_t, std::string> Key;
+      static std::mutex lock;
+      static std::map<Key, Ptr> cache;
+
+      Key key(cmds, maxBurst, str);
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = cache.find(key);
+        if (it != cache.end())
+          return it->second;
+      }
+
+      // compile outside of the lock, it may throw
+      Ptr prog = std::make_shared<const InitProgram>(str, cmds, N, maxBurst);
+
+      std::lock_guard<std::mutex> guard(lock);
+      // configurations are few, but do not grow without bound
+      if (cache.size() >= 64)
+        cache.clear();
+      cache[key] = prog;
+
+      return prog;
+    }
+
+    const std::vector<InitOp> &ops() const { return m_ops; }
+
+    /*
+     * Execute the program in order.  Register writes are passed to
+     * writeRegs(uint8_t reg, const uint8_t *data, size_t len), other
+     * commands to call(const InitOp &op).
+     */
+    template <typename WriteRegs, typename Call>
+    void run(WriteRegs writeRegs, Call call) const
+    {
+      for (const InitOp &op : m_ops)
+        {
+          if (op.id < 0)
+            writeRegs(op.reg, op.data.data(), op.data.size());
+          else
+            call(op);
+        }
+    }
+
+  private:
+    static void fail(const std::string &tok, const char *why)
+    {
+      throw std::invalid_argument(std::string("InitProgram") + ": " + why
+                                  + " in '" + tok + "'");
+    }
+
+    static double convert(const std::string &tok, const std::string &arg,
+                          char type)
+    {
+      const char *s = arg.c_str();
+      char *end;
+      double v;
+
+      errno = 0;
+      if (type == 'f')
+        v = strtod(s, &end);
+      else
+        v = (double)strtol(s, &end, 0);
+
+      if (arg.empty() || *end != '\0' || errno == ERANGE)
+        fail(tok, "invalid argument");
+
+      return v;
+    }
+
+    void add(const std::string &tok, const InitCommand *cmds, size_t ncmds,
+             size_t maxBurst)
+    {
+      std::vector<std::string> parts;
+      size_t start = 0, end;
+
+      while ((end = tok.find(':', start)) != std::string::npos)
+        {
+          parts.push_back(tok.substr(start, end - start));
+          start = end + 1;
+        }
+      parts.push_back(tok.substr(start));
+
+      // commands without arguments may be written with a trailing colon
+      if (parts.size() == 2 && parts[1].empty())
+        parts.pop_back();
+
+      const InitCommand *cmd = NULL;
+      for (size_t i = 0; i < ncmds && !cmd; i++)
+        if (parts[0] == cmds[i].name)
+          cmd = &cmds[i];
+
+      if (!cmd)
+        fail(tok, "unknown command");
+      if (parts.size() - 1 != std::string(cmd->args).size())
+        fail(tok, "wrong number of arguments");
+
+      InitOp op;
+      op.id = cmd->id;
+      op.reg = 0;
+      for (size_t i = 1; i < parts.size(); i++)
+        op.args.push_back(convert(tok, parts[i], cmd->args[i - 1]));
+
+      if (cmd->write == INIT_CALL)
+        {
+          m_ops.push_back(op);
+          return;
+        }
+
+      // register writes
+      long reg = op.intArg(0);
+      long val = op.intArg(1);
+      long max = (cmd->write == INIT_WRITE8) ? 0xff : 0xffff;
+
+      if (reg < 0 || reg > 0xff || val < 0 || val > max)
+        fail(tok, "value out of range");
+
+      op.id = -1;
+      op.reg = reg;
+      op.args.clear();
+      if (cmd->write == INIT_WRITE8)
+        op.data.push_back(val);
+      else if (cmd->write == INIT_WRITE16LE)
+        op.data = { (uint8_t)val, (uint8_t)(val >> 8) };
+      else
+        op.data = { (uint8_t)(val >> 8), (uint8_t)val };
+
+      // append to the previous write if it ends right before this one
+      if (!m_ops.empty())
+        {
+          InitOp &prev = m_ops.back();
+          if (prev.id < 0
+              && prev.reg + prev.data.size() == op.reg
+              && prev.data.size() + op.data.size() <= maxBurst)
+            {
+              prev.data.insert(prev.data.end(), op.data.begin(),
+                               op.data.end());
+              return;
+            }
+        }
+
+      m_ops.push_back(op);
+    }
+
+    std::vector<InitOp> m_ops;
+  };
+}
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include <mraa/i2c.hpp>
+
+/*
+ * Compile time register maps for 8-bit register mapped devices.
+ *
+ * A Field describes a group of bits at a fixed register address: its
+ * position, width, access mode, byte order and signedness, all known
+ * at compile time.  A field may span several consecutive registers,
+ * e.g. a 16-bit output sample:
+ *
+ *   typedef regmap::Field<REG_CTRL1, 3, 2> Ctrl1Odr;
+ *   typedef regmap::Field<REG_OUT_X_L, 0, 16, regmap::RO,
+ *                         regmap::LITTLE, true> OutX;
+ *
+ * A Block groups fields that are close together and transfers all the
+ * registers they occupy in one burst:
+ *
+ *   regmap::Block<OutX, OutY, OutZ> out;
+ *   out.read(bus);
+ *   x = out.get<OutX>();
+ *
+ * The bus is any object providing
+ *
+ *   void readRegs(uint8_t reg, uint8_t *buf, int len);
+ *   void writeRegs(uint8_t reg, const uint8_t *buf, int len);
+ *
+ * that throws on failure, such as regmap::I2cBus.  Reading a write only
+ * field, writing a read only one, or getting a field from a block it is
+ * not part of fails to compile.
+ */
+namespace upm {
+namespace regmap {
+
+  /* Field access modes */
+  enum Access { RO = 1, WO = 2, RW = 3 };
+
+  /* Byte order of fields spanning several registers */
+  enum Endian { LITTLE, BIG };
+
+  namespace detail {
+    constexpr uint32_t ones(unsigned width)
+    {
+      return (width >= 32) ? 0xffffffffu : ((1u << width) - 1);
+    }
+
+    constexpr unsigned minOf(unsigned a) { return a; }
+
+    template <typename... T>
+    constexpr unsigned minOf(unsigned a, unsigned b, T... rest)
+    {
+      return minOf(a < b ? a : b, rest...);
+    }
+
+    constexpr unsigned maxOf(unsigned a) { return a; }
+
+    template <typename... T>
+    constexpr unsigned maxOf(unsigned a, unsigned b, T... rest)
+    {
+      return maxOf(a > b ? a : b, rest...);
+    }
+
+    constexpr bool allOf() { return true; }
+
+    template <typename... T>
+    constexpr bool allOf(bool a, T... rest)
+    {
+      return a && allOf(rest...);
+    }
+  }
+
+  /*
+   * Width bits starting at bit Shift of the little or big endian
+   * integer formed by the registers starting at Addr.
+   */
+  template <uint8_t Addr, unsigned Shift, unsigned Width,
+            Access Acc = RW, Endian End = LITTLE, bool Signed = false>
+  struct Field {
+    static_assert(Width > 0 && Shift + Width <= 32,
+                  "a field must fit in 32 bits");
+
+    typedef typename std::conditional<Signed, int32_t, uint32_t>::type
+      value_type;
+
+    static constexpr uint8_t addr = Addr;
+    static constexpr unsigned bytes = (Shift + Width + 7) / 8;
+    static constexpr unsigned last = Addr + bytes - 1;
+    static constexpr Access access = Acc;
+    static constexpr uint32_t mask = detail::ones(Width) << Shift;
+    // true if the field covers its registers completely, so it can be
+    // written without reading them first
+    static constexpr bool whole = (mask == detail::ones(8 * bytes));
+
+    static_assert(last <= 0xff, "field extends past register 0xff");
+
+    /* Assemble the registers of the field, regs points to Addr */
+    static uint32_t raw(const uint8_t *regs)
+    {
+      uint32_t v = 0;
+      for (unsigned i = 0; i < bytes; i++)
+        v |= (uint32_t)regs[(End == LITTLE) ? i : bytes - 1 - i] << (8 * i);
+      return v;
+    }
+
+    /* Split v back into the registers of the field */
+    static void store(uint8_t *regs, uint32_t v)
+    {
+      for (unsigned i = 0; i < bytes; i++)
+        regs[(End == LITTLE) ? i : bytes - 1 - i] = (uint8_t)(v >> (8 * i));
+    }
+
+    /* Extract the field from its registers */
+    static value_type decode(const uint8_t *regs)
+    {
+      uint32_t v = (raw(regs) & mask) >> Shift;
+      if (Signed)
+        {
+          // sign extend
+          uint32_t sign = 1u << (Width - 1);
+          v = (v ^ sign) - sign;
+        }
+      return (value_type)v;
+    }
+
+    /* Replace the field in its registers, leaving other bits alone */
+    static void encode(uint8_t *regs, value_type val)
+    {
+      store(regs, (raw(regs) & ~mask) | (((uint32_t)val << Shift) & mask));
+    }
+  };
+
+  // definitions for odr-used constants, C++11 needs them out of class
+  template <uint8_t Addr, unsigned Shift, unsigned Width, Access Acc,
+            Endian End, bool Signed>
+  constexpr uint8_t Field<Addr, Shift, Width, Acc, End, Signed>::addr;
+  template <uint8_t Addr, unsigned Shift, unsigned Width, Access Acc,
+            Endian End, bool Signed>
+  constexpr unsigned Field<Addr, Shift, Width, Acc, End, Signed>::bytes;
+  template <uint8_t Addr, unsigned Shift, unsigned Width, Access Acc,
+            Endian End, bool Signed>
+  constexpr unsigned Field<Addr, Shift, Width, Acc, End, Signed>::last;
+  template <uint8_t Addr, unsigned Shift, unsigned Width, Access Acc,
+            Endian End, bool Signed>
+  constexpr Access Field<Addr, Shift, Width, Acc, End, Signed>::access;
+  template <uint8_t Addr, unsigned Shift, unsigned Width, Access Acc,
+            Endian End, bool Signed>
+  constexpr uint32_t Field<Addr, Shift, Width, Acc, End, Signed>::mask;
+  template <uint8_t Addr, unsigned Shift, unsigned Width, Access Acc,
+            Endian End, bool Signed>
+  constexpr bool Field<Addr, Shift, Width, Acc, End, Signed>::whole;
+
+  /* A whole 8-bit register */
+  template <uint8_t Addr, Access Acc = RW>
+  using Reg = Field<Addr, 0, 8, Acc>;
+
+  /* A single bit */
+  template <uint8_t Addr, unsigned N, Access Acc = RW>
+  using Bit = Field<Addr, N, 1, Acc>;
+
+  /*
+   * Registers holding a group of fields, transferred in one burst
+   * spanning the lowest to the highest register of the fields.  Keep
+   * the fields close together, the registers in between are
+   * transferred as well.
+   */
+  template <typename... Fields>
+  class Block {
+  public:
+    static constexpr uint8_t first = detail::minOf(Fields::addr...);
+    static constexpr uint8_t last = detail::maxOf(Fields::last...);
+    static constexpr unsigned size = last - first + 1;
+
+    static_assert(size <= 64, "block is too large for one burst");
+
+    Block() { memset(m_regs, 0, sizeof(m_regs)); }
+
+    /* Read all registers of the block in one transaction */
+    template <typename Bus>
+    void read(Bus &bus)
+    {
+      static_assert(detail::allOf((Fields::access & RO)...),
+                    "block contains write only fields");
+      bus.readRegs(first, m_regs, size);
+    }
+
+    /* Write all registers of the block in one transaction.  Registers
+     * not covered by fields are written as read, or 0. */
+    template <typename Bus>
+    void write(Bus &bus) const
+    {
+      static_assert(detail::allOf((Fields::access & WO)...),
+                    "block contains read only fields");
+      bus.writeRegs(first, m_regs, size);
+    }
+
+    template <typename F>
+    typename F::value_type get() const
+    {
+      static_assert(F::addr >= first && F::last <= last,
+                    "field is not part of this block");
+      return F::decode(m_regs + (F::addr - first));
+    }
+
+    template <typename F>
+    void set(typename F::value_type val)
+    {
+      static_assert(F::addr >= first && F::last <= last,
+                    "field is not part of this block");
+      F::encode(m_regs + (F::addr - first), val);
+    }
+
+    /* Raw register contents, starting at first */
+    const uint8_t *data() const { return m_regs; }
+
+  private:
+    uint8_t m_regs[size];
+  };
+
+  template <typename... Fields>
+  constexpr uint8_t Block<Fields...>::first;
+  template <typename... Fields>
+  constexpr uint8_t Block<Fields...>::last;
+  template <typename... Fields>
+  constexpr unsigned Block<Fields...>::size;
+
+  /* Read a single field */
+  template <typename F, typename Bus>
+  typename F::value_type read(Bus &bus)
+  {
+    static_assert(F::access & RO, "field is write only");
+
+    uint8_t regs[F::bytes];
+    bus.readRegs(F::addr, regs, F::bytes);
+    return F::decode(regs);
+  }
+
+  /* Write a single field.  Fields that only cover part of their
+   * registers are read, modified and written back. */
+  template <typename F, typename Bus>
+  void write(Bus &bus, typename F::value_type val)
+  {
+    static_assert(F::access & WO, "field is read only");
+    static_assert(F::whole || (F::access & RO),
+                  "can not modify part of a write only register");
+
+    uint8_t regs[F::bytes] = { 0 };
+    if (!F::whole)
+      bus.readRegs(F::addr, regs, F::bytes);
+    F::encode(regs, val);
+    bus.writeRegs(F::addr, regs, F::bytes);
+  }
+
+  /*
+   * Register access on an mraa::I2c device, whose address must
+   * already be set.  Devices that need a flag in the register address
+   * to auto-increment it on multi-byte transfers (0x80 on most ST
+   * sensors) pass it as AutoIncrement.
+   */
+  template <uint8_t AutoIncrement = 0>
+  class I2cBus {
+  public:
+    explicit I2cBus(mraa::I2c &i2c) : m_i2c(i2c) {}
+
+    void readRegs(uint8_t reg, uint8_t *buf, int len)
+    {
+      if (len > 1)
+        reg |= AutoIncrement;
+
+      if (m_i2c.readBytesReg(reg, buf, len) != len)
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": I2c.readBytesReg() failed");
+    }
+
+    void writeRegs(uint8_t reg, const uint8_t *buf, int len)
+    {
+      if (len == 1)
+        {
+          if (m_i2c.writeReg(reg, buf[0]) != mraa::SUCCESS)
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": I2c.writeReg() failed");
+          return;
+        }
+
+      uint8_t data[65];
+      if (len < 1 || len > 64)
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": invalid length");
+
+      data[0] = reg | AutoIncrement;
+      memcpy(data + 1, buf, len);
+      if (m_i2c.write(data, len + 1) != mraa::SUCCESS)
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": I2c.write() failed");
+    }
+
+  private:
+    mraa::I2c &m_i2c;
+  };
+}
+}
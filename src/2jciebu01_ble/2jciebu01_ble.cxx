@@ -30,6 +30,11 @@ OM2JCIEBU_BLE::OM2JCIEBU_BLE(std::string ble_address)
 
 }
 
+OM2JCIEBU_BLE::~OM2JCIEBU_BLE()
+{
+    stopPolling();
+}
+
 bool OM2JCIEBU_BLE::connectBleDevice(std::string ble_address)
 {
     
@@ -76,6 +81,8 @@ bool OM2JCIEBU_BLE::connectBleDevice(std::string ble_address)
 
 bool OM2JCIEBU_BLE::removeBleDevice()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_ioLock);
+    bleLiveDataChar = nullptr;
     if(is_BleConnected) { //disconnect with device if connected
         if(bleSensorTag->disconnect()) {
             is_BleConnected = false;
@@ -96,6 +103,7 @@ bool OM2JCIEBU_BLE::stopBleDiscovery()
 
 bool OM2JCIEBU_BLE::writePacket(OM2JCIEBU::OM2JCIEBU_ATTRIBUTE_T attribute_name, const std::vector<unsigned char> &arg_value)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_ioLock);
     if(!(is_BleConnected)) { //Connect with device if not connected
         if(!(connectBleDevice(OM2JCIEBU_BLE::bleMACaddress))) {
             return false;
@@ -176,6 +184,7 @@ bool OM2JCIEBU_BLE::writePacket(OM2JCIEBU::OM2JCIEBU_ATTRIBUTE_T attribute_name,
 
 OM2JCIEBU_BLE::OM2JCIEBU_ERROR_T OM2JCIEBU_BLE::getDiscoveredServices(OM2JCIEBU::OM2JCIEBU_ATTRIBUTE_T attribute_name)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_ioLock);
     if(!(is_BleConnected)) { //Connect with device if not connected
         if(!(connectBleDevice(OM2JCIEBU_BLE::bleMACaddress))) {
             return FAILURE;
@@ -260,12 +269,17 @@ OM2JCIEBU_BLE::OM2JCIEBU_ERROR_T OM2JCIEBU_BLE::getSensorData(OM2JCIEBU::OM2JCIE
         std::cout << "Null pointer received..." << std::endl;
         return FAILURE;
     }
+    std::lock_guard<std::recursive_mutex> lock(m_ioLock);
+    if(bleSensorChar == nullptr) {
+        std::cout << "Characteristics not discovered..." << std::endl;
+        return FAILURE;
+    }
     unsigned char *data;
     OM2JCIEBU_BLE::OM2JCIEBU_ERROR_T verifyResult = FAILURE;
     //Read raw data from connected BLE device based on characteristics
     std::vector<unsigned char> response = bleSensorChar->read_value();
     unsigned int size = response.size();
-    if(size > 0) {
+    if(size >= OM2JCIEBU_BLE_LIVE_LONG_DATA_MIN_LEN) {
         data = response.data();
 #if DEBUG_LOG
         std::cout << "Raw data=[";
@@ -283,6 +297,32 @@ OM2JCIEBU_BLE::OM2JCIEBU_ERROR_T OM2JCIEBU_BLE::getSensorData(OM2JCIEBU::OM2JCIE
     return verifyResult;
 }
 
+OM2JCIEBU_BLE::OM2JCIEBU_ERROR_T OM2JCIEBU_BLE::getLatestData(om2jciebuData_t &data)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_ioLock);
+
+    //look the live data characteristic up once, writePacket() reuses
+    //bleSensorChar for the configuration characteristics
+    if(bleLiveDataChar == nullptr || !is_BleConnected) {
+        if(getDiscoveredServices(ALL_PARAM) != SUCCESS)
+            return FAILURE;
+        bleLiveDataChar = bleSensorChar;
+    }
+
+    BluetoothGattCharacteristic *savedChar = bleSensorChar;
+    bleSensorChar = bleLiveDataChar;
+    OM2JCIEBU_BLE::OM2JCIEBU_ERROR_T verifyResult = FAILURE;
+    try {
+        verifyResult = getSensorData(ALL_PARAM, &data);
+    } catch(...) {
+        bleSensorChar = savedChar;
+        throw;
+    }
+    bleSensorChar = savedChar;
+
+    return verifyResult;
+}
+
 OM2JCIEBU_BLE::OM2JCIEBU_ERROR_T OM2JCIEBU_BLE::getAdvSensorData(OM2JCIEBU::OM2JCIEBU_ATTRIBUTE_T attribute_name, void *attribute_data)
 {
     if(attribute_data == NULL) {
@@ -292,6 +332,7 @@ OM2JCIEBU_BLE::OM2JCIEBU_ERROR_T OM2JCIEBU_BLE::getAdvSensorData(OM2JCIEBU::OM2J
     uint8_t advSensordata[MAX_SENSOR_DATA_SIZE] = {0};
     int advDataindex = 0;
     OM2JCIEBU_BLE::OM2JCIEBU_ERROR_T verifyResult = FAILURE;
+    std::lock_guard<std::recursive_mutex> lock(m_ioLock);
     if(is_BleConnected) { //disconnect with device if connected
         removeBleDevice();
         is_BleConnected = false;
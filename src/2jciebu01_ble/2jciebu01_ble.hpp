@@ -38,6 +38,8 @@
 #define DEBUG_LOG                                          0
 #define MAX_UUID_SIZE                                      64
 #define MAX_SENSOR_DATA_SIZE                               64
+// sequence number up to eCO2 in the latest data long characteristic
+#define OM2JCIEBU_BLE_LIVE_LONG_DATA_MIN_LEN               17
 
 
 /*=========================================================================*/
@@ -77,6 +79,11 @@ public :
     */
     OM2JCIEBU_BLE(std::string ble_address);
 
+    /**
+    * OM2JCIEBU_BLE destructor
+    */
+    ~OM2JCIEBU_BLE();
+
 
     /**
     * Get discovery service from Connetced BLE device
@@ -95,6 +102,16 @@ public :
      */
     OM2JCIEBU_ERROR_T getSensorData(OM2JCIEBU::OM2JCIEBU_ATTRIBUTE_T attribute_name, void *attribute_data);
 
+    /**
+     * Get all omron sensor live data with one read of the latest
+     * data long (0x5012) characteristic.  Connects and looks the
+     * characteristic up on first use.  The discomfort index and heat
+     * stroke are not part of this characteristic and are set to 0.
+     * @param data   Structure to store the decoded sensor data
+     * @return One of the OM2JCIEBU_ERROR_T values
+     */
+    OM2JCIEBU_ERROR_T getLatestData(om2jciebuData_t &data);
+
     /**
      * Get omron sensor live data based on advertise payload
      *
@@ -135,7 +152,8 @@ private:
     BluetoothDevice  *bleSensorTag = nullptr;
     BluetoothGattCharacteristic *bleSensorChar = nullptr;
     BluetoothGattService *bleService = nullptr;
-    om2jciebuData_t om2jciebuData_ble;
+    BluetoothGattCharacteristic *bleLiveDataChar = nullptr;
+    om2jciebuData_t om2jciebuData_ble = om2jciebuData_t();
     std::string bleMACaddress;
     bool is_BleConnected = false;
 
@@ -12,12 +12,25 @@
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <chrono>
 
 #include "2jciebu01.hpp"
 
 using namespace upm;
 using namespace std;
 
+OM2JCIEBU::OM2JCIEBU() : m_pollRunning(false), m_pollExit(false), m_pollInterval(1000),
+    m_pollData(), m_pollResult(FAILURE), m_pollCount(0), m_pollSeen(0)
+{
+}
+
+OM2JCIEBU::~OM2JCIEBU()
+{
+    // the derived classes stop the poller in their destructors, while
+    // getLatestData() can still be called
+    stopPolling();
+}
+
 
 void OM2JCIEBU::getAddress(OM2JCIEBU_ATTRIBUTE_T attribute_name, OM2JCIEBU_INTERFACE_T interface, void *attribute_value)
 {
@@ -83,5 +96,105 @@ uint16_t OM2JCIEBU::crc_16(uint8_t *data, int length)
     return crc;
 }
 
+void OM2JCIEBU::startPolling(int milliseconds)
+{
+    if(milliseconds <= 0)
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": interval must be greater than 0");
+
+    std::lock_guard<std::mutex> lock(m_pollLock);
+    m_pollInterval = milliseconds;
+    if(m_pollRunning)
+        return;
+
+    m_pollRunning = true;
+    m_pollExit = false;
+    m_pollResult = FAILURE;
+    m_pollThread = std::thread(&OM2JCIEBU::pollThread, this);
+}
+
+void OM2JCIEBU::stopPolling()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pollLock);
+        if(!m_pollRunning || m_pollExit)
+            return;
+        m_pollExit = true;
+    }
+    m_pollCond.notify_all();
+
+    m_pollThread.join();
 
+    std::lock_guard<std::mutex> lock(m_pollLock);
+    m_pollRunning = false;
+}
 
+bool OM2JCIEBU::isPolling()
+{
+    std::lock_guard<std::mutex> lock(m_pollLock);
+    return m_pollRunning && !m_pollExit;
+}
+
+OM2JCIEBU::OM2JCIEBU_ERROR_T OM2JCIEBU::getPolledData(om2jciebuData_t &data)
+{
+    std::lock_guard<std::mutex> lock(m_pollLock);
+    if(m_pollCount == 0)
+        return FAILURE;
+
+    data = m_pollData;
+    m_pollSeen = m_pollCount;
+    return m_pollResult;
+}
+
+bool OM2JCIEBU::waitForPolledData(om2jciebuData_t &data, int milliseconds)
+{
+    std::unique_lock<std::mutex> lock(m_pollLock);
+
+    auto fresh = [this] { return !m_pollRunning || m_pollExit ||
+                                 (m_pollCount != m_pollSeen && m_pollResult == SUCCESS); };
+
+    if(milliseconds < 0)
+        m_pollCond.wait(lock, fresh);
+    else
+        m_pollCond.wait_for(lock, std::chrono::milliseconds(milliseconds), fresh);
+
+    if(m_pollCount == m_pollSeen || m_pollResult != SUCCESS)
+        return false;
+
+    data = m_pollData;
+    m_pollSeen = m_pollCount;
+    return true;
+}
+
+void OM2JCIEBU::pollThread()
+{
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+
+    while(true) {
+        om2jciebuData_t data = om2jciebuData_t();
+        OM2JCIEBU_ERROR_T result;
+        try {
+            result = getLatestData(data);
+        } catch(const std::exception &e) {
+            std::cerr << __FUNCTION__ << ": " << e.what() << std::endl;
+            result = ERROR_UNKNOWN;
+        }
+
+        std::unique_lock<std::mutex> lock(m_pollLock);
+        if(result == SUCCESS)
+            m_pollData = data;
+        m_pollResult = result;
+        m_pollCount++;
+        m_pollCond.notify_all();
+
+        // deadlines are absolute, so the interval does not stretch by
+        // the time spent talking to the sensor
+        next += std::chrono::milliseconds(m_pollInterval);
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if(next < now)
+            next = now;
+
+        if(m_pollCond.wait_until(lock, next, [this] { return m_pollExit; }))
+            break;
+    }
+}
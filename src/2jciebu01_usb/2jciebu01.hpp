@@ -16,6 +16,9 @@
 #include <string>
 #include <iostream>
 #include <limits>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -129,9 +132,14 @@ public :
     } om2jciebuData_t;
 
     /**
-    * OM2JCIEBU destructor
+    * OM2JCIEBU constructor
     */
-    virtual ~OM2JCIEBU() {}
+    OM2JCIEBU();
+
+    /**
+    * OM2JCIEBU destructor, stops the poller if still running
+    */
+    virtual ~OM2JCIEBU();
 
     /**
      * get address or UUID based on attribute name
@@ -197,6 +205,52 @@ public :
      */
     virtual OM2JCIEBU_ERROR_T getSensorData(OM2JCIEBU_ATTRIBUTE_T attribute_name, void *attribute_data) = 0;
 
+    /**
+     * Get all omron sensor live data in a single exchange, using the
+     * latest data long frame
+     * @param data   Structure to store the decoded sensor data
+     * @return One of the OM2JCIEBU_ERROR_T values
+     */
+    virtual OM2JCIEBU_ERROR_T getLatestData(om2jciebuData_t &data) = 0;
+
+    /**
+     * Start reading the latest data long frame periodically in a
+     * background thread.  The most recent sample is returned by
+     * getPolledData(), the other methods of the sensor may still be
+     * called while polling.
+     * @param milliseconds   polling interval
+     */
+    void startPolling(int milliseconds = 1000);
+
+    /**
+     * Stop the background poller and wait for it to exit
+     */
+    void stopPolling();
+
+    /**
+     * Check whether the background poller is running
+     * @return true if polling
+     */
+    bool isPolling();
+
+    /**
+     * Get the most recent sample read by the background poller
+     * @param data   Structure to store the sensor data
+     * @return SUCCESS, or the error of the last poll if it failed,
+     * FAILURE if nothing was read yet
+     */
+    OM2JCIEBU_ERROR_T getPolledData(om2jciebuData_t &data);
+
+    /**
+     * Wait for a sample newer than the one last returned by
+     * getPolledData() or waitForPolledData()
+     * @param data         Structure to store the sensor data
+     * @param milliseconds maximum time to wait, -1 to wait forever
+     * @return true if a new sample was stored in data, false on timeout
+     * or if the poller is not running
+     */
+    bool waitForPolledData(om2jciebuData_t &data, int milliseconds = -1);
+
     /**
     * Verifies the packet header and indicates it is valid or not
     *
@@ -206,5 +260,28 @@ public :
     */
 
     virtual OM2JCIEBU_ERROR_T verifyPacket(uint8_t *pkt, int len) = 0;
+
+protected:
+    // serializes exchanges with the sensor between the poller and
+    // the caller
+    std::recursive_mutex m_ioLock;
+
+private:
+    /* Disable implicit copy and assignment operators */
+    OM2JCIEBU(const OM2JCIEBU&) = delete;
+    OM2JCIEBU &operator=(const OM2JCIEBU&) = delete;
+
+    std::thread m_pollThread;
+    std::mutex m_pollLock;
+    std::condition_variable m_pollCond;
+    bool m_pollRunning;
+    bool m_pollExit;
+    int m_pollInterval;
+    om2jciebuData_t m_pollData;
+    OM2JCIEBU_ERROR_T m_pollResult;
+    unsigned int m_pollCount;
+    unsigned int m_pollSeen;
+
+    void pollThread();
 };
 }
@@ -28,6 +28,11 @@ OM2JCIEBU_UART::OM2JCIEBU_UART(std::string uart_raw, int baud) : m_uart(uart_raw
                                  ": failed to set baud rate to " + std::to_string(baud));
 }
 
+OM2JCIEBU_UART::~OM2JCIEBU_UART()
+{
+    stopPolling();
+}
+
 bool OM2JCIEBU_UART::setupTty(uint32_t baud)
 {
     return m_uart.setBaudRate(baud) == mraa::SUCCESS;
@@ -115,7 +120,8 @@ int OM2JCIEBU_UART::readCmdPacket(OM2JCIEBU_UART::OM2JCIEBU_ATTRIBUTE_T attribut
 
 void OM2JCIEBU_UART::configureSensorAdvSetting(uint16_t milliseconds, OM2JCIEBU::OM2JCIEBU_ADV_PARAM_T adv_mode)
 {
-    
+    std::lock_guard<std::recursive_mutex> lock(m_ioLock);
+
     uint8_t adv_config[3] = {0};
     uint16_t interval;
     interval = milliseconds / OM2JCIEBU_INTERVAL_UNIT; /*calculate interval which is given by user using interval unit */
@@ -125,10 +131,17 @@ void OM2JCIEBU_UART::configureSensorAdvSetting(uint16_t milliseconds, OM2JCIEBU:
     adv_config[2] = adv_mode;
 
     writeCmdPacket(ADV_CONFIGURE, adv_config, sizeof(adv_config));
+
+    //consume the response, so it is not taken for the next read
+    uint8_t pkt[OM2JCIEBU_UART_MAX_PKT_LEN];
+    int len = 0;
+    readResponse(pkt, len);
 }
 
 void OM2JCIEBU_UART::configureSensorLedState(OM2JCIEBU::OM2JCIEBU_LED_SCALE_T state, uint8_t red, uint8_t green, uint8_t blue)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_ioLock);
+
     uint8_t led_config[5] = {0};
 
     led_config[0] = state;
@@ -138,6 +151,11 @@ void OM2JCIEBU_UART::configureSensorLedState(OM2JCIEBU::OM2JCIEBU_LED_SCALE_T st
     led_config[4] = blue;
 
     writeCmdPacket(LED_CONFIGURE, led_config, sizeof(led_config));
+
+    //consume the response, so it is not taken for the next read
+    uint8_t pkt[OM2JCIEBU_UART_MAX_PKT_LEN];
+    int len = 0;
+    readResponse(pkt, len);
 }
 
 int OM2JCIEBU_UART::writeCmdPacket(OM2JCIEBU_UART::OM2JCIEBU_ATTRIBUTE_T attribute_name, uint8_t *data, uint16_t length)
@@ -228,30 +246,22 @@ OM2JCIEBU_UART::OM2JCIEBU_ERROR_T OM2JCIEBU_UART::getSensorData(OM2JCIEBU_ATTRIB
         std::cout << "Null pointer received..." << std::endl;
         return FAILURE;
     }
+    std::lock_guard<std::recursive_mutex> lock(m_ioLock);
+
     //create a payload frame for read sensor data
     readCmdPacket(attribute_name);
 
-    char buf[OM2JCIEBU_UART_MAX_READ_PKT_LEN];
     uint8_t pkt[OM2JCIEBU_UART_MAX_PKT_LEN];
-    int rv;
-    int8_t pkt_index = 0, idx = 0;
-    OM2JCIEBU_UART::OM2JCIEBU_ERROR_T verifyResult = FAILURE;
-
-    //read from UART
-    while(true) {
-        rv = readData(buf, OM2JCIEBU_UART_MAX_READ_PKT_LEN);
-        if(rv > 0) {
-            for(idx = 0; idx < rv; idx++)
-                pkt[pkt_index++] = buf[idx];
-        } else {
-            verifyResult = verifyPacket(pkt, pkt_index);
-            if(verifyResult == SUCCESS) {
-                break;
-            } else {
-                return verifyResult;
-            }
-        }
+    int len = 0;
+    OM2JCIEBU_UART::OM2JCIEBU_ERROR_T verifyResult = readResponse(pkt, len);
+    if(verifyResult != SUCCESS)
+        return verifyResult;
+
+    if(len < OM2JCIEBU_UART_LIVE_LONG_DATA_MIN_LEN) {
+        std::cout << "Error Invalid Length" << std::endl;
+        return ERROR_WRONG_LENGTH;
     }
+
     //calculate a data and store in struct
     parseSensorData(pkt);
 
@@ -261,6 +271,45 @@ OM2JCIEBU_UART::OM2JCIEBU_ERROR_T OM2JCIEBU_UART::getSensorData(OM2JCIEBU_ATTRIB
     return verifyResult;
 }
 
+OM2JCIEBU_UART::OM2JCIEBU_ERROR_T OM2JCIEBU_UART::getLatestData(om2jciebuData_t &data)
+{
+    // every sensor attribute is read through the latest data long
+    // frame, so ALL_PARAM decodes all of them from one exchange
+    return getSensorData(ALL_PARAM, &data);
+}
+
+OM2JCIEBU_UART::OM2JCIEBU_ERROR_T OM2JCIEBU_UART::readResponse(uint8_t *pkt, int &len)
+{
+    int rv;
+    int expected = OM2JCIEBU_UART_LENGTH_INDEX + 2;
+
+    len = 0;
+    //read header and length first, then the rest of the frame
+    while(len < expected) {
+        rv = readData((char *)pkt + len, expected - len);
+        if(rv <= 0) {
+            std::cout << "Timeout waiting for response" << std::endl;
+            return FAILURE;
+        }
+        len += rv;
+
+        if(expected == OM2JCIEBU_UART_LENGTH_INDEX + 2 && len >= expected) {
+            if(pkt[0] != OM2JCIEBU_UART_HEADER_START || pkt[1] != OM2JCIEBU_UART_HEADER_END) {
+                std::cout << "Invalid reponse" << std::endl;
+                return ERROR_UNKNOWN;
+            }
+            expected += pkt[OM2JCIEBU_UART_LENGTH_INDEX] | pkt[OM2JCIEBU_UART_LENGTH_INDEX + 1] << 8;
+            if(expected > OM2JCIEBU_UART_MAX_PKT_LEN ||
+               expected < OM2JCIEBU_UART_COMMAND_ERROR_CODE_INDEX + OM2JCIEBU_CRC_LENGTH) {
+                std::cout << "Error Invalid Length" << std::endl;
+                return ERROR_WRONG_LENGTH;
+            }
+        }
+    }
+
+    return verifyPacket(pkt, len);
+}
+
 OM2JCIEBU_UART::OM2JCIEBU_ERROR_T OM2JCIEBU_UART::verifyPacket(uint8_t *pkt, int len)
 {
     if(pkt == NULL) {
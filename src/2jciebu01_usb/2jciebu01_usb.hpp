@@ -30,6 +30,10 @@
 
 #define OM2JCIEBU_UART_COMMAND_INDEX                        0x04
 #define OM2JCIEBU_UART_COMMAND_ERROR_CODE_INDEX             0x07
+#define OM2JCIEBU_UART_LENGTH_INDEX                         0x02
+// header, length, command, address and data up to the heat stroke
+// value, plus crc
+#define OM2JCIEBU_UART_LIVE_LONG_DATA_MIN_LEN               30
 
 
 
@@ -97,6 +101,11 @@ public :
     */
     OM2JCIEBU_UART(std::string path, int baud = 115200);
 
+    /**
+    * OM2JCIEBU_UART destructor
+    */
+    ~OM2JCIEBU_UART();
+
     /**
      * Sets up proper tty I/O modes and the baud rate. For this device,
      * the default baud rate is 115200.
@@ -138,6 +147,14 @@ public :
      */
     OM2JCIEBU_ERROR_T getSensorData(OM2JCIEBU::OM2JCIEBU_ATTRIBUTE_T attribute_name, void *attribute_data);
 
+    /**
+     * Get all omron sensor live data with one read of the latest
+     * data long (0x5021) frame
+     * @param data   Structure to store the decoded sensor data
+     * @return One of the OM2JCIEBU_ERROR_T values
+     */
+    OM2JCIEBU_ERROR_T getLatestData(om2jciebuData_t &data);
+
     /**
     * Set LED configartion of sensor
     *
@@ -211,6 +228,16 @@ private:
      */
     int readData(char *buffer, int len);
 
+    /**
+     * Reads one response frame.  The frame length is taken from the
+     * header, so this returns as soon as the whole frame is in,
+     * rather than waiting for the read to time out.
+     * @param pkt Buffer of OM2JCIEBU_UART_MAX_PKT_LEN bytes for the frame
+     * @param len Set to the length of the frame
+     * @return One of the OM2JCIEBU_ERROR_T values
+     */
+    OM2JCIEBU_ERROR_T readResponse(uint8_t *pkt, int &len);
+
     /**
      * Verifies the packet header and indicates it is valid or not
      *
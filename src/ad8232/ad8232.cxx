@@ -18,6 +18,16 @@
 using namespace upm;
 using namespace std;
 
+static upm_result_t readAio(void *ctx, float *value)
+{
+  try {
+    *value = static_cast<mraa::Aio *>(ctx)->read();
+  } catch (std::exception&) {
+    return UPM_ERROR_OPERATION_FAILED;
+  }
+  return UPM_SUCCESS;
+}
+
 
 AD8232::AD8232(int loPlus, int loMinus, int output, float aref) : 
   m_gpioLOPlus(loPlus), m_gpioLOMinus(loMinus), m_aioOUT(output)
@@ -27,6 +37,10 @@ AD8232::AD8232(int loPlus, int loMinus, int output, float aref) :
 
   m_aref = aref;
   m_ares = (1 << m_aioOUT.getBit());
+
+  if (!(m_sampler = upm_aio_sampler_init(readAio, &m_aioOUT, 250, 1024)))
+    throw std::runtime_error(std::string(__FUNCTION__) +
+                             ": upm_aio_sampler_init() failed");
 }
 
 AD8232::AD8232(std::string initStr) : 
@@ -62,10 +76,15 @@ AD8232::AD8232(std::string initStr) :
     }
   }
   m_ares = (1 << m_aioOUT.getBit());
+
+  if (!(m_sampler = upm_aio_sampler_init(readAio, &m_aioOUT, 250, 1024)))
+    throw std::runtime_error(std::string(__FUNCTION__) +
+                             ": upm_aio_sampler_init() failed");
 }
 
 AD8232::~AD8232()
 {
+  upm_aio_sampler_close(m_sampler);
 }
 
 int AD8232::value()
@@ -75,3 +94,34 @@ int AD8232::value()
   else
     return m_aioOUT.read();
 }
+
+bool AD8232::leadsOff()
+{
+  return m_gpioLOPlus.read() || m_gpioLOMinus.read();
+}
+
+void AD8232::startSampling(float rateHz)
+{
+  if (upm_aio_sampler_set_rate(m_sampler, rateHz) != UPM_SUCCESS)
+    throw std::invalid_argument(std::string(__FUNCTION__) +
+                                ": Invalid rate or already sampling");
+
+  if (upm_aio_sampler_start(m_sampler) != UPM_SUCCESS)
+    throw std::runtime_error(std::string(__FUNCTION__) +
+                             ": upm_aio_sampler_start() failed");
+}
+
+void AD8232::stopSampling()
+{
+  upm_aio_sampler_stop(m_sampler);
+}
+
+size_t AD8232::readSamples(float *buffer, size_t len, int timeoutMs)
+{
+  int n = upm_aio_sampler_read(m_sampler, buffer, len, timeoutMs);
+  if (n < 0)
+    throw std::runtime_error(std::string(__FUNCTION__) +
+                             ": Failed to do an aio read.");
+
+  return n;
+}
@@ -17,6 +17,8 @@
 #include <mraa/aio.hpp>
 #include <mraa/initio.hpp>
 
+#include "upm_aio_sampler.h"
+
 #define AD8232_DEFAULT_AREF  3.3
 
 namespace upm {
@@ -48,6 +50,10 @@ namespace upm {
    * Processing (https://www.processing.org/) is software
    * that should work, using information from the SparkFun* website.
    *
+   * For a plot with an even time base, startSampling() samples the
+   * output at a fixed rate, on absolute deadlines, in the background,
+   * and readSamples() fetches the samples in blocks.
+   *
    * This example just dumps the raw data:
    *
    * @image html ad8232.jpg
@@ -91,6 +97,40 @@ namespace upm {
      */
     int value();
 
+    /**
+     * Returns whether a leads off condition is detected.
+     *
+     * @return true if LO+ or LO- is set
+     */
+    bool leadsOff();
+
+    /**
+     * Starts sampling the output pin in the background.  The latest
+     * 1024 samples are kept until read.
+     *
+     * @param rateHz Sample rate in Hz
+     */
+    void startSampling(float rateHz);
+
+    /**
+     * Stops background sampling.  Samples not read yet can still be
+     * read.
+     */
+    void stopSampling();
+
+    /**
+     * Fetches the ADC values sampled in the background, oldest first.
+     * Samples taken while the leads were off are not marked, check
+     * leadsOff().
+     *
+     * @param buffer Buffer to fill
+     * @param len Number of samples the buffer holds
+     * @param timeoutMs Maximum time to wait for the first sample in
+     * milliseconds, 0 to not wait, -1 to wait forever
+     * @return Number of samples, 0 on timeout
+     */
+    size_t readSamples(float *buffer, size_t len, int timeoutMs = -1);
+
   private:
     mraa::Gpio m_gpioLOPlus;
     mraa::Gpio m_gpioLOMinus;
@@ -99,6 +139,7 @@ namespace upm {
 
     float m_aref;
     int m_ares;
+    upm_aio_sampler_context m_sampler;
   };
 }
 
@@ -0,0 +1,22 @@
+%include "../common_top.i"
+
+/* BEGIN Java syntax  ------------------------------------------------------- */
+#ifdef SWIGJAVA
+%include "../java_buffer.i"
+
+JAVA_JNI_LOADLIBRARY(javaupm_ad8232)
+#endif
+/* END Java syntax */
+
+/* BEGIN Python syntax  ----------------------------------------------------- */
+#ifdef SWIGPYTHON
+%include "../python_buffer.i"
+#endif
+/* END Python syntax */
+
+/* BEGIN Common SWIG syntax ------------------------------------------------- */
+%{
+#include "ad8232.hpp"
+%}
+%include "ad8232.hpp"
+/* END Common SWIG syntax */
@@ -12,11 +12,12 @@
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <string.h>
 #include <unistd.h>
 #include <utility>
 #include "math.h"
 #include "adxl345.hpp"
-#include "upm_string_parser.hpp"
+#include "upm_init_program.hpp"
 
 
 #define READ_BUFFER_LENGTH 6
@@ -77,6 +78,14 @@
 
 using namespace upm;
 
+namespace {
+    // init string commands, e.g. writeReg:0x1e:2 to set the X offset.
+    // Writes to consecutive registers go out in one burst.
+    const InitCommand initCommands[] = {
+        { "writeReg", "ii", INIT_WRITE8, 0 },
+    };
+}
+
 Adxl345::Adxl345(int bus) : m_i2c(bus)
 {
     //init bus and reset chip
@@ -115,11 +124,10 @@ Adxl345::Adxl345(int bus) : m_i2c(bus)
 Adxl345::Adxl345(std::string initStr) : m_i2c(nullptr), mraaIo(initStr)
 {
     mraa_io_descriptor* descs = mraaIo.getMraaDescriptors();
-    std::vector<std::string> upmTokens;
 
-    if(!mraaIo.getLeftoverStr().empty()) {
-      upmTokens = UpmStringParser::parse(mraaIo.getLeftoverStr());
-    }
+    // check the init string before touching the device
+    InitProgram::Ptr program =
+        InitProgram::compile(mraaIo.getLeftoverStr(), initCommands, 32);
 
     if(!descs->i2cs) {
       throw std::invalid_argument(std::string(__FUNCTION__) +
@@ -151,6 +159,17 @@ Adxl345::Adxl345(std::string initStr) : m_i2c(nullptr), mraaIo(initStr)
     m_offsets[1] = 0.003773584;
     m_offsets[2] = 0.00390625;
 
+    program->run(
+        [this](uint8_t reg, const uint8_t *data, size_t len) {
+            uint8_t buf[1 + 32];
+            buf[0] = reg;
+            memcpy(&buf[1], data, len);
+            if (m_i2c.write(buf, len + 1) != mraa::SUCCESS)
+                throw std::runtime_error(std::string("Adxl345") +
+                                         ": i2c.write() init string failed");
+        },
+        [](const InitOp &) {});
+
     Adxl345::update();
 }
 
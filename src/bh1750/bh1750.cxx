@@ -12,12 +12,29 @@
 #include <iostream>
 #include <stdexcept>
 
-#include "upm_string_parser.hpp"
+#include "upm_init_program.hpp"
 #include "bh1750.hpp"
 
 using namespace upm;
 using namespace std;
 
+namespace {
+  enum {
+    INIT_MODE,
+    INIT_POWER_UP,
+    INIT_POWER_DOWN,
+    INIT_SEND_COMMAND
+  };
+
+  // init string commands
+  const InitCommand initCommands[] = {
+    { "mode",        "i", INIT_CALL, INIT_MODE },
+    { "powerUp",     "",  INIT_CALL, INIT_POWER_UP },
+    { "powerDown",   "",  INIT_CALL, INIT_POWER_DOWN },
+    { "sendCommand", "i", INIT_CALL, INIT_SEND_COMMAND },
+  };
+}
+
 BH1750::BH1750(int bus, int addr, BH1750_OPMODES_T mode) :
   m_bh1750(bh1750_init(bus, addr, mode))
 {
@@ -29,11 +46,10 @@ BH1750::BH1750(int bus, int addr, BH1750_OPMODES_T mode) :
 BH1750::BH1750(std::string initStr) : mraaIo(initStr)
 {
   mraa_io_descriptor* descs = mraaIo.getMraaDescriptors();
-  std::vector<std::string> upmTokens;
 
-  if(!mraaIo.getLeftoverStr().empty()) {
-    upmTokens = UpmStringParser::parse(mraaIo.getLeftoverStr());
-  }
+  // check the init string before allocating anything
+  InitProgram::Ptr program =
+    InitProgram::compile(mraaIo.getLeftoverStr(), initCommands);
 
   // make sure MRAA is initialized
   int mraa_rv;
@@ -65,28 +81,31 @@ BH1750::BH1750(std::string initStr) : mraaIo(initStr)
       }
   }
 
-  for (std::string tok : upmTokens)
-  {
-    if(tok.substr(0, 5) == "mode:") {
-      BH1750_OPMODES_T mode = (BH1750_OPMODES_T)std::stoi(tok.substr(5), nullptr, 0);
-        if(bh1750_set_opmode(m_bh1750, mode) != UPM_SUCCESS)
+  program->run(
+    [](uint8_t, const uint8_t *, size_t) {},
+    [this](const InitOp &op) {
+      switch (op.id)
         {
-          bh1750_close(m_bh1750);
-          throw std::runtime_error(std::string(__FUNCTION__) +
-                                   ": bh1750_init() failed");
+        case INIT_MODE:
+          if (bh1750_set_opmode(m_bh1750, (BH1750_OPMODES_T)op.intArg(0))
+              != UPM_SUCCESS)
+            {
+              bh1750_close(m_bh1750);
+              throw std::runtime_error(std::string("BH1750") +
+                                       ": bh1750_init() failed");
+            }
+          break;
+        case INIT_POWER_UP:
+          powerUp();
+          break;
+        case INIT_POWER_DOWN:
+          powerDown();
+          break;
+        case INIT_SEND_COMMAND:
+          sendCommand(op.intArg(0));
+          break;
         }
-    }
-    if(tok.substr(0, 8) == "powerUp:") {
-      powerUp();
-    }
-    if(tok.substr(0, 10) == "powerDown:") {
-      powerDown();
-    }
-    if(tok.substr(0, 12) == "sendCommand:") {
-      uint8_t  mode = (uint8_t)std::stoul(tok.substr(12), nullptr, 0);
-      sendCommand(mode);
-    }
-  }
+    });
 }
 
 BH1750::~BH1750()
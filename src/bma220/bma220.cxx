@@ -16,11 +16,28 @@
 #include <string.h>
 
 #include "bma220.hpp"
-#include "upm_string_parser.hpp"
+#include "upm_init_program.hpp"
 
 using namespace upm;
 using namespace std;
 
+namespace {
+  enum {
+    INIT_ACCEL_SCALE,
+    INIT_FILTER_CONFIG,
+    INIT_SERIAL_HIGH_BW
+  };
+
+  // init string commands.  The registers are at even addresses, so
+  // writes can not be merged into bursts.
+  const InitCommand initCommands[] = {
+    { "writeReg",              "ii", INIT_WRITE8, 0 },
+    { "setAccelerometerScale", "i",  INIT_CALL,   INIT_ACCEL_SCALE },
+    { "setFilterConfig",       "i",  INIT_CALL,   INIT_FILTER_CONFIG },
+    { "setSerialHighBW",       "i",  INIT_CALL,   INIT_SERIAL_HIGH_BW },
+  };
+}
+
 static bool operator!(mraa::MraaIo &mraaIo)
 {
   return mraaIo.getMraaDescriptors() == NULL;
@@ -59,6 +76,10 @@ BMA220::BMA220(int bus, uint8_t addr) :
 
 BMA220::BMA220(std::string initStr) : mraaIo(initStr)
 {
+  // check the init string before touching the device
+  InitProgram::Ptr program =
+    InitProgram::compile(mraaIo.getLeftoverStr(), initCommands);
+
   m_accelX = 0.0;
   m_accelY = 0.0;
   m_accelZ = 0.0;
@@ -83,43 +104,25 @@ BMA220::BMA220(std::string initStr) : mraaIo(initStr)
                               ": Unable to set accel scale");
   }
 
-  std::vector<std::string> upmTokens;
-  if(!mraaIo.getLeftoverStr().empty()) {
-    upmTokens = UpmStringParser::parse(mraaIo.getLeftoverStr());
-  }
-
-  std::string::size_type sz;
-
-  for(std::string tok :upmTokens)
-  {
-    if(tok.substr(0, 9) == "writeReg:") {
-      uint8_t reg = std::stoul(tok.substr(9), &sz, 0);
-      tok = tok.substr(9);
-      uint8_t val = std::stoul(tok.substr(sz+1), nullptr, 0);
-      writeReg(reg, val);
-    }
-    if(tok.substr(0, 22) == "setAccelerometerScale:") {
-      FSL_RANGE_T scale = (FSL_RANGE_T)std::stoi(tok.substr(22), nullptr, 0);
-      setAccelerometerScale(scale);
-    }
-    if(tok.substr(0, 16) == "setFilterConfig:") {
-      FILTER_CONFIG_T filter = (FILTER_CONFIG_T)std::stoi(tok.substr(16), nullptr, 0);
-      setFilterConfig(filter);
-    }
-
-    if(tok.substr(0, 16) == "setSerialHighBW:") {
-      bool high = std::stoi(tok.substr(16), nullptr, 0);
-      setSerialHighBW(high);
-    }
-    if(tok.substr(0, 16) == "setFilterConfig:") {
-      FILTER_CONFIG_T filter = (FILTER_CONFIG_T)std::stoi(tok.substr(16), nullptr, 0);
-      setFilterConfig(filter);
-    }
-    if(tok.substr(0, 16) == "setFilterConfig:") {
-      FILTER_CONFIG_T filter = (FILTER_CONFIG_T)std::stoi(tok.substr(16), nullptr, 0);
-      setFilterConfig(filter);
-    }
-  }
+  program->run(
+    [this](uint8_t reg, const uint8_t *data, size_t len) {
+      for (size_t i = 0; i < len; i++)
+        writeReg(reg + i, data[i]);
+    },
+    [this](const InitOp &op) {
+      switch (op.id)
+        {
+        case INIT_ACCEL_SCALE:
+          setAccelerometerScale((FSL_RANGE_T)op.intArg(0));
+          break;
+        case INIT_FILTER_CONFIG:
+          setFilterConfig((FILTER_CONFIG_T)op.intArg(0));
+          break;
+        case INIT_SERIAL_HIGH_BW:
+          setSerialHighBW(op.intArg(0));
+          break;
+        }
+    });
 }
 
 BMA220::~BMA220()
@@ -216,6 +216,28 @@ upm_result_t bma250e_devinit(const bma250e_context dev,
     return UPM_SUCCESS;
 }
 
+// LSB mask/shift and scaling of the acceleration data registers
+static void _get_data_format(const bma250e_context dev, uint8_t *mask,
+                             uint8_t *shift, float *divisor)
+{
+    switch (dev->resolution)
+    {
+    case BMA250E_RESOLUTION_10BITS:
+        *mask = _BMA250E_ACCD10_LSB_MASK;
+        *shift = _BMA250E_ACCD10_LSB_SHIFT;
+        *divisor = 64.0;
+
+        break;
+
+    case BMA250E_RESOLUTION_12BITS:
+        *mask = _BMA250E_ACCD12_LSB_MASK;
+        *shift = _BMA250E_ACCD12_LSB_SHIFT;
+        *divisor = 16.0;
+
+        break;
+    }
+}
+
 upm_result_t bma250e_update(const bma250e_context dev)
 {
     assert(dev != NULL);
@@ -241,22 +263,7 @@ upm_result_t bma250e_update(const bma250e_context dev)
     uint8_t mask = 0, shift = 0;
     float divisor = 1;
 
-    switch (dev->resolution)
-    {
-    case BMA250E_RESOLUTION_10BITS:
-        mask = _BMA250E_ACCD10_LSB_MASK;
-        shift = _BMA250E_ACCD10_LSB_SHIFT;
-        divisor = 64.0;
-
-        break;
-
-    case BMA250E_RESOLUTION_12BITS:
-        mask = _BMA250E_ACCD12_LSB_MASK;
-        shift = _BMA250E_ACCD12_LSB_SHIFT;
-        divisor = 16.0;
-
-        break;
-    }
+    _get_data_format(dev, &mask, &shift, &divisor);
 
     // x                       msb     lsb
     dev->accX = INT16_TO_FLOAT(buf[1], (buf[0] & (mask << shift))) / divisor;
@@ -287,6 +294,57 @@ upm_result_t bma250e_update(const bma250e_context dev)
     return UPM_SUCCESS;
 }
 
+int bma250e_fifo_read(const bma250e_context dev, float *buffer, int len)
+{
+    assert(dev != NULL);
+
+    if (!dev->fifoAvailable)
+        return -1;
+
+    // 6 byte frames with all three axes, 2 bytes for a single axis
+    uint8_t axes = (bma250e_read_reg(dev, BMA250E_REG_FIFO_CONFIG_1)
+                    >> _BMA250E_FIFO_CONFIG_1_FIFO_DATA_SHIFT)
+        & _BMA250E_FIFO_CONFIG_1_FIFO_DATA_SEL;
+    int values = (axes == BMA250E_FIFO_DATA_SEL_XYZ) ? 3 : 1;
+
+    int frames = (bma250e_read_reg(dev, BMA250E_REG_FIFO_STATUS)
+                  >> _BMA250E_FIFO_STATUS_FRAME_COUNTER_SHIFT)
+        & _BMA250E_FIFO_STATUS_FRAME_COUNTER_MASK;
+
+    if (frames > len / values)
+        frames = len / values;
+
+    if (frames <= 0)
+        return 0;
+
+    // FIFO_DATA does not auto-increment, so a burst read returns
+    // consecutive frames
+    int bufLen = frames * values * 2;
+    uint8_t buf[bufLen];
+
+    if (bma250e_read_regs(dev, BMA250E_REG_FIFO_DATA, buf, bufLen) != bufLen)
+    {
+        printf("%s: bma250e_read_regs() failed to read %d bytes\n",
+               __FUNCTION__, bufLen);
+        return -1;
+    }
+
+    uint8_t mask = 0, shift = 0;
+    float divisor = 1;
+
+    _get_data_format(dev, &mask, &shift, &divisor);
+
+    for (int i = 0; i < frames * values; i++)
+    {
+        float val = INT16_TO_FLOAT(buf[i * 2 + 1],
+                                   (buf[i * 2] & (mask << shift))) / divisor;
+
+        buffer[i] = (val * dev->accScale) / 1000.0;
+    }
+
+    return frames;
+}
+
 void bma250e_enable_fifo(const bma250e_context dev, bool useFIFO)
 {
     assert(dev != NULL);
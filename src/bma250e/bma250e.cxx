@@ -353,6 +353,16 @@ void BMA250E::fifoConfig(BMA250E_FIFO_MODE_T mode,
                                  + ": bma250e_fifo_config() failed");
 }
 
+size_t BMA250E::fifoRead(float *buffer, size_t len)
+{
+    int rv = bma250e_fifo_read(m_bma250e, buffer, (int)len);
+    if (rv < 0)
+        throw std::runtime_error(string(__FUNCTION__)
+                                 + ": bma250e_fifo_read() failed");
+
+    return rv;
+}
+
 void BMA250E::setSelfTest(bool sign, bool amp, BMA250E_SELFTTEST_AXIS_T axis)
 {
     if (bma250e_set_self_test(m_bma250e, sign, amp, axis))
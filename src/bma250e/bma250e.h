@@ -101,6 +101,22 @@ extern "C" {
      */
     upm_result_t bma250e_update(const bma250e_context dev);
 
+    /**
+     * Read all frames currently stored in the FIFO, up to the size of
+     * the supplied buffer, with a single burst read.  The FIFO should
+     * be configured in FIFO or STREAM mode with
+     * bma250e_fifo_config().  Values are in gravities, interleaved as
+     * x, y, z when all axes are selected, otherwise one value per
+     * frame.  bma250e_update() and bma250e_get_accelerometer() are
+     * not affected.
+     *
+     * @param dev The device context.
+     * @param buffer Buffer to store the values in.
+     * @param len Size of the buffer, in floats.
+     * @return The number of frames read, or -1 on error.
+     */
+    int bma250e_fifo_read(const bma250e_context dev, float *buffer, int len);
+
     /**
      * Return the chip ID.
      *
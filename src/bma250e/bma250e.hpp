@@ -258,6 +258,24 @@ namespace upm {
         void fifoConfig(BMA250E_FIFO_MODE_T mode,
                         BMA250E_FIFO_DATA_SEL_T axes);
 
+        /**
+         * Read all frames currently stored in the FIFO, up to the size
+         * of the supplied buffer, with a single burst read.  The FIFO
+         * should be configured in FIFO_MODE_FIFO or FIFO_MODE_STREAM
+         * mode with fifoConfig().  Values are in gravities, interleaved
+         * as x, y, z when all axes are selected, otherwise one value
+         * per frame.
+         *
+         * From Python, the buffer can be any writable float32 buffer
+         * object (e.g. a numpy array), which is filled in place.
+         *
+         * @param buffer Buffer to store the values in.
+         * @param len Size of the buffer, in floats.
+         * @return The number of frames read.
+         * @throws std::runtime_error on failure.
+         */
+        size_t fifoRead(float *buffer, size_t len);
+
         /**
          * Enable, disable, and configure the built in self test on a per
          * axis basis.  See the datasheet for details.
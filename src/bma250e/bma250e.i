@@ -1,5 +1,5 @@
 #ifdef SWIGPYTHON
-%module (package="upm") bma250e
+%module (package="upm", threads="1") bma250e
 #endif
 
 %import "interfaces/interfaces.i"
@@ -9,6 +9,7 @@
 /* BEGIN Java syntax  ------------------------------------------------------- */
 #ifdef SWIGJAVA
 %include "../upm_javastdvector.i"
+%include "../java_buffer.i"
 
 %ignore getAccelerometer(float *, float *, float *);
 %ignore installISR (BMA250E_INTERRUPT_PINS_T, int, mraa::Edge , void *, void *);
@@ -43,8 +44,14 @@ JAVA_JNI_LOADLIBRARY(javaupm_bma250e)
 /* BEGIN Python syntax  ----------------------------------------------------- */
 #ifdef SWIGPYTHON
 %include "../upm_vectortypes.i"
+%include "../python_buffer.i"
 %pointer_functions(int, intp);
 %pointer_functions(float, floatp);
+
+/* Only release the GIL around calls that wait on the bus */
+%nothread;
+%thread upm::BMA250E::update;
+%thread upm::BMA250E::fifoRead;
 #endif
 /* END Python syntax */
 
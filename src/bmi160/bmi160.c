@@ -19,6 +19,7 @@
 #include "bmi160.h"
 
 #include <upm_utilities.h>
+#include <upm_bus_stats.h>
 
 // we have to do it the old skool way.  Note, this also means that
 // only one instance of the bmi160 driver can be active at a time.
@@ -30,6 +31,10 @@ static mraa_gpio_context gpioContext = NULL;
 // whether we are doing I2C or SPI
 static bool isSPI = false;
 
+#if defined(UPM_BUS_STATS)
+static upm_bus_stats_t *busStats = NULL;
+#endif
+
 // Our bmi160 info structure
 struct bmi160_t s_bmi160;
 
@@ -63,15 +68,18 @@ s8 bmi160_bus_read(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt)
         memset((char *)sbuf, 0, cnt + 1);
         sbuf[0] = reg_addr;
 
+        UPM_BUS_STATS_BEGIN(clk);
         bmi160_cs_on();
 
         if (mraa_spi_transfer_buf(spiContext, sbuf, sbuf, cnt + 1))
         {
             bmi160_cs_off();
+            UPM_BUS_STATS_END(busStats, clk, 0, cnt + 1, 0);
             printf("%s: mraa_spi_transfer_buf() failed.\n", __FUNCTION__);
             return 1;
         }
         bmi160_cs_off();
+        UPM_BUS_STATS_END(busStats, clk, cnt, 1, 1);
 
       // now copy it into user buffer
         int i;
@@ -89,7 +97,11 @@ s8 bmi160_bus_read(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt)
         return 1;
     }
 
-    if (mraa_i2c_read_bytes_data(i2cContext, reg_addr, reg_data, cnt) < 0)
+    UPM_BUS_STATS_BEGIN(clk);
+    int rv = mraa_i2c_read_bytes_data(i2cContext, reg_addr, reg_data, cnt);
+    UPM_BUS_STATS_END(busStats, clk, cnt, 1, rv >= 0);
+
+    if (rv < 0)
     {
         printf("%s: mraa_i2c_read_bytes() failed.\n", __FUNCTION__);
         return 1;
@@ -119,15 +131,18 @@ s8 bmi160_bus_write(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt)
         for (i=0; i<cnt; i++)
             sbuf[i + 1] = reg_data[i];
 
+        UPM_BUS_STATS_BEGIN(clk);
         bmi160_cs_on();
 
         if (mraa_spi_transfer_buf(spiContext, sbuf, sbuf, cnt + 1))
         {
             bmi160_cs_off();
+            UPM_BUS_STATS_END(busStats, clk, 0, cnt + 1, 0);
             printf("%s: mraa_spi_transfer_buf() failed.\n", __FUNCTION__);
             return 1;
         }
         bmi160_cs_off();
+        UPM_BUS_STATS_END(busStats, clk, 0, cnt + 1, 1);
 
         return 0;
     }
@@ -146,7 +161,9 @@ s8 bmi160_bus_write(u8 dev_addr, u8 reg_addr, u8 *reg_data, u8 cnt)
     for (i=0; i<cnt; i++)
         buffer[i+1] = reg_data[i];
 
+    UPM_BUS_STATS_BEGIN(clk);
     mraa_result_t rv = mraa_i2c_write(i2cContext, buffer, cnt+1);
+    UPM_BUS_STATS_END(busStats, clk, 0, cnt + 1, rv == MRAA_SUCCESS);
 
     if (rv != MRAA_SUCCESS)
     {
@@ -246,6 +263,8 @@ bmi160_context bmi160_init(unsigned int bus, int address, int cs_pin,
         }
     }
 
+    UPM_BUS_STATS_REGISTER(busStats, "bmi160", bus, isSPI ? -1 : address);
+
     // init the driver interface functions
     s_bmi160.bus_write = bmi160_bus_write;
     s_bmi160.bus_read = bmi160_bus_read;
@@ -333,6 +352,8 @@ void bmi160_close(bmi160_context dev)
         mraa_gpio_close(gpioContext);
     gpioContext = NULL;
 
+    UPM_BUS_STATS_UNREGISTER(busStats);
+
     free(dev);
 }
 
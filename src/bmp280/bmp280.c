@@ -50,6 +50,30 @@ void _csOff(const bmp280_context dev)
         mraa_gpio_write(dev->gpio, 1);
 }
 
+// register access for the shadow register cache
+static upm_result_t _read_reg_cb(void *ctx, uint8_t reg, uint8_t *val)
+{
+    if (bmp280_read_regs((bmp280_context)ctx, reg, val, 1) != 1)
+        return UPM_ERROR_OPERATION_FAILED;
+
+    return UPM_SUCCESS;
+}
+
+static upm_result_t _write_reg_cb(void *ctx, uint8_t reg, uint8_t val)
+{
+    return bmp280_write_reg((bmp280_context)ctx, reg, val);
+}
+
+// update a bitfield in a control register, using the shadow register
+// cache to avoid bus round trips
+static upm_result_t _update_bits(const bmp280_context dev, uint8_t reg,
+                                 uint8_t mask, uint8_t shift, uint8_t val)
+{
+    return upm_reg_cache_update_bits(&dev->reg_cache, reg, mask << shift,
+                                     val << shift, _read_reg_cb,
+                                     _write_reg_cb, dev);
+}
+
 // These functions come from the BMP280 datasheet, section 3.11.3
 
 // Returns temperature in DegC, resolution is 0.01 DegC. Output value
@@ -219,6 +243,17 @@ bmp280_context bmp280_init(int bus, int addr, int cs)
     // zero out context
     memset((void *)dev, 0, sizeof(struct _bmp280_context));
 
+    // the control registers only change when we write them.  The
+    // mode bits in ctrl_meas are the exception, handled in
+    // bmp280_set_measure_mode().
+    upm_reg_cache_init(&dev->reg_cache);
+    upm_reg_cache_set_nonvolatile(&dev->reg_cache, BMP280_REG_CHIPID,
+                                  BMP280_REG_CHIPID);
+    upm_reg_cache_set_nonvolatile(&dev->reg_cache, BME280_REG_CTRL_HUM,
+                                  BME280_REG_CTRL_HUM);
+    upm_reg_cache_set_nonvolatile(&dev->reg_cache, BMP280_REG_CTRL_MEAS,
+                                  BMP280_REG_CONFIG);
+
     // make sure MRAA is initialized
     if (mraa_init() != MRAA_SUCCESS)
     {
@@ -285,6 +320,8 @@ bmp280_context bmp280_init(int bus, int addr, int cs)
         }
     }
 
+    UPM_BUS_STATS_REGISTER(dev->bus_stats, "bmp280", bus, addr);
+
     // check the chip id
 
     uint8_t chipID = bmp280_read_reg(dev, BMP280_REG_CHIPID);
@@ -340,6 +377,8 @@ void bmp280_close(bmp280_context dev)
     if (dev->gpio)
         mraa_gpio_close(dev->gpio);
 
+    UPM_BUS_STATS_UNREGISTER(dev->bus_stats);
+
     free(dev);
 }
 
@@ -442,27 +481,42 @@ uint8_t bmp280_read_reg(const bmp280_context dev, uint8_t reg)
 {
     assert(dev != NULL);
 
+    uint8_t val;
+    if (upm_reg_cache_get(&dev->reg_cache, reg, &val))
+        return val;
+
     if (dev->isSPI)
     {
-        reg |= 0x80; // needed for read
-        uint8_t pkt[2] = {reg, 0};
+        uint8_t pkt[2] = {(uint8_t)(reg | 0x80), 0}; // 0x80 needed for read
 
+        UPM_BUS_STATS_BEGIN(clk);
         _csOn(dev);
         if (mraa_spi_transfer_buf(dev->spi, pkt, pkt, 2))
         {
             _csOff(dev);
+            UPM_BUS_STATS_END(dev->bus_stats, clk, 0, 2, 0);
             printf("%s: mraa_spi_transfer_buf() failed.",
                    __FUNCTION__);
 
             return 0xff;
         }
         _csOff(dev);
+        UPM_BUS_STATS_END(dev->bus_stats, clk, 1, 1, 1);
+
+        upm_reg_cache_put(&dev->reg_cache, reg, pkt[1]);
 
         return pkt[1];
     }
     else
     {
-        return (uint8_t)mraa_i2c_read_byte_data(dev->i2c, reg);
+        UPM_BUS_STATS_BEGIN(clk);
+        int rv = mraa_i2c_read_byte_data(dev->i2c, reg);
+        UPM_BUS_STATS_END(dev->bus_stats, clk, 1, 1, rv >= 0);
+
+        if (rv >= 0)
+            upm_reg_cache_put(&dev->reg_cache, reg, (uint8_t)rv);
+
+        return (uint8_t)rv;
     }
 }
 
@@ -484,16 +538,19 @@ int bmp280_read_regs(const bmp280_context dev,
         // to, since we have no control over CS.  This means a buffer
         // copy is now required, but that's the way it goes.
 
+        UPM_BUS_STATS_BEGIN(clk);
         _csOn(dev);
         if (mraa_spi_transfer_buf(dev->spi, sbuf, sbuf, len + 1))
         {
             _csOff(dev);
+            UPM_BUS_STATS_END(dev->bus_stats, clk, 0, len + 1, 0);
             printf("%s: mraa_spi_transfer_buf() failed.",
                    __FUNCTION__);
 
             return 0;
         }
         _csOff(dev);
+        UPM_BUS_STATS_END(dev->bus_stats, clk, len, 1, 1);
 
         // now copy it into user buffer
         for (int i=0; i<len; i++)
@@ -501,7 +558,11 @@ int bmp280_read_regs(const bmp280_context dev,
     }
     else
     {
-        if (mraa_i2c_read_bytes_data(dev->i2c, reg, buffer, len) != len)
+        UPM_BUS_STATS_BEGIN(clk);
+        int rv = mraa_i2c_read_bytes_data(dev->i2c, reg, buffer, len);
+        UPM_BUS_STATS_END(dev->bus_stats, clk, len, 1, rv == len);
+
+        if (rv != len)
             return UPM_ERROR_OPERATION_FAILED;
     }
 
@@ -515,30 +576,40 @@ upm_result_t bmp280_write_reg(const bmp280_context dev,
 
     if (dev->isSPI)
     {
-        reg &= 0x7f; // mask off 0x80 for writing
-        uint8_t pkt[2] = {reg, val};
+        uint8_t pkt[2] = {(uint8_t)(reg & 0x7f), val}; // mask off 0x80 for writing
 
+        UPM_BUS_STATS_BEGIN(clk);
         _csOn(dev);
         if (mraa_spi_transfer_buf(dev->spi, pkt, NULL, 2))
         {
             _csOff(dev);
+            UPM_BUS_STATS_END(dev->bus_stats, clk, 0, 2, 0);
+            upm_reg_cache_invalidate(&dev->reg_cache, reg);
             printf("%s: mraa_spi_transfer_buf() failed.",
                    __FUNCTION__);
 
             return UPM_ERROR_OPERATION_FAILED;
         }
         _csOff(dev);
+        UPM_BUS_STATS_END(dev->bus_stats, clk, 0, 2, 1);
     }
     else
     {
-        if (mraa_i2c_write_byte_data(dev->i2c, val, reg))
+        UPM_BUS_STATS_BEGIN(clk);
+        mraa_result_t rv = mraa_i2c_write_byte_data(dev->i2c, val, reg);
+        UPM_BUS_STATS_END(dev->bus_stats, clk, 0, 2, rv == MRAA_SUCCESS);
+
+        if (rv)
         {
+            upm_reg_cache_invalidate(&dev->reg_cache, reg);
             printf("%s: mraa_i2c_write_byte_data() failed.",
                    __FUNCTION__);
             return UPM_ERROR_OPERATION_FAILED;
         }
     }
 
+    upm_reg_cache_put(&dev->reg_cache, reg, val);
+
     return UPM_SUCCESS;
 }
 
@@ -554,6 +625,7 @@ void bmp280_reset(const bmp280_context dev)
     assert(dev != NULL);
 
     bmp280_write_reg(dev, BMP280_REG_RESET, BMP280_RESET_BYTE);
+    upm_reg_cache_invalidate_all(&dev->reg_cache);
     upm_delay(1);
 }
 
@@ -586,12 +658,8 @@ void bmp280_set_filter(const bmp280_context dev, BMP280_FILTER_T filter)
 {
     assert(dev != NULL);
 
-    uint8_t reg = bmp280_read_reg(dev, BMP280_REG_CONFIG);
-
-    reg &= ~(_BMP280_CONFIG_FILTER_MASK << _BMP280_CONFIG_FILTER_SHIFT);
-    reg |= (filter << _BMP280_CONFIG_FILTER_SHIFT);
-
-    bmp280_write_reg(dev, BMP280_REG_CONFIG, reg);
+    _update_bits(dev, BMP280_REG_CONFIG, _BMP280_CONFIG_FILTER_MASK,
+                 _BMP280_CONFIG_FILTER_SHIFT, filter);
 }
 
 void bmp280_set_timer_standby(const bmp280_context dev,
@@ -599,12 +667,8 @@ void bmp280_set_timer_standby(const bmp280_context dev,
 {
     assert(dev != NULL);
 
-    uint8_t reg = bmp280_read_reg(dev, BMP280_REG_CONFIG);
-
-    reg &= ~(_BMP280_CONFIG_T_SB_MASK << _BMP280_CONFIG_T_SB_SHIFT);
-    reg |= (tsb << _BMP280_CONFIG_T_SB_SHIFT);
-
-    bmp280_write_reg(dev, BMP280_REG_CONFIG, reg);
+    _update_bits(dev, BMP280_REG_CONFIG, _BMP280_CONFIG_T_SB_MASK,
+                 _BMP280_CONFIG_T_SB_SHIFT, tsb);
 }
 
 void bmp280_set_measure_mode(const bmp280_context dev,
@@ -612,13 +676,20 @@ void bmp280_set_measure_mode(const bmp280_context dev,
 {
     assert(dev != NULL);
 
-    uint8_t reg = bmp280_read_reg(dev, BMP280_REG_CTRL_MEAS);
-
-    reg &= ~(_BMP280_CTRL_MEAS_MODE_MASK << _BMP280_CTRL_MEAS_MODE_SHIFT);
-    reg |= (mode << _BMP280_CTRL_MEAS_MODE_SHIFT);
-
-    bmp280_write_reg(dev, BMP280_REG_CTRL_MEAS, reg);
+    _update_bits(dev, BMP280_REG_CTRL_MEAS, _BMP280_CTRL_MEAS_MODE_MASK,
+                 _BMP280_CTRL_MEAS_MODE_SHIFT, mode);
     dev->mode = mode;
+
+    // the device drops back to sleep mode once a forced measurement
+    // completes, so that is what the shadow copy should hold
+    uint8_t reg;
+    if (mode == BMP280_MODE_FORCED
+        && upm_reg_cache_get(&dev->reg_cache, BMP280_REG_CTRL_MEAS, &reg))
+    {
+        reg &= ~(_BMP280_CTRL_MEAS_MODE_MASK << _BMP280_CTRL_MEAS_MODE_SHIFT);
+        reg |= (BMP280_MODE_SLEEP << _BMP280_CTRL_MEAS_MODE_SHIFT);
+        upm_reg_cache_put(&dev->reg_cache, BMP280_REG_CTRL_MEAS, reg);
+    }
 }
 
 void bmp280_set_oversample_rate_pressure(const bmp280_context dev,
@@ -626,12 +697,8 @@ void bmp280_set_oversample_rate_pressure(const bmp280_context dev,
 {
     assert(dev != NULL);
 
-    uint8_t reg = bmp280_read_reg(dev, BMP280_REG_CTRL_MEAS);
-
-    reg &= ~(_BMP280_CTRL_MEAS_OSRS_P_MASK << _BMP280_CTRL_MEAS_OSRS_P_SHIFT);
-    reg |= (rate << _BMP280_CTRL_MEAS_OSRS_P_SHIFT);
-
-    bmp280_write_reg(dev, BMP280_REG_CTRL_MEAS, reg);
+    _update_bits(dev, BMP280_REG_CTRL_MEAS, _BMP280_CTRL_MEAS_OSRS_P_MASK,
+                 _BMP280_CTRL_MEAS_OSRS_P_SHIFT, rate);
 }
 
 void bmp280_set_oversample_rate_temperature(const bmp280_context dev,
@@ -639,12 +706,8 @@ void bmp280_set_oversample_rate_temperature(const bmp280_context dev,
 {
     assert(dev != NULL);
 
-    uint8_t reg = bmp280_read_reg(dev, BMP280_REG_CTRL_MEAS);
-
-    reg &= ~(_BMP280_CTRL_MEAS_OSRS_T_MASK << _BMP280_CTRL_MEAS_OSRS_T_SHIFT);
-    reg |= (rate << _BMP280_CTRL_MEAS_OSRS_T_SHIFT);
-
-    bmp280_write_reg(dev, BMP280_REG_CTRL_MEAS, reg);
+    _update_bits(dev, BMP280_REG_CTRL_MEAS, _BMP280_CTRL_MEAS_OSRS_T_MASK,
+                 _BMP280_CTRL_MEAS_OSRS_T_SHIFT, rate);
 }
 
 // bme280 only
@@ -655,12 +718,8 @@ void bmp280_set_oversample_rate_humidity(const bmp280_context dev,
 
     if (dev->isBME)
     {
-        uint8_t reg = bmp280_read_reg(dev, BME280_REG_CTRL_HUM);
-
-        reg &= ~(_BME280_CTRL_HUM_OSRS_H_MASK << _BME280_CTRL_HUM_OSRS_H_SHIFT);
-        reg |= (rate << _BME280_CTRL_HUM_OSRS_H_SHIFT);
-
-        bmp280_write_reg(dev, BME280_REG_CTRL_HUM, reg);
+        _update_bits(dev, BME280_REG_CTRL_HUM, _BME280_CTRL_HUM_OSRS_H_MASK,
+                     _BME280_CTRL_HUM_OSRS_H_SHIFT, rate);
     }
 }
 
@@ -16,6 +16,8 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <upm.h>
+#include <upm_bus_stats.h>
+#include <upm_reg_cache.h>
 
 #include <mraa/i2c.h>
 #include <mraa/spi.h>
@@ -92,6 +94,12 @@ extern "C" {
         int16_t dig_H4;
         int16_t dig_H5;
         int8_t dig_H6;
+
+        // bus statistics, if enabled
+        upm_bus_stats_t *bus_stats;
+
+        // shadow copies of the control registers
+        upm_reg_cache_t reg_cache;
     } *bmp280_context;
 
     /**
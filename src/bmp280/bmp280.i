@@ -17,6 +17,11 @@ JAVA_JNI_LOADLIBRARY(javaupm_bmp280)
 /* END Java syntax */
 
 /* BEGIN Javascript syntax  ------------------------------------------------- */
+#ifdef SWIGJAVASCRIPT
+%include "../node_async.i"
+
+UPM_NODE_ASYNC(upm::BMP280, update)
+#endif
 /* END Javascript syntax */
 
 /* BEGIN Python syntax  ----------------------------------------------------- */
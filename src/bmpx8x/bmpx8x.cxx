@@ -21,11 +21,23 @@
 #include <stdlib.h>
 
 #include "bmpx8x.hpp"
-#include "upm_string_parser.hpp"
+#include "upm_init_program.hpp"
 
 using namespace upm;
 using namespace std;
 
+namespace {
+  enum {
+    INIT_OVERSAMPLING
+  };
+
+  // init string commands
+  const InitCommand initCommands[] = {
+    { "setOversampling", "i",  INIT_CALL,   INIT_OVERSAMPLING },
+    { "writeReg",        "ii", INIT_WRITE8, 0 },
+  };
+}
+
 BMPX8X::BMPX8X (int bus, int addr) :
     m_bmpx8x(bmpx8x_init(bus, addr))
 {
@@ -37,11 +49,10 @@ BMPX8X::BMPX8X (int bus, int addr) :
 BMPX8X::BMPX8X(std::string initStr) : mraaIo(initStr)
 {
     mraa_io_descriptor* descs = mraaIo.getMraaDescriptors();
-    std::vector<std::string> upmTokens;
 
-    if(!mraaIo.getLeftoverStr().empty()) {
-        upmTokens = UpmStringParser::parse(mraaIo.getLeftoverStr());
-    }
+    // check the init string before allocating anything
+    InitProgram::Ptr program =
+        InitProgram::compile(mraaIo.getLeftoverStr(), initCommands);
 
     m_bmpx8x = (bmpx8x_context)malloc(sizeof(struct _bmpx8x_context));
     if(!m_bmpx8x) {
@@ -90,19 +101,15 @@ BMPX8X::BMPX8X(std::string initStr) : mraaIo(initStr)
                                  + ": bmpx8x_init() failed");
     }
 
-    std::string::size_type sz;
-    for(std::string tok : upmTokens) {
-        if(tok.substr(0, 16) == "setOversampling:") {
-           BMPX8X_OSS_T oss = (BMPX8X_OSS_T)std::stoi(tok.substr(16), nullptr, 0);
-           setOversampling(oss);
-        }
-        if(tok.substr(0, 9) == "writeReg:") {
-            uint8_t reg = std::stoul(tok.substr(9), &sz, 0);
-            tok = tok.substr(9);
-            uint8_t val = std::stoul(tok.substr(sz+1), nullptr, 0);
-            writeReg(reg, val);
-        }
-    }
+    program->run(
+        [this](uint8_t reg, const uint8_t *data, size_t len) {
+            for (size_t i = 0; i < len; i++)
+                writeReg(reg + i, data[i]);
+        },
+        [this](const InitOp &op) {
+            if (op.id == INIT_OVERSAMPLING)
+                setOversampling((BMPX8X_OSS_T)op.intArg(0));
+        });
 }
 
 
@@ -15,6 +15,7 @@
 #include <assert.h>
 
 #include <upm_utilities.h>
+#include <upm_cal_store.h>
 
 #include "bno055.h"
 
@@ -23,6 +24,24 @@
     (float)( (int16_t)( (l) | ((h) << 8) ) )
 
 
+// Start a settle time, e.g. after a mode change.  Instead of sleeping
+// here, the next bus access waits for it, so the caller can do other
+// work in between.
+static void _settle(const bno055_context dev, uint32_t us)
+{
+    dev->ready = upm_clock_deadline_us(us);
+    dev->settling = true;
+}
+
+static void _wait_ready(const bno055_context dev)
+{
+    if (dev->settling)
+    {
+        upm_delay_until_ns(&dev->ready, 0);
+        dev->settling = false;
+    }
+}
+
 // clear internal data items
 static void _clear_data(const bno055_context dev)
 {
@@ -112,6 +131,26 @@ static upm_result_t _update_non_fusion_data(const bno055_context dev)
     return UPM_SUCCESS;
 }
 
+// save the calibration data once the device becomes fully calibrated
+static void _refresh_calibration(const bno055_context dev)
+{
+    dev->cal_checked = upm_clock_init();
+
+    if (!bno055_is_fully_calibrated(dev))
+    {
+        dev->cal_saved = false;
+        return;
+    }
+
+    if (dev->cal_saved)
+        return;
+
+    uint8_t data[BNO055_CALIBRATION_DATA_SIZE];
+    if (!bno055_read_calibration_data(dev, data, sizeof(data))
+        && !upm_cal_store_save_async(dev->cal_key, data, sizeof(data)))
+        dev->cal_saved = true;
+}
+
 // init
 bno055_context bno055_init(int bus, uint8_t addr, mraa_io_descriptor* descs)
 {
@@ -168,6 +207,8 @@ bno055_context bno055_init(int bus, uint8_t addr, mraa_io_descriptor* descs)
         }
     }
 
+    UPM_BUS_STATS_REGISTER(dev->bus_stats, "bno055", bus, addr);
+
     _clear_data(dev);
 
     // forcibly set page 0, so we are synced with the device
@@ -221,6 +262,20 @@ bno055_context bno055_init(int bus, uint8_t addr, mraa_io_descriptor* descs)
     // set Euler units to degrees
     urv += bno055_set_euler_units(dev, false);
 
+    // restore saved calibration while still in config mode
+    if (!descs && upm_cal_store_enabled())
+    {
+        char key[64];
+        snprintf(key, sizeof(key), "bno055/%02x/i2c-%d/%02x", chipID, bus,
+                 addr);
+        // restoring only saves relearning the calibration, so a bad
+        // or unreadable entry must not make the device unusable
+        upm_result_t crv = bno055_set_calibration_store(dev, key);
+        if (crv != UPM_SUCCESS)
+            printf("%s: Restoring calibration for %s failed (%d), "
+                   "continuing uncalibrated\n", __FUNCTION__, key, (int)crv);
+    }
+
     // by default, we set the operating mode to the NDOF fusion mode
     urv += bno055_set_operation_mode(dev, BNO055_OPERATION_MODE_NDOF);
 
@@ -244,6 +299,8 @@ void bno055_close(bno055_context dev)
     if (dev->i2c)
         mraa_i2c_stop(dev->i2c);
 
+    UPM_BUS_STATS_UNREGISTER(dev->bus_stats);
+
     free(dev);
 }
 
@@ -266,6 +323,9 @@ upm_result_t bno055_update(const bno055_context dev)
     if (_update_non_fusion_data(dev))
         return UPM_ERROR_OPERATION_FAILED;
 
+    if (dev->cal_key[0] && upm_elapsed_ms(&dev->cal_checked) >= 1000)
+        _refresh_calibration(dev);
+
     return UPM_SUCCESS;
 }
 
@@ -274,7 +334,12 @@ upm_result_t bno055_read_reg(const bno055_context dev, uint8_t reg,
 {
     assert(dev != NULL);
 
+    _wait_ready(dev);
+
+    UPM_BUS_STATS_BEGIN(clk);
     int rv = mraa_i2c_read_byte_data(dev->i2c, reg);
+    UPM_BUS_STATS_END(dev->bus_stats, clk, 1, 1, rv >= 0);
+
     if (rv < 0)
     {
         printf("%s: mraa_i2c_read_byte_data() failed\n",
@@ -293,7 +358,13 @@ upm_result_t bno055_read_regs(const bno055_context dev, uint8_t reg,
 {
     assert(dev != NULL);
 
-    if (mraa_i2c_read_bytes_data(dev->i2c, reg, buffer, len) < 0)
+    _wait_ready(dev);
+
+    UPM_BUS_STATS_BEGIN(clk);
+    int rv = mraa_i2c_read_bytes_data(dev->i2c, reg, buffer, len);
+    UPM_BUS_STATS_END(dev->bus_stats, clk, (int)len, 1, rv >= 0);
+
+    if (rv < 0)
     {
         printf("%s: mraa_i2c_read_bytes() failed\n",
                __FUNCTION__);
@@ -308,7 +379,13 @@ upm_result_t bno055_write_reg(const bno055_context dev,
 {
     assert(dev != NULL);
 
-    if (mraa_i2c_write_byte_data(dev->i2c, val, reg))
+    _wait_ready(dev);
+
+    UPM_BUS_STATS_BEGIN(clk);
+    mraa_result_t rv = mraa_i2c_write_byte_data(dev->i2c, val, reg);
+    UPM_BUS_STATS_END(dev->bus_stats, clk, 0, 2, rv == MRAA_SUCCESS);
+
+    if (rv)
     {
         printf("%s: mraa_i2c_write_byte_data() failed\n",
                __FUNCTION__);
@@ -323,13 +400,19 @@ upm_result_t bno055_write_regs(const bno055_context dev, uint8_t reg,
 {
     assert(dev != NULL);
 
+    _wait_ready(dev);
+
     uint8_t buf[len + 1];
 
     buf[0] = reg;
     for (size_t i=0; i<len; i++)
         buf[i+1] = buffer[i];
 
-    if (mraa_i2c_write(dev->i2c, buf, len + 1))
+    UPM_BUS_STATS_BEGIN(clk);
+    mraa_result_t rv = mraa_i2c_write(dev->i2c, buf, len + 1);
+    UPM_BUS_STATS_END(dev->bus_stats, clk, 0, (int)len + 1, rv == MRAA_SUCCESS);
+
+    if (rv)
     {
         printf("%s: mraa_i2c_write() failed\n",
                __FUNCTION__);
@@ -590,7 +673,8 @@ upm_result_t bno055_set_operation_mode(const bno055_context dev,
 
     dev->currentMode = mode;
 
-    upm_delay_us(30);
+    // switching into config mode takes 19ms, out of it 7ms
+    _settle(dev, (mode == BNO055_OPERATION_MODE_CONFIGMODE) ? 19000 : 7000);
 
     return UPM_SUCCESS;
 }
@@ -660,7 +744,7 @@ upm_result_t bno055_reset_system(const bno055_context dev)
     if (bno055_write_reg(dev, BNO055_REG_SYS_TRIGGER, reg))
         return UPM_ERROR_OPERATION_FAILED;
 
-    upm_delay(1);
+    _settle(dev, 1000000);
 
     return UPM_SUCCESS;
 }
@@ -847,6 +931,39 @@ upm_result_t bno055_write_calibration_data(const bno055_context dev,
     return UPM_SUCCESS;
 }
 
+upm_result_t bno055_set_calibration_store(const bno055_context dev,
+                                          const char *key)
+{
+    assert(dev != NULL);
+
+    if (!key)
+    {
+        dev->cal_key[0] = 0;
+        return UPM_SUCCESS;
+    }
+
+    if (strlen(key) >= sizeof(dev->cal_key))
+        return UPM_ERROR_INVALID_PARAMETER;
+
+    strcpy(dev->cal_key, key);
+    dev->cal_saved = false;
+    dev->cal_checked = upm_clock_init();
+
+    // the device keeps its calibration until power is lost, don't
+    // overwrite a good one
+    if (bno055_is_fully_calibrated(dev))
+        return UPM_SUCCESS;
+
+    uint8_t data[BNO055_CALIBRATION_DATA_SIZE];
+    upm_result_t rv = upm_cal_store_load(key, data, sizeof(data));
+    if (rv == UPM_ERROR_NO_DATA)
+        return UPM_SUCCESS;
+    if (rv)
+        return rv;
+
+    return bno055_write_calibration_data(dev, data, sizeof(data));
+}
+
 float bno055_get_temperature(const bno055_context dev)
 {
     assert(dev != NULL);
@@ -12,10 +12,12 @@
  */
 
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 
 #include "bno055.hpp"
 #include "upm_string_parser.hpp"
+#include "upm_cal_store.h"
 
 using namespace upm;
 using namespace std;
@@ -50,6 +52,37 @@ BNO055::BNO055(std::string initStr) : mraaIo(initStr)
         throw std::runtime_error(string(__FUNCTION__)
                                  + ": bno055_init() failed");
 
+    // bno055_init() can't tell where the device is when given
+    // descriptors, name the store key from the "i:<bus>:<addr>" token
+    if (upm_cal_store_enabled())
+    {
+        std::istringstream in(initStr);
+        std::string tok;
+        while (std::getline(in, tok, ','))
+        {
+            int bus, addr;
+            if (sscanf(tok.c_str(), "i:%i:%i", &bus, &addr) == 2)
+            {
+                char key[64];
+                snprintf(key, sizeof(key), "bno055/%02x/i2c-%d/%02x",
+                         BNO055_CHIPID, bus, addr);
+                // as in bno055_init(), a bad or unreadable entry must
+                // not make the device unusable
+                try
+                {
+                    setCalibrationStore(key);
+                }
+                catch (std::runtime_error& e)
+                {
+                    cerr << __FUNCTION__ << ": Restoring calibration for "
+                         << key << " failed, continuing uncalibrated: "
+                         << e.what() << endl;
+                }
+                break;
+            }
+        }
+    }
+
     std::string::size_type sz, prev_sz;
     for(std::string tok : upmTokens)
     {
@@ -411,6 +444,14 @@ void BNO055::writeCalibrationData(vector<uint8_t> calibrationData)
                                  + ": bno055_write_calibration_data() failed");
 }
 
+void BNO055::setCalibrationStore(std::string key)
+{
+    if (bno055_set_calibration_store(m_bno055,
+                                     key.empty() ? nullptr : key.c_str()))
+        throw std::runtime_error(string(__FUNCTION__)
+                                 + ": bno055_set_calibration_store() failed");
+}
+
 float BNO055::getTemperature(bool fahrenheit)
 {
     float temperature = bno055_get_temperature(m_bno055);
@@ -16,6 +16,7 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <upm.h>
+#include <upm_bus_stats.h>
 
 #include <mraa/i2c.h>
 #include <mraa/gpio.h>
@@ -94,6 +95,20 @@ extern "C" {
         float grvX;
         float grvY;
         float grvZ;
+
+        // bus statistics, if enabled
+        upm_bus_stats_t *bus_stats;
+
+        // a reset or mode change in progress, the device is not to
+        // be accessed before ready
+        bool settling;
+        upm_clock_t ready;
+
+        // calibration store key, empty if not used, and when the
+        // calibration status was last checked
+        char cal_key[64];
+        upm_clock_t cal_checked;
+        bool cal_saved;
     } *bno055_context;
 
     /**
@@ -228,6 +243,10 @@ extern "C" {
      * modes.  The device must be in config mode for most
      * configuration operations.  See the datasheet for details.
      *
+     * The switch takes up to 19ms.  This function returns right away
+     * and the next access to the device waits for the rest of that
+     * time.
+     *
      * @param dev The device context.
      * @param mode One of the OPERATION_MODES_T values.
      * @return UPM result.
@@ -238,7 +257,8 @@ extern "C" {
     /**
      * Reboot the sensor.  This is equivalent to a power on reset.
      * All calibration data will be lost, and the device must be
-     * re-calibrated.
+     * re-calibrated.  As with mode changes, the next access to the
+     * device waits for the reboot to finish.
      *
      * @param dev The device context.
      * @return UPM result.
@@ -306,6 +326,24 @@ extern "C" {
                                                uint8_t *data,
                                                size_t len);
 
+    /**
+     * Keep the calibration data of this device in the calibration
+     * store (see upm_cal_store.h).  Unless the device is already fully
+     * calibrated, calibration data saved under the key is restored
+     * right away.  From then on, bno055_update() checks the
+     * calibration status about once a second and saves the data each
+     * time the device becomes fully calibrated.
+     *
+     * bno055_init() does this by itself when the store is enabled,
+     * with the key "bno055/<chip id>/i2c-<bus>/<address>".
+     *
+     * @param dev The device context.
+     * @param key The device key, or NULL to stop using the store.
+     * @return UPM result.
+     */
+    upm_result_t bno055_set_calibration_store(const bno055_context dev,
+                                              const char *key);
+
     /**
      * Return the current measured temperature.  Note, this is not
      * ambient temperature - this is the temperature of the selected
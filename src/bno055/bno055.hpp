@@ -281,6 +281,20 @@ namespace upm {
          */
         void writeCalibrationData(std::vector<uint8_t> calibrationData);
 
+        /**
+         * Keep the calibration data of this device in the calibration
+         * store (see upm_cal_store.h).  Unless the device is already
+         * fully calibrated, calibration data saved under the key is
+         * restored right away, and update() saves the data again each
+         * time the device becomes fully calibrated.  The constructors
+         * do this by themselves when the store is enabled.
+         *
+         * @param key The device key, e.g. "bno055/a0/i2c-1/28", or an
+         * empty string to stop using the store.
+         * @throws std::runtime_error on failure.
+         */
+        void setCalibrationStore(std::string key);
+
         /**
          * Return the current measured temperature.  Note, this is not
          * ambient temperature - this is the temperature of the selected
@@ -13,10 +13,23 @@
 #include <stdexcept>
 
 #include "dfrph.hpp"
-#include "upm_string_parser.hpp"
+#include "upm_init_program.hpp"
 
 using namespace upm;
 
+namespace {
+    enum {
+        INIT_OFFSET,
+        INIT_SCALE
+    };
+
+    // init string commands
+    const InitCommand initCommands[] = {
+        { "setOffset", "f", INIT_CALL, INIT_OFFSET },
+        { "setScale",  "f", INIT_CALL, INIT_SCALE },
+    };
+}
+
 DFRPH::DFRPH(int pin, float vref) : _dev(dfrph_init(pin))
 {
     if (_dev == NULL)
@@ -27,12 +40,11 @@ DFRPH::DFRPH(int pin, float vref) : _dev(dfrph_init(pin))
 DFRPH::DFRPH(std::string initStr) : mraaIo(initStr)
 {
     mraa_io_descriptor* descs = mraaIo.getMraaDescriptors();
-    std::vector<std::string> upmTokens;
 
-    if(!mraaIo.getLeftoverStr().empty()) {
-        upmTokens = UpmStringParser::parse(mraaIo.getLeftoverStr());
-    }
-    
+    // check the init string before allocating anything
+    InitProgram::Ptr program =
+        InitProgram::compile(mraaIo.getLeftoverStr(), initCommands);
+
     _dev = (dfrph_context) malloc(sizeof(struct _dfrph_context));
 
     if(!_dev)
@@ -69,16 +81,14 @@ DFRPH::DFRPH(std::string initStr) : mraaIo(initStr)
     _dev->m_offset = 0.0;
     _dev->m_scale = 1.0; 
     
-    for (std::string tok : upmTokens) {
-        if(tok.substr(0,10) == "setOffset:") {
-          float offset = std::stof(tok.substr(10));
-          setOffset(offset);
-        }
-        if(tok.substr(0,9) == "setScale:") {
-          float scale = std::stof(tok.substr(9));
-          setScale(scale);
-        }
-    }    
+    program->run(
+        [](uint8_t, const uint8_t *, size_t) {},
+        [this](const InitOp &op) {
+            if (op.id == INIT_OFFSET)
+                setOffset(op.floatArg(0));
+            else if (op.id == INIT_SCALE)
+                setScale(op.floatArg(0));
+        });
 }
 
 DFRPH::~DFRPH()
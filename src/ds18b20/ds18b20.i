@@ -6,6 +6,14 @@ JAVA_JNI_LOADLIBRARY(javaupm_ds18b20)
 #endif
 /* END Java syntax */
 
+/* BEGIN Javascript syntax  ------------------------------------------------- */
+#ifdef SWIGJAVASCRIPT
+%include "../node_async.i"
+
+UPM_NODE_ASYNC(upm::DS18B20, update)
+#endif
+/* END Javascript syntax */
+
 /* BEGIN Common SWIG syntax ------------------------------------------------- */
 %include "carrays.i"
 %{
@@ -19,6 +19,14 @@
 
 using namespace upm;
 
+static upm_result_t readAio (void *ctx, float *value) {
+    int x = mraa_aio_read ((mraa_aio_context) ctx);
+    if (x == -1)
+        return UPM_ERROR_OPERATION_FAILED;
+    *value = x;
+    return UPM_SUCCESS;
+}
+
 ECS1030::ECS1030 (int pinNumber) {
     m_dataPinCtx = mraa_aio_init(pinNumber);
     if (m_dataPinCtx == NULL) {
@@ -26,6 +34,14 @@ ECS1030::ECS1030 (int pinNumber) {
                                   ": mraa_aio_init() failed");
     }
 
+    m_sampler = upm_aio_sampler_init (readAio, m_dataPinCtx, SAMPLE_RATE_HZ,
+                                      NUMBER_OF_SAMPLES);
+    if (m_sampler == NULL) {
+      mraa_aio_close (m_dataPinCtx);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": upm_aio_sampler_init() failed");
+    }
+
     m_calibration = 111.1;
 }
 
@@ -39,54 +55,64 @@ ECS1030::ECS1030 (std::string initStr) : mraaIo(initStr) {
     m_dataPinCtx = descs->aios[0];
   }
 
+  m_sampler = upm_aio_sampler_init (readAio, m_dataPinCtx, SAMPLE_RATE_HZ,
+                                    NUMBER_OF_SAMPLES);
+  if (m_sampler == NULL) {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": upm_aio_sampler_init() failed");
+  }
+
   m_calibration = 111.1;
 }
 
 ECS1030::~ECS1030 () {
     mraa_result_t error = MRAA_SUCCESS;
 
+    upm_aio_sampler_close (m_sampler);
+
     error = mraa_aio_close (m_dataPinCtx);
     if (error != MRAA_SUCCESS) {
     }
 }
 
+void
+ECS1030::setSampleRate (float rateHz) {
+    if (upm_aio_sampler_set_rate (m_sampler, rateHz) != UPM_SUCCESS)
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": Invalid sample rate");
+}
+
+void
+ECS1030::sample (upm_aio_stats_t &stats) {
+    upm_aio_sampler_reset_stats (m_sampler);
+    if (upm_aio_sampler_capture (m_sampler, NULL, NUMBER_OF_SAMPLES) != UPM_SUCCESS)
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": Failed to do an aio read.");
+    upm_aio_sampler_get_stats (m_sampler, &stats);
+}
+
 double
 ECS1030::getCurrency_A () {
-    int     sensorValue  = 0;
-    float   volt         = 0;
-    float   rms          = 0;
-
-    for (int i = 0; i < NUMBER_OF_SAMPLES; i++) {
-        sensorValue = mraa_aio_read (m_dataPinCtx);
-        if (sensorValue == -1) throw std::runtime_error(std::string(__FUNCTION__) +
-                                                        ": Failed to do an aio read.");
-        volt = (VOLT_M * sensorValue) - 2.5;
-        volt = volt * volt;
-        rms = rms + volt;
-        usleep (DELAY_MS);
-    }
+    upm_aio_stats_t stats;
 
-    rms = rms / (float)NUMBER_OF_SAMPLES;
-    rms = sqrt(rms);
-    return rms / R_LOAD;
+    sample (stats);
+
+    // mean of (volt - 2.5)^2 from the moments of the raw samples
+    double bias = VOLT_M * stats.mean - 2.5;
+    double ac = VOLT_M * stats.ac_rms;
+    return sqrt (ac * ac + bias * bias) / R_LOAD;
 }
 
 double
 ECS1030::getCurrency_B () {
-    double sumCurrency    = 0;
-
-    for (int i = 0; i < NUMBER_OF_SAMPLES; i++) {
-        m_lastSample = m_sample;
-        m_sample = mraa_aio_read (m_dataPinCtx);
-        if (m_sample == -1) throw std::runtime_error(std::string(__FUNCTION__) +
-                                                     ": Failed to do an aio read.");
-        m_lastFilter = m_filteredSample;
-        m_filteredSample = 0.996 * (m_lastFilter + m_sample - m_lastSample);
-        sumCurrency += (m_filteredSample * m_filteredSample);
-    }
+    upm_aio_stats_t stats;
+
+    // the RMS of the samples around their mean, the window covering
+    // whole mains periods
+    sample (stats);
 
     double ratio = m_calibration * ((SUPPLYVOLTAGE / 1000.0) / (ADC_RESOLUTION));
-    return ( ratio * sqrt(sumCurrency / NUMBER_OF_SAMPLES) );
+    return ( ratio * stats.ac_rms );
 }
 
 double
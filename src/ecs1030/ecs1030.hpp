@@ -17,12 +17,16 @@
 #include <mraa/gpio.h>
 #include <mraa/initio.hpp>
 
+#include "upm_aio_sampler.h"
+
 namespace upm {
 
 #define NUMBER_OF_SAMPLES  500
 #define ADC_RESOLUTION     1024
 #define SUPPLYVOLTAGE      5100
 #define CURRENT_RATIO      2000.0
+/* 500 samples at 5 kHz cover 5 periods of 50 Hz or 6 periods of 60 Hz */
+#define SAMPLE_RATE_HZ     5000
 
 #define HIGH               1
 #define LOW                0
@@ -54,6 +58,11 @@ namespace upm {
    * measures a load up to 30 A, which makes it great for building your own
    * energy monitors.
    *
+   * The current is computed from NUMBER_OF_SAMPLES samples taken at a
+   * fixed rate (SAMPLE_RATE_HZ by default) on absolute deadlines, so
+   * the window spans a whole number of mains periods regardless of the
+   * ADC read latency.
+   *
    * @image html ecs1030.jpg
    * <br><em>ECS1030 Sensor image provided by SparkFun* under
    * <a href=https://creativecommons.org/licenses/by/2.0/>
@@ -64,8 +73,8 @@ namespace upm {
 class ECS1030 {
     public:
         static const uint8_t DELAY_MS  = 20000 / NUMBER_OF_SAMPLES; /* 1/50Hz is 20ms period */
-        static const uint8_t VOLT_M    = 5.1 / 1023;
-        static const uint8_t R_LOAD    = 2000.0 / CURRENT_RATIO;
+        static constexpr double VOLT_M = 5.1 / 1023;
+        static constexpr double R_LOAD = 2000.0 / CURRENT_RATIO;
 
         /**
          * Instantiates an ECS1030 object
@@ -91,6 +100,15 @@ class ECS1030 {
          */
         double getCurrency_A ();
 
+        /**
+         * Sets the rate at which the NUMBER_OF_SAMPLES samples of a
+         * measurement are taken.  Pick a rate at which they cover a
+         * whole number of mains periods.
+         *
+         * @param rateHz Sample rate in Hz
+         */
+        void setSampleRate (float rateHz);
+
         /**
          * Returns power data for a sampled period
          */
@@ -113,14 +131,13 @@ class ECS1030 {
             return m_name;
         }
     private:
+        void sample (upm_aio_stats_t &stats);
+
         std::string         m_name;
         mraa_aio_context    m_dataPinCtx;
         mraa::MraaIo        mraaIo;
+        upm_aio_sampler_context m_sampler;
 
         double              m_calibration;
-        int                 m_lastSample;
-        double              m_lastFilter;
-        int                 m_sample;
-        double              m_filteredSample;
 };
 }
@@ -18,6 +18,15 @@
 using namespace upm;
 using namespace std;
 
+static upm_result_t readAio(void *ctx, float *value)
+{
+    int x = mraa_aio_read((mraa_aio_context) ctx);
+    if (x == -1)
+        return UPM_ERROR_OPERATION_FAILED;
+    *value = x;
+    return UPM_SUCCESS;
+}
+
 EMG::EMG(int pin)
 {
     if (!(m_aio = mraa_aio_init(pin))) {
@@ -25,27 +34,36 @@ EMG::EMG(int pin)
                                     ": mraa_aio_init() failed, invalid pin?");
         return;
     }
+
+    // history is not used
+    if (!(m_sampler = upm_aio_sampler_init(readAio, m_aio, 1000, 1))) {
+        mraa_aio_close(m_aio);
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": upm_aio_sampler_init() failed");
+    }
 }
 
 EMG::~EMG()
 {
+    upm_aio_sampler_close(m_sampler);
     mraa_aio_close(m_aio);
 }
 
 void
 EMG::calibrate()
 {
-    int val, sum = 0;
-
-    for (int i = 0; i < 1100; i++) {
-        val = mraa_aio_read(m_aio);
-        if (val != -1)
-            throw std::runtime_error(std::string(__FUNCTION__) + ": Failed to do an aio read.");
-        sum += val;
-        usleep(1000);
-    }
-    sum /= 1100;
-    cout << "Static analog data = " << sum << endl;
+    upm_aio_stats_t stats;
+
+    // 1100 samples at 1 kHz
+    if (upm_aio_sampler_set_rate(m_sampler, 1000) != UPM_SUCCESS)
+        throw std::runtime_error(std::string(__FUNCTION__) + ": Sampling in the background");
+
+    upm_aio_sampler_reset_stats(m_sampler);
+    if (upm_aio_sampler_capture(m_sampler, NULL, 1100) != UPM_SUCCESS)
+        throw std::runtime_error(std::string(__FUNCTION__) + ": Failed to do an aio read.");
+    upm_aio_sampler_get_stats(m_sampler, &stats);
+
+    cout << "Static analog data = " << (int)stats.mean << endl;
 }
 
 int
@@ -73,3 +91,32 @@ EMG::getVolts()
 
     return val;
 }
+
+void
+EMG::startSampling(float rateHz)
+{
+    if (upm_aio_sampler_set_rate(m_sampler, rateHz) != UPM_SUCCESS)
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": Invalid rate or already sampling");
+
+    if (upm_aio_sampler_start(m_sampler) != UPM_SUCCESS)
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": upm_aio_sampler_start() failed");
+}
+
+void
+EMG::stopSampling()
+{
+    upm_aio_sampler_stop(m_sampler);
+}
+
+float
+EMG::getEnvelope()
+{
+    upm_aio_stats_t stats;
+    upm_aio_sampler_get_stats(m_sampler, &stats);
+
+    /* Same scaling as getVolts(), without the offset */
+    return stats.envelope / (1 << mraa_aio_get_bit(m_aio))
+        * this->m_scale * this->m_aRef;
+}
@@ -13,6 +13,7 @@
 #include <string>
 #include <mraa/aio.h>
 #include "interfaces/iEmg.hpp"
+#include "upm_aio_sampler.h"
 
 namespace upm {
   /**
@@ -35,6 +36,10 @@ namespace upm {
    * Grove EMG muscle signal reader gathers small muscle signals,
    * then processes them, and returns the result
    *
+   * startSampling() samples the signal in the background at a fixed
+   * rate, on absolute deadlines, and follows its envelope, a measure
+   * of the muscle activity.
+   *
    * @image html emg.jpg
    * @snippet emg.cxx Interesting
    */
@@ -65,8 +70,29 @@ namespace upm {
 
     virtual float getVolts();
 
+    /**
+     * Starts sampling in the background
+     *
+     * @param rateHz Sample rate in Hz
+     */
+    void startSampling(float rateHz);
+
+    /**
+     * Stops background sampling
+     */
+    void stopSampling();
+
+    /**
+     * Returns the envelope of the signal around its resting level,
+     * following it with a 1 ms attack and a 100 ms release
+     *
+     * @return Envelope in volts
+     */
+    float getEnvelope();
+
   private:
     mraa_aio_context m_aio;
+    upm_aio_sampler_context m_sampler;
     /* Analog voltage reference */
     float m_aRef = 5.0;
     /* Scale */
@@ -15,11 +15,64 @@
 #include <stdexcept>
 #include <string>
 
+#include "upm_regmap.hpp"
 #include "h3lis331dl.hpp"
 
 using namespace upm;
 using namespace std;
 
+namespace {
+  typedef H3LIS331DL D;
+
+  // register map, the device sets the MSB of the register address to
+  // auto-increment it
+  typedef regmap::I2cBus<0x80> I2cBus;
+
+  typedef regmap::Reg<D::REG_WHOAMI, regmap::RO> WhoAmI;
+
+  typedef regmap::Field<D::REG_REG1, 0, 3> Reg1Axes;
+  typedef regmap::Field<D::REG_REG1, D::REG1_DR_SHIFT, 2> Reg1Dr;
+  typedef regmap::Field<D::REG_REG1, D::REG1_PM_SHIFT, 3> Reg1Pm;
+
+  typedef regmap::Field<D::REG_REG2, D::REG2_HPCF_SHIFT, 2> Reg2Hpcf;
+  typedef regmap::Bit<D::REG_REG2, 2> Reg2Hpen1;
+  typedef regmap::Bit<D::REG_REG2, 3> Reg2Hpen2;
+  typedef regmap::Bit<D::REG_REG2, 4> Reg2Fds;
+  typedef regmap::Field<D::REG_REG2, D::REG2_HPM_SHIFT, 2> Reg2Hpm;
+  typedef regmap::Bit<D::REG_REG2, 7> Reg2Boot;
+
+  typedef regmap::Field<D::REG_REG3, D::REG3_I1_CFG_SHIFT, 2> Reg3I1Cfg;
+  typedef regmap::Bit<D::REG_REG3, 2> Reg3Lir1;
+  typedef regmap::Field<D::REG_REG3, D::REG3_I2_CFG_SHIFT, 2> Reg3I2Cfg;
+  typedef regmap::Bit<D::REG_REG3, 5> Reg3Lir2;
+  typedef regmap::Bit<D::REG_REG3, 6> Reg3PpOd;
+  typedef regmap::Bit<D::REG_REG3, 7> Reg3Ihl;
+
+  typedef regmap::Field<D::REG_REG4, D::REG4_FS_SHIFT, 2> Reg4Fs;
+  typedef regmap::Bit<D::REG_REG4, 6> Reg4Ble;
+  typedef regmap::Bit<D::REG_REG4, 7> Reg4Bdu;
+
+  typedef regmap::Field<D::REG_REG5, 0, 2> Reg5TurnOn;
+
+  typedef regmap::Reg<D::REG_STATUS, regmap::RO> Status;
+
+  typedef regmap::Field<D::REG_OUT_X_L, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> OutX;
+  typedef regmap::Field<D::REG_OUT_Y_L, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> OutY;
+  typedef regmap::Field<D::REG_OUT_Z_L, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> OutZ;
+
+  typedef regmap::Reg<D::REG_INT1_CFG> Int1Cfg;
+  typedef regmap::Reg<D::REG_INT1_SRC> Int1Src;
+  typedef regmap::Reg<D::REG_INT1_THS> Int1Ths;
+  typedef regmap::Reg<D::REG_INT1_DUR> Int1Dur;
+  typedef regmap::Reg<D::REG_INT2_CFG> Int2Cfg;
+  typedef regmap::Reg<D::REG_INT2_SRC> Int2Src;
+  typedef regmap::Reg<D::REG_INT2_THS> Int2Ths;
+  typedef regmap::Reg<D::REG_INT2_DUR> Int2Dur;
+}
+
 
 H3LIS331DL::H3LIS331DL(int bus, uint8_t address):
   m_i2c(bus)
@@ -44,316 +97,173 @@ H3LIS331DL::~H3LIS331DL()
 
 bool H3LIS331DL::init(DR_BITS_T odr, PM_BITS_T pm, FS_BITS_T fs)
 {
-  if (!setDataRate(odr)) {
-    return false;
-  }
-  if (!setPowerMode(pm)) {
-    return false;
-  }
-  if (!setFullScale(fs)) {
-    return false;
-  }
-
-  // now enable X, Y, and Z axes
-  if (!enableAxis(REG1_XEN | REG1_YEN | REG1_ZEN)) {
-    return false;
-  }
+  I2cBus bus(m_i2c);
+
+  // data rate, power mode and axis enables all live in REG1
+  regmap::Block<Reg1Dr, Reg1Pm, Reg1Axes> reg1;
+  reg1.read(bus);
+  reg1.set<Reg1Dr>(odr);
+  reg1.set<Reg1Pm>(pm);
+  reg1.set<Reg1Axes>(REG1_XEN | REG1_YEN | REG1_ZEN);
+  reg1.write(bus);
+
+  regmap::write<Reg4Fs>(bus, fs);
 
   return true;
 }
 
 uint8_t H3LIS331DL::getChipID()
 {
-  return m_i2c.readReg(REG_WHOAMI);
+  I2cBus bus(m_i2c);
+
+  return regmap::read<WhoAmI>(bus);
 }
 
 bool H3LIS331DL::setDataRate(DR_BITS_T odr)
 {
-  uint8_t reg1 = m_i2c.readReg(REG_REG1);
-
-  reg1 &= ~(REG1_DR0 | REG1_DR1);
-  reg1 |= (odr << REG1_DR_SHIFT);
+  I2cBus bus(m_i2c);
 
-  if (m_i2c.writeReg(REG_REG1, reg1))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg1Dr>(bus, odr);
 
   return true;
 }
 
 bool H3LIS331DL::setPowerMode(PM_BITS_T pm)
 {
-  uint8_t reg1 = m_i2c.readReg(REG_REG1);
-
-  reg1 &= ~(REG1_PM0 | REG1_PM1 | REG1_PM2);
-  reg1 |= (pm << REG1_PM_SHIFT);
+  I2cBus bus(m_i2c);
 
-  if (m_i2c.writeReg(REG_REG1, reg1))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg1Pm>(bus, pm);
 
   return true;
 }
 
 bool H3LIS331DL::enableAxis(uint8_t axisEnable)
 {
-  uint8_t reg1 = m_i2c.readReg(REG_REG1);
-
-  reg1 &= ~(REG1_XEN | REG1_YEN | REG1_ZEN);
-  reg1 |= (axisEnable & (REG1_XEN | REG1_YEN | REG1_ZEN));
+  I2cBus bus(m_i2c);
 
-  if (m_i2c.writeReg(REG_REG1, reg1))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg1Axes>(bus, axisEnable);
 
   return true;
 }
 
 bool H3LIS331DL::setFullScale(FS_BITS_T fs)
 {
-  uint8_t reg4 = m_i2c.readReg(REG_REG4);
-
-  reg4 &= ~(REG4_FS0 | REG4_FS1);
-  reg4 |= (fs << REG4_FS_SHIFT);
+  I2cBus bus(m_i2c);
 
-  if (m_i2c.writeReg(REG_REG4, reg4))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg4Fs>(bus, fs);
 
   return true;
 }
 
 bool H3LIS331DL::setHPCF(HPCF_BITS_T val)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
+  I2cBus bus(m_i2c);
 
-  reg &= ~(REG2_HPCF0 | REG2_HPCF1);
-  reg |= (val << REG2_HPCF_SHIFT);
-
-  if (m_i2c.writeReg(REG_REG2, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg2Hpcf>(bus, val);
 
   return true;
 }
 
 bool H3LIS331DL::setHPM(HPM_BITS_T val)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
-
-  reg &= ~(REG2_HPM0 | REG2_HPM1);
-  reg |= (val << REG2_HPM_SHIFT);
+  I2cBus bus(m_i2c);
 
-  if (m_i2c.writeReg(REG_REG2, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg2Hpm>(bus, val);
 
   return true;
 }
 
 bool H3LIS331DL::boot()
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
-
-  reg |= REG2_BOOT;
+  I2cBus bus(m_i2c);
 
-  if (m_i2c.writeReg(REG_REG2, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg2Boot>(bus, 1);
 
   // wait for the boot bit to clear
   do {
-    reg = m_i2c.readReg(REG_REG2);
     usleep(200000);
-  } while (reg & REG2_BOOT);
+  } while (regmap::read<Reg2Boot>(bus));
 
   return true;
 }
 
 bool H3LIS331DL::enableHPF1(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
-
-  if (enable)
-    reg |= REG2_HPEN1;
-  else
-    reg &= ~REG2_HPEN1;
+  I2cBus bus(m_i2c);
 
-  if (m_i2c.writeReg(REG_REG2, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg2Hpen1>(bus, enable);
 
   return true;
 }
 
 bool H3LIS331DL::enableHPF2(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
+  I2cBus bus(m_i2c);
 
-  if (enable)
-    reg |= REG2_HPEN2;
-  else
-    reg &= ~REG2_HPEN2;
-
-  if (m_i2c.writeReg(REG_REG2, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg2Hpen2>(bus, enable);
 
   return true;
 }
 
 bool H3LIS331DL::enableFDS(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG2);
-
-  if (enable)
-    reg |= REG2_FDS;
-  else
-    reg &= ~REG2_FDS;
+  I2cBus bus(m_i2c);
 
-  if (m_i2c.writeReg(REG_REG2, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg2Fds>(bus, enable);
 
   return true;
 }
 
 bool H3LIS331DL::setInterruptActiveLow(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  I2cBus bus(m_i2c);
 
-  if (enable)
-    reg |= REG3_IHL;
-  else
-    reg &= ~REG3_IHL;
-
-  if (m_i2c.writeReg(REG_REG3, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg3Ihl>(bus, enable);
 
   return true;
 }
 
 bool H3LIS331DL::setInterruptOpenDrain(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
-
-  if (enable)
-    reg |= REG3_PP_OD;
-  else
-    reg &= ~REG3_PP_OD;
+  I2cBus bus(m_i2c);
 
-  if (m_i2c.writeReg(REG_REG3, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg3PpOd>(bus, enable);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt1Latch(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  I2cBus bus(m_i2c);
 
-  if (enable)
-    reg |= REG3_LIR1;
-  else
-    reg &= ~REG3_LIR1;
-
-  if (m_i2c.writeReg(REG_REG3, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg3Lir1>(bus, enable);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt2Latch(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  I2cBus bus(m_i2c);
 
-  if (enable)
-    reg |= REG3_LIR2;
-  else
-    reg &= ~REG3_LIR2;
-
-  if (m_i2c.writeReg(REG_REG3, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg3Lir2>(bus, enable);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt1PadConfig(I_CFG_BITS_T val)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  I2cBus bus(m_i2c);
 
-  reg &= ~(REG3_I1_CFG0 | REG3_I1_CFG1);
-  reg |= (val << REG3_I1_CFG_SHIFT);
-
-  if (m_i2c.writeReg(REG_REG3, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg3I1Cfg>(bus, val);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt2PadConfig(I_CFG_BITS_T val)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG3);
+  I2cBus bus(m_i2c);
 
-  reg &= ~(REG3_I2_CFG0 | REG3_I2_CFG1);
-  reg |= (val << REG3_I2_CFG_SHIFT);
-
-  if (m_i2c.writeReg(REG_REG3, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg3I2Cfg>(bus, val);
 
   return true;
 }
@@ -361,200 +271,125 @@ bool H3LIS331DL::setInterrupt2PadConfig(I_CFG_BITS_T val)
 
 bool H3LIS331DL::enableBDU(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG4);
+  I2cBus bus(m_i2c);
 
-  if (enable)
-    reg |= REG4_BDU;
-  else
-    reg &= ~REG4_BDU;
-
-  if (m_i2c.writeReg(REG_REG4, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg4Bdu>(bus, enable);
 
   return true;
 }
 
 bool H3LIS331DL::enableBLE(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG4);
+  I2cBus bus(m_i2c);
 
-  if (enable)
-    reg |= REG4_BLE;
-  else
-    reg &= ~REG4_BLE;
-
-  if (m_i2c.writeReg(REG_REG4, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg4Ble>(bus, enable);
 
   return true;
 }
 
 bool H3LIS331DL::enableSleepToWake(bool enable)
 {
-  uint8_t reg = m_i2c.readReg(REG_REG5);
+  I2cBus bus(m_i2c);
 
-  if (enable)
-    reg |= (REG5_TURNON0 | REG5_TURNON1);
-  else
-    reg &= ~(REG5_TURNON0 | REG5_TURNON1);
-
-  if (m_i2c.writeReg(REG_REG5, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Reg5TurnOn>(bus, enable ? 0x3 : 0x0);
 
   return true;
 }
 
 uint8_t H3LIS331DL::getStatus()
 {
-  return m_i2c.readReg(REG_STATUS);
+  I2cBus bus(m_i2c);
+
+  return regmap::read<Status>(bus);
 }
 
 bool H3LIS331DL::setInterrupt1Config(uint8_t val)
 {
-  uint8_t reg = m_i2c.readReg(REG_INT1_CFG);
+  I2cBus bus(m_i2c);
 
   // mask off reserved bit
-  reg = (val & ~0x40);
-
-  if (m_i2c.writeReg(REG_INT1_CFG, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Int1Cfg>(bus, val & ~0x40);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt1Source(uint8_t val)
 {
-  uint8_t reg = m_i2c.readReg(REG_INT1_SRC);
+  I2cBus bus(m_i2c);
 
   // mask off reserved bit
-  reg = (val & ~0x80);
-
-  if (m_i2c.writeReg(REG_INT1_SRC, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Int1Src>(bus, val & ~0x80);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt1Threshold(uint8_t val)
 {
-  if (m_i2c.writeReg(REG_INT1_THS, val))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  I2cBus bus(m_i2c);
+
+  regmap::write<Int1Ths>(bus, val);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt1Duration(uint8_t val)
 {
-  if (m_i2c.writeReg(REG_INT1_DUR, val))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  I2cBus bus(m_i2c);
+
+  regmap::write<Int1Dur>(bus, val);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt2Config(uint8_t val)
 {
-  uint8_t reg = m_i2c.readReg(REG_INT2_CFG);
+  I2cBus bus(m_i2c);
 
   // mask off reserved bit
-  reg = (val & ~0x40);
-
-  if (m_i2c.writeReg(REG_INT2_CFG, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Int2Cfg>(bus, val & ~0x40);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt2Source(uint8_t val)
 {
-  uint8_t reg = m_i2c.readReg(REG_INT2_SRC);
+  I2cBus bus(m_i2c);
 
   // mask off reserved bit
-  reg = (val & ~0x80);
-
-  if (m_i2c.writeReg(REG_INT2_SRC, reg))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  regmap::write<Int2Src>(bus, val & ~0x80);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt2Threshold(uint8_t val)
 {
-  if (m_i2c.writeReg(REG_INT2_THS, val))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  I2cBus bus(m_i2c);
+
+  regmap::write<Int2Ths>(bus, val);
 
   return true;
 }
 
 bool H3LIS331DL::setInterrupt2Duration(uint8_t val)
 {
-  if (m_i2c.writeReg(REG_INT2_DUR, val))
-    {
-      throw std::runtime_error(std::string(__FUNCTION__) +
-                               ": I2c.writeReg() failed");
-      return false;
-    }
+  I2cBus bus(m_i2c);
+
+  regmap::write<Int2Dur>(bus, val);
 
   return true;
 }
 
 void H3LIS331DL::update()
 {
-  uint8_t low, high;
-
-  // X
-  low = m_i2c.readReg(REG_OUT_X_L);
-  high = m_i2c.readReg(REG_OUT_X_H);
-  m_rawX = ((high << 8) | low);
+  I2cBus bus(m_i2c);
 
-  // Y
-  low = m_i2c.readReg(REG_OUT_Y_L);
-  high = m_i2c.readReg(REG_OUT_Y_H);
-  m_rawY = ((high << 8) | low);
+  // all three axes in one burst
+  regmap::Block<OutX, OutY, OutZ> out;
+  out.read(bus);
 
-  // Z
-  low = m_i2c.readReg(REG_OUT_Z_L);
-  high = m_i2c.readReg(REG_OUT_Z_H);
-  m_rawZ = ((high << 8) | low);
+  m_rawX = out.get<OutX>();
+  m_rawY = out.get<OutY>();
+  m_rawZ = out.get<OutZ>();
 }
 
 void H3LIS331DL::setAdjustmentOffsets(int adjX, int adjY, int adjZ)
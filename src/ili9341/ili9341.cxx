@@ -12,6 +12,7 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <stdexcept>
@@ -329,6 +330,56 @@ void ILI9341::fillScreen(uint16_t color) {
     fillRect(0, 0,  _width, _height, color);
 }
 
+void ILI9341::drawImage(int16_t x, int16_t y, int16_t w, int16_t h,
+                        uint8_t *buffer, size_t len) {
+
+    if (w <= 0 || h <= 0) return;
+
+    if (len < (size_t)w * h * 2) {
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": buffer too small for the image");
+    }
+
+    // clip to the screen
+    int16_t x0 = std::max<int16_t>(x, 0);
+    int16_t y0 = std::max<int16_t>(y, 0);
+    int16_t x1 = std::min<int>(x + w, _width);
+    int16_t y1 = std::min<int>(y + h, _height);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    setAddrWindow(x0, y0, x1 - 1, y1 - 1);
+
+    lcdCSOn();
+    dcHigh();
+
+    uint8_t *row = buffer + ((size_t)(y0 - y) * w + (x0 - x)) * 2;
+    if (x1 - x0 == w) {
+        // whole rows are contiguous in the buffer
+        writePixels(row, (size_t)(y1 - y0) * w * 2);
+    } else {
+        for (int16_t i = y0; i < y1; i++, row += w * 2) {
+            writePixels(row, (x1 - x0) * 2);
+        }
+    }
+
+    lcdCSOff();
+}
+
+void ILI9341::writePixels(uint8_t *buffer, size_t len) {
+    // spidev limits the size of a single transfer
+    const size_t maxTransfer = 4096;
+
+    while (len) {
+        size_t n = std::min(len, maxTransfer);
+        if (m_spi.transfer(buffer, NULL, n) != mraa::SUCCESS) {
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": SPI transfer failed");
+        }
+        buffer += n;
+        len -= n;
+    }
+}
+
 void ILI9341::invertDisplay(bool i) {
     writecommand(i ? ILI9341_INVON : ILI9341_INVOFF);
 }
@@ -231,6 +231,23 @@ namespace upm {
              */
             void fillScreen(uint16_t color);
 
+            /**
+             * Draws an image.  The pixels are written to the display in
+             * as few SPI transfers as possible, parts outside of the
+             * screen are clipped.
+             *
+             * @param x Axis on the horizontal scale of upper-left corner
+             * @param y Axis on the vertical scale of upper-left corner
+             * @param w Width of the image in pixels
+             * @param h Height of the image in pixels
+             * @param buffer w * h RGB (16-bit) pixels, row by row, each
+             * sent high byte first
+             * @param len Size of buffer in bytes
+             * @throws std::invalid_argument if buffer is too small
+             */
+            void drawImage(int16_t x, int16_t y, int16_t w, int16_t h,
+                           uint8_t *buffer, size_t len);
+
             /**
              * Sets the screen to one of four 90 deg rotations.
              *
@@ -325,6 +342,8 @@ namespace upm {
             mraa::Spi   m_spi;
 
             std::string m_name;
+
+            void writePixels(uint8_t *buffer, size_t len);
     };
 }
 
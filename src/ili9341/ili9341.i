@@ -2,6 +2,8 @@
 
 /* BEGIN Java syntax  ------------------------------------------------------- */
 #ifdef SWIGJAVA
+%include "../java_buffer.i"
+
 %apply uint8_t *INPUT { uint8_t *addr }
 
 JAVA_JNI_LOADLIBRARY(javaupm_ili9341)
@@ -43,3 +43,58 @@
 %typemap(freearg) (char *buffer, int len) {
         JCALL3(ReleaseByteArrayElements, jenv, $input, (jbyte *)$1, 0);
 }
+
+/* Zero-copy bulk I/O through direct NIO buffers
+ *
+ * Functions taking a (TYPE *buffer, size_t len) argument pair accept a
+ * direct java.nio buffer of the matching element type.  The driver reads
+ * or fills the elements between its position and limit in place, so one
+ * buffer can carry payloads of varying length; the position itself is
+ * left unchanged.  Multi-byte views must use the native byte order, and
+ * should be allocated once and reused:
+ *
+ *     FloatBuffer buf = ByteBuffer.allocateDirect(3 * 64 * 4)
+ *         .order(ByteOrder.nativeOrder()).asFloatBuffer();
+ *     long n = sensor.readBufferSamples(buf);
+ *
+ *     out.clear();
+ *     out.put(payload).flip();
+ *     radio.send(out, 0);
+ *
+ * The Java side passes a slice() of the buffer, which shares its memory
+ * but starts at the position, so the native side gets the address of
+ * the position and the number of remaining elements.
+ *
+ * Other argument pairs can use these typemaps through %apply, len is
+ * range checked against the type it is converted to.
+ */
+%define UPM_JAVA_DIRECT_BUFFER(TYPE, JTYPE)
+%typemap(jni) (TYPE *buffer, size_t len) "jobject";
+%typemap(jtype) (TYPE *buffer, size_t len) %{java.nio.JTYPE%}
+%typemap(jstype) (TYPE *buffer, size_t len) %{java.nio.JTYPE%}
+
+%typemap(javain) (TYPE *buffer, size_t len) "($javainput).slice()";
+
+%typemap(in) (TYPE *buffer, size_t len) {
+        jlong capacity = JCALL1(GetDirectBufferCapacity, jenv, $input);
+
+        $1 = ($1_ltype) JCALL1(GetDirectBufferAddress, jenv, $input);
+        if (!$1 || capacity < 0) {
+                SWIG_JavaThrowException(jenv, SWIG_JavaIllegalArgumentException,
+                                        "expected a direct " #JTYPE);
+                return $null;
+        }
+
+        $2 = ($2_ltype) capacity;
+        if ((jlong) $2 != capacity) {
+                SWIG_JavaThrowException(jenv, SWIG_JavaIllegalArgumentException,
+                                        #JTYPE " is too large");
+                return $null;
+        }
+}
+%enddef
+
+UPM_JAVA_DIRECT_BUFFER(uint8_t, ByteBuffer)
+UPM_JAVA_DIRECT_BUFFER(int16_t, ShortBuffer)
+UPM_JAVA_DIRECT_BUFFER(uint16_t, ShortBuffer)
+UPM_JAVA_DIRECT_BUFFER(float, FloatBuffer)
@@ -150,6 +150,13 @@ Sets acceleration scale of sensor and the buffer.
 */
 static void kx122_map_grange(const kx122_context dev, KX122_RANGE_T grange);
 
+/**
+Marks the control registers as cacheable in the shadow register cache.
+
+@param dev The device context.
+*/
+static void kx122_init_reg_cache(const kx122_context dev);
+
 kx122_context kx122_init(int bus, int addr, int chip_select_pin, int spi_bus_frequency)
 {
   kx122_context dev = (kx122_context)malloc(sizeof(struct _kx122_context));
@@ -167,6 +174,8 @@ kx122_context kx122_init(int bus, int addr, int chip_select_pin, int spi_bus_fre
   dev->gpio1 = NULL;
   dev->gpio2 = NULL;
 
+  kx122_init_reg_cache(dev);
+
   if(mraa_init() != MRAA_SUCCESS){
     printf("%s: mraa_init() failed.\n", __FUNCTION__);
     kx122_close(dev);
@@ -270,10 +279,12 @@ static void kx122_chip_select_off(const kx122_context dev)
 //Register operations
 static upm_result_t kx122_read_register(const kx122_context dev, uint8_t reg, uint8_t *data)
 {
-  if(dev->using_spi){
-    reg |= SPI_READ;
+  if(upm_reg_cache_get(&dev->reg_cache,reg,data)){
+    return UPM_SUCCESS;
+  }
 
-    uint8_t spi_data[2] = {reg,0};
+  if(dev->using_spi){
+    uint8_t spi_data[2] = {reg | SPI_READ,0};
 
     kx122_chip_select_on(dev);
 
@@ -284,6 +295,7 @@ static upm_result_t kx122_read_register(const kx122_context dev, uint8_t reg, ui
       return UPM_ERROR_OPERATION_FAILED;
     }
       *data = spi_data[1];
+      upm_reg_cache_put(&dev->reg_cache,reg,*data);
 
       kx122_chip_select_off(dev);
       return UPM_SUCCESS;
@@ -293,6 +305,7 @@ static upm_result_t kx122_read_register(const kx122_context dev, uint8_t reg, ui
 
     if(value != -1){
       *data = (uint8_t) value;
+      upm_reg_cache_put(&dev->reg_cache,reg,*data);
       return UPM_SUCCESS;
     }
 
@@ -343,64 +356,71 @@ static upm_result_t kx122_read_registers(const kx122_context dev, uint8_t reg, u
 static upm_result_t kx122_write_register(const kx122_context dev, uint8_t reg, uint8_t val)
 {
   if(dev->using_spi){
-    reg &= SPI_WRITE;
-    uint8_t spi_data[2] = {reg,val};
+    uint8_t spi_data[2] = {reg & SPI_WRITE,val};
 
     kx122_chip_select_on(dev);
     if(mraa_spi_transfer_buf(dev->spi,spi_data,NULL,(sizeof(spi_data) / sizeof(uint8_t))) != MRAA_SUCCESS){
       printf("%s: mraa_spi_transfer_buf() failed.\n", __FUNCTION__);
 
       kx122_chip_select_off(dev);
+      upm_reg_cache_invalidate(&dev->reg_cache,reg);
       return UPM_ERROR_OPERATION_FAILED;
     }
 
     kx122_chip_select_off(dev);
-    return UPM_SUCCESS;
   }
   else{
     if(mraa_i2c_write_byte_data(dev->i2c,val,reg) != MRAA_SUCCESS){
       printf("%s: mraa_i2c_write_byte_data() failed.\n",__FUNCTION__);
+      upm_reg_cache_invalidate(&dev->reg_cache,reg);
       return UPM_ERROR_OPERATION_FAILED;
     }
-    return UPM_SUCCESS;
   }
+
+  upm_reg_cache_put(&dev->reg_cache,reg,val);
+  return UPM_SUCCESS;
 }
 
-static upm_result_t kx122_set_bit_pattern(const kx122_context dev, uint8_t reg, uint8_t val, uint8_t bit_mask)
+static upm_result_t kx122_read_register_cb(void *ctx, uint8_t reg, uint8_t *val)
 {
-  uint8_t reg_val;
+  return kx122_read_register((kx122_context)ctx,reg,val);
+}
 
-  if(kx122_read_register(dev,reg,&reg_val) != UPM_SUCCESS){
-    return UPM_ERROR_OPERATION_FAILED;
-  }
+static upm_result_t kx122_write_register_cb(void *ctx, uint8_t reg, uint8_t val)
+{
+  return kx122_write_register((kx122_context)ctx,reg,val);
+}
 
-  reg_val &= ~bit_mask;
-  reg_val |= val;
-  return kx122_write_register(dev,reg,reg_val);
+static upm_result_t kx122_set_bit_pattern(const kx122_context dev, uint8_t reg, uint8_t val, uint8_t bit_mask)
+{
+  //Bits of val outside of bit_mask are set as well
+  return upm_reg_cache_update_bits(&dev->reg_cache,reg,bit_mask | val,val,
+                                   kx122_read_register_cb,kx122_write_register_cb,dev);
 }
 
 static upm_result_t kx122_set_bit_on(const kx122_context dev, uint8_t reg, uint8_t val)
 {
-  uint8_t reg_val;
-
-  if(kx122_read_register(dev,reg,&reg_val) != UPM_SUCCESS){
-    return UPM_ERROR_OPERATION_FAILED;
-  }
-
-  reg_val |= val;
-  return kx122_write_register(dev,reg,reg_val);
+  return upm_reg_cache_update_bits(&dev->reg_cache,reg,val,val,
+                                   kx122_read_register_cb,kx122_write_register_cb,dev);
 }
 
 static upm_result_t kx122_set_bit_off(const kx122_context dev, uint8_t reg, uint8_t val)
 {
-  uint8_t reg_val;
-
-  if(kx122_read_register(dev,reg,&reg_val) != UPM_SUCCESS){
-    return UPM_ERROR_OPERATION_FAILED;
-  }
+  return upm_reg_cache_update_bits(&dev->reg_cache,reg,val,0,
+                                   kx122_read_register_cb,kx122_write_register_cb,dev);
+}
 
-  reg_val &= ~val;
-  return kx122_write_register(dev,reg,reg_val);
+static void kx122_init_reg_cache(const kx122_context dev)
+{
+  upm_reg_cache_init(&dev->reg_cache);
+
+  //Control, interrupt, embedded function and buffer setup registers
+  //only change when written.  CNTL2 is volatile (self-clearing SRST
+  //and COTC bits).
+  upm_reg_cache_set_nonvolatile(&dev->reg_cache,KX122_WHO_AM_I,KX122_WHO_AM_I);
+  upm_reg_cache_set_nonvolatile(&dev->reg_cache,KX122_CNTL1,KX122_CNTL1);
+  upm_reg_cache_set_nonvolatile(&dev->reg_cache,KX122_CNTL3,KX122_LP_CNTL);
+  upm_reg_cache_set_nonvolatile(&dev->reg_cache,KX122_BUF_CNTL1,KX122_BUF_CNTL2);
 }
 
 static void kx122_set_default_values(const kx122_context dev)
@@ -584,6 +604,9 @@ upm_result_t kx122_sensor_software_reset(const kx122_context dev)
     counter++;
   }
 
+  //All registers are back to their defaults
+  upm_reg_cache_invalidate_all(&dev->reg_cache);
+
   if(counter == MAX_LOOP_COUNT){
     return UPM_ERROR_OPERATION_FAILED;
   }
@@ -1080,3 +1103,42 @@ upm_result_t kx122_read_buffer_samples(const kx122_context dev, uint len, float
 
   return UPM_SUCCESS;
 }
+
+upm_result_t kx122_read_buffer_samples_xyz(const kx122_context dev, uint len, float *xyz_array, bool raw)
+{
+  assert(dev != NULL);
+  uint frame = (dev->buffer_res == LOW_RES) ? LOW_RES_SAMPLE_MODIFIER : HIGH_RES_SAMPLE_MODIFIER;
+  bool filo = (dev->buffer_mode == KX122_FILO_MODE);
+
+  uint8_t buffer[len * frame];
+
+  if(kx122_read_registers(dev,KX122_BUF_READ,buffer,len * frame) != UPM_SUCCESS){
+    return UPM_ERROR_OPERATION_FAILED;
+  }
+
+  for (uint i = 0; i < len; i++) {
+    const uint8_t *sample = buffer + i * frame;
+
+    for (int axis = 0; axis < 3; axis++) {
+      //FILO mode stores the axes, and their bytes, in reverse order
+      int pos = filo ? 2 - axis : axis;
+      float value;
+
+      if(dev->buffer_res == HIGH_RES){
+        value = filo ?
+          (float)((int16_t) (sample[pos * 2] << 8) | sample[pos * 2 + 1]) :
+          (float)((int16_t) (sample[pos * 2 + 1] << 8) | sample[pos * 2]);
+      }
+      else{
+        value = (float)(int8_t)sample[pos];
+      }
+
+      if(!raw){
+        value = (value * dev->buffer_accel_scale) * GRAVITY;
+      }
+      xyz_array[i * 3 + axis] = value;
+    }
+  }
+
+  return UPM_SUCCESS;
+}
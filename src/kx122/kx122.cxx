@@ -350,6 +350,41 @@ std::vector<float> KX122::getBufferSamples(uint len)
   return xyz_array;
 }
 
+size_t KX122::readRawBufferSamples(float *buffer, size_t len)
+{
+  return readBufferSamples(buffer, len, true);
+}
+
+size_t KX122::readBufferSamples(float *buffer, size_t len)
+{
+  return readBufferSamples(buffer, len, false);
+}
+
+size_t KX122::readBufferSamples(float *buffer, size_t len, bool raw)
+{
+  size_t samples = len / 3;
+  if(samples == 0){
+    return 0;
+  }
+
+  uint available = getBufferStatus();
+  if(samples > available){
+    samples = available;
+  }
+  if(samples > MAX_SAMPLES_IN_BUFFER){
+    samples = MAX_SAMPLES_IN_BUFFER;
+  }
+  if(samples == 0){
+    return 0;
+  }
+
+  if(kx122_read_buffer_samples_xyz(m_kx122,samples,buffer,raw)){
+    throw std::runtime_error(std::string(__FUNCTION__) + "kx122_read_buffer_samples_xyz failed");
+  }
+
+  return samples;
+}
+
 void KX122::clearBuffer()
 {
   if(kx122_clear_buffer(m_kx122)){
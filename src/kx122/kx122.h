@@ -27,6 +27,7 @@ extern "C"{
 #include <mraa/gpio.h>
 
 #include <upm.h>
+#include <upm_reg_cache.h>
 
 #include "kx122_registers.h"
 
@@ -143,6 +144,8 @@ typedef struct _kx122_context {
 
   bool using_spi;
 
+  upm_reg_cache_t reg_cache; //Shadow copies of the control registers
+
 } *kx122_context;
 
 //Struct for ODR values and their decimal counterparts.
@@ -651,6 +654,20 @@ Make sure the array size is atleast the amount of samples to be read.
 */
 upm_result_t kx122_read_buffer_samples(const kx122_context dev, uint len, float *x_array, float *y_array, float *z_array);
 
+/**
+Gets the specified amount of acceleration samples from the buffer, decoded
+straight into one array of interleaved x, y, z values.
+
+Make sure the array size is atleast 3 times the amount of samples to be read.
+
+@param dev The device context.
+@param len The amount of samples to read from the buffer.
+@param xyz_array Pointer to an floating point array to store the data.
+@param raw True for raw values, false for converted (m/s^2) values.
+@return UPM result.
+*/
+upm_result_t kx122_read_buffer_samples_xyz(const kx122_context dev, uint len, float *xyz_array, bool raw);
+
 /**
 Clears the buffer, removing all existing samples from the buffer.
 
@@ -485,6 +485,37 @@ namespace upm{
       */
       std::vector<float> getBufferSamples(uint len);
 
+      /**
+      Reads raw acceleration samples from the buffer into a caller supplied
+      array, interleaved as x, y & z-axis data. Reads as many samples as fit
+      into the array, but no more than are currently in the buffer.
+
+      From Python, the array can be any writable float32 buffer object
+      (e.g. a numpy array), which is filled in place.
+
+      @param buffer Array to store the samples in.
+      @param len Size of the array, in floats.
+      @return number of samples read.
+      @throws std::runtime_error on failure.
+      */
+      size_t readRawBufferSamples(float *buffer, size_t len);
+
+      /**
+      Reads converted (m/s^2) acceleration samples from the buffer into a
+      caller supplied array, interleaved as x, y & z-axis data. Reads as
+      many samples as fit into the array, but no more than are currently in
+      the buffer.
+
+      From Python, the array can be any writable float32 buffer object
+      (e.g. a numpy array), which is filled in place.
+
+      @param buffer Array to store the samples in.
+      @param len Size of the array, in floats.
+      @return number of samples read.
+      @throws std::runtime_error on failure.
+      */
+      size_t readBufferSamples(float *buffer, size_t len);
+
       /**
       Clears the buffer, removing all existing samples from the buffer.
 
@@ -495,6 +526,8 @@ namespace upm{
       //Device context
       kx122_context m_kx122;
 
+      size_t readBufferSamples(float *buffer, size_t len, bool raw);
+
       /* Disable implicit copy and assignment operators */
       KX122(const KX122&) = delete;
       KX122 &operator=(const KX122&) = delete;
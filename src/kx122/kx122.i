@@ -1,11 +1,33 @@
+#ifdef SWIGPYTHON
+%module (package="upm", threads="1") kx122
+#endif
+
 %include "../common_top.i"
 
 /* BEGIN Java syntax  ------------------------------------------------------- */
 #ifdef SWIGJAVA
+%include "../java_buffer.i"
+
 JAVA_JNI_LOADLIBRARY(javaupm_kx122)
 #endif
 /* END Java syntax */
 
+/* BEGIN Python syntax  ----------------------------------------------------- */
+#ifdef SWIGPYTHON
+%include "../python_buffer.i"
+
+/* Only release the GIL around calls that wait on the bus */
+%nothread;
+%thread upm::KX122::getRawAccelerationData;
+%thread upm::KX122::getAccelerationData;
+%thread upm::KX122::getAccelerationDataVector;
+%thread upm::KX122::getRawBufferSamples;
+%thread upm::KX122::getBufferSamples;
+%thread upm::KX122::readRawBufferSamples;
+%thread upm::KX122::readBufferSamples;
+#endif
+/* END Python syntax */
+
 /* BEGIN Common SWIG syntax ------------------------------------------------- */
 %include "std_vector.i"
 %template(floatVector) std::vector<float>;
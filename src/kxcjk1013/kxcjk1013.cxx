@@ -29,6 +29,12 @@ KXCJK1013::KXCJK1013(int device)
                                     ": mraa_iio_init() failed, invalid device?");
         return;
     }
+    if (!(m_stream = upm_iio_stream_init(device))) {
+        mraa_iio_close(m_iio);
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": upm_iio_stream_init() failed");
+    }
+
     m_scale = 1;
     m_iio_device_num = device;
     snprintf(trigger, 64, "hrtimer-kxcjk1013-hr-dev%d", device);
@@ -47,6 +53,7 @@ KXCJK1013::KXCJK1013(int device)
 
 KXCJK1013::~KXCJK1013()
 {
+    upm_iio_stream_close(m_stream);
     if (m_iio)
         mraa_iio_close(m_iio);
 }
@@ -123,6 +130,7 @@ KXCJK1013::enableBuffer(int length)
 bool
 KXCJK1013::disableBuffer()
 {
+    upm_iio_stream_release(m_stream);
     mraa_iio_write_int(m_iio, "buffer/enable", 0);
 
     return true;
@@ -133,6 +141,8 @@ KXCJK1013::setScale(float scale)
 {
     m_scale = scale;
     mraa_iio_write_float(m_iio, "in_accel_scale", scale);
+    // picked up by the next readBuffer()
+    upm_iio_stream_release(m_stream);
 
     return true;
 }
@@ -158,6 +168,7 @@ KXCJK1013::enable3AxisChannel()
 
     // need update channel data size after enable
     mraa_iio_update_channels(m_iio);
+    upm_iio_stream_release(m_stream);
     return true;
 }
 
@@ -187,3 +198,37 @@ KXCJK1013::extract3Axis(char* data, float* x, float* y, float* z)
         *z = tmp[2];
     }
 }
+
+size_t
+KXCJK1013::readBuffer(float* buffer, size_t len, int timeoutMs)
+{
+    static const char* axes[3] = { "accel_x", "accel_y", "accel_z" };
+    float* data[UPM_IIO_STREAM_MAX_CHANNELS] = { 0 };
+    size_t count = len / 3;
+
+    if (!upm_iio_stream_num_channels(m_stream)) {
+        if (upm_iio_stream_open(m_stream) != UPM_SUCCESS)
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": upm_iio_stream_open() failed, buffer not enabled?");
+
+        // same scale as extract3Axis()
+        for (int i = 0; i < 3; i++)
+            upm_iio_stream_set_scale(m_stream, upm_iio_stream_find_channel(m_stream, axes[i]),
+                                     m_scale);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        int chan = upm_iio_stream_find_channel(m_stream, axes[i]);
+        if (chan < 0)
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": axis scan elements not enabled");
+        data[chan] = buffer + i * count;
+    }
+
+    int n = upm_iio_stream_read(m_stream, data, NULL, count, timeoutMs);
+    if (n < 0)
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": upm_iio_stream_read() failed");
+
+    return n;
+}
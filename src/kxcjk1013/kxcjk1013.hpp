@@ -13,6 +13,8 @@
 #include <string>
 #include <mraa/iio.h>
 
+#include "upm_iio_stream.h"
+
 namespace upm
 {
 /**
@@ -112,8 +114,29 @@ class KXCJK1013
      */
     void extract3Axis(char* data, float* x, float* y, float* z);
 
+    /**
+     * Read a block of samples from the trigger buffer, as an
+     * alternative to installISR() and extract3Axis().  Call
+     * enable3AxisChannel() and enableBuffer() first.  Waits up to
+     * timeoutMs for the first sample, then returns the samples already
+     * buffered, as many as fit.
+     *
+     * The samples are stored by axis: the first third of the buffer
+     * receives the x values, the second the y and the last the z
+     * values.  Units are m/s^2.
+     *
+     * @param buffer Array to store the samples in
+     * @param len Size of the array, in floats
+     * @param timeoutMs Maximum time to wait in milliseconds, -1 to wait
+     * forever
+     * @return Number of samples read, 0 on timeout
+     * @throws std::runtime_error on failure
+     */
+    size_t readBuffer(float* buffer, size_t len, int timeoutMs = -1);
+
   private:
     mraa_iio_context m_iio;
+    upm_iio_stream_context m_stream; // block reader
     int m_iio_device_num;
     bool m_mount_matrix_exist; // is mount matrix exist
     float m_mount_matrix[9];   // mount matrix
@@ -16,15 +16,13 @@
 #include <string.h>
 #include <math.h>
 #include "l3gd20.hpp"
+#include "upm_cal_store.h"
 
 #define NUMBER_OF_BITS_IN_BYTE 8
 #define GYRO_MIN_SAMPLES 5 /* Drop first few gyro samples after enable */
 #define GYRO_MAX_ERR 0.05
 #define GYRO_DS_SIZE 100
 
-#define GYRO_DENOISE_MAX_SAMPLES 5
-#define GYRO_DENOISE_NUM_FIELDS 3
-
 using namespace upm;
 using namespace std;
 
@@ -45,6 +43,12 @@ L3GD20::L3GD20(int device) :
         return;
     }
 
+    if (!(m_stream = upm_iio_stream_init(device))) {
+        mraa_iio_close(m_iio);
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": upm_iio_stream_init() failed");
+    }
+
     m_scale = 1;
     m_iio_device_num = device;
     snprintf(trigger, 64, "hrtimer-l3gd20-hr-dev%d", device);
@@ -65,20 +69,15 @@ L3GD20::L3GD20(int device) :
     // initial calibrate data
     initCalibrate();
 
-    // initial denoise data
-    m_filter.buff =
-    (float*) calloc(GYRO_DENOISE_MAX_SAMPLES, sizeof(float) * GYRO_DENOISE_NUM_FIELDS);
-    if (m_filter.buff == NULL) {
-        throw std::invalid_argument(std::string(__FUNCTION__) +
-                                    ": mraa_iio_init() failed, calloc denoise data");
-        return;
-    }
-    m_filter.sample_size = GYRO_DENOISE_MAX_SAMPLES;
-    m_filter.count = 0;
-    m_filter.idx = 0;
+    char key[UPM_CAL_STORE_MAX_KEY + 1];
+    if (upm_cal_store_enabled()
+        && upm_cal_store_iio_key("l3gd20", device, key,
+                                 sizeof(key)) == UPM_SUCCESS)
+        setCalibrationStore(key);
 }
 
-L3GD20::L3GD20(int bus, int addr)
+L3GD20::L3GD20(int bus, int addr) :
+  m_iio(0), m_stream(0)
 {
   m_i2c = new mraa::I2c(bus);
 
@@ -103,21 +102,6 @@ L3GD20::L3GD20(int bus, int addr)
   // initial calibrate data
   initCalibrate();
 
-  // initial denoise data
-  m_filter.buff =
-    (float*) calloc(GYRO_DENOISE_MAX_SAMPLES,
-                    sizeof(float) * GYRO_DENOISE_NUM_FIELDS);
-
-  if (m_filter.buff == NULL)
-    {
-      throw std::bad_alloc();
-      return;
-    }
-
-  m_filter.sample_size = GYRO_DENOISE_MAX_SAMPLES;
-  m_filter.count = 0;
-  m_filter.idx = 0;
-
   // check ChipID
 
   uint8_t cid = getChipID();
@@ -133,6 +117,13 @@ L3GD20::L3GD20(int bus, int addr)
       return;
     }
 
+  if (upm_cal_store_enabled())
+    {
+      char key[64];
+      snprintf(key, sizeof(key), "l3gd20/%02x/i2c-%d/%02x", cid, bus, addr);
+      setCalibrationStore(key);
+    }
+
   // set a normal power mode (with all axes enabled)
   setPowerMode(POWER_NORMAL);
 
@@ -148,10 +139,7 @@ L3GD20::L3GD20(int bus, int addr)
 
 L3GD20::~L3GD20()
 {
-    if (m_filter.buff) {
-        free(m_filter.buff);
-        m_filter.buff = NULL;
-    }
+    upm_iio_stream_close(m_stream);
     if (m_iio)
         mraa_iio_close(m_iio);
 }
@@ -302,8 +290,7 @@ void L3GD20::update()
   m_gyrZ = ((float(val) * m_gyrScale) / 1000.0) * (M_PI/180.0);
   m_gyrZ = m_gyrZ - m_cal_data.bias_z;
 
-  if (m_calibrated == false)
-    m_calibrated = gyroCollect(m_gyrX, m_gyrY, m_gyrZ);
+  collectCalibration(m_gyrX, m_gyrY, m_gyrZ);
 
   if (m_event_count++ >= GYRO_MIN_SAMPLES)
     {
@@ -410,6 +397,8 @@ L3GD20::enableBuffer(int length)
 bool
 L3GD20::disableBuffer()
 {
+    if (m_stream)
+        upm_iio_stream_release(m_stream);
     mraa_iio_write_int(m_iio, "buffer/enable", 0);
     return true;
 }
@@ -422,6 +411,9 @@ L3GD20::setScale(float scale)
     mraa_iio_write_float(m_iio, "in_anglvel_x_scale", scale);
     mraa_iio_write_float(m_iio, "in_anglvel_y_scale", scale);
     mraa_iio_write_float(m_iio, "in_anglvel_z_scale", scale);
+    // picked up by the next readBuffer()
+    if (m_stream)
+        upm_iio_stream_release(m_stream);
     return true;
 }
 
@@ -445,6 +437,8 @@ L3GD20::enable3AxisChannel()
 
     // need update channel data size after enable
     mraa_iio_update_channels(m_iio);
+    if (m_stream)
+        upm_iio_stream_release(m_stream);
     return true;
 }
 
@@ -482,9 +476,72 @@ L3GD20::extract3Axis(char* data, float* x, float* y, float* z)
         *z = tmp[2];
     }
 
-    /* Attempt gyroscope calibration if we have not reached this state */
-    if (m_calibrated == false)
-        m_calibrated = gyroCollect(*x, *y, *z);
+    filterSample(x, y, z);
+
+    return true;
+}
+
+size_t
+L3GD20::readBuffer(float* buffer, size_t len, int timeoutMs)
+{
+    static const char* axes[3] = { "anglvel_x", "anglvel_y", "anglvel_z" };
+    float* data[UPM_IIO_STREAM_MAX_CHANNELS] = { 0 };
+    size_t count = len / 3;
+
+    if (!m_stream)
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": only supported in IIO mode");
+
+    if (!upm_iio_stream_num_channels(m_stream)) {
+        if (upm_iio_stream_open(m_stream) != UPM_SUCCESS)
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": upm_iio_stream_open() failed, buffer not enabled?");
+
+        // same scale as extract3Axis()
+        for (int i = 0; i < 3; i++)
+            upm_iio_stream_set_scale(m_stream, upm_iio_stream_find_channel(m_stream, axes[i]),
+                                     m_scale);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        int chan = upm_iio_stream_find_channel(m_stream, axes[i]);
+        if (chan < 0)
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": axis scan elements not enabled");
+        data[chan] = buffer + i * count;
+    }
+
+    int n = upm_iio_stream_read(m_stream, data, NULL, count, timeoutMs);
+    if (n < 0)
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": upm_iio_stream_read() failed");
+
+    // the calibration and the median filter work sample by sample,
+    // and the first samples after enable are dropped
+    float* x = buffer;
+    float* y = buffer + count;
+    float* z = buffer + 2 * count;
+    size_t kept = 0;
+
+    for (int i = 0; i < n; i++) {
+        m_event_count++;
+        if (m_event_count < GYRO_MIN_SAMPLES)
+            continue;
+
+        x[kept] = x[i];
+        y[kept] = y[i];
+        z[kept] = z[i];
+        filterSample(&x[kept], &y[kept], &z[kept]);
+        kept++;
+    }
+
+    return kept;
+}
+
+void
+L3GD20::filterSample(float* x, float* y, float* z)
+{
+    collectCalibration(*x, *y, *z);
 
     *x = *x - m_cal_data.bias_x;
     *y = *y - m_cal_data.bias_y;
@@ -493,8 +550,6 @@ L3GD20::extract3Axis(char* data, float* x, float* y, float* z)
 
     gyroDenoiseMedian(x, y, z);
     clampGyroReadingsToZero(x, y, z);
-
-    return true;
 }
 
 void
@@ -530,6 +585,35 @@ L3GD20::loadCalibratedData(float bias_x, float bias_y, float bias_z)
     m_cal_data.bias_z = bias_z;
 }
 
+void
+L3GD20::setCalibrationStore(std::string key)
+{
+    float bias[3];
+
+    m_cal_key = key;
+    if (!key.empty()
+        && upm_cal_store_load(key.c_str(), bias, sizeof(bias)) == UPM_SUCCESS)
+        loadCalibratedData(bias[0], bias[1], bias[2]);
+}
+
+void
+L3GD20::collectCalibration(float x, float y, float z)
+{
+    /* Attempt gyroscope calibration if we have not reached this state */
+    if (m_calibrated)
+        return;
+
+    m_calibrated = gyroCollect(x, y, z);
+
+    // a fresh bias, keep it for the next start
+    if (m_calibrated && !m_cal_key.empty())
+    {
+        float bias[3] = { m_cal_data.bias_x, m_cal_data.bias_y,
+                          m_cal_data.bias_z };
+        upm_cal_store_save_async(m_cal_key.c_str(), bias, sizeof(bias));
+    }
+}
+
 bool
 L3GD20::gyroCollect(float x, float y, float z)
 {
@@ -593,91 +677,17 @@ void
 L3GD20::gyroDenoiseMedian(float* x, float* y, float* z)
 {
     /* Thanks to https://github.com/01org/android-iio-sensors-hal for denoise algorithm */
-    unsigned int offset;
-
-    /* If we are at event count 1 reset the indices */
-    if (m_event_count == 1) {
-        m_filter.count = 0;
-        m_filter.idx = 0;
-    }
-
-    if (m_filter.count < m_filter.sample_size)
-        m_filter.count++;
+    float v[3] = { *x, *y, *z };
 
-    offset = 0;
-    m_filter.buff[offset + m_filter.idx] = *x;
-    *x = median(m_filter.buff + offset, m_filter.count);
+    /* If we are at event count 1 reset the history */
+    if (m_event_count == 1)
+        m_filter.reset();
 
-    offset = m_filter.sample_size * 1;
-    m_filter.buff[offset + m_filter.idx] = *y;
-    *y = median(m_filter.buff + offset, m_filter.count);
-
-    offset = m_filter.sample_size * 2;
-    m_filter.buff[offset + m_filter.idx] = *z;
-    *z = median(m_filter.buff + offset, m_filter.count);
-
-    m_filter.idx = (m_filter.idx + 1) % m_filter.sample_size;
-}
-
-float
-L3GD20::median(float* queue, unsigned int size)
-{
-    /* http://en.wikipedia.org/wiki/Quickselect */
-
-    unsigned int left = 0;
-    unsigned int right = size - 1;
-    unsigned int pivot_index;
-    unsigned int median_index = (right / 2);
-    float temp[size];
-
-    memcpy(temp, queue, size * sizeof(float));
-
-    /* If the list has only one element return it */
-    if (left == right)
-        return temp[left];
-
-    while (left < right) {
-        pivot_index = (left + right) / 2;
-        pivot_index = partition(temp, left, right, pivot_index);
-        if (pivot_index == median_index)
-            return temp[median_index];
-        else if (pivot_index > median_index)
-            right = pivot_index - 1;
-        else
-            left = pivot_index + 1;
-    }
-
-    return temp[left];
-}
-
-unsigned int
-L3GD20::partition(float* list, unsigned int left, unsigned int right, unsigned int pivot_index)
-{
-    unsigned int i;
-    unsigned int store_index = left;
-    float aux;
-    float pivot_value = list[pivot_index];
-
-    /* Swap list[pivotIndex] and list[right] */
-    aux = list[pivot_index];
-    list[pivot_index] = list[right];
-    list[right] = aux;
-
-    for (i = left; i < right; i++) {
-        if (list[i] < pivot_value) {
-            /* Swap list[store_index] and list[i] */
-            aux = list[store_index];
-            list[store_index] = list[i];
-            list[i] = aux;
-            store_index++;
-        }
-    }
+    m_filter.filter(v, v);
 
-    /* Swap list[right] and list[store_index] */
-    aux = list[right];
-    list[right] = list[store_index];
-    list[store_index] = aux;
-    return store_index;
+    *x = v[0];
+    *y = v[1];
+    *z = v[2];
 }
 
 void
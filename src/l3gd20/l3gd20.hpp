@@ -17,6 +17,9 @@
 
 #include <interfaces/iGyroscope.hpp>
 
+#include "upm_iio_stream.h"
+#include "upm_filters.hpp"
+
 #define L3GD20_DEFAULT_I2C_BUS                      0
 // if SDO tied to GND
 #define L3GD20_DEFAULT_I2C_ADDR                     0x6a
@@ -70,13 +73,6 @@ class L3GD20: virtual public iGyroscope
         float max_x, max_y, max_z;
     } gyro_cal_t;
 
-    typedef struct {
-        float* buff;
-        unsigned int idx;
-        unsigned int count;
-        unsigned int sample_size;
-    } filter_median_t;
-
     // NOTE: Reserved registers must not be written into or permanent
     // device damage can result.  Reading from them may return
     // indeterminate values.  Registers containing reserved bitfields
@@ -599,6 +595,27 @@ class L3GD20: virtual public iGyroscope
      */
     bool extract3Axis(char* data, float* x, float* y, float* z);
 
+    /**
+     * Read a block of samples from the trigger buffer, as an
+     * alternative to installISR() and extract3Axis().  IIO only.  Call
+     * enable3AxisChannel() and enableBuffer() first.  Waits up to
+     * timeoutMs for the first sample, then returns the samples already
+     * buffered, as many as fit.  The samples go through the same
+     * calibration and denoise steps as with extract3Axis().
+     *
+     * The samples are stored by axis: the first third of the buffer
+     * receives the x values, the second the y and the last the z
+     * values.  Units are radians per second.
+     *
+     * @param buffer Array to store the samples in
+     * @param len Size of the array, in floats
+     * @param timeoutMs Maximum time to wait in milliseconds, -1 to wait
+     * forever
+     * @return Number of samples read, 0 on timeout
+     * @throws std::runtime_error on failure
+     */
+    size_t readBuffer(float* buffer, size_t len, int timeoutMs = -1);
+
     /**
      * Reset calibration data and start collect calibration data again
      */
@@ -619,6 +636,18 @@ class L3GD20: virtual public iGyroscope
      */
     void loadCalibratedData(float bias_x, float bias_y, float bias_z);
 
+    /**
+     * Keep the gyroscope bias in the calibration store (see
+     * upm_cal_store.h).  A bias saved under the key is loaded right
+     * away, and a new one is saved whenever calibration completes.
+     * The constructors do this by themselves when the store is
+     * enabled, with the key "l3gd20/<chip id>/i2c-<bus>/<address>", or
+     * one made by upm_cal_store_iio_key() for IIO devices.
+     *
+     * @param key Device key, or an empty string to stop using the store
+     */
+    void setCalibrationStore(std::string key);
+
     /**
      * Read a register. I2C mode only.
      *
@@ -660,23 +689,6 @@ class L3GD20: virtual public iGyroscope
      */
     void gyroDenoiseMedian(float* x, float* y, float* z);
 
-    /**
-     * median algorithm
-     * @param queue
-     * @param size
-     */
-    float median(float* queue, unsigned int size);
-
-    /**
-     * partition algorithm
-     * @param list
-     * @param left
-     * @param right
-     * @param pivot_index
-     */
-    unsigned int
-    partition(float* list, unsigned int left, unsigned int right, unsigned int pivot_index);
-
     /**
      * Clamp Gyro Readings to Zero
      * @param x X-Axis
@@ -695,6 +707,7 @@ class L3GD20: virtual public iGyroscope
 
   private:
     mraa_iio_context m_iio;
+    upm_iio_stream_context m_stream; // block reader
 
     int m_iio_device_num;
     bool m_mount_matrix_exist; // is mount matrix exist
@@ -703,6 +716,13 @@ class L3GD20: virtual public iGyroscope
     int m_event_count;         // sample data arrive
     bool m_calibrated;         // calibrate state
     gyro_cal_t m_cal_data;     // calibrate data
-    filter_median_t m_filter;  // filter data
+    MovingMedian<float, 3, 5> m_filter; // denoise filter
+    std::string m_cal_key;     // calibration store key
+
+    // feed a sample to the bias calibration until it completes
+    void collectCalibration(float x, float y, float z);
+
+    // calibrate and denoise a scaled sample
+    void filterSample(float* x, float* y, float* z);
 };
 }
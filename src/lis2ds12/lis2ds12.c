@@ -31,6 +31,12 @@
 #undef _SHIFTMASK
 #define _SHIFTMASK(x) (_MASK(x) << _SHIFT(x))
 
+// FIFO decoders for the low power, high frequency and high
+// resolution modes
+UPM_FIFO_DECODER_XYZ16(_decode_10b, 10)
+UPM_FIFO_DECODER_XYZ16(_decode_12b, 12)
+UPM_FIFO_DECODER_XYZ16(_decode_14b, 14)
+
 // SPI CS on and off functions
 static void _csOn(const lis2ds12_context dev)
 {
@@ -211,6 +217,24 @@ upm_result_t lis2ds12_set_odr(const lis2ds12_context dev,
 
     // mask it off and set it
     odr &= _MASK(CTRL1_ODR);
+
+    // the low power ODRs (8-15) sample at 10b, HF mode at 12b, and
+    // the rest at 14b
+    if (hf_mode)
+    {
+        dev->fifoDecode = _decode_12b;
+        dev->fifoShift = 4;
+    }
+    else if (odr >= LIS2DS12_ODR_LP_1HZ)
+    {
+        dev->fifoDecode = _decode_10b;
+        dev->fifoShift = 6;
+    }
+    else
+    {
+        dev->fifoDecode = _decode_14b;
+        dev->fifoShift = 2;
+    }
     reg |= (odr << _SHIFT(CTRL1_ODR));
 
     // set the HF bit appropriately
@@ -541,6 +565,101 @@ uint8_t lis2ds12_get_status(const lis2ds12_context dev)
     return lis2ds12_read_reg(dev, LIS2DS12_REG_STATUS);
 }
 
+upm_result_t lis2ds12_set_fifo_mode(const lis2ds12_context dev,
+                                    LIS2DS12_FMODE_T mode,
+                                    int threshold)
+{
+    assert(dev != NULL);
+
+    if (threshold < 0 || threshold > 255)
+    {
+        printf("%s: threshold must be between 0 and 255\n", __FUNCTION__);
+        return UPM_ERROR_INVALID_PARAMETER;
+    }
+
+    uint8_t reg = lis2ds12_read_reg(dev, LIS2DS12_REG_FIFO_CTRL);
+
+    // going through bypass mode empties the FIFO
+    reg &= ~_SHIFTMASK(FIFO_CTRL_FMODE);
+    if (lis2ds12_write_reg(dev, LIS2DS12_REG_FIFO_CTRL, reg))
+        return UPM_ERROR_OPERATION_FAILED;
+
+    uint8_t reg4 = lis2ds12_read_reg(dev, LIS2DS12_REG_CTRL4);
+
+    if (mode != LIS2DS12_FMODE_BYPASS)
+        reg4 |= LIS2DS12_CTRL4_INT1_FTH;
+    else
+        reg4 &= ~LIS2DS12_CTRL4_INT1_FTH;
+
+    if (lis2ds12_write_reg(dev, LIS2DS12_REG_FIFO_THS, threshold)
+        || lis2ds12_write_reg(dev, LIS2DS12_REG_CTRL4, reg4))
+        return UPM_ERROR_OPERATION_FAILED;
+
+    if (mode != LIS2DS12_FMODE_BYPASS)
+    {
+        reg |= (mode << _SHIFT(FIFO_CTRL_FMODE));
+        if (lis2ds12_write_reg(dev, LIS2DS12_REG_FIFO_CTRL, reg))
+            return UPM_ERROR_OPERATION_FAILED;
+    }
+
+    return UPM_SUCCESS;
+}
+
+int lis2ds12_drain_fifo(const lis2ds12_context dev, float *buffer,
+                        int frames)
+{
+    assert(dev != NULL);
+
+    // FIFO_SRC holds the overrun flag and bit 8 of the sample count,
+    // FIFO_SAMPLES the rest
+    uint8_t src[2];
+
+    if (lis2ds12_read_regs(dev, LIS2DS12_REG_FIFO_SRC, src, 2) != 2)
+    {
+        printf("%s: lis2ds12_read_regs() failed to read FIFO status\n",
+               __FUNCTION__);
+        return -1;
+    }
+
+    int count = src[1];
+    if (src[0] & LIS2DS12_FIFO_SRC_DIFF8)
+        count |= 0x100;
+
+    if (src[0] & LIS2DS12_FIFO_SRC_FIFO_OVR)
+        dev->fifoOverruns++;
+
+    if (count > frames)
+        count = frames;
+
+    if (!count)
+        return 0;
+
+    // with the FIFO in use, the address rolls back from OUT_Z_H to
+    // OUT_X_L, so one burst returns all the samples
+    int bufLen = count * 6;
+    uint8_t buf[LIS2DS12_FIFO_SIZE * 6];
+
+    if (lis2ds12_read_regs(dev, LIS2DS12_REG_OUT_X_L, buf, bufLen) != bufLen)
+    {
+        printf("%s: lis2ds12_read_regs() failed to read %d bytes\n",
+               __FUNCTION__, bufLen);
+        return -1;
+    }
+
+    dev->fifoDecode(buf, count,
+                    (dev->accScale / 1000.0) * (1 << dev->fifoShift),
+                    buffer);
+
+    return count;
+}
+
+int lis2ds12_get_fifo_overruns(const lis2ds12_context dev)
+{
+    assert(dev != NULL);
+
+    return dev->fifoOverruns;
+}
+
 upm_result_t lis2ds12_install_isr(const lis2ds12_context dev,
                                   LIS2DS12_INTERRUPT_PINS_T intr, int gpio,
                                   mraa_gpio_edge_t level,
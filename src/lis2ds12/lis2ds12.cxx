@@ -180,6 +180,32 @@ uint8_t LIS2DS12::getStatus()
     return lis2ds12_get_status(m_lis2ds12);
 }
 
+void LIS2DS12::setFifoMode(LIS2DS12_FMODE_T mode, int threshold)
+{
+    if (lis2ds12_set_fifo_mode(m_lis2ds12, mode, threshold))
+        throw std::runtime_error(string(__FUNCTION__)
+                                 + ": lis2ds12_set_fifo_mode() failed");
+}
+
+std::vector<float> LIS2DS12::drainFifo()
+{
+    std::vector<float> v(LIS2DS12_FIFO_SIZE * 3);
+
+    int count = lis2ds12_drain_fifo(m_lis2ds12, v.data(),
+                                    LIS2DS12_FIFO_SIZE);
+    if (count < 0)
+        throw std::runtime_error(string(__FUNCTION__)
+                                 + ": lis2ds12_drain_fifo() failed");
+
+    v.resize(count * 3);
+    return v;
+}
+
+int LIS2DS12::getFifoOverruns()
+{
+    return lis2ds12_get_fifo_overruns(m_lis2ds12);
+}
+
 void LIS2DS12::installISR(LIS2DS12_INTERRUPT_PINS_T intr, int gpio,
                           mraa::Edge level,
                           void (*isr)(void *), void *arg)
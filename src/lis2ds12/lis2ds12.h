@@ -20,6 +20,7 @@
 #include <mraa/gpio.h>
 
 #include "upm.h"
+#include "upm_fifo_decode.h"
 
 #include "lis2ds12_defs.h"
 
@@ -56,6 +57,14 @@ extern "C" {
 
         // acc scaling
         float accScale;
+
+        // FIFO sample decoder for the current ODR mode, and the
+        // number of unused low bits it shifts out
+        upm_fifo_decoder_t fifoDecode;
+        int fifoShift;
+
+        // FIFO overruns seen by lis2ds12_drain_fifo()
+        int fifoOverruns;
     } *lis2ds12_context;
 
     /**
@@ -243,6 +252,45 @@ extern "C" {
      */
     uint8_t lis2ds12_get_status(const lis2ds12_context dev);
 
+    /**
+     * Set the FIFO mode.  In any mode but bypass, the FIFO threshold
+     * interrupt is routed to INT1, so samples can be collected in
+     * batches with lis2ds12_drain_fifo() from an interrupt handler.
+     * The FIFO is emptied first.  While the FIFO is in use,
+     * lis2ds12_update() returns the oldest sample in it.
+     *
+     * @param dev The device context
+     * @param mode One of the LIS2DS12_FMODE_T values
+     * @param threshold Threshold level, 0-255 samples
+     * @return UPM result
+     */
+    upm_result_t lis2ds12_set_fifo_mode(const lis2ds12_context dev,
+                                        LIS2DS12_FMODE_T mode,
+                                        int threshold);
+
+    /**
+     * Read all unread samples from the FIFO in one burst and return
+     * them in gravities, decoded for the current ODR mode (low
+     * power, high resolution or high frequency).
+     *
+     * @param dev The device context
+     * @param buffer Buffer for 3 floats (x, y and z) per sample
+     * @param frames Maximum number of samples to read, the FIFO
+     * holds up to LIS2DS12_FIFO_SIZE
+     * @return Number of samples read, or -1 on error
+     */
+    int lis2ds12_drain_fifo(const lis2ds12_context dev, float *buffer,
+                            int frames);
+
+    /**
+     * Return the number of times lis2ds12_drain_fifo() found the FIFO
+     * overrun, losing samples
+     *
+     * @param dev The device context
+     * @return Overrun count
+     */
+    int lis2ds12_get_fifo_overruns(const lis2ds12_context dev);
+
     /**
      * Install an interrupt handler
      *
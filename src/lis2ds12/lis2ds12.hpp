@@ -243,6 +243,36 @@ namespace upm {
          */
         uint8_t getStatus();
 
+        /**
+         * Set the FIFO mode.  In any mode but bypass, the FIFO
+         * threshold interrupt is routed to INT1, so samples can be
+         * collected in batches with drainFifo() from an interrupt
+         * handler.  The FIFO is emptied first.  While the FIFO is in
+         * use, update() returns the oldest sample in it.
+         *
+         * @param mode One of the LIS2DS12_FMODE_T values
+         * @param threshold Threshold level, 0-255 samples
+         * @throws std::runtime_error on failure
+         */
+        void setFifoMode(LIS2DS12_FMODE_T mode, int threshold=0);
+
+        /**
+         * Read all unread samples from the FIFO in one burst.
+         *
+         * @return Vector of x, y and z in gravities for each sample,
+         * oldest first
+         * @throws std::runtime_error on failure
+         */
+        std::vector<float> drainFifo();
+
+        /**
+         * Return the number of times drainFifo() found the FIFO
+         * overrun, losing samples
+         *
+         * @return Overrun count
+         */
+        int getFifoOverruns();
+
         /**
          * install an interrupt handler
          *
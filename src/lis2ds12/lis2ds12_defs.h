@@ -23,6 +23,9 @@ extern "C" {
 
 #define LIS2DS12_CHIPID 0x43
 
+// FIFO depth, in XYZ samples
+#define LIS2DS12_FIFO_SIZE 256
+
     // NOTE: Reserved registers must not be written into or permanent
     // damage can result.  Reading from them may return indeterminate
     // values.  Registers containing reserved bitfields must be
@@ -34,6 +34,27 @@
 #undef _SHIFTMASK
 #define _SHIFTMASK(x) (_MASK(x) << _SHIFT(x))
 
+// FIFO decoders for the low power, normal and high resolution modes
+UPM_FIFO_DECODER_XYZ16(_decode_8b, 8)
+UPM_FIFO_DECODER_XYZ16(_decode_10b, 10)
+UPM_FIFO_DECODER_XYZ16(_decode_12b, 12)
+
+// Pick the FIFO decoder matching the LP and HR bits
+static void
+_select_fifo_decoder(const lis3dh_context dev)
+{
+    if (lis3dh_read_reg(dev, LIS3DH_REG_CTRL_REG1) & LIS3DH_CTRL_REG1_LPEN) {
+        dev->fifoDecode = _decode_8b;
+        dev->fifoShift = 8;
+    } else if (lis3dh_read_reg(dev, LIS3DH_REG_CTRL_REG4) & LIS3DH_CTRL_REG4_HR) {
+        dev->fifoDecode = _decode_12b;
+        dev->fifoShift = 4;
+    } else {
+        dev->fifoDecode = _decode_10b;
+        dev->fifoShift = 6;
+    }
+}
+
 // SPI CS on and off functions
 static void
 _csOn(const lis3dh_context dev)
@@ -277,6 +298,8 @@ lis3dh_enable_lp_mode(const lis3dh_context dev, bool lp_enable)
         return UPM_ERROR_OPERATION_FAILED;
     }
 
+    _select_fifo_decoder(dev);
+
     return UPM_SUCCESS;
 }
 
@@ -311,6 +334,8 @@ lis3dh_enable_hr_mode(const lis3dh_context dev, bool hr_enable)
         return UPM_ERROR_OPERATION_FAILED;
     }
 
+    _select_fifo_decoder(dev);
+
     return UPM_SUCCESS;
 }
 
@@ -729,6 +754,105 @@ lis3dh_get_status_aux(const lis3dh_context dev)
     return lis3dh_read_reg(dev, LIS3DH_REG_STATUS_REG_AUX);
 }
 
+upm_result_t
+lis3dh_set_fifo_mode(const lis3dh_context dev, LIS3DH_FM_T mode, int threshold)
+{
+    assert(dev != NULL);
+
+    if (threshold < 0 || threshold > _MASK(FIFO_CTRL_REG_FTH)) {
+        printf("%s: threshold must be between 0 and 31\n", __FUNCTION__);
+        return UPM_ERROR_INVALID_PARAMETER;
+    }
+
+    bool enable = (mode != LIS3DH_FM_BYPASS);
+
+    // Going through bypass mode empties the FIFO
+    if (lis3dh_write_reg(dev, LIS3DH_REG_FIFO_CTRL_REG, 0)) {
+        printf("%s: failed to reset FIFO\n", __FUNCTION__);
+        return UPM_ERROR_OPERATION_FAILED;
+    }
+
+    uint8_t reg5 = lis3dh_read_reg(dev, LIS3DH_REG_CTRL_REG5);
+    uint8_t reg3 = lis3dh_read_reg(dev, LIS3DH_REG_CTRL_REG3);
+
+    if (enable) {
+        reg5 |= LIS3DH_CTRL_REG5_FIFO_EN;
+        reg3 |= LIS3DH_CTRL_REG3_I1_WTM;
+    } else {
+        reg5 &= ~LIS3DH_CTRL_REG5_FIFO_EN;
+        reg3 &= ~LIS3DH_CTRL_REG3_I1_WTM;
+    }
+
+    if (lis3dh_write_reg(dev, LIS3DH_REG_CTRL_REG5, reg5) ||
+        lis3dh_write_reg(dev, LIS3DH_REG_CTRL_REG3, reg3)) {
+        printf("%s: failed to enable FIFO\n", __FUNCTION__);
+        return UPM_ERROR_OPERATION_FAILED;
+    }
+
+    if (enable) {
+        uint8_t reg = (mode << _SHIFT(FIFO_CTRL_REG_FM)) |
+                      (threshold << _SHIFT(FIFO_CTRL_REG_FTH));
+
+        if (lis3dh_write_reg(dev, LIS3DH_REG_FIFO_CTRL_REG, reg)) {
+            printf("%s: failed to set FIFO mode\n", __FUNCTION__);
+            return UPM_ERROR_OPERATION_FAILED;
+        }
+    }
+
+    return UPM_SUCCESS;
+}
+
+int
+lis3dh_drain_fifo(const lis3dh_context dev, float* buffer, int frames)
+{
+    assert(dev != NULL);
+
+    uint8_t src = lis3dh_read_reg(dev, LIS3DH_REG_FIFO_SRC_REG);
+    int count;
+
+    if (src & LIS3DH_FIFO_SRC_REG_OVRN_FIFO) {
+        // Full, and the oldest samples have been overwritten
+        count = LIS3DH_FIFO_SIZE;
+        dev->fifoOverruns++;
+    } else if (src & LIS3DH_FIFO_SRC_REG_EMPTY) {
+        count = 0;
+    } else {
+        count = (src >> _SHIFT(FIFO_SRC_REG_FSS)) & _MASK(FIFO_SRC_REG_FSS);
+    }
+
+    if (count > frames) {
+        count = frames;
+    }
+
+    if (!count) {
+        return 0;
+    }
+
+    // With the FIFO enabled, the address rolls back from OUT_Z_H to
+    // OUT_X_L, so one burst returns all the samples
+    const int bufLen = count * 6;
+    uint8_t buf[LIS3DH_FIFO_SIZE * 6];
+
+    if (lis3dh_read_regs(dev, LIS3DH_REG_OUT_X_L, buf, bufLen) != bufLen) {
+        printf("%s: lis3dh_read_regs() failed to read %d bytes of FIFO data\n",
+               __FUNCTION__,
+               bufLen);
+        return -1;
+    }
+
+    dev->fifoDecode(buf, count, dev->accScale * (1 << dev->fifoShift), buffer);
+
+    return count;
+}
+
+int
+lis3dh_get_fifo_overruns(const lis3dh_context dev)
+{
+    assert(dev != NULL);
+
+    return dev->fifoOverruns;
+}
+
 upm_result_t
 lis3dh_install_isr(const lis3dh_context dev,
                    LIS3DH_INTERRUPT_PINS_T intr,
@@ -253,6 +253,34 @@ LIS3DH::getStatusAux()
     return lis3dh_get_status_aux(m_lis3dh);
 }
 
+void
+LIS3DH::setFifoMode(LIS3DH_FM_T mode, int threshold)
+{
+    if (lis3dh_set_fifo_mode(m_lis3dh, mode, threshold)) {
+        throw std::runtime_error(string(__FUNCTION__) + ": lis3dh_set_fifo_mode() failed");
+    }
+}
+
+std::vector<float>
+LIS3DH::drainFifo()
+{
+    std::vector<float> v(LIS3DH_FIFO_SIZE * 3);
+
+    int count = lis3dh_drain_fifo(m_lis3dh, v.data(), LIS3DH_FIFO_SIZE);
+    if (count < 0) {
+        throw std::runtime_error(string(__FUNCTION__) + ": lis3dh_drain_fifo() failed");
+    }
+
+    v.resize(count * 3);
+    return v;
+}
+
+int
+LIS3DH::getFifoOverruns()
+{
+    return lis3dh_get_fifo_overruns(m_lis3dh);
+}
+
 void
 LIS3DH::installISR(LIS3DH_INTERRUPT_PINS_T intr,
                    int gpio,
@@ -24,6 +24,7 @@
 #include <mraa/spi.h>
 
 #include "upm.h"
+#include "upm_fifo_decode.h"
 
 #include "lis3dh_defs.h"
 
@@ -65,6 +66,14 @@ typedef struct _lis3dh_context {
     // Acceleration scaling - used to calculate actual acceleration,
     // depending on sensor working mode (low power/normal/high resolution)
     float accScale;
+
+    // FIFO sample decoder for the current resolution, and the number
+    // of unused low bits it shifts out
+    upm_fifo_decoder_t fifoDecode;
+    int fifoShift;
+
+    // FIFO overruns seen by lis3dh_drain_fifo()
+    int fifoOverruns;
 } * lis3dh_context;
 
 /**
@@ -334,6 +343,43 @@ uint8_t lis3dh_get_status(const lis3dh_context dev);
  */
 uint8_t lis3dh_get_status_aux(const lis3dh_context dev);
 
+/**
+ * Set the FIFO mode.  In any mode but bypass the FIFO is enabled and
+ * its watermark interrupt is routed to INT1, so samples can be
+ * collected in batches with lis3dh_drain_fifo() from an interrupt
+ * handler.  The FIFO is emptied first.  While the FIFO is enabled,
+ * lis3dh_update() returns the oldest sample in it.
+ *
+ * @param dev The device context
+ * @param mode One of the LIS3DH_FM_T values
+ * @param threshold Watermark level, 0-31 samples
+ * @return UPM result
+ */
+upm_result_t lis3dh_set_fifo_mode(const lis3dh_context dev,
+                                  LIS3DH_FM_T mode,
+                                  int threshold);
+
+/**
+ * Read all unread samples from the FIFO in one burst and return them
+ * in gravities, decoded for the current power mode.
+ *
+ * @param dev The device context
+ * @param buffer Buffer for 3 floats (x, y and z) per sample
+ * @param frames Maximum number of samples to read, the FIFO holds up
+ * to LIS3DH_FIFO_SIZE
+ * @return Number of samples read, or -1 on error
+ */
+int lis3dh_drain_fifo(const lis3dh_context dev, float* buffer, int frames);
+
+/**
+ * Return the number of times lis3dh_drain_fifo() found the FIFO
+ * overrun, losing samples
+ *
+ * @param dev The device context
+ * @return Overrun count
+ */
+int lis3dh_get_fifo_overruns(const lis3dh_context dev);
+
 /**
  * Install an interrupt handler
  *
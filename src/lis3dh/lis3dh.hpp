@@ -325,6 +325,36 @@ class LIS3DH: virtual public iAcceleration
      */
     uint8_t getStatusAux();
 
+    /**
+     * Set the FIFO mode.  In any mode but bypass the FIFO is enabled
+     * and its watermark interrupt is routed to INT1, so samples can
+     * be collected in batches with drainFifo() from an interrupt
+     * handler.  The FIFO is emptied first.  While the FIFO is
+     * enabled, update() returns the oldest sample in it.
+     *
+     * @param mode One of the LIS3DH_FM_T values
+     * @param threshold Watermark level, 0-31 samples
+     * @throws std::runtime_error on failure
+     */
+    void setFifoMode(LIS3DH_FM_T mode, int threshold = 0);
+
+    /**
+     * Read all unread samples from the FIFO in one burst.
+     *
+     * @return A floating point vector containing x, y and z in
+     * gravities for each sample, oldest first
+     * @throws std::runtime_error on failure
+     */
+    std::vector<float> drainFifo();
+
+    /**
+     * Return the number of times drainFifo() found the FIFO overrun,
+     * losing samples
+     *
+     * @return Overrun count
+     */
+    int getFifoOverruns();
+
     /**
      * Install an interrupt handler
      *
@@ -26,6 +26,9 @@ extern "C" {
 
 #define LIS3DH_CHIPID 0x33
 
+// FIFO depth, in XYZ samples
+#define LIS3DH_FIFO_SIZE 32
+
 // NOTE: Reserved registers must not be written into or permanent
 // damage can result. Reading from them may return indeterminate
 // values. Registers containing reserved bitfields must be
@@ -10,21 +10,39 @@
  */
 
 #include <iostream>
+#include <stdexcept>
+#include <string>
 
 #include "loudness.hpp"
 
 using namespace std;
 using namespace upm;
 
+static upm_result_t readAio(void *ctx, float *value)
+{
+  try {
+    *value = static_cast<mraa::Aio *>(ctx)->read();
+  } catch (std::exception&) {
+    return UPM_ERROR_OPERATION_FAILED;
+  }
+  return UPM_SUCCESS;
+}
+
 Loudness::Loudness(int pin, float aref) :
   m_aio(pin)
 {
   m_aRes = m_aio.getBit();
   m_aref = aref;
+
+  // history is not used
+  if (!(m_sampler = upm_aio_sampler_init(readAio, &m_aio, 100, 1)))
+    throw std::runtime_error(string(__FUNCTION__) +
+                             ": upm_aio_sampler_init() failed");
 }
 
 Loudness::~Loudness()
 {
+  upm_aio_sampler_close(m_sampler);
 }
 
 float Loudness::loudness()
@@ -33,3 +51,41 @@ float Loudness::loudness()
 
   return(val * (m_aref / float(1 << m_aRes)));
 }
+
+void Loudness::startSampling(float rateHz)
+{
+  if (upm_aio_sampler_set_rate(m_sampler, rateHz) != UPM_SUCCESS)
+    throw std::invalid_argument(string(__FUNCTION__) +
+                                ": Invalid rate or already sampling");
+
+  upm_aio_sampler_reset_stats(m_sampler);
+  if (upm_aio_sampler_start(m_sampler) != UPM_SUCCESS)
+    throw std::runtime_error(string(__FUNCTION__) +
+                             ": upm_aio_sampler_start() failed");
+}
+
+void Loudness::stopSampling()
+{
+  upm_aio_sampler_stop(m_sampler);
+}
+
+void Loudness::resetStatistics()
+{
+  upm_aio_sampler_reset_stats(m_sampler);
+}
+
+float Loudness::getAverage()
+{
+  upm_aio_stats_t stats;
+  upm_aio_sampler_get_stats(m_sampler, &stats);
+
+  return(stats.mean * (m_aref / float(1 << m_aRes)));
+}
+
+float Loudness::getPeak()
+{
+  upm_aio_stats_t stats;
+  upm_aio_sampler_get_stats(m_sampler, &stats);
+
+  return(stats.max * (m_aref / float(1 << m_aRes)));
+}
@@ -14,6 +14,8 @@
 #include <string>
 #include <mraa/aio.hpp>
 
+#include "upm_aio_sampler.h"
+
 namespace upm {
   /**
    * @brief Loudness Sensors Library
@@ -43,6 +45,9 @@ namespace upm {
    * This driver was developed using the DFRobot Loudness Sensor V2
    * and the Grove Loudness sensor.
    *
+   * startSampling() samples the output in the background at a fixed
+   * rate, on absolute deadlines, and tracks its average and peak.
+   *
    * @image html groveloudness.jpg
    * @snippet loudness.cxx Interesting
    */
@@ -70,6 +75,37 @@ namespace upm {
      */
     float loudness();
 
+    /**
+     * Starts sampling in the background and restarts the statistics
+     *
+     * @param rateHz Sample rate in Hz
+     */
+    void startSampling(float rateHz);
+
+    /**
+     * Stops background sampling
+     */
+    void stopSampling();
+
+    /**
+     * Restarts the statistics
+     */
+    void resetStatistics();
+
+    /**
+     * Returns the average voltage since the statistics were restarted
+     *
+     * @return Average voltage
+     */
+    float getAverage();
+
+    /**
+     * Returns the highest voltage since the statistics were restarted
+     *
+     * @return Peak voltage
+     */
+    float getPeak();
+
   protected:
     mraa::Aio m_aio;
 
@@ -77,6 +113,7 @@ namespace upm {
     float m_aref;
     // ADC resolution
     int m_aRes;
+    upm_aio_sampler_context m_sampler;
   };
 }
 
@@ -29,6 +29,12 @@
 #undef _SHIFTMASK
 #define _SHIFTMASK(x) (_MASK(x) << _SHIFT(x))
 
+// acc FIFO decoders for the low power, normal and high resolution
+// modes
+UPM_FIFO_DECODER_XYZ16(_decode_8b, 8)
+UPM_FIFO_DECODER_XYZ16(_decode_10b, 10)
+UPM_FIFO_DECODER_XYZ16(_decode_12b, 12)
+
 
 // init
 lsm303agr_context lsm303agr_init(int bus, int acc_addr, int mag_addr)
@@ -271,16 +277,19 @@ upm_result_t lsm303agr_set_power_mode(const lsm303agr_context dev,
         case LSM303AGR_POWER_LOW_POWER:
             reg1 |= LSM303AGR_CTRL_REG1_A_LPEN;
             reg4 &= ~LSM303AGR_CTRL_REG4_A_HR;
+            dev->fifoDecode = _decode_8b;
             break;
 
         case LSM303AGR_POWER_NORMAL:
             reg1 &= ~LSM303AGR_CTRL_REG1_A_LPEN;
             reg4 &= ~LSM303AGR_CTRL_REG4_A_HR;
+            dev->fifoDecode = _decode_10b;
             break;
 
         case LSM303AGR_POWER_HIGH_RESOLUTION:
             reg1 &= ~LSM303AGR_CTRL_REG1_A_LPEN;
             reg4 |= LSM303AGR_CTRL_REG4_A_HR;
+            dev->fifoDecode = _decode_12b;
             break;
         }
 
@@ -696,6 +705,108 @@ uint8_t lsm303agr_get_mag_int_src(const lsm303agr_context dev)
     return lsm303agr_read_reg(dev, LSM303AGR_REG_INT_SRC_REG_M);
 }
 
+upm_result_t lsm303agr_set_fifo_mode(const lsm303agr_context dev,
+                                     LSM303AGR_A_FM_T mode,
+                                     int threshold)
+{
+    assert(dev != NULL);
+
+    if (!dev->i2cACC)
+        return UPM_ERROR_NO_RESOURCES;
+
+    if (threshold < 0 || threshold > _MASK(FIFO_CTRL_REG_A_FTH))
+    {
+        printf("%s: threshold must be between 0 and 31\n", __FUNCTION__);
+        return UPM_ERROR_INVALID_PARAMETER;
+    }
+
+    bool enable = (mode != LSM303AGR_A_FM_BYPASS);
+
+    // going through bypass mode empties the FIFO
+    if (lsm303agr_write_reg(dev, LSM303AGR_REG_FIFO_CTRL_REG_A, 0))
+        return UPM_ERROR_OPERATION_FAILED;
+
+    uint8_t reg5 = lsm303agr_read_reg(dev, LSM303AGR_REG_CTRL_REG5_A);
+    uint8_t reg3 = lsm303agr_read_reg(dev, LSM303AGR_REG_CTRL_REG3_A);
+
+    if (enable)
+    {
+        reg5 |= LSM303AGR_CTRL_REG5_A_FIFO_EN;
+        reg3 |= LSM303AGR_CTRL_REG3_A_I1_WTM;
+    }
+    else
+    {
+        reg5 &= ~LSM303AGR_CTRL_REG5_A_FIFO_EN;
+        reg3 &= ~LSM303AGR_CTRL_REG3_A_I1_WTM;
+    }
+
+    if (lsm303agr_write_reg(dev, LSM303AGR_REG_CTRL_REG5_A, reg5)
+        || lsm303agr_write_reg(dev, LSM303AGR_REG_CTRL_REG3_A, reg3))
+        return UPM_ERROR_OPERATION_FAILED;
+
+    // the threshold field starts at bit 0
+    if (enable
+        && lsm303agr_write_reg(dev, LSM303AGR_REG_FIFO_CTRL_REG_A,
+                               (mode << _SHIFT(FIFO_CTRL_REG_A_FM))
+                               | threshold))
+        return UPM_ERROR_OPERATION_FAILED;
+
+    return UPM_SUCCESS;
+}
+
+int lsm303agr_drain_fifo(const lsm303agr_context dev, float *buffer,
+                         int frames)
+{
+    assert(dev != NULL);
+
+    if (!dev->i2cACC)
+        return -1;
+
+    uint8_t src = lsm303agr_read_reg(dev, LSM303AGR_REG_FIFO_SRC_REG_A);
+    int count;
+
+    if (src & LSM303AGR_FIFO_SRC_REG_A_OVRN_FIFO)
+    {
+        // full, and the oldest samples have been overwritten
+        count = LSM303AGR_FIFO_SIZE;
+        dev->fifoOverruns++;
+    }
+    else if (src & LSM303AGR_FIFO_SRC_REG_A_EMPTY)
+        count = 0;
+    else
+        count = (src >> _SHIFT(FIFO_SRC_REG_A_FSS))
+            & _MASK(FIFO_SRC_REG_A_FSS);
+
+    if (count > frames)
+        count = frames;
+
+    if (!count)
+        return 0;
+
+    // with the FIFO enabled, the address rolls back from OUT_Z_H_A to
+    // OUT_X_L_A, so one burst returns all the samples
+    int bufLen = count * 6;
+    uint8_t buf[LSM303AGR_FIFO_SIZE * 6];
+
+    if (lsm303agr_read_regs(dev, LSM303AGR_REG_OUT_X_L_A, buf,
+                            bufLen) != bufLen)
+    {
+        printf("%s: lsm303agr_read_regs() failed.\n", __FUNCTION__);
+        return -1;
+    }
+
+    dev->fifoDecode(buf, count, dev->accScale / 1000.0, buffer);
+
+    return count;
+}
+
+int lsm303agr_get_fifo_overruns(const lsm303agr_context dev)
+{
+    assert(dev != NULL);
+
+    return dev->fifoOverruns;
+}
+
 upm_result_t lsm303agr_install_isr(const lsm303agr_context dev,
                                    LSM303AGR_INTERRUPT_PINS_T intr, int gpio,
                                    mraa_gpio_edge_t level,
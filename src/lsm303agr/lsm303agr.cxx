@@ -189,6 +189,32 @@ uint8_t LSM303AGR::getMagnetometerIntSrc()
     return lsm303agr_get_mag_int_src(m_lsm303agr);
 }
 
+void LSM303AGR::setFifoMode(LSM303AGR_A_FM_T mode, int threshold)
+{
+    if (lsm303agr_set_fifo_mode(m_lsm303agr, mode, threshold))
+        throw std::runtime_error(string(__FUNCTION__)
+                                 + ": lsm303agr_set_fifo_mode() failed");
+}
+
+std::vector<float> LSM303AGR::drainFifo()
+{
+    std::vector<float> v(LSM303AGR_FIFO_SIZE * 3);
+
+    int count = lsm303agr_drain_fifo(m_lsm303agr, v.data(),
+                                     LSM303AGR_FIFO_SIZE);
+    if (count < 0)
+        throw std::runtime_error(string(__FUNCTION__)
+                                 + ": lsm303agr_drain_fifo() failed");
+
+    v.resize(count * 3);
+    return v;
+}
+
+int LSM303AGR::getFifoOverruns()
+{
+    return lsm303agr_get_fifo_overruns(m_lsm303agr);
+}
+
 
 void LSM303AGR::installISR(LSM303AGR_INTERRUPT_PINS_T intr, int gpio,
                            mraa::Edge level,
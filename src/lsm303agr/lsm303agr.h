@@ -19,6 +19,7 @@
 #include <mraa/gpio.h>
 
 #include "upm.h"
+#include "upm_fifo_decode.h"
 
 #include "lsm303agr_defs.h"
 
@@ -55,6 +56,12 @@ extern "C" {
         float accScale;
         float accDivisor;
 
+        // acc FIFO sample decoder for the current power mode
+        upm_fifo_decoder_t fifoDecode;
+
+        // acc FIFO overruns seen by lsm303agr_drain_fifo()
+        int fifoOverruns;
+
         // uncompensated acc data
         float accX;
         float accY;
@@ -304,6 +311,46 @@ extern "C" {
      */
     uint8_t lsm303agr_get_mag_int_src(const lsm303agr_context dev);
 
+    /**
+     * Set the accelerometer FIFO mode.  In any mode but bypass the
+     * FIFO is enabled and its watermark interrupt is routed to INT1,
+     * so samples can be collected in batches with
+     * lsm303agr_drain_fifo() from an interrupt handler.  The FIFO is
+     * emptied first.  While the FIFO is enabled, lsm303agr_update()
+     * returns the oldest sample in it.
+     *
+     * @param dev The device context
+     * @param mode One of the LSM303AGR_A_FM_T values
+     * @param threshold Watermark level, 0-31 samples
+     * @return UPM result
+     */
+    upm_result_t lsm303agr_set_fifo_mode(const lsm303agr_context dev,
+                                         LSM303AGR_A_FM_T mode,
+                                         int threshold);
+
+    /**
+     * Read all unread samples from the accelerometer FIFO in one
+     * burst and return them in gravities, decoded for the current
+     * power mode.
+     *
+     * @param dev The device context
+     * @param buffer Buffer for 3 floats (x, y and z) per sample
+     * @param frames Maximum number of samples to read, the FIFO holds
+     * up to LSM303AGR_FIFO_SIZE
+     * @return Number of samples read, or -1 on error
+     */
+    int lsm303agr_drain_fifo(const lsm303agr_context dev, float *buffer,
+                             int frames);
+
+    /**
+     * Return the number of times lsm303agr_drain_fifo() found the
+     * FIFO overrun, losing samples
+     *
+     * @param dev The device context
+     * @return Overrun count
+     */
+    int lsm303agr_get_fifo_overruns(const lsm303agr_context dev);
+
     /**
      * Install an interrupt handler
      *
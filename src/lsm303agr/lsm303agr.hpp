@@ -299,6 +299,38 @@ namespace upm {
          */
         uint8_t getMagnetometerIntSrc();
 
+        /**
+         * Set the accelerometer FIFO mode.  In any mode but bypass
+         * the FIFO is enabled and its watermark interrupt is routed
+         * to INT1, so samples can be collected in batches with
+         * drainFifo() from an interrupt handler.  The FIFO is emptied
+         * first.  While the FIFO is enabled, update() returns the
+         * oldest sample in it.
+         *
+         * @param mode One of the LSM303AGR_A_FM_T values
+         * @param threshold Watermark level, 0-31 samples
+         * @throws std::runtime_error on failure
+         */
+        void setFifoMode(LSM303AGR_A_FM_T mode, int threshold=0);
+
+        /**
+         * Read all unread samples from the accelerometer FIFO in one
+         * burst.
+         *
+         * @return Vector of x, y and z in gravities for each sample,
+         * oldest first
+         * @throws std::runtime_error on failure
+         */
+        std::vector<float> drainFifo();
+
+        /**
+         * Return the number of times drainFifo() found the FIFO
+         * overrun, losing samples
+         *
+         * @return Overrun count
+         */
+        int getFifoOverruns();
+
         /**
          * Install an interrupt handler
          *
@@ -25,6 +25,9 @@ extern "C" {
 #define LSM303AGR_CHIPID_ACC 0x33
 #define LSM303AGR_CHIPID_MAG 0x40
 
+// accelerometer FIFO depth, in XYZ samples
+#define LSM303AGR_FIFO_SIZE 32
+
 // This device has 2 I2C addresses - one for the accelerometer (ACC)
 // and one for the magnetometer (MAG). But, it uses a single register
 // map.  The MAG registers start at 0x40, while the ACC registers
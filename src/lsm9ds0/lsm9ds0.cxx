@@ -15,11 +15,59 @@
 #include <string.h>
 #include <vector>
 
+#include "upm_regmap.hpp"
 #include "lsm9ds0.hpp"
 
 using namespace upm;
 using namespace std;
 
+namespace {
+  typedef LSM9DS0 D;
+
+  // output registers, the device sets the MSB of the register address
+  // to auto-increment it
+  typedef regmap::I2cBus<0x80> I2cBus;
+
+  typedef regmap::Field<D::REG_OUT_X_L_G, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> GyroX;
+  typedef regmap::Field<D::REG_OUT_Y_L_G, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> GyroY;
+  typedef regmap::Field<D::REG_OUT_Z_L_G, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> GyroZ;
+
+  typedef regmap::Field<D::REG_OUT_X_L_A, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> AccelX;
+  typedef regmap::Field<D::REG_OUT_Y_L_A, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> AccelY;
+  typedef regmap::Field<D::REG_OUT_Z_L_A, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> AccelZ;
+
+  typedef regmap::Field<D::REG_OUT_X_L_M, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> MagX;
+  typedef regmap::Field<D::REG_OUT_Y_L_M, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> MagY;
+  typedef regmap::Field<D::REG_OUT_Z_L_M, 0, 16, regmap::RO,
+                        regmap::LITTLE, true> MagZ;
+
+  typedef regmap::Field<D::REG_OUT_TEMP_L_XM, 0, 12, regmap::RO,
+                        regmap::LITTLE, true> TempXM;
+
+  // gyroscope ODR in Hz by the DR bits, the upper half of G_ODR_T
+  const float gyroODR[4] = { 95, 190, 380, 760 };
+
+  // accelerometer ODR in Hz by XM_AODR_T; the datasheet has 1600Hz
+  // for XM_AODR_1000
+  const float accelODR[11] = { 0, 3.125, 6.25, 12.5, 25, 50, 100, 200,
+                               400, 800, 1600 };
+
+  void toFloat3(const uint8_t *buf, float scale, float *v)
+  {
+    for (int i = 0; i < 3; i++)
+      v[i] = (float(int16_t(buf[2 * i] | (buf[2 * i + 1] << 8))) * scale)
+        / 1000.0;
+  }
+}
+
 
 LSM9DS0::LSM9DS0(int bus, bool raw, uint8_t gAddress, uint8_t xmAddress) :
   m_i2cG(bus, raw), m_i2cXM(bus, raw), m_gpioG_INT(0), m_gpioG_DRDY(0),
@@ -46,6 +94,11 @@ LSM9DS0::LSM9DS0(int bus, bool raw, uint8_t gAddress, uint8_t xmAddress) :
   m_gyroScale = 0.0;
   m_magScale = 0.0;
 
+  m_streaming = false;
+  m_watermark = 0;
+  m_streamOverruns = 0;
+  m_streamDropped = 0;
+
   mraa::Result rv;
   if ( (rv = m_i2cG.address(m_gAddr)) != mraa::SUCCESS)
     {
@@ -64,6 +117,16 @@ LSM9DS0::LSM9DS0(int bus, bool raw, uint8_t gAddress, uint8_t xmAddress) :
 
 LSM9DS0::~LSM9DS0()
 {
+  // the bus may be gone, don't let that terminate the program
+  try
+    {
+      stopStreaming();
+    }
+  catch (const std::exception &e)
+    {
+      cerr << "LSM9DS0: " << e.what() << endl;
+    }
+
   uninstallISR(INTERRUPT_G_INT);
   uninstallISR(INTERRUPT_G_DRDY);
   uninstallISR(INTERRUPT_XM_GEN1);
@@ -194,82 +257,59 @@ void LSM9DS0::update()
 {
   updateGyroscope();
   updateAccelerometer();
-  updateMagnetometer();
-  updateTemperature();
-}
 
-void LSM9DS0::updateGyroscope()
-{
-  uint8_t buffer[6];
+  // the temperature and magnetometer outputs are only separated by
+  // the magnetometer status register, so read them in one burst
+  I2cBus bus(m_i2cXM);
+  regmap::Block<TempXM, MagX, MagY, MagZ> xm;
+  xm.read(bus);
 
-  memset(buffer, 0, 6);
-  readRegs(DEV_GYRO, REG_OUT_X_L_G, buffer, 6);
+  m_magX = float(xm.get<MagX>());
+  m_magY = float(xm.get<MagY>());
+  m_magZ = float(xm.get<MagZ>());
 
-  int16_t x, y, z;
+  m_temp = float(xm.get<TempXM>());
+}
 
-  x =  ( (buffer[1] << 8) | buffer[0] );
-  y =  ( (buffer[3] << 8) | buffer[2] );
-  z =  ( (buffer[5] << 8) | buffer[4] );
+void LSM9DS0::updateGyroscope()
+{
+  I2cBus bus(m_i2cG);
+  regmap::Block<GyroX, GyroY, GyroZ> out;
+  out.read(bus);
 
-  m_gyroX = float(x);
-  m_gyroY = float(y);
-  m_gyroZ = float(z);
+  m_gyroX = float(out.get<GyroX>());
+  m_gyroY = float(out.get<GyroY>());
+  m_gyroZ = float(out.get<GyroZ>());
 }
 
 void LSM9DS0::updateAccelerometer()
 {
-  uint8_t buffer[6];
-
-  memset(buffer, 0, 6);
-  readRegs(DEV_XM, REG_OUT_X_L_A, buffer, 6);
+  I2cBus bus(m_i2cXM);
+  regmap::Block<AccelX, AccelY, AccelZ> out;
+  out.read(bus);
 
-  int16_t x, y, z;
-
-  x =  ( (buffer[1] << 8) | buffer[0] );
-  y =  ( (buffer[3] << 8) | buffer[2] );
-  z =  ( (buffer[5] << 8) | buffer[4] );
-
-  m_accelX = float(x);
-  m_accelY = float(y);
-  m_accelZ = float(z);
+  m_accelX = float(out.get<AccelX>());
+  m_accelY = float(out.get<AccelY>());
+  m_accelZ = float(out.get<AccelZ>());
 }
 
 void LSM9DS0::updateMagnetometer()
 {
-  uint8_t buffer[6];
-
-  memset(buffer, 0, 6);
-  readRegs(DEV_XM, REG_OUT_X_L_M, buffer, 6);
-
-  int16_t x, y, z;
-
-  x =  ( (buffer[1] << 8) | buffer[0] );
-  y =  ( (buffer[3] << 8) | buffer[2] );
-  z =  ( (buffer[5] << 8) | buffer[4] );
+  I2cBus bus(m_i2cXM);
+  regmap::Block<MagX, MagY, MagZ> out;
+  out.read(bus);
 
-  m_magX = float(x);
-  m_magY = float(y);
-  m_magZ = float(z);
+  m_magX = float(out.get<MagX>());
+  m_magY = float(out.get<MagY>());
+  m_magZ = float(out.get<MagZ>());
 }
 
 void LSM9DS0::updateTemperature()
 {
-  uint8_t buffer[2];
-
-  memset(buffer, 0, 2);
-  readRegs(DEV_XM, REG_OUT_TEMP_L_XM, buffer, 2);
-
-  //  cerr << "HIGH: " << int(buffer[1]) << " LOW: " << int(buffer[0]) << endl;
+  I2cBus bus(m_i2cXM);
 
   // 12b signed
-  int16_t temp = ( (buffer[1] << 8) | (buffer[0] ) );
-  if (temp & 0x0800)
-    {
-      temp &= ~0x0800;
-      temp *= -1;
-    }
-
-  m_temp = float(temp);
+  m_temp = float(regmap::read<TempXM>(bus));
 }
 
 uint8_t LSM9DS0::readReg(DEVICE_T dev, uint8_t reg)
@@ -784,3 +824,299 @@ mraa::Gpio*& LSM9DS0::getPin(INTERRUPT_PINS_T intr)
                               ": Invalid interrupt enum passed");
     }
 }
+
+void LSM9DS0::startStreaming(int gyroPin, int xmPin, int watermark)
+{
+  if (watermark < 1 || watermark >= LSM9DS0_FIFO_SIZE)
+    throw std::invalid_argument(string(__FUNCTION__) +
+                                ": watermark must be between 1 and 31");
+
+  stopStreaming();
+
+  uint8_t g1 = readReg(DEV_GYRO, REG_CTRL_REG1_G);
+  uint8_t xm1 = readReg(DEV_XM, REG_CTRL_REG1_XM);
+  int godr = (g1 >> _CTRL_REG1_G_ODR_SHIFT) & _CTRL_REG1_G_ODR_MASK;
+  int aodr = (xm1 >> _CTRL_REG1_XM_AODR_SHIFT) & _CTRL_REG1_XM_AODR_MASK;
+
+  if (!(g1 & CTRL_REG1_G_PD))
+    throw std::invalid_argument(string(__FUNCTION__) +
+                                ": gyroscope is powered down");
+
+  if (aodr == XM_AODR_PWRDWN || aodr > XM_AODR_1000)
+    throw std::invalid_argument(string(__FUNCTION__) +
+                                ": accelerometer is powered down");
+
+  // empty both FIFOs, bypass mode clears them
+  writeReg(DEV_GYRO, REG_FIFO_CTRL_REG_G,
+           G_FM_BYPASS << _FIFO_CTRL_REG_G_FM_SHIFT);
+  writeReg(DEV_XM, REG_FIFO_CTRL_REG, FM_BYPASS << _FIFO_CTRL_REG_FM_SHIFT);
+
+  writeReg(DEV_GYRO, REG_CTRL_REG5_G,
+           readReg(DEV_GYRO, REG_CTRL_REG5_G) | CTRL_REG5_G_FIFO_EN);
+  writeReg(DEV_XM, REG_CTRL_REG0_XM,
+           (readReg(DEV_XM, REG_CTRL_REG0_XM) | CTRL_REG0_XM_FIFO_EN)
+           & ~CTRL_REG0_XM_WTM_LEN);
+
+  // watermark interrupts on DRDY_G and INT2_XM
+  writeReg(DEV_GYRO, REG_CTRL_REG3_G,
+           readReg(DEV_GYRO, REG_CTRL_REG3_G) | CTRL_REG3_G_I2_WTM);
+  writeReg(DEV_XM, REG_CTRL_REG4_XM,
+           readReg(DEV_XM, REG_CTRL_REG4_XM) | CTRL_REG4_XM_P2_WTM);
+
+  {
+    std::lock_guard<std::mutex> guard(m_streamLock);
+
+    m_streamG.odr = gyroODR[godr >> 2];
+    m_streamG.count = 0;
+    m_streamG.samples.clear();
+
+    m_streamXM.odr = accelODR[aodr];
+    m_streamXM.count = 0;
+    m_streamXM.samples.clear();
+
+    m_streamQueue.clear();
+    m_streamOverruns = 0;
+    m_streamDropped = 0;
+    m_watermark = watermark;
+    m_streaming = true;
+  }
+
+  installISR(INTERRUPT_G_DRDY, gyroPin, mraa::EDGE_RISING,
+             gyroStreamIsr, this);
+  installISR(INTERRUPT_XM_GEN2, xmPin, mraa::EDGE_RISING,
+             xmStreamIsr, this);
+
+  // both timelines start here
+  {
+    std::lock_guard<std::mutex> guard(m_streamLock);
+    m_streamStart = std::chrono::steady_clock::now();
+  }
+
+  writeReg(DEV_GYRO, REG_FIFO_CTRL_REG_G,
+           (G_FM_STREAM << _FIFO_CTRL_REG_G_FM_SHIFT) | watermark);
+  writeReg(DEV_XM, REG_FIFO_CTRL_REG,
+           (FM_STREAM << _FIFO_CTRL_REG_FM_SHIFT) | watermark);
+}
+
+void LSM9DS0::stopStreaming()
+{
+  {
+    std::lock_guard<std::mutex> guard(m_streamLock);
+    if (!m_streaming)
+      return;
+    m_streaming = false;
+  }
+
+  // waits for a drain in progress to finish
+  uninstallISR(INTERRUPT_G_DRDY);
+  uninstallISR(INTERRUPT_XM_GEN2);
+
+  writeReg(DEV_GYRO, REG_FIFO_CTRL_REG_G,
+           G_FM_BYPASS << _FIFO_CTRL_REG_G_FM_SHIFT);
+  writeReg(DEV_XM, REG_FIFO_CTRL_REG, FM_BYPASS << _FIFO_CTRL_REG_FM_SHIFT);
+
+  writeReg(DEV_GYRO, REG_CTRL_REG3_G,
+           readReg(DEV_GYRO, REG_CTRL_REG3_G) & ~CTRL_REG3_G_I2_WTM);
+  writeReg(DEV_XM, REG_CTRL_REG4_XM,
+           readReg(DEV_XM, REG_CTRL_REG4_XM) & ~CTRL_REG4_XM_P2_WTM);
+
+  writeReg(DEV_GYRO, REG_CTRL_REG5_G,
+           readReg(DEV_GYRO, REG_CTRL_REG5_G) & ~CTRL_REG5_G_FIFO_EN);
+  writeReg(DEV_XM, REG_CTRL_REG0_XM,
+           readReg(DEV_XM, REG_CTRL_REG0_XM) & ~CTRL_REG0_XM_FIFO_EN);
+
+  m_streamCond.notify_all();
+}
+
+int LSM9DS0::readStream(STREAM_SAMPLE_T *samples, int maxSamples,
+                        int timeoutMs)
+{
+  std::unique_lock<std::mutex> guard(m_streamLock);
+
+  auto ready = [this]() {
+    return !m_streamQueue.empty() || !m_streaming;
+  };
+
+  if (timeoutMs < 0)
+    m_streamCond.wait(guard, ready);
+  else if (timeoutMs > 0)
+    m_streamCond.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                          ready);
+
+  int n = 0;
+  while (n < maxSamples && !m_streamQueue.empty())
+    {
+      samples[n++] = m_streamQueue.front();
+      m_streamQueue.pop_front();
+    }
+
+  return n;
+}
+
+int LSM9DS0::getStreamOverruns()
+{
+  std::lock_guard<std::mutex> guard(m_streamLock);
+  return m_streamOverruns;
+}
+
+int LSM9DS0::getStreamDropped()
+{
+  std::lock_guard<std::mutex> guard(m_streamLock);
+  return m_streamDropped;
+}
+
+void LSM9DS0::gyroStreamIsr(void *ctx)
+{
+  try
+    {
+      static_cast<LSM9DS0 *>(ctx)->drainFifo(DEV_GYRO);
+    }
+  catch (const std::exception &e)
+    {
+      cerr << "LSM9DS0: " << e.what() << endl;
+    }
+}
+
+void LSM9DS0::xmStreamIsr(void *ctx)
+{
+  try
+    {
+      static_cast<LSM9DS0 *>(ctx)->drainFifo(DEV_XM);
+    }
+  catch (const std::exception &e)
+    {
+      cerr << "LSM9DS0: " << e.what() << endl;
+    }
+}
+
+void LSM9DS0::drainFifo(DEVICE_T dev)
+{
+  bool gyro = (dev == DEV_GYRO);
+  STREAM_SRC_T &src = gyro ? m_streamG : m_streamXM;
+  float scale = gyro ? m_gyroScale : m_accelScale;
+  uint8_t buf[LSM9DS0_FIFO_SIZE * 6];
+  uint8_t magBuf[6];
+  int n;
+
+  // both FIFO_SRC registers have the same layout
+  do
+    {
+      uint8_t fifo = readReg(dev, gyro ? uint8_t(REG_FIFO_SRC_REG_G)
+                             : uint8_t(REG_FIFO_SRC_REG));
+      bool overrun = (fifo & FIFO_CTRL_REG_OVRN);
+
+      n = (fifo >> _FIFO_CTRL_REG_FSS_SHIFT) & _FIFO_CTRL_REG_FSS_MASK;
+      if (overrun)
+        n = LSM9DS0_FIFO_SIZE;
+      else if (fifo & FIFO_CTRL_REG_EMPTY)
+        n = 0;
+
+      if (!n)
+        break;
+
+      // in FIFO mode, reads roll over from OUT_Z_H back to OUT_X_L,
+      // so one burst returns n samples
+      readRegs(dev, gyro ? uint8_t(REG_OUT_X_L_G) : uint8_t(REG_OUT_X_L_A),
+               buf, n * 6);
+
+      // the magnetometer has no FIFO, sample it with each burst
+      if (!gyro)
+        readRegs(DEV_XM, REG_OUT_X_L_M, magBuf, 6);
+
+      std::lock_guard<std::mutex> guard(m_streamLock);
+
+      if (!m_streaming)
+        return;
+
+      if (overrun)
+        {
+          // the oldest samples were overwritten, skip the number
+          // that should have been taken by now
+          double elapsed = std::chrono::duration<double>
+            (std::chrono::steady_clock::now() - m_streamStart).count();
+          uint64_t expected = uint64_t(elapsed * src.odr);
+
+          if (expected > src.count + n)
+            src.count = expected - n;
+          m_streamOverruns++;
+        }
+
+      for (int i = 0; i < n; i++)
+        {
+          STREAM_RAW_T raw;
+
+          src.count++;
+          raw.t = uint64_t((src.count * 1000000.0) / src.odr);
+          toFloat3(buf + 6 * i, scale, raw.v);
+          if (gyro)
+            raw.mag[0] = raw.mag[1] = raw.mag[2] = 0;
+          else
+            toFloat3(magBuf, m_magScale, raw.mag);
+
+          src.samples.push_back(raw);
+        }
+
+      alignStreams();
+    }
+  while (n >= m_watermark);
+}
+
+void LSM9DS0::alignStreams()
+{
+  std::deque<STREAM_RAW_T> &g = m_streamG.samples;
+  std::deque<STREAM_RAW_T> &a = m_streamXM.samples;
+  bool added = false;
+
+  // a gyroscope sample is complete once the accelerometer has a
+  // sample at or after its time
+  while (!g.empty() && !a.empty() && a.back().t >= g.front().t)
+    {
+      const STREAM_RAW_T &gs = g.front();
+
+      // keep the last accelerometer sample at or before gs
+      while (a.size() > 1 && a[1].t <= gs.t)
+        a.pop_front();
+
+      const STREAM_RAW_T &a0 = a[0];
+      float accel[3];
+
+      if (a0.t >= gs.t)
+        {
+          for (int i = 0; i < 3; i++)
+            accel[i] = a0.v[i];
+        }
+      else
+        {
+          const STREAM_RAW_T &a1 = a[1];
+          float f = float(gs.t - a0.t) / float(a1.t - a0.t);
+
+          for (int i = 0; i < 3; i++)
+            accel[i] = a0.v[i] + (a1.v[i] - a0.v[i]) * f;
+        }
+
+      STREAM_SAMPLE_T out;
+      out.timestamp = gs.t;
+      out.accelX = accel[0];
+      out.accelY = accel[1];
+      out.accelZ = accel[2];
+      out.gyroX = gs.v[0];
+      out.gyroY = gs.v[1];
+      out.gyroZ = gs.v[2];
+      out.magX = a0.mag[0];
+      out.magY = a0.mag[1];
+      out.magZ = a0.mag[2];
+
+      if (m_streamQueue.size() >= LSM9DS0_STREAM_QUEUE_LEN)
+        {
+          m_streamQueue.pop_front();
+          m_streamDropped++;
+        }
+      m_streamQueue.push_back(out);
+      added = true;
+
+      g.pop_front();
+    }
+
+  if (added)
+    m_streamCond.notify_all();
+}
@@ -10,6 +10,10 @@
  */
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <mraa/common.hpp>
@@ -25,6 +29,13 @@
 #define LSM9DS0_DEFAULT_XM_ADDR 0x1d
 #define LSM9DS0_DEFAULT_GYRO_ADDR 0x6b
 
+// number of levels in the gyroscope and accelerometer FIFOs
+#define LSM9DS0_FIFO_SIZE 32
+
+// number of aligned samples queued in streaming mode until read by
+// readStream(), older ones are dropped
+#define LSM9DS0_STREAM_QUEUE_LEN 1024
+
 namespace upm {
 
   /**
@@ -1045,6 +1056,31 @@ namespace upm {
       INTERRUPT_XM_GEN2  // XM interrupt generator 2
     } INTERRUPT_PINS_T;
 
+    /**
+     * A gyroscope sample with the accelerometer and magnetometer at
+     * the same time, as returned by readStream()
+     */
+    typedef struct {
+      // microseconds since startStreaming(), from the sample count
+      // and ODR
+      uint64_t timestamp;
+
+      // acceleration in g
+      float accelX;
+      float accelY;
+      float accelZ;
+
+      // angular rate in degrees/s
+      float gyroX;
+      float gyroY;
+      float gyroZ;
+
+      // magnetic field in gauss
+      float magX;
+      float magY;
+      float magZ;
+    } STREAM_SAMPLE_T;
+
 
     /**
      * lsm9ds0 constructor
@@ -1437,6 +1473,65 @@ namespace upm {
      */
     void uninstallISR(INTERRUPT_PINS_T intr);
 
+    /**
+     * Start streaming at the full ODR of the gyroscope and the
+     * accelerometer.  Both FIFOs are put in stream mode, and their
+     * watermark interrupts, routed to the DRDY_G and INT2_XM pins,
+     * make the interrupt threads drain each FIFO in a single burst
+     * once it holds watermark samples.  Each gyroscope sample is then
+     * paired with the accelerometer interpolated to its time, both
+     * placed on a timeline by their sample count and ODR, and with
+     * the latest magnetometer sample, read along with each
+     * accelerometer burst.  The magnetometer has no FIFO, and at 100Hz
+     * at most is slow enough for that.
+     *
+     * The ODRs in effect are used; set them before calling this.  The
+     * accelerometer should run at least as fast as the gyroscope
+     * for the interpolation to be meaningful.
+     *
+     * @param gyroPin GPIO connected to DRDY_G
+     * @param xmPin GPIO connected to INT2_XM
+     * @param watermark FIFO level that triggers a drain, 1-31
+     * @throws std::invalid_argument if a sensor is powered down or
+     * watermark is out of range
+     */
+    void startStreaming(int gyroPin, int xmPin, int watermark=16);
+
+    /**
+     * Stop streaming, switch both FIFOs back to bypass mode and
+     * release the interrupt pins.  Samples still queued can be read.
+     */
+    void stopStreaming();
+
+    /**
+     * Take aligned samples from the stream queue, oldest first.
+     *
+     * @param samples buffer for the samples
+     * @param maxSamples size of the buffer
+     * @param timeoutMs time to wait for the first sample in
+     * milliseconds, 0 not to wait, negative to wait for ever
+     * @return the number of samples returned
+     */
+    int readStream(STREAM_SAMPLE_T *samples, int maxSamples,
+                   int timeoutMs=0);
+
+    /**
+     * Number of FIFO overruns in streaming mode, samples were lost
+     * when the interrupt threads could not keep up.  The timestamps
+     * skip an estimate of the lost samples.
+     *
+     * @return the number of overruns
+     */
+    int getStreamOverruns();
+
+    /**
+     * Number of aligned samples dropped because the stream queue was
+     * full
+     *
+     * @return the number of dropped samples
+     */
+    int getStreamDropped();
+
   protected:
     // uncompensated accelerometer and gyroscope values
     float m_accelX;
@@ -1478,5 +1573,38 @@ namespace upm {
     mraa::Gpio *m_gpioG_DRDY;
     mraa::Gpio *m_gpioXM_GEN1;
     mraa::Gpio *m_gpioXM_GEN2;
+
+    // one sensor's samples in streaming mode
+    typedef struct {
+      uint64_t t;
+      float v[3];
+      float mag[3];
+    } STREAM_RAW_T;
+
+    typedef struct {
+      float odr;
+      uint64_t count;      // samples taken since start, lost ones too
+      std::deque<STREAM_RAW_T> samples;
+    } STREAM_SRC_T;
+
+    // guards the streaming state, shared with the interrupt threads
+    std::mutex m_streamLock;
+    std::condition_variable m_streamCond;
+    bool m_streaming;
+    int m_watermark;
+    std::chrono::steady_clock::time_point m_streamStart;
+    STREAM_SRC_T m_streamG;
+    STREAM_SRC_T m_streamXM;
+    std::deque<STREAM_SAMPLE_T> m_streamQueue;
+    int m_streamOverruns;
+    int m_streamDropped;
+
+    static void gyroStreamIsr(void *ctx);
+    static void xmStreamIsr(void *ctx);
+
+    // read the FIFO of dev until below the watermark, convert the
+    // samples and align what can be aligned
+    void drainFifo(DEVICE_T dev);
+    void alignStreams();
   };
 }
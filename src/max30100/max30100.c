@@ -397,6 +397,72 @@ static void _internal_sample_rdy(void *arg)
         return;
 }
 
+upm_result_t max30100_read_fifo(const max30100_context* dev, uint16_t *buffer,
+                                int len, int *count)
+{
+    assert(dev != NULL && "max30100_read_fifo: Context cannot be NULL");
+    assert(count != NULL && "max30100_read_fifo: count cannot be NULL");
+
+    *count = 0;
+
+    /* WR_PTR, OVF_COUNTER and RD_PTR are adjacent, read them at once */
+    uint8_t ptrs[3];
+    if (mraa_i2c_read_bytes_data(dev->_i2c_context, MAX30100_REG_FIFO_WR_PTR,
+                                 ptrs, 3) != 3)
+        return UPM_ERROR_OPERATION_FAILED;
+
+    /* 16 entry FIFO, full if anything overflowed.  Equal pointers mean
+     * either empty or exactly full, A_FULL (latched when the FIFO
+     * reached 15 samples) tells them apart. */
+    int total = (ptrs[0] - ptrs[2]) & 0x0f;
+    bool status_read = false;
+    if (ptrs[1] != 0)
+        total = 16;
+    else if (total == 0)
+    {
+        uint8_t status;
+        if (max30100_read(dev, MAX30100_REG_INTERRUPT_STATUS, &status)
+            != UPM_SUCCESS)
+            return UPM_ERROR_OPERATION_FAILED;
+        status_read = true;
+
+        if (status & MAX30100_A_FULL)
+            total = 16;
+    }
+
+    int avail = total;
+    if (avail > len / 2)
+        avail = len / 2;
+
+    if (avail <= 0)
+        return UPM_SUCCESS;
+
+    /* The FIFO data register does not auto-increment, a burst read
+     * returns consecutive samples */
+    uint8_t data[16 * 4];
+    if (mraa_i2c_read_bytes_data(dev->_i2c_context, MAX30100_REG_FIFO_DATA,
+                                 data, avail * 4) != avail * 4)
+        return UPM_ERROR_OPERATION_FAILED;
+
+    for (int i = 0; i < avail * 2; i++)
+        buffer[i] = ((uint16_t)data[i * 2] << 8) | data[i * 2 + 1];
+
+    /* Once drained, clear a stale A_FULL so the next empty FIFO is not
+     * taken for a full one.  With samples left behind, equal pointers
+     * can only mean full, so the flag may stay. */
+    if (avail == total && !status_read)
+    {
+        uint8_t status;
+        if (max30100_read(dev, MAX30100_REG_INTERRUPT_STATUS, &status)
+            != UPM_SUCCESS)
+            return UPM_ERROR_OPERATION_FAILED;
+    }
+
+    *count = avail;
+
+    return UPM_SUCCESS;
+}
+
 upm_result_t max30100_sample(max30100_context* dev, max30100_value *samp)
 {
     assert(dev != NULL && "max30100_sample: Context cannot be NULL");
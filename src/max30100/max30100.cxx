@@ -45,6 +45,15 @@ max30100_value MAX30100::sample()
 }
 
 
+size_t MAX30100::read_fifo(uint16_t *buffer, size_t len)
+{
+    int count = 0;
+    upm_result_t result = max30100_read_fifo(_dev, buffer, (int)len, &count);
+    if (result != UPM_SUCCESS)
+        max30100_throw(__FUNCTION__, "max30100_read_fifo", result);
+    return count;
+}
+
 void MAX30100::sample_continuous(int gpio_pin, bool buffered, Callback *cb)
 {
     // Use a default callback if one is NOT provided
@@ -80,6 +80,22 @@ void max30100_close(max30100_context* dev);
  */
 upm_result_t max30100_sample(max30100_context* dev, max30100_value *samp);
 
+/**
+ * Read all samples currently stored in the FIFO, up to the size of the
+ * supplied buffer, without waiting for new ones.  Samples are stored
+ * interleaved as IR, R pairs.  Use this for polled sampling instead of
+ * max30100_sample_continuous().  Reads the interrupt status register,
+ * clearing it, to tell an empty FIFO from a full one.
+ *
+ * @param dev Sensor context pointer
+ * @param buffer Buffer to store the IR/R values in
+ * @param len Size of the buffer, in values (2 per sample)
+ * @param count Number of samples read
+ * @return Function result code
+ */
+upm_result_t max30100_read_fifo(const max30100_context* dev, uint16_t *buffer,
+                                int len, int *count);
+
 /**
  * Continuously sample Infrared/Red values.
  *
@@ -89,6 +89,20 @@ class MAX30100 {
          */
         max30100_value sample();
 
+        /**
+         * Read all samples currently stored in the FIFO, up to the size
+         * of the supplied buffer, without waiting for new ones.  Samples
+         * are stored interleaved as IR, R pairs.
+         *
+         * From Python, the buffer can be any writable uint16 buffer
+         * object (e.g. a numpy array), which is filled in place.
+         *
+         * @param buffer Buffer to store the IR/R values in
+         * @param len Size of the buffer, in values (2 per sample)
+         * @return Number of samples read
+         */
+        size_t read_fifo(uint16_t *buffer, size_t len);
+
         /**
          * Continuously sample Infrared/Red values.
          *
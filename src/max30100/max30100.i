@@ -6,6 +6,8 @@
 %module(directors="1", threads="1") javaupm_max30100
 %feature("director") upm::Callback;
 #endif
+%include "../java_buffer.i"
+
 JAVA_JNI_LOADLIBRARY(javaupm_max30100)
 #endif
 /* END Java syntax */
@@ -15,6 +17,8 @@ JAVA_JNI_LOADLIBRARY(javaupm_max30100)
 %module(directors="1", threads="1") pyupm_max30100
 
 %feature("director") upm::Callback;
+
+%include "../python_buffer.i"
 #endif
 /* END Python syntax */
 
@@ -16,10 +16,22 @@
 #include <stdlib.h>
 #include <functional>
 #include <string.h>
+#include <vector>
 #include "mic.hpp"
 
 using namespace upm;
 
+// samples kept for the spectrum
+#define SPECTRUM_SIZE 1024
+
+static upm_result_t readAio(void *ctx, float *value) {
+    int x = mraa_aio_read((mraa_aio_context) ctx);
+    if (x == -1)
+        return UPM_ERROR_OPERATION_FAILED;
+    *value = x;
+    return UPM_SUCCESS;
+}
+
 Microphone::Microphone(int micPin) {
     // initialise analog mic input
     
@@ -29,9 +41,19 @@ Microphone::Microphone(int micPin) {
                                     ": mraa_aio_init() failed, invalid pin?");
         return;
       }
+
+    if ( !(m_sampler = upm_aio_sampler_init(readAio, m_micCtx, 1000,
+                                            SPECTRUM_SIZE)) )
+      {
+        mraa_aio_close(m_micCtx);
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": upm_aio_sampler_init() failed");
+      }
 }
 
 Microphone::~Microphone() {
+    upm_aio_sampler_close(m_sampler);
+
     // close analog input
     mraa_result_t error;
     error = mraa_aio_close(m_micCtx);
@@ -55,13 +77,21 @@ Microphone::getSampledWindow (unsigned int freqMS, int numberOfSamples,
         return 0;
     }
 
+    // not while sampling in the background
+    if (upm_aio_sampler_set_rate(m_sampler, 1000.0 / freqMS) != UPM_SUCCESS) {
+        return 0;
+    }
+
+    // one capture, so all samples are on the same deadline grid
+    std::vector<float> samples(numberOfSamples);
+    if (upm_aio_sampler_capture(m_sampler, samples.data(),
+                                numberOfSamples) != UPM_SUCCESS) {
+        return 0;
+    }
+
     while (sampleIdx < numberOfSamples) {
-        int x = mraa_aio_read (m_micCtx);
-        if (x == -1) {
-            return 0;
-        }
-        buffer[sampleIdx++] = x;
-        usleep(freqMS * 1000);
+        buffer[sampleIdx] = samples[sampleIdx];
+        sampleIdx++;
     }
 
     return sampleIdx;
@@ -91,3 +121,59 @@ Microphone::printGraph (thresholdContext* ctx) {
         std::cout << ".";
     std::cout << std::endl;
 }
+
+void
+Microphone::startSampling (float rateHz) {
+    if (upm_aio_sampler_set_rate(m_sampler, rateHz) != UPM_SUCCESS) {
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": Invalid rate or already sampling");
+    }
+
+    upm_aio_sampler_reset_stats(m_sampler);
+    if (upm_aio_sampler_start(m_sampler) != UPM_SUCCESS) {
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": upm_aio_sampler_start() failed");
+    }
+}
+
+void
+Microphone::stopSampling () {
+    upm_aio_sampler_stop(m_sampler);
+}
+
+void
+Microphone::resetStatistics () {
+    upm_aio_sampler_reset_stats(m_sampler);
+}
+
+float
+Microphone::getRms () {
+    upm_aio_stats_t stats;
+    upm_aio_sampler_get_stats(m_sampler, &stats);
+    return stats.ac_rms;
+}
+
+float
+Microphone::getPeak () {
+    upm_aio_stats_t stats;
+    upm_aio_sampler_get_stats(m_sampler, &stats);
+    return stats.peak;
+}
+
+float
+Microphone::getEnvelope () {
+    upm_aio_stats_t stats;
+    upm_aio_sampler_get_stats(m_sampler, &stats);
+    return stats.envelope;
+}
+
+float
+Microphone::getDominantFrequency () {
+    float mag[SPECTRUM_SIZE / 2 + 1];
+
+    if (upm_aio_sampler_spectrum(m_sampler, mag, SPECTRUM_SIZE) != UPM_SUCCESS) {
+        return 0;
+    }
+
+    return upm_spectrum_peak(mag, SPECTRUM_SIZE, upm_aio_sampler_get_rate(m_sampler));
+}
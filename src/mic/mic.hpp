@@ -14,6 +14,8 @@
 #include <mraa/gpio.h>
 #include <mraa/aio.h>
 
+#include "upm_aio_sampler.h"
+
 struct thresholdContext {
     long averageReading;
     unsigned long runningAverage;
@@ -42,6 +44,11 @@ namespace upm {
  *
  * This module defines the Analog Microphone sensor
  *
+ * Samples are taken on absolute deadlines, so the sample rate does not
+ * drift with the ADC read latency.  startSampling() keeps sampling in
+ * the background and tracks the level (RMS, peak and envelope) and the
+ * dominant frequency of the signal.
+ *
  * @image html mic.jpg
  * @snippet mic.cxx Interesting
  */
@@ -63,7 +70,7 @@ class Microphone {
          * Gets samples from the microphone according to the provided window and
          * number of samples
          *
-         * @param freqMS Time between each sample (in microseconds)
+         * @param freqMS Time between each sample (in milliseconds)
          * @param numberOfSamples Number of sample to sample for this window
          * @param buffer Buffer with sampled data
          */
@@ -88,8 +95,59 @@ class Microphone {
          */
         void printGraph (thresholdContext* ctx);
 
+        /**
+         * Starts sampling in the background and restarts the level
+         * statistics
+         *
+         * @param rateHz Sample rate in Hz
+         */
+        void startSampling (float rateHz);
+
+        /**
+         * Stops background sampling
+         */
+        void stopSampling ();
+
+        /**
+         * Restarts the level statistics
+         */
+        void resetStatistics ();
+
+        /**
+         * Returns the RMS of the signal around its DC level since the
+         * statistics were restarted
+         *
+         * @return RMS in ADC counts
+         */
+        float getRms ();
+
+        /**
+         * Returns the largest excursion of the signal from its DC level
+         * since the statistics were restarted
+         *
+         * @return Peak in ADC counts
+         */
+        float getPeak ();
+
+        /**
+         * Returns the current envelope of the signal, following its
+         * level with a 1 ms attack and a 100 ms release
+         *
+         * @return Envelope in ADC counts
+         */
+        float getEnvelope ();
+
+        /**
+         * Returns the frequency of the strongest component of the latest
+         * 1024 samples
+         *
+         * @return Frequency in Hz, or 0 if fewer samples were taken
+         */
+        float getDominantFrequency ();
+
     private:
         mraa_aio_context    m_micCtx;
+        upm_aio_sampler_context m_sampler;
 };
 
 }
@@ -22,7 +22,8 @@
 
 using namespace upm;
 
-MMA7455::MMA7455 (int bus, int devAddr) : m_i2ControlCtx(bus) {
+MMA7455::MMA7455 (int bus, int devAddr) : m_i2ControlCtx(bus),
+    m_gpioInt1(NULL), m_gpioInt2(NULL), m_freefall(false) {
     unsigned char data   = 0;
 
     m_name = "MMA7455";
@@ -53,6 +54,10 @@ MMA7455::MMA7455 (int bus, int devAddr) : m_i2ControlCtx(bus) {
     }
 }
 
+MMA7455::~MMA7455 () {
+    stopEvents ();
+}
+
 mraa::Result
 MMA7455::calibrate () {
     mraa::Result error = mraa::SUCCESS;
@@ -195,3 +200,187 @@ MMA7455::i2cWriteReg (unsigned char reg, uint8_t *buffer, int len) {
 
     return error;
 }
+
+uint8_t
+MMA7455::readReg (unsigned char reg) {
+    uint8_t value = 0;
+
+    if (i2cReadReg (reg, &value, 0x1) != 1) {
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": mraa_i2c_read() failed");
+    }
+
+    return value;
+}
+
+void
+MMA7455::writeReg (unsigned char reg, uint8_t value) {
+    if (i2cWriteReg (reg, &value, 0x1) != mraa::SUCCESS) {
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": mraa_i2c_write() failed");
+    }
+}
+
+uint8_t
+MMA7455::eventThreshold (float threshold) {
+    // thresholds are 7 bit magnitudes on the 8g scale, 16 counts per g
+    int ths = (int) (threshold * 16 + 0.5);
+
+    if (ths < 1 || ths > 0x7f) {
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": threshold must be between 0.0625g"
+                                    " and 7.9g");
+    }
+
+    return (uint8_t) ths;
+}
+
+void
+MMA7455::setEventMode (uint8_t mode, uint8_t ctl1, uint8_t ctl2) {
+    uint8_t mctl = readReg (MMA7455_MCTL);
+
+    // INTREG 00: level detection on INT1, pulse detection on INT2
+    writeReg (MMA7455_CTL1, ctl1);
+    writeReg (MMA7455_CTL2, ctl2);
+
+    mctl &= ~(BIT (MMA7455_MODE0) | BIT (MMA7455_MODE1));
+    writeReg (MMA7455_MCTL, mctl | mode);
+
+    // drop anything latched under the old settings
+    writeReg (MMA7455_INTRST, BIT (MMA7455_CLR_INT1) | BIT (MMA7455_CLR_INT2));
+    writeReg (MMA7455_INTRST, 0);
+}
+
+void
+MMA7455::enableLevelDetection (float threshold, bool freefall,
+                               bool x, bool y, bool z) {
+    uint8_t ctl1 = (x ? 0 : BIT (MMA7455_XDA)) |
+                   (y ? 0 : BIT (MMA7455_YDA)) |
+                   (z ? 0 : BIT (MMA7455_ZDA));
+
+    writeReg (MMA7455_LDTH, eventThreshold (threshold));
+
+    // LDPL selects the AND of the axes below the threshold (freefall)
+    // over the OR of the axes above it (motion)
+    m_freefall = freefall;
+    setEventMode (BIT (MMA7455_MODE1), ctl1,
+                  freefall ? BIT (MMA7455_LDPL) : 0);
+}
+
+void
+MMA7455::enablePulseDetection (float threshold, uint8_t duration,
+                               bool x, bool y, bool z) {
+    uint8_t ctl1 = (x ? 0 : BIT (MMA7455_XDA)) |
+                   (y ? 0 : BIT (MMA7455_YDA)) |
+                   (z ? 0 : BIT (MMA7455_ZDA));
+
+    if (duration == 0) {
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": duration must be between 1 and 255");
+    }
+
+    writeReg (MMA7455_PDTH, eventThreshold (threshold));
+    writeReg (MMA7455_PD, duration);
+    writeReg (MMA7455_LT, 0);
+    writeReg (MMA7455_TW, 0);
+
+    // CTL2 = 0 selects motion for the level detection bits
+    m_freefall = false;
+    setEventMode (BIT (MMA7455_MODE0) | BIT (MMA7455_MODE1), ctl1, 0);
+}
+
+void
+MMA7455::disableEventDetection () {
+    setEventMode (BIT (MMA7455_MODE0), 0, 0);
+}
+
+void
+MMA7455::startEvents (int int1Pin, int int2Pin) {
+    stopEvents ();
+
+    m_gpioInt1 = new mraa::Gpio (int1Pin);
+    m_gpioInt1->dir (mraa::DIR_IN);
+    m_gpioInt1->isr (mraa::EDGE_RISING, eventIsr, this);
+
+    if (int2Pin >= 0) {
+        m_gpioInt2 = new mraa::Gpio (int2Pin);
+        m_gpioInt2->dir (mraa::DIR_IN);
+        m_gpioInt2->isr (mraa::EDGE_RISING, eventIsr, this);
+    }
+
+    // an interrupt may already be latched, with no edge to come
+    handleEvents ();
+}
+
+void
+MMA7455::stopEvents () {
+    if (m_gpioInt1) {
+        m_gpioInt1->isrExit ();
+        delete m_gpioInt1;
+        m_gpioInt1 = NULL;
+    }
+
+    if (m_gpioInt2) {
+        m_gpioInt2->isrExit ();
+        delete m_gpioInt2;
+        m_gpioInt2 = NULL;
+    }
+}
+
+bool
+MMA7455::getEvent (MotionEvent &event, int timeoutMs) {
+    return m_events.pop (event, timeoutMs);
+}
+
+void
+MMA7455::setEventCallback (EventQueue<MotionEvent>::Callback cb) {
+    m_events.setCallback (cb);
+}
+
+unsigned int
+MMA7455::getEventsDropped () {
+    return m_events.dropped ();
+}
+
+void
+MMA7455::eventIsr (void *ctx) {
+    try {
+        static_cast<MMA7455 *>(ctx)->handleEvents ();
+    } catch (const std::exception &e) {
+        std::cerr << "MMA7455: " << e.what() << std::endl;
+    }
+}
+
+void
+MMA7455::handleEvents () {
+    const uint8_t level = BIT (MMA7455_LDX) | BIT (MMA7455_LDY) |
+                          BIT (MMA7455_LDZ);
+    const uint8_t pulse = BIT (MMA7455_PDX) | BIT (MMA7455_PDY) |
+                          BIT (MMA7455_PDZ);
+
+    std::lock_guard<std::mutex> lock (m_eventLock);
+
+    uint8_t src = readReg (MMA7455_DETSRC);
+
+    if (!(src & (BIT (MMA7455_INT1) | BIT (MMA7455_INT2)))) {
+        return;
+    }
+
+    MotionEvent e;
+    e.source = src;
+    e.timestamp = MotionEvent::now ();
+
+    if (src & level) {
+        e.type = m_freefall ? MOTION_EVENT_FREEFALL : MOTION_EVENT_MOTION;
+        m_events.push (e);
+    }
+
+    if (src & pulse) {
+        e.type = MOTION_EVENT_TAP;
+        m_events.push (e);
+    }
+
+    // the interrupts stay latched until cleared
+    writeReg (MMA7455_INTRST, BIT (MMA7455_CLR_INT1) | BIT (MMA7455_CLR_INT2));
+    writeReg (MMA7455_INTRST, 0);
+}
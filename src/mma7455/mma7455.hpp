@@ -12,10 +12,14 @@
 
 #include <string>
 #include <vector>
+#include <mutex>
 #include <mraa/i2c.hpp>
+#include <mraa/gpio.hpp>
 
 #include <interfaces/iAcceleration.hpp>
 
+#include "upm_event_queue.hpp"
+
 #define ADDR               0x1D // device address
 
 // Register names according to the datasheet.
@@ -157,6 +161,14 @@ typedef union {
  *
  * This module defines the MMA7455 interface for libmma7455
  *
+ * The level and pulse detection modes let the device detect motion,
+ * freefall or taps itself.  Enable one with enableLevelDetection() or
+ * enablePulseDetection() and call startEvents() with the GPIOs
+ * connected to INT1 and INT2; events then arrive through getEvent()
+ * or an event callback.  The two modes are exclusive, enabling one
+ * disables the other.  While detecting, readData() and
+ * getAcceleration() still return the 10 bit output values.
+ *
  * @image html mma7455.jpg
  * @snippet mma7455.cxx Interesting
  */
@@ -170,6 +182,11 @@ class MMA7455: virtual public iAcceleration {
          */
         MMA7455 (int bus=0, int devAddr=0x1D);
 
+        /**
+         * MMA7455 destructor
+         */
+        ~MMA7455 ();
+
         /**
          * Returns the name of the component
          *
@@ -230,11 +247,106 @@ class MMA7455: virtual public iAcceleration {
          */
         mraa::Result i2cWriteReg (unsigned char reg, uint8_t *buffer, int len);
 
+        /**
+         * Switches to the level detection mode, reported on INT1.
+         * Motion is detected when any enabled axis exceeds the
+         * threshold, freefall when all enabled axes are below it.
+         * This disables pulse detection.
+         *
+         * @param threshold Threshold in g, 0.0625 to 7.9
+         * @param freefall Detect freefall instead of motion
+         * @param x Use the X-axis
+         * @param y Use the Y-axis
+         * @param z Use the Z-axis
+         */
+        void enableLevelDetection (float threshold, bool freefall=false,
+                                   bool x=true, bool y=true, bool z=true);
+
+        /**
+         * Switches to the pulse detection mode; single taps are
+         * reported on INT2.  This disables level detection, including
+         * a freefall setup.
+         *
+         * @param threshold Threshold in g, 0.0625 to 7.9
+         * @param duration Longest pulse counted as a tap, in 0.5 ms
+         * steps, 1-255
+         * @param x Use the X-axis
+         * @param y Use the Y-axis
+         * @param z Use the Z-axis
+         */
+        void enablePulseDetection (float threshold, uint8_t duration=0x10,
+                                   bool x=true, bool y=true, bool z=true);
+
+        /**
+         * Switches back to the measurement mode.
+         */
+        void disableEventDetection ();
+
+        /**
+         * Starts delivering events, replacing any ISRs installed
+         * before.  The interrupts are active high.
+         *
+         * @param int1Pin GPIO pin connected to INT1 (level detection)
+         * @param int2Pin GPIO pin connected to INT2 (pulse detection),
+         * or -1 if not connected
+         */
+        void startEvents (int int1Pin, int int2Pin=-1);
+
+        /**
+         * Stops delivering events and uninstalls the ISRs.
+         */
+        void stopEvents ();
+
+        /**
+         * Takes the oldest event.  The source field holds the
+         * detection source register.
+         *
+         * @param event The event
+         * @param timeoutMs Time to wait for an event in milliseconds,
+         * 0 to return at once, negative to wait forever
+         * @return True if an event was taken
+         */
+        bool getEvent (MotionEvent &event, int timeoutMs=0);
+
+        /**
+         * Sets a callback receiving events, on the interrupt thread,
+         * instead of queueing them for getEvent().  An empty function
+         * restores the queue.
+         *
+         * @param cb Callback
+         */
+        void setEventCallback (EventQueue<MotionEvent>::Callback cb);
+
+        /**
+         * Returns the number of events dropped because the queue was
+         * full.
+         *
+         * @return Count
+         */
+        unsigned int getEventsDropped ();
+
     private:
+        /* Disable implicit copy and assignment operators */
+        MMA7455 (const MMA7455&) = delete;
+        MMA7455 &operator= (const MMA7455&) = delete;
+
+        uint8_t readReg (unsigned char reg);
+        void writeReg (unsigned char reg, uint8_t value);
+        uint8_t eventThreshold (float threshold);
+        void setEventMode (uint8_t mode, uint8_t ctl1, uint8_t ctl2);
+        static void eventIsr (void *ctx);
+        void handleEvents ();
+
         std::string m_name;
         int              m_controlAddr;
         int              m_bus;
         mraa::I2c  m_i2ControlCtx;
+        mraa::Gpio       *m_gpioInt1;
+        mraa::Gpio       *m_gpioInt2;
+        EventQueue<MotionEvent> m_events;
+        // serializes handleEvents () between the ISR threads
+        std::mutex       m_eventLock;
+        bool             m_freefall;
 };
 
 }
@@ -48,6 +48,14 @@ JAVA_JNI_LOADLIBRARY(javaupm_mma7455)
 /* END Python syntax */
 
 /* BEGIN Common SWIG syntax ------------------------------------------------- */
+/* callbacks are not wrapped, poll with getEvent() */
+%ignore setEventCallback;
+
+%{
+#include "upm_event_queue.hpp"
+%}
+%include "upm_event_queue.hpp"
+
 %{
 #include "mma7455.hpp"
 %}
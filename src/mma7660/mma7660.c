@@ -329,6 +329,35 @@ upm_result_t mma7660_set_sample_rate(const mma7660_context dev,
     return mma7660_write_byte(dev, MMA7660_REG_SR, sr);
 }
 
+upm_result_t mma7660_set_tap_detection(const mma7660_context dev,
+                                       uint8_t threshold,
+                                       int debounce,
+                                       bool x, bool y, bool z)
+{
+    assert(dev != NULL);
+
+    if (threshold > _MMA7660_PDET_PDTH_MASK || debounce < 1
+        || debounce > 256)
+    {
+        printf("%s: threshold or debounce out of range.\n", __FUNCTION__);
+        return UPM_ERROR_OUT_OF_RANGE;
+    }
+
+    // the axis bits disable detection
+    uint8_t pdet = threshold;
+    if (!x)
+        pdet |= MMA7660_PDET_XDA;
+    if (!y)
+        pdet |= MMA7660_PDET_YDA;
+    if (!z)
+        pdet |= MMA7660_PDET_ZDA;
+
+    if (mma7660_write_byte(dev, MMA7660_REG_PDET, pdet))
+        return UPM_ERROR_OPERATION_FAILED;
+
+    return mma7660_write_byte(dev, MMA7660_REG_PD, (uint8_t)(debounce - 1));
+}
+
 upm_result_t mma7660_get_acceleration(const mma7660_context dev,
                                       float *ax, float *ay, float *az)
 {
@@ -20,7 +20,7 @@ using namespace std;
 
 
 MMA7660::MMA7660(int bus, uint8_t address) :
-    m_mma7660(mma7660_init(bus, address))
+    m_mma7660(mma7660_init(bus, address)), m_orientation(0xff)
 {
     if (!m_mma7660)
         throw std::runtime_error(std::string(__FUNCTION__) +
@@ -188,3 +188,100 @@ std::vector<float> MMA7660::getAcceleration()
     return v;
 }
 
+
+void MMA7660::setTapDetection(uint8_t threshold, int debounce,
+                              bool x, bool y, bool z)
+{
+    if (mma7660_set_tap_detection(m_mma7660, threshold, debounce, x, y, z))
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": mma7660_set_tap_detection() failed");
+}
+
+void MMA7660::startEvents(int pin, uint8_t ibits)
+{
+    stopEvents();
+
+    // interrupt setup needs the standby mode.  The ISR triggers on the
+    // rising edge, so drive INT push-pull, active high.
+    setModeStandby();
+    if (!setInterruptBits(ibits))
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": mma7660_set_interrupt_bits() failed");
+    writeByte(MMA7660_REG_MODE, readByte(MMA7660_REG_MODE)
+              | MMA7660_MODE_IPP | MMA7660_MODE_IAH);
+    setModeActive();
+
+    m_orientation = 0xff;
+    installISR(pin, eventIsr, this);
+
+    // reading the tilt register releases INT, so only do it once the
+    // ISR is installed; an event latched before that would otherwise
+    // never make an edge.  This also records the current orientation.
+    handleEvents();
+}
+
+void MMA7660::stopEvents()
+{
+    uninstallISR();
+}
+
+bool MMA7660::getEvent(MotionEvent &event, int timeoutMs)
+{
+    return m_events.pop(event, timeoutMs);
+}
+
+void MMA7660::setEventCallback(EventQueue<MotionEvent>::Callback cb)
+{
+    m_events.setCallback(cb);
+}
+
+unsigned int MMA7660::getEventsDropped()
+{
+    return m_events.dropped();
+}
+
+void MMA7660::eventIsr(void *ctx)
+{
+    try
+    {
+        static_cast<MMA7660 *>(ctx)->handleEvents();
+    }
+    catch (const std::exception &e)
+    {
+        cerr << "MMA7660: " << e.what() << endl;
+    }
+}
+
+void MMA7660::handleEvents()
+{
+    std::lock_guard<std::mutex> lock(m_eventLock);
+
+    // reading the tilt register releases the interrupt
+    uint8_t tilt = getVerifiedTilt();
+    uint8_t orientation = tilt
+        & ((_MMA7660_TILT_POLA_MASK << _MMA7660_TILT_POLA_SHIFT)
+           | (_MMA7660_TILT_BAFRO_MASK << _MMA7660_TILT_BAFRO_SHIFT));
+
+    MotionEvent e;
+    e.source = tilt;
+    e.timestamp = MotionEvent::now();
+
+    if (tilt & MMA7660_TILT_TAP)
+    {
+        e.type = MOTION_EVENT_TAP;
+        m_events.push(e);
+    }
+
+    if (tilt & MMA7660_TILT_SHAKE)
+    {
+        e.type = MOTION_EVENT_SHAKE;
+        m_events.push(e);
+    }
+
+    if (orientation != m_orientation)
+    {
+        m_orientation = orientation;
+        e.type = MOTION_EVENT_ORIENTATION;
+        m_events.push(e);
+    }
+}
@@ -233,6 +233,24 @@ extern "C" {
     upm_result_t mma7660_set_sample_rate(const mma7660_context dev,
                                          MMA7660_AUTOSLEEP_T sr);
 
+    /**
+     * Sets up tap detection, reported with MMA7660_INTR_PDINT.
+     * Note: the device must be in the standby mode to set these
+     * registers.
+     *
+     * @param dev Device context.
+     * @param threshold Tap threshold in counts (21.33 per g), 0-31
+     * @param debounce Number of samples the tap must last, 1-256
+     * @param x Detect taps on the X-axis
+     * @param y Detect taps on the Y-axis
+     * @param z Detect taps on the Z-axis
+     * @return UPM result
+     */
+    upm_result_t mma7660_set_tap_detection(const mma7660_context dev,
+                                           uint8_t threshold,
+                                           int debounce,
+                                           bool x, bool y, bool z);
+
 #ifdef __cplusplus
 }
 #endif
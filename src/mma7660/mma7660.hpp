@@ -11,10 +11,13 @@
 #pragma once
 
 #include <vector>
+#include <mutex>
 
 #include "mma7660.h"
 #include <interfaces/iAcceleration.hpp>
 
+#include "upm_event_queue.hpp"
+
 namespace upm {
 
     /**
@@ -40,6 +43,11 @@ namespace upm {
      * gesture detection, and X/Y/Z-axis measurements of g-forces
      * being applied (up to 1.5g)
      *
+     * Tap, shake and orientation changes can be detected by the
+     * device itself: startEvents() enables their interrupts and
+     * delivers them through getEvent() or an event callback, so the
+     * application does not need to poll samples.
+     *
      * This module was tested with the Grove 3-Axis Digital
      * Accelerometer (1.5g)
      *
@@ -219,6 +227,74 @@ namespace upm {
          */
         void installISR(int pin, void (*isr)(void *), void *arg);
 
+        /**
+         * Sets up tap detection, reported with MMA7660_INTR_PDINT.
+         * Note: the device must be in the standby mode to set these
+         * registers.
+         *
+         * @param threshold Tap threshold in counts (21.33 per g), 0-31
+         * @param debounce Number of samples the tap must last, 1-256
+         * @param x Detect taps on the X-axis
+         * @param y Detect taps on the Y-axis
+         * @param z Detect taps on the Z-axis
+         */
+        void setTapDetection(uint8_t threshold, int debounce,
+                             bool x=true, bool y=true, bool z=true);
+
+        /**
+         * Starts delivering events.  This enables the requested
+         * interrupts, sets the interrupt output to push-pull, active
+         * high, and installs an ISR on the pin, replacing any ISR
+         * installed before.  Tap events need setTapDetection().
+         * The current orientation is reported as the first
+         * orientation event.
+         *
+         * @param pin GPIO pin connected to the INT output
+         * @param ibits Bitmask of MMA7660_INTR_T values; FBINT and
+         * PLINT report orientation changes, PDINT taps and the
+         * SHINT bits shakes
+         */
+        void startEvents(int pin,
+                         uint8_t ibits=(MMA7660_INTR_FBINT |
+                                        MMA7660_INTR_PLINT |
+                                        MMA7660_INTR_PDINT |
+                                        MMA7660_INTR_SHINTX |
+                                        MMA7660_INTR_SHINTY |
+                                        MMA7660_INTR_SHINTZ));
+
+        /**
+         * Stops delivering events and uninstalls the ISR.
+         */
+        void stopEvents();
+
+        /**
+         * Takes the oldest event.  The source field holds the tilt
+         * register.
+         *
+         * @param event The event
+         * @param timeoutMs Time to wait for an event in milliseconds,
+         * 0 to return at once, negative to wait forever
+         * @return True if an event was taken
+         */
+        bool getEvent(MotionEvent &event, int timeoutMs=0);
+
+        /**
+         * Sets a callback receiving events, on the interrupt thread,
+         * instead of queueing them for getEvent().  An empty function
+         * restores the queue.
+         *
+         * @param cb Callback
+         */
+        void setEventCallback(EventQueue<MotionEvent>::Callback cb);
+
+        /**
+         * Returns the number of events dropped because the queue was
+         * full.
+         *
+         * @return Count
+         */
+        unsigned int getEventsDropped();
+
     protected:
         mma7660_context m_mma7660;
 
@@ -227,5 +303,14 @@ namespace upm {
         MMA7660(const MMA7660&) = delete;
         MMA7660 &operator=(const MMA7660&) = delete;
 
+        static void eventIsr(void *ctx);
+        void handleEvents();
+
+        EventQueue<MotionEvent> m_events;
+        // serializes handleEvents() between the ISR and startEvents()
+        std::mutex m_eventLock;
+        // BAFRO and POLA bits last seen, 0xff before the first read
+        uint8_t m_orientation;
+
     };
 }
@@ -56,6 +56,14 @@ JAVA_JNI_LOADLIBRARY(javaupm_mma7660)
 %pointer_functions(int, intp);
 %pointer_functions(float, floatp);
 
+/* callbacks are not wrapped, poll with getEvent() */
+%ignore setEventCallback;
+
+%{
+#include "upm_event_queue.hpp"
+%}
+%include "upm_event_queue.hpp"
+
 %{
 #include "mma7660_regs.h"
 #include "mma7660.hpp"
@@ -58,6 +58,26 @@ extern "C" {
         MMA7660_MODE_IAH           = 0x80  // intr active low/high
     } MMA7660_MODE_T;
 
+    // tilt register bits
+    typedef enum {
+        _MMA7660_TILT_BAFRO_MASK    = 0x03, // MMA7660_TILT_BF_T
+        _MMA7660_TILT_BAFRO_SHIFT   = 0,
+        _MMA7660_TILT_POLA_MASK     = 0x07, // MMA7660_TILT_LP_T
+        _MMA7660_TILT_POLA_SHIFT    = 2,
+        MMA7660_TILT_TAP            = 0x20,
+        MMA7660_TILT_ALERT          = 0x40, // register being updated
+        MMA7660_TILT_SHAKE          = 0x80
+    } MMA7660_TILT_BITS_T;
+
+    // tap detection register bits
+    typedef enum {
+        _MMA7660_PDET_PDTH_MASK     = 0x1f, // tap threshold, in counts
+        _MMA7660_PDET_PDTH_SHIFT    = 0,
+        MMA7660_PDET_XDA            = 0x20, // disable X tap detection
+        MMA7660_PDET_YDA            = 0x40, // disable Y tap detection
+        MMA7660_PDET_ZDA            = 0x80  // disable Z tap detection
+    } MMA7660_PDET_BITS_T;
+
     // tilt BackFront (BF) bits
     typedef enum {
         MMA7660_BF_UNKNOWN          = 0x00,
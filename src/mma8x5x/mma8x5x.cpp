@@ -25,7 +25,9 @@
 using namespace upm;
 
 MMA8X5X::MMA8X5X (int bus, mma8x5x_params_t *params,
-                                         int devAddr) : m_i2ControlCtx(bus) {
+                                         int devAddr) : m_i2ControlCtx(bus),
+                                         m_gpioInt(NULL),
+                                         m_motionMode(false) {
     uint8_t reg;
 
     s_data->x = 0;
@@ -92,6 +94,11 @@ MMA8X5X::MMA8X5X (int bus, mma8x5x_params_t *params,
     }
 }
 
+MMA8X5X::~MMA8X5X()
+{
+    stopEvents();
+}
+
 int
 MMA8X5X::setDeviceName(uint8_t type)
 {
@@ -343,4 +350,267 @@ MMA8X5X::getData(mma8x5x_data_t* data, int bSampleData)
     data->z = s_data->z;
 
     return 0;
-}
\ No newline at end of file
+}
+void
+MMA8X5X::writeReg(uint8_t reg, uint8_t val)
+{
+    if (m_i2ControlCtx.writeReg(reg, val) != mraa::SUCCESS) {
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": mraa_i2c_write_byte_data() failed");
+    }
+}
+
+void
+MMA8X5X::writeEventConfig(const uint8_t (*regs)[2], int count,
+                          uint8_t intBit, bool enable)
+{
+    uint8_t ctrl1 = m_i2ControlCtx.readReg(MMA8X5X_CTRL_REG1);
+    uint8_t ctrl4 = m_i2ControlCtx.readReg(MMA8X5X_CTRL_REG4);
+    uint8_t ctrl5 = m_i2ControlCtx.readReg(MMA8X5X_CTRL_REG5);
+
+    /* the INT_EN and INT_CFG bits line up, route everything to INT1 */
+    if (enable) {
+        ctrl4 |= intBit;
+        ctrl5 |= intBit;
+    } else {
+        ctrl4 &= ~intBit;
+    }
+
+    /* the embedded functions can only be set up in standby */
+    writeReg(MMA8X5X_CTRL_REG1, ctrl1 & ~MMA8X5X_CTRL_REG1_ACTIVE);
+    for (int i = 0; i < count; i++) {
+        writeReg(regs[i][0], regs[i][1]);
+    }
+    writeReg(MMA8X5X_CTRL_REG4, ctrl4);
+    writeReg(MMA8X5X_CTRL_REG5, ctrl5);
+    writeReg(MMA8X5X_CTRL_REG1, ctrl1);
+}
+
+uint8_t
+MMA8X5X::eventThreshold(float threshold)
+{
+    int ths = (int)(threshold / MMA8X5X_EVENT_THS_G + 0.5);
+
+    if (ths < 1 || ths > MMA8X5X_FF_MT_THS_MASK) {
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": threshold must be between 0.063g"
+                                    " and 8g");
+    }
+
+    return (uint8_t)ths;
+}
+
+void
+MMA8X5X::enableFreefallDetection(float threshold, uint8_t count)
+{
+    /* freefall is all axes low, the AND of the events */
+    const uint8_t regs[][2] = {
+        { MMA8X5X_FF_MT_CFG, MMA8X5X_FF_MT_CFG_ELE | MMA8X5X_FF_MT_CFG_XEFE |
+          MMA8X5X_FF_MT_CFG_YEFE | MMA8X5X_FF_MT_CFG_ZEFE },
+        { MMA8X5X_FF_MT_THS, eventThreshold(threshold) },
+        { MMA8X5X_FF_MT_COUNT, count },
+    };
+
+    writeEventConfig(regs, 3, MMA8X5X_CTRL_REG4_INT_EN_FF_MT, true);
+    m_motionMode = false;
+}
+
+void
+MMA8X5X::enableMotionDetection(float threshold, uint8_t count,
+                               bool x, bool y, bool z)
+{
+    const uint8_t regs[][2] = {
+        { MMA8X5X_FF_MT_CFG, (uint8_t)(MMA8X5X_FF_MT_CFG_ELE |
+                                       MMA8X5X_FF_MT_CFG_OAE |
+                                       (x ? MMA8X5X_FF_MT_CFG_XEFE : 0) |
+                                       (y ? MMA8X5X_FF_MT_CFG_YEFE : 0) |
+                                       (z ? MMA8X5X_FF_MT_CFG_ZEFE : 0)) },
+        { MMA8X5X_FF_MT_THS, eventThreshold(threshold) },
+        { MMA8X5X_FF_MT_COUNT, count },
+    };
+
+    writeEventConfig(regs, 3, MMA8X5X_CTRL_REG4_INT_EN_FF_MT, true);
+    m_motionMode = true;
+}
+
+void
+MMA8X5X::enableTransientDetection(float threshold, uint8_t count,
+                                  bool x, bool y, bool z)
+{
+    if (s_params->type == MMA8X5X_DEVICE_ID_MMA8653) {
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": not supported by the " + m_name);
+    }
+
+    const uint8_t regs[][2] = {
+        { MMA8X5X_TRANSIENT_CFG,
+          (uint8_t)(MMA8X5X_TRANSIENT_CFG_ELE |
+                    (x ? MMA8X5X_TRANSIENT_CFG_XTEFE : 0) |
+                    (y ? MMA8X5X_TRANSIENT_CFG_YTEFE : 0) |
+                    (z ? MMA8X5X_TRANSIENT_CFG_ZTEFE : 0)) },
+        { MMA8X5X_TRANSIENT_THS, eventThreshold(threshold) },
+        { MMA8X5X_TRANSIENT_COUNT, count },
+    };
+
+    writeEventConfig(regs, 3, MMA8X5X_CTRL_REG4_INT_EN_TRANS, true);
+}
+
+void
+MMA8X5X::enableTapDetection(float threshold, bool doubleTap,
+                            uint8_t timeLimit, uint8_t latency,
+                            uint8_t window)
+{
+    if (s_params->type == MMA8X5X_DEVICE_ID_MMA8653) {
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": not supported by the " + m_name);
+    }
+
+    uint8_t cfg = MMA8X5X_PULSE_CFG_ELE | MMA8X5X_PULSE_CFG_XSPEFE |
+                  MMA8X5X_PULSE_CFG_YSPEFE | MMA8X5X_PULSE_CFG_ZSPEFE;
+    if (doubleTap) {
+        cfg |= MMA8X5X_PULSE_CFG_XDPEFE | MMA8X5X_PULSE_CFG_YDPEFE |
+               MMA8X5X_PULSE_CFG_ZDPEFE;
+    }
+
+    uint8_t ths = eventThreshold(threshold);
+    const uint8_t regs[][2] = {
+        { MMA8X5X_PULSE_CFG, cfg },
+        { MMA8X5X_PULSE_THSX, ths },
+        { MMA8X5X_PULSE_THSY, ths },
+        { MMA8X5X_PULSE_THSZ, ths },
+        { MMA8X5X_PULSE_TMLT, timeLimit },
+        { MMA8X5X_PULSE_LTCY, latency },
+        { MMA8X5X_PULSE_WIND, window },
+    };
+
+    writeEventConfig(regs, 7, MMA8X5X_CTRL_REG4_INT_EN_PULSE, true);
+}
+
+void
+MMA8X5X::enableOrientationDetection(uint8_t count)
+{
+    const uint8_t regs[][2] = {
+        { MMA8X5X_PL_CFG, MMA8X5X_PL_CFG_DBCNTM | MMA8X5X_PL_CFG_PL_EN },
+        { MMA8X5X_PL_COUNT, count },
+    };
+
+    writeEventConfig(regs, 2, MMA8X5X_CTRL_REG4_INT_EN_LNDPRT, true);
+}
+
+void
+MMA8X5X::disableEventDetection()
+{
+    const uint8_t regs[][2] = {
+        { MMA8X5X_FF_MT_CFG, 0 },
+        { MMA8X5X_PL_CFG, MMA8X5X_PL_CFG_DBCNTM },
+        { MMA8X5X_TRANSIENT_CFG, 0 },
+        { MMA8X5X_PULSE_CFG, 0 },
+    };
+
+    /* the MMA8653 has no transient and pulse registers */
+    writeEventConfig(regs,
+                     s_params->type == MMA8X5X_DEVICE_ID_MMA8653 ? 2 : 4,
+                     MMA8X5X_CTRL_REG4_INT_EN_FF_MT |
+                     MMA8X5X_CTRL_REG4_INT_EN_PULSE |
+                     MMA8X5X_CTRL_REG4_INT_EN_LNDPRT |
+                     MMA8X5X_CTRL_REG4_INT_EN_TRANS, false);
+}
+
+void
+MMA8X5X::startEvents(int gpio)
+{
+    stopEvents();
+
+    m_gpioInt = new mraa::Gpio(gpio);
+    m_gpioInt->dir(mraa::DIR_IN);
+    m_gpioInt->isr(mraa::EDGE_FALLING, eventIsr, this);
+
+    /* INT1 may already be asserted, with no edge to come */
+    handleEvents();
+}
+
+void
+MMA8X5X::stopEvents()
+{
+    if (m_gpioInt) {
+        m_gpioInt->isrExit();
+        delete m_gpioInt;
+        m_gpioInt = NULL;
+    }
+}
+
+bool
+MMA8X5X::getEvent(MotionEvent &event, int timeoutMs)
+{
+    return m_events.pop(event, timeoutMs);
+}
+
+void
+MMA8X5X::setEventCallback(EventQueue<MotionEvent>::Callback cb)
+{
+    m_events.setCallback(cb);
+}
+
+unsigned int
+MMA8X5X::getEventsDropped()
+{
+    return m_events.dropped();
+}
+
+void
+MMA8X5X::eventIsr(void *ctx)
+{
+    try {
+        static_cast<MMA8X5X *>(ctx)->handleEvents();
+    } catch (const std::exception &e) {
+        std::cerr << "MMA8X5X: " << e.what() << std::endl;
+    }
+}
+
+void
+MMA8X5X::handleEvents()
+{
+    const uint8_t events = MMA8X5X_INT_SOURCE_FF_MT |
+                           MMA8X5X_INT_SOURCE_PULSE |
+                           MMA8X5X_INT_SOURCE_LNDPRT |
+                           MMA8X5X_INT_SOURCE_TRANS;
+
+    std::lock_guard<std::mutex> lock(m_eventLock);
+
+    uint8_t src;
+
+    /* reading the source registers clears the latched events, keep
+       going until INT1 is released so the next event makes an edge */
+    while ((src = m_i2ControlCtx.readReg(MMA8X5X_INT_SOURCE)) & events) {
+        MotionEvent e;
+        e.timestamp = MotionEvent::now();
+
+        if (src & MMA8X5X_INT_SOURCE_FF_MT) {
+            e.source = m_i2ControlCtx.readReg(MMA8X5X_FF_MT_SRC);
+            e.type = m_motionMode ? MOTION_EVENT_MOTION
+                                  : MOTION_EVENT_FREEFALL;
+            m_events.push(e);
+        }
+
+        if (src & MMA8X5X_INT_SOURCE_TRANS) {
+            e.source = m_i2ControlCtx.readReg(MMA8X5X_TRANSIENT_SRC);
+            e.type = MOTION_EVENT_TRANSIENT;
+            m_events.push(e);
+        }
+
+        if (src & MMA8X5X_INT_SOURCE_PULSE) {
+            e.source = m_i2ControlCtx.readReg(MMA8X5X_PULSE_SRC);
+            e.type = (e.source & MMA8X5X_PULSE_SRC_DPE) ?
+                MOTION_EVENT_DOUBLE_TAP : MOTION_EVENT_TAP;
+            m_events.push(e);
+        }
+
+        if (src & MMA8X5X_INT_SOURCE_LNDPRT) {
+            e.source = m_i2ControlCtx.readReg(MMA8X5X_PL_STATUS);
+            if (e.source & MMA8X5X_PL_STATUS_NEWLP) {
+                e.type = MOTION_EVENT_ORIENTATION;
+                m_events.push(e);
+            }
+        }
+    }
+}
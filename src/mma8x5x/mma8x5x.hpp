@@ -14,12 +14,16 @@
 #pragma once
 
 #include <string>
+#include <mutex>
 #include <mraa/i2c.hpp>
+#include <mraa/gpio.hpp>
 #include <stdint.h>
 #include <stdbool.h>
 
 #include <interfaces/iAcceleration.hpp>
 
+#include "upm_event_queue.hpp"
+
 /* Supported devices by this driver */
 #define MMA8X5X_DEVICE_ID_MMA8652 0x4a
 #define MMA8X5X_DEVICE_ID_MMA8653 0x5a
@@ -286,6 +290,9 @@
 #define MMA8X5X_CTRL_REG5_INT_CFG_FIFO      (1 << 6)
 #define MMA8X5X_CTRL_REG5_INT_CFG_ASLP      (1 << 7)
 
+/* Threshold resolution of the embedded functions, in g per LSB */
+#define MMA8X5X_EVENT_THS_G                 0.063
+
 namespace upm {
 
 typedef struct {
@@ -328,6 +335,14 @@ typedef struct {
  * options configurable to two interrupt pins. The MMA8X5X have user-selectable
  * full scales of +-2g/+-4g/+-8g.
  *
+ * The embedded freefall/motion, transient, pulse (tap) and
+ * landscape/portrait functions can detect events on the device
+ * itself.  Enable them with the enable*Detection() methods and call
+ * startEvents() with the GPIO connected to INT1; events then arrive
+ * through getEvent() or an event callback, without reading samples.
+ * The MMA8653 only has the freefall/motion and landscape/portrait
+ * functions.
+ *
  * @snippet mma8x5x.cxx Interesting
  */
 class MMA8X5X: virtual public iAcceleration {
@@ -343,6 +358,11 @@ class MMA8X5X: virtual public iAcceleration {
         MMA8X5X (int bus, mma8x5x_params_t* params=NULL,
                          int devAddr=MMA8X5X_I2C_ADDRESS);
 
+        /**
+         * MMA8X5X destructor
+         */
+        ~MMA8X5X();
+
         /**
          * Set device name and type matching given type or
          * read out devive_id to set name and type of device 
@@ -454,7 +474,140 @@ class MMA8X5X: virtual public iAcceleration {
          */
         int getData(mma8x5x_data_t* data, int bSampleData = 0);
 
+        /**
+         * Detect freefall: all enabled axes below the threshold for
+         * count samples.  This shares the freefall/motion function
+         * with enableMotionDetection(), the last one called is in
+         * effect.
+         *
+         * @param threshold Threshold in g, up to 8g
+         * @param count Debounce count, in samples
+         * @throws std::invalid_argument, std::runtime_error on failure
+         */
+        void enableFreefallDetection(float threshold = 0.5,
+                                     uint8_t count = 3);
+
+        /**
+         * Detect motion: any of the enabled axes above the threshold
+         * for count samples.  This shares the freefall/motion
+         * function with enableFreefallDetection(), the last one
+         * called is in effect.
+         *
+         * @param threshold Threshold in g, up to 8g
+         * @param count Debounce count, in samples
+         * @param x Detect on the x-axis
+         * @param y Detect on the y-axis
+         * @param z Detect on the z-axis
+         * @throws std::invalid_argument, std::runtime_error on failure
+         */
+        void enableMotionDetection(float threshold = 1.5,
+                                   uint8_t count = 3, bool x = true,
+                                   bool y = true, bool z = true);
+
+        /**
+         * Detect transients: high-pass filtered acceleration of any
+         * enabled axis above the threshold for count samples.
+         *
+         * @param threshold Threshold in g, up to 8g
+         * @param count Debounce count, in samples
+         * @param x Detect on the x-axis
+         * @param y Detect on the y-axis
+         * @param z Detect on the z-axis
+         * @throws std::invalid_argument, std::runtime_error on failure
+         */
+        void enableTransientDetection(float threshold = 0.5,
+                                      uint8_t count = 3, bool x = true,
+                                      bool y = true, bool z = true);
+
+        /**
+         * Detect taps (pulses) on all axes.  The time values are in
+         * units that depend on the data rate and oversampling mode,
+         * see the PULSE_TMLT, PULSE_LTCY and PULSE_WIND registers in
+         * the datasheet; the defaults suit 400Hz in normal mode.
+         *
+         * @param threshold Threshold in g, up to 8g
+         * @param doubleTap Also detect double taps
+         * @param timeLimit Longest pulse
+         * @param latency Time after a pulse when no pulse is detected
+         * @param window Time after the latency for a second pulse
+         * @throws std::invalid_argument, std::runtime_error on failure
+         */
+        void enableTapDetection(float threshold = 2.0,
+                                bool doubleTap = false,
+                                uint8_t timeLimit = 0x18,
+                                uint8_t latency = 0x28,
+                                uint8_t window = 0x3c);
+
+        /**
+         * Detect landscape/portrait and back/front orientation
+         * changes.
+         *
+         * @param count Debounce count, in samples
+         * @throws std::runtime_error on failure
+         */
+        void enableOrientationDetection(uint8_t count = 5);
+
+        /**
+         * Turn off all event detection functions and their
+         * interrupts.
+         *
+         * @throws std::runtime_error on failure
+         */
+        void disableEventDetection();
+
+        /**
+         * Start delivering events.  All event interrupts are routed
+         * to INT1, active low.
+         *
+         * @param gpio GPIO pin connected to INT1
+         * @throws std::runtime_error on failure
+         */
+        void startEvents(int gpio);
+
+        /**
+         * Stop delivering events and release the GPIO pin.
+         */
+        void stopEvents();
+
+        /**
+         * Take the oldest event.  The source field holds FF_MT_SRC,
+         * TRANSIENT_SRC, PULSE_SRC or PL_STATUS, depending on the
+         * event type.
+         *
+         * @param event The event
+         * @param timeoutMs Time to wait for an event in milliseconds,
+         * 0 to return at once, negative to wait forever
+         * @return True if an event was taken
+         */
+        bool getEvent(MotionEvent &event, int timeoutMs = 0);
+
+        /**
+         * Set a callback receiving events, on the interrupt thread,
+         * instead of queueing them for getEvent().  An empty
+         * function restores the queue.
+         *
+         * @param cb Callback
+         */
+        void setEventCallback(EventQueue<MotionEvent>::Callback cb);
+
+        /**
+         * Number of events dropped because the queue was full.
+         *
+         * @return Count
+         */
+        unsigned int getEventsDropped();
+
     private:
+        /* Disable implicit copy and assignment operators */
+        MMA8X5X(const MMA8X5X&) = delete;
+        MMA8X5X &operator=(const MMA8X5X&) = delete;
+
+        void writeReg(uint8_t reg, uint8_t val);
+        void writeEventConfig(const uint8_t (*regs)[2], int count,
+                              uint8_t intBit, bool enable);
+        uint8_t eventThreshold(float threshold);
+        static void eventIsr(void *ctx);
+        void handleEvents();
 
         std::string m_name;
 
@@ -464,6 +617,13 @@ class MMA8X5X: virtual public iAcceleration {
 
         mma8x5x_params_t s_params[1];
         mma8x5x_data_t s_data[1];
+
+        mraa::Gpio *m_gpioInt;
+        EventQueue<MotionEvent> m_events;
+        /* serializes handleEvents() between the ISR and startEvents() */
+        std::mutex m_eventLock;
+        /* FF_MT is set up for motion, not freefall */
+        bool m_motionMode;
 };
 
 }
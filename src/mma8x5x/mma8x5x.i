@@ -0,0 +1,35 @@
+#ifdef SWIGPYTHON
+%module (package="upm") mma8x5x
+#endif
+
+%import "interfaces/interfaces.i"
+
+%include "../common_top.i"
+
+/* BEGIN Java syntax  ------------------------------------------------------- */
+#ifdef SWIGJAVA
+%typemap(javaimports) SWIGTYPE %{
+import upm_interfaces.*;
+
+import java.util.AbstractList;
+import java.lang.Float;
+%}
+
+JAVA_JNI_LOADLIBRARY(javaupm_mma8x5x)
+#endif
+/* END Java syntax */
+
+/* BEGIN Common SWIG syntax ------------------------------------------------- */
+/* callbacks are not wrapped, poll with getEvent() */
+%ignore setEventCallback;
+
+%{
+#include "upm_event_queue.hpp"
+%}
+%include "upm_event_queue.hpp"
+
+%{
+#include "mma8x5x.hpp"
+%}
+%include "mma8x5x.hpp"
+/* END Common SWIG syntax */
@@ -15,6 +15,7 @@
 #include <string.h>
 #include <math.h>
 #include "mmc35240.hpp"
+#include "upm_cal_store.h"
 
 #define NUMBER_OF_BITS_IN_BYTE 8
 
@@ -24,10 +25,6 @@
 #define MAGNETIC_LOW 960 /* 31 micro tesla squared */
 #define CAL_STEPS 5
 
-/* Filter defines */
-#define FILTER_MAX_SAMPLE 20
-#define FILTER_NUM_FILED 3
-
 using namespace upm;
 using namespace android;
 
@@ -37,6 +34,14 @@ static const float min_diffs[CAL_STEPS] = { 0.2, 0.25, 0.4, 0.6, 1.0 };
 static const float max_sqr_errs[CAL_STEPS] = { 10.0, 10.0, 8.0, 5.0, 3.5 };
 static const unsigned int lookback_counts[CAL_STEPS] = { 2, 3, 4, 5, 6 };
 
+/* Calibration as kept in the calibration store */
+typedef struct {
+    int32_t level;
+    double offset[3];
+    double w_invert[3][3];
+    double bfield;
+} compass_cal_blob_t;
+
 MMC35240::MMC35240(int device)
 {
     float mag_scale;
@@ -47,6 +52,13 @@ MMC35240::MMC35240(int device)
                                     ": mraa_iio_init() failed, invalid device?");
         return;
     }
+
+    if (!(m_stream = upm_iio_stream_init(device))) {
+        mraa_iio_close(m_iio);
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": upm_iio_stream_init() failed");
+    }
+
     m_scale = 1;
     m_iio_device_num = device;
     snprintf(trigger, 64, "hrtimer-mmc35240-hr-dev%d", device);
@@ -62,25 +74,22 @@ MMC35240::MMC35240(int device)
     if (mraa_iio_read_float(m_iio, "in_magn_scale", &mag_scale) == MRAA_SUCCESS)
         m_scale = mag_scale;
 
+    // no averaging until the sampling frequency is set
+    m_sampling_frequency = 0;
+
     // calibration init data
     initCalibrate();
 
-    // filter init data
-    memset(&m_filter, 0, sizeof(filter_average_t));
-    m_filter.max_samples = FILTER_MAX_SAMPLE;
-    m_filter.num_fields = FILTER_NUM_FILED;
+    char key[UPM_CAL_STORE_MAX_KEY + 1];
+    if (upm_cal_store_enabled()
+        && upm_cal_store_iio_key("mmc35240", device, key,
+                                 sizeof(key)) == UPM_SUCCESS)
+        setCalibrationStore(key);
 }
 
 MMC35240::~MMC35240()
 {
-    if (m_filter.history) {
-        free(m_filter.history);
-        m_filter.history = NULL;
-    }
-    if (m_filter.history_sum) {
-        free(m_filter.history_sum);
-        m_filter.history_sum = NULL;
-    }
+    upm_iio_stream_close(m_stream);
     if (m_iio)
         mraa_iio_close(m_iio);
 }
@@ -155,6 +164,7 @@ MMC35240::enableBuffer(int length)
 bool
 MMC35240::disableBuffer()
 {
+    upm_iio_stream_release(m_stream);
     mraa_iio_write_int(m_iio, "buffer/enable", 0);
     return true;
 }
@@ -164,6 +174,8 @@ MMC35240::setScale(float scale)
 {
     m_scale = scale;
     mraa_iio_write_float(m_iio, "in_magn_scale", scale);
+    // picked up by the next readBuffer()
+    upm_iio_stream_release(m_stream);
     return true;
 }
 
@@ -188,6 +200,7 @@ MMC35240::enable3AxisChannel()
 
     // need update channel data size after enable
     mraa_iio_update_channels(m_iio);
+    upm_iio_stream_release(m_stream);
     return true;
 }
 
@@ -221,6 +234,50 @@ MMC35240::extract3Axis(char* data, float* x, float* y, float* z)
     denoise_average(x, y, z);
 }
 
+size_t
+MMC35240::readBuffer(float* buffer, size_t len, int timeoutMs)
+{
+    static const char* axes[3] = { "magn_x", "magn_y", "magn_z" };
+    float* data[UPM_IIO_STREAM_MAX_CHANNELS] = { 0 };
+    size_t count = len / 3;
+
+    if (!upm_iio_stream_num_channels(m_stream)) {
+        if (upm_iio_stream_open(m_stream) != UPM_SUCCESS)
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": upm_iio_stream_open() failed, buffer not enabled?");
+
+        // same scale as extract3Axis()
+        for (int i = 0; i < 3; i++)
+            upm_iio_stream_set_scale(m_stream, upm_iio_stream_find_channel(m_stream, axes[i]),
+                                     CONVERT_GAUSS_TO_MICROTESLA(m_scale));
+    }
+
+    for (int i = 0; i < 3; i++) {
+        int chan = upm_iio_stream_find_channel(m_stream, axes[i]);
+        if (chan < 0)
+            throw std::runtime_error(std::string(__FUNCTION__) +
+                                     ": axis scan elements not enabled");
+        data[chan] = buffer + i * count;
+    }
+
+    int n = upm_iio_stream_read(m_stream, data, NULL, count, timeoutMs);
+    if (n < 0)
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": upm_iio_stream_read() failed");
+
+    // the calibration and the averaging filter work sample by sample
+    for (int i = 0; i < n; i++) {
+        float* x = &buffer[i];
+        float* y = &buffer[count + i];
+        float* z = &buffer[2 * count + i];
+
+        calibrateCompass(x, y, z, &m_cal_data);
+        denoise_average(x, y, z);
+    }
+
+    return n;
+}
+
 int
 MMC35240::getCalibratedLevel()
 {
@@ -298,6 +355,46 @@ MMC35240::resetSample(compass_cal_t* data)
     data->average[0] = data->average[1] = data->average[2] = 0;
 }
 
+void
+MMC35240::setCalibrationStore(std::string key)
+{
+    compass_cal_blob_t blob;
+
+    m_cal_key = key;
+    if (key.empty()
+        || upm_cal_store_load(key.c_str(), &blob, sizeof(blob)) != UPM_SUCCESS
+        || blob.level < 0 || blob.level >= CAL_STEPS)
+        return;
+
+    m_cal_level = blob.level;
+    for (int i = 0; i < 3; i++) {
+        m_cal_data.offset[i][0] = blob.offset[i];
+        for (int j = 0; j < 3; j++)
+            m_cal_data.w_invert[i][j] = blob.w_invert[i][j];
+    }
+    m_cal_data.bfield = blob.bfield;
+}
+
+void
+MMC35240::saveCalibration()
+{
+    compass_cal_blob_t blob;
+
+    if (m_cal_key.empty())
+        return;
+
+    memset(&blob, 0, sizeof(blob));
+    blob.level = m_cal_level;
+    for (int i = 0; i < 3; i++) {
+        blob.offset[i] = m_cal_data.offset[i][0];
+        for (int j = 0; j < 3; j++)
+            blob.w_invert[i][j] = m_cal_data.w_invert[i][j];
+    }
+    blob.bfield = m_cal_data.bfield;
+
+    upm_cal_store_save_async(m_cal_key.c_str(), &blob, sizeof(blob));
+}
+
 void
 MMC35240::calibrateCompass(float* x, float* y, float* z, compass_cal_t* cal_data)
 {
@@ -422,6 +519,7 @@ MMC35240::compassReady(compass_cal_t* cal_data)
                 cal_data->bfield = new_cal_data.bfield;
                 if (m_cal_level < (cal_steps - 1))
                     m_cal_level++;
+                saveCalibration();
 #ifdef DEBUG
                 printf("CompassCalibration: ready check success, caldata: %f %f %f %f %f %f %f %f "
                        "%f %f %f %f %f, err %f\n",
@@ -727,72 +825,29 @@ MMC35240::denoise_average(float* x, float* y, float* z)
 {
     /*
      * Smooth out incoming data using a moving average over a number of
-     * samples. We accumulate one second worth of samples, or max_samples,
-     * depending on which is lower.
+     * samples. We accumulate one second worth of samples, or the
+     * filter's maximum window, depending on which is lower.
      */
-    float* data[3];
-    int f;
-    int history_size;
-    int history_full = 0;
-    filter_average_t* filter;
-
-    data[0] = x;
-    data[1] = y;
-    data[2] = z;
+    float v[3] = { *x, *y, *z };
+    size_t window;
 
     /* Don't denoise anything if we have less than two samples per second */
     if (m_sampling_frequency < 2)
         return;
 
-    filter = (filter_average_t*) &m_filter;
-
-    if (!filter)
-        return;
-
-    /* Restrict window size to the min of sampling_rate and max_samples */
-    if (m_sampling_frequency > filter->max_samples)
-        history_size = filter->max_samples;
+    /* Restrict window size to the min of sampling_rate and max window */
+    if (m_sampling_frequency > m_filter.maxWindow())
+        window = m_filter.maxWindow();
     else
-        history_size = m_sampling_frequency;
+        window = m_sampling_frequency;
 
     /* Reset history if we're operating on an incorrect window size */
-    if (filter->history_size != history_size) {
-        filter->history_size = history_size;
-        filter->history_entries = 0;
-        filter->history_index = 0;
-        filter->history =
-        (float*) realloc(filter->history, filter->history_size * filter->num_fields * sizeof(float));
-        if (filter->history) {
-            filter->history_sum =
-            (float*) realloc(filter->history_sum, filter->num_fields * sizeof(float));
-            if (filter->history_sum)
-                memset(filter->history_sum, 0, filter->num_fields * sizeof(float));
-        }
-    }
+    if (m_filter.getWindow() != window)
+        m_filter.setWindow(window);
 
-    if (!filter->history || !filter->history_sum)
-        return; /* Unlikely, but still... */
-
-    /* Update initialized samples count */
-    if (filter->history_entries < filter->history_size)
-        filter->history_entries++;
-    else
-        history_full = 1;
-
-    /* Record new sample and calculate the moving sum */
-    for (f = 0; f < filter->num_fields; f++) {
-        /** A field is going to be overwritten if history is full, so decrease the history sum */
-        if (history_full)
-            filter->history_sum[f] -=
-            filter->history[filter->history_index * filter->num_fields + f];
-
-        filter->history[filter->history_index * filter->num_fields + f] = *data[f];
-        filter->history_sum[f] += *data[f];
-
-        /* For now simply compute a mobile mean for each field and output filtered data */
-        *data[f] = filter->history_sum[f] / filter->history_entries;
-    }
+    m_filter.filter(v, v);
 
-    /* Update our rolling index (next evicted cell) */
-    filter->history_index = (filter->history_index + 1) % filter->history_size;
+    *x = v[0];
+    *y = v[1];
+    *z = v[2];
 }
@@ -13,6 +13,9 @@
 #include <string>
 #include <mraa/iio.h>
 
+#include "upm_iio_stream.h"
+#include "upm_filters.hpp"
+
 // Adopt
 // https://android.googlesource.com/platform/frameworks/native/+/refs/heads/master/services/sensorservice/mat.h
 #include "mat.h"
@@ -63,16 +66,6 @@ class MMC35240
 
     typedef double mat_input_t[MAGN_DS_SIZE][3];
 
-    typedef struct {
-        int max_samples;     /* Maximum averaging window size */
-        int num_fields;      /* Number of fields per sample (usually 3) */
-        float* history;      /* Working buffer containing recorded samples */
-        float* history_sum;  /* The current sum of the history elements */
-        int history_size;    /* Number of recorded samples */
-        int history_entries; /* How many of these are initialized */
-        int history_index;   /* Index of sample to evict next time */
-    } filter_average_t;
-
     /**
      * MMC35240 Tri-axis Magnetic Sensor
      *
@@ -143,6 +136,27 @@ class MMC35240
      */
     void extract3Axis(char* data, float* x, float* y, float* z);
 
+    /**
+     * Read a block of samples from the trigger buffer, as an
+     * alternative to installISR() and extract3Axis().  Call
+     * enable3AxisChannel() and enableBuffer() first.  Waits up to
+     * timeoutMs for the first sample, then returns the samples already
+     * buffered, as many as fit.  The samples go through the same
+     * calibration and denoise steps as with extract3Axis().
+     *
+     * The samples are stored by axis: the first third of the buffer
+     * receives the x values, the second the y and the last the z
+     * values.  Units are micro Tesla.
+     *
+     * @param buffer Array to store the samples in
+     * @param len Size of the array, in floats
+     * @param timeoutMs Maximum time to wait in milliseconds, -1 to wait
+     * forever
+     * @return Number of samples read, 0 on timeout
+     * @throws std::runtime_error on failure
+     */
+    size_t readBuffer(float* buffer, size_t len, int timeoutMs = -1);
+
     /**
      * Get calibrated level
      */
@@ -165,6 +179,17 @@ class MMC35240
     void
     loadCalibratedData(int cal_level, double offset[3][1], double w_invert[3][3], double bfield);
 
+    /**
+     * Keep the compass calibration in the calibration store (see
+     * upm_cal_store.h).  Calibration saved under the key is loaded
+     * right away, and saved again each time it improves.  The
+     * constructor does this by itself when the store is enabled, with
+     * the key made by upm_cal_store_iio_key().
+     *
+     * @param key Device key, or an empty string to stop using the store
+     */
+    void setCalibrationStore(std::string key);
+
   private:
     /* Adopt https://github.com/01org/android-iio-sensors-hal/blob/master/compass-calibration.c */
     void resetSample(compass_cal_t* data);
@@ -184,7 +209,11 @@ class MMC35240
     /* Adopt https://github.com/01org/android-iio-sensors-hal/blob/master/filtering.c */
     void denoise_average(float* x, float* y, float* z);
 
+    // queue the current calibration to the store
+    void saveCalibration();
+
     mraa_iio_context m_iio;
+    upm_iio_stream_context m_stream; // block reader
     int m_iio_device_num;
     float m_sampling_frequency; // sampling frequency
     bool m_mount_matrix_exist;  // is mount matrix exist
@@ -192,6 +221,7 @@ class MMC35240
     float m_scale;              // data scale
     compass_cal_t m_cal_data;   // calibrate data
     int m_cal_level;            // calibrated level
-    filter_average_t m_filter;  // filter data
+    MovingAverage<float, 3, 20> m_filter; // denoise filter
+    std::string m_cal_key;      // calibration store key
 };
 }
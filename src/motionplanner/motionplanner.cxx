@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "motionplanner.hpp"
+
+using namespace upm;
+using namespace std;
+
+namespace {
+  // Time at which a move of length bigger than zero reaches a given
+  // distance along its path.  The speed ramps up from rest over the
+  // first rampDist steps, cruises, and ramps back down over the last
+  // rampDist steps; ramps are symmetric, so the deceleration times
+  // are the acceleration times mirrored.
+  class Profile {
+  public:
+    Profile(double length, double speed, double accel,
+            MotionPlanner::PROFILE_T profile)
+      : m_length(length), m_scurve(profile == MotionPlanner::PROFILE_SCURVE)
+    {
+      // ramp time is k * v / a: 1 for constant acceleration, pi/2 for
+      // a cosine shaped speed ramp with the same peak acceleration
+      double k = m_scurve ? M_PI / 2.0 : 1.0;
+
+      // too short to reach the cruise speed: turn around halfway
+      if (k * speed * speed / accel > length)
+        speed = sqrt(accel * length / k);
+
+      m_speed = speed;
+      m_rampTime = k * speed / accel;
+      m_rampDist = speed * m_rampTime / 2.0;
+      m_totalTime = 2.0 * m_rampTime + (length - 2.0 * m_rampDist) / speed;
+    }
+
+    double timeAt(double dist) const
+    {
+      if (dist <= m_rampDist)
+        return rampTime(dist);
+      else if (dist < m_length - m_rampDist)
+        return m_rampTime + (dist - m_rampDist) / m_speed;
+      else
+        return m_totalTime - rampTime(m_length - dist);
+    }
+
+  private:
+    double rampTime(double dist) const
+    {
+      if (dist <= 0.0)
+        return 0.0;
+
+      if (!m_scurve)
+        // dist = (v / T) * t^2 / 2
+        return sqrt(2.0 * dist * m_rampTime / m_speed);
+
+      // dist = v / 2 * (t - T / pi * sin(pi * t / T)), solved with
+      // Newton's method.  Start from the cubic approximation, which
+      // is good near 0 where the derivative vanishes.
+      double T = m_rampTime;
+      double t = cbrt(12.0 * T * T * dist / (m_speed * M_PI * M_PI));
+
+      for (int i = 0; i < 8; i++)
+      {
+        t = min(max(t, 0.0), T);
+
+        double f = m_speed / 2.0 * (t - T / M_PI * sin(M_PI * t / T)) - dist;
+        double df = m_speed / 2.0 * (1.0 - cos(M_PI * t / T));
+
+        if (df <= 0.0)
+          break;
+
+        double dt = f / df;
+        t -= dt;
+
+        if (fabs(dt) < 1e-9)
+          break;
+      }
+
+      return min(max(t, 0.0), T);
+    }
+
+    double m_length;
+    bool m_scurve;
+    double m_speed;
+    double m_rampTime;
+    double m_rampDist;
+    double m_totalTime;
+  };
+
+  void addNs(struct timespec &ts, const struct timespec &base, double sec)
+  {
+    long long ns = base.tv_nsec + (long long)(sec * 1e9);
+
+    ts.tv_sec = base.tv_sec + ns / 1000000000;
+    ts.tv_nsec = ns % 1000000000;
+  }
+}
+
+MotionPlanner::MotionPlanner() :
+  m_speed(200.0), m_accel(400.0), m_profile(PROFILE_TRAPEZOIDAL),
+  m_busy(false), m_abort(false), m_exit(false)
+{
+  m_thread = std::thread(&MotionPlanner::run, this);
+}
+
+MotionPlanner::~MotionPlanner()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_queue.clear();
+    m_abort = true;
+    m_exit = true;
+  }
+  m_wake.notify_all();
+
+  m_thread.join();
+}
+
+int MotionPlanner::addAxis(std::function<void(bool)> step, int position)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+
+  if (m_busy || !m_queue.empty())
+    throw std::runtime_error(string(__FUNCTION__) +
+                             ": Can not add an axis while moving");
+
+  Axis axis;
+  axis.step = step;
+  axis.position = position;
+  axis.target = position;
+  m_axes.push_back(axis);
+
+  return m_axes.size() - 1;
+}
+
+int MotionPlanner::addAxis(StepMotor &motor)
+{
+  StepMotor *m = &motor;
+
+  return addAxis([m](bool forward) { m->singleStep(forward); },
+                 motor.getPosition());
+}
+
+int MotionPlanner::addAxis(ULN200XA &motor)
+{
+  ULN200XA *m = &motor;
+
+  return addAxis([m](bool forward) {
+      m->singleStep(forward ? ULN200XA_DIR_CW : ULN200XA_DIR_CCW);
+    }, 0);
+}
+
+int MotionPlanner::getAxisCount()
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+
+  return m_axes.size();
+}
+
+void MotionPlanner::setMaxSpeed(float stepsPerSec)
+{
+  if (!(stepsPerSec > 0))
+    throw std::invalid_argument(string(__FUNCTION__) +
+                                ": Parameter must be greater than 0");
+
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_speed = stepsPerSec;
+}
+
+void MotionPlanner::setAcceleration(float stepsPerSec2)
+{
+  if (!(stepsPerSec2 > 0))
+    throw std::invalid_argument(string(__FUNCTION__) +
+                                ": Parameter must be greater than 0");
+
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_accel = stepsPerSec2;
+}
+
+void MotionPlanner::setProfile(PROFILE_T profile)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+  m_profile = profile;
+}
+
+void MotionPlanner::moveTo(const std::vector<int> &positions)
+{
+  std::vector<int> steps(positions.size());
+
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (positions.size() != m_axes.size())
+      throw std::invalid_argument(string(__FUNCTION__) +
+                                  ": Need one position per axis");
+
+    for (size_t i = 0; i < positions.size(); i++)
+      steps[i] = positions[i] - m_axes[i].target;
+  }
+
+  move(steps);
+}
+
+void MotionPlanner::move(const std::vector<int> &steps)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    if (steps.size() != m_axes.size())
+      throw std::invalid_argument(string(__FUNCTION__) +
+                                  ": Need one value per axis");
+
+    bool any = false;
+    for (size_t i = 0; i < steps.size(); i++)
+    {
+      m_axes[i].target += steps[i];
+      if (steps[i])
+        any = true;
+    }
+
+    if (!any)
+      return;
+
+    Segment seg;
+    seg.steps = steps;
+    seg.speed = m_speed;
+    seg.accel = m_accel;
+    seg.profile = m_profile;
+    m_queue.push_back(seg);
+  }
+
+  m_wake.notify_all();
+}
+
+bool MotionPlanner::wait(int timeoutMs)
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+
+  auto idle = [this] { return !m_busy && m_queue.empty(); };
+
+  bool done = true;
+  if (timeoutMs < 0)
+    m_idle.wait(lock, idle);
+  else
+    done = m_idle.wait_for(lock, std::chrono::milliseconds(timeoutMs), idle);
+
+  if (m_error)
+  {
+    std::exception_ptr error = m_error;
+    m_error = nullptr;
+    std::rethrow_exception(error);
+  }
+
+  return done;
+}
+
+bool MotionPlanner::isMoving()
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+
+  return m_busy || !m_queue.empty();
+}
+
+void MotionPlanner::stop()
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+
+  m_queue.clear();
+  if (m_busy)
+    m_abort = true;
+
+  m_idle.wait(lock, [this] { return !m_busy; });
+}
+
+int MotionPlanner::getPosition(int axis)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+
+  if (axis < 0 || axis >= (int)m_axes.size())
+    throw std::out_of_range(string(__FUNCTION__) + ": Invalid axis");
+
+  return m_axes[axis].position;
+}
+
+void MotionPlanner::setPosition(int axis, int position)
+{
+  std::lock_guard<std::mutex> lock(m_lock);
+
+  if (axis < 0 || axis >= (int)m_axes.size())
+    throw std::out_of_range(string(__FUNCTION__) + ": Invalid axis");
+
+  if (m_busy || !m_queue.empty())
+    throw std::runtime_error(string(__FUNCTION__) +
+                             ": Can not set the position while moving");
+
+  m_axes[axis].position = position;
+  m_axes[axis].target = position;
+}
+
+bool MotionPlanner::setRealtimePriority(int priority)
+{
+  struct sched_param param;
+  param.sched_priority = priority;
+
+  return pthread_setschedparam(m_thread.native_handle(), SCHED_FIFO,
+                               &param) == 0;
+}
+
+void MotionPlanner::run()
+{
+  std::unique_lock<std::mutex> lock(m_lock);
+
+  while (true)
+  {
+    m_wake.wait(lock, [this] { return m_exit || !m_queue.empty(); });
+    if (m_exit)
+      break;
+
+    Segment seg = m_queue.front();
+    m_queue.pop_front();
+    m_busy = true;
+    m_abort = false;
+
+    lock.unlock();
+    try
+    {
+      execute(seg);
+    }
+    catch (...)
+    {
+      lock.lock();
+      m_error = std::current_exception();
+      m_queue.clear();
+      lock.unlock();
+    }
+    lock.lock();
+
+    // after an abort or error the queued targets are gone, the axes
+    // are wherever they stopped
+    if (m_queue.empty())
+      for (auto &axis : m_axes)
+        axis.target = axis.position;
+
+    m_busy = false;
+    m_idle.notify_all();
+  }
+}
+
+void MotionPlanner::execute(const Segment &seg)
+{
+  size_t n = seg.steps.size();
+  int length = 0;
+
+  for (size_t i = 0; i < n; i++)
+    length = max(length, abs(seg.steps[i]));
+
+  Profile profile(length, seg.speed, seg.accel, seg.profile);
+
+  // each axis takes its j'th step when the longest axis has covered
+  // j * length / |steps| of its path
+  std::vector<int> taken(n, 0);
+  std::vector<double> next(n, 0.0);
+
+  for (size_t i = 0; i < n; i++)
+    if (seg.steps[i])
+      next[i] = profile.timeAt((double)length / abs(seg.steps[i]));
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (true)
+  {
+    // earliest pending step
+    int axis = -1;
+    for (size_t i = 0; i < n; i++)
+      if (taken[i] < abs(seg.steps[i]) && (axis < 0 || next[i] < next[axis]))
+        axis = i;
+
+    if (axis < 0)
+      break;
+
+    struct timespec deadline;
+    addNs(deadline, start, next[axis]);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline,
+                           NULL) == EINTR);
+
+    bool forward = seg.steps[axis] > 0;
+
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      if (m_abort)
+        return;
+    }
+
+    m_axes[axis].step(forward);
+    taken[axis]++;
+
+    {
+      std::lock_guard<std::mutex> lock(m_lock);
+      m_axes[axis].position += forward ? 1 : -1;
+    }
+
+    if (taken[axis] < abs(seg.steps[axis]))
+      next[axis] = profile.timeAt((double)(taken[axis] + 1) * length
+                                  / abs(seg.steps[axis]));
+  }
+}
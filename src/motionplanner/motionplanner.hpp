@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <stepmotor.hpp>
+#include <uln200xa.hpp>
+
+namespace upm {
+  /**
+   * @brief Stepper Motion Planner
+   * @defgroup motionplanner libupm-motionplanner
+   * @ingroup generic gpio motor
+   */
+
+  /**
+   * @library motionplanner
+   * @sensor motionplanner
+   * @comname Stepper Motion Planner
+   * @type motor
+   * @man generic
+   * @con gpio
+   * @brief API for non-blocking, coordinated stepper motor moves
+   *
+   * MotionPlanner drives one or more StepMotor or ULN200XA stepper
+   * motors (axes) from a background thread.  Moves are queued with
+   * moveTo() or move() and return immediately; wait() blocks until
+   * the queue has been executed.
+   *
+   * Every move starts and ends at rest, with the speed ramped up and
+   * down using either a trapezoidal (constant acceleration) or an
+   * S-curve (smooth acceleration) profile.  When several axes move at
+   * once their steps are interpolated along a straight line, so all of
+   * them arrive at the same time.  The speed and acceleration limits
+   * apply to the axis with the longest move.
+   *
+   * Steps are timed against absolute deadlines on the monotonic
+   * clock, so the timing does not drift with the time spent toggling
+   * GPIOs, and the thread sleeps rather than spins between steps.
+   * For the lowest jitter, give the thread a realtime priority with
+   * setRealtimePriority().
+   *
+   * @snippet motionplanner.cxx Interesting
+   */
+  class MotionPlanner {
+  public:
+    /**
+     * Speed profiles
+     */
+    typedef enum {
+      PROFILE_TRAPEZOIDAL = 0,   // constant acceleration
+      PROFILE_SCURVE             // acceleration ramped up and down
+    } PROFILE_T;
+
+    /**
+     * MotionPlanner constructor.  Starts the motion thread.
+     */
+    MotionPlanner();
+
+    /**
+     * MotionPlanner destructor.  Aborts any queued moves and stops the
+     * motion thread.
+     */
+    ~MotionPlanner();
+
+    /**
+     * Adds a StepMotor as the next axis.  The axis starts out at the
+     * motor's current position.  The motor must not be stepped
+     * directly while the planner is moving it, and must outlive the
+     * planner.
+     *
+     * @param motor Stepper motor
+     * @return Index of the new axis
+     * @throws std::runtime_error if called while moving
+     */
+    int addAxis(StepMotor &motor);
+
+    /**
+     * Adds a ULN200XA driven stepper motor as the next axis.  The axis
+     * starts out at position 0.  The motor must not be stepped
+     * directly while the planner is moving it, and must outlive the
+     * planner.
+     *
+     * @param motor Stepper motor
+     * @return Index of the new axis
+     * @throws std::runtime_error if called while moving
+     */
+    int addAxis(ULN200XA &motor);
+
+    /**
+     * Returns the number of axes.
+     *
+     * @return Number of axes
+     */
+    int getAxisCount();
+
+    /**
+     * Sets the cruise speed used by the following moves.  Default 200
+     * steps per second.
+     *
+     * @param stepsPerSec Speed, in steps per second
+     * @throws std::invalid_argument if not positive
+     */
+    void setMaxSpeed(float stepsPerSec);
+
+    /**
+     * Sets the (peak) acceleration used by the following moves.
+     * Default 400 steps per second per second.
+     *
+     * @param stepsPerSec2 Acceleration, in steps per second per second
+     * @throws std::invalid_argument if not positive
+     */
+    void setAcceleration(float stepsPerSec2);
+
+    /**
+     * Sets the speed profile used by the following moves.  Default
+     * PROFILE_TRAPEZOIDAL.  For the same peak acceleration, an S-curve
+     * ramp takes pi/2 times as long as a trapezoidal one.
+     *
+     * @param profile One of the PROFILE_T values
+     */
+    void setProfile(PROFILE_T profile);
+
+    /**
+     * Queues a coordinated move to absolute positions, one per axis.
+     * The move starts where the previously queued moves end.  Returns
+     * immediately.
+     *
+     * @param positions Target position of each axis, in steps
+     * @throws std::invalid_argument if the number of positions does
+     * not match the number of axes
+     */
+    void moveTo(const std::vector<int> &positions);
+
+    /**
+     * Queues a coordinated move by a number of steps, one per axis.
+     * Returns immediately.
+     *
+     * @param steps Steps to move each axis by, negative values move
+     * backward
+     * @throws std::invalid_argument if the number of values does not
+     * match the number of axes
+     */
+    void move(const std::vector<int> &steps);
+
+    /**
+     * Waits for all queued moves to finish.
+     *
+     * @param timeoutMs Maximum time to wait in milliseconds, or -1 to
+     * wait forever
+     * @return true if all moves finished, false on timeout
+     * @throws std::runtime_error if a motor failed to step, the queue
+     * is aborted in that case
+     */
+    bool wait(int timeoutMs = -1);
+
+    /**
+     * Returns whether a move is executing or queued.
+     *
+     * @return true if moving
+     */
+    bool isMoving();
+
+    /**
+     * Aborts the current move immediately, and drops all queued
+     * moves.  As there is no deceleration, motors moving at speed may
+     * lose steps.
+     */
+    void stop();
+
+    /**
+     * Gets the current position of an axis.
+     *
+     * @param axis Axis index
+     * @return Position, in steps
+     * @throws std::out_of_range for an invalid axis
+     */
+    int getPosition(int axis);
+
+    /**
+     * Sets the current position of an axis, e.g. after homing.
+     *
+     * @param axis Axis index
+     * @param position Position, in steps
+     * @throws std::out_of_range for an invalid axis
+     * @throws std::runtime_error if called while moving
+     */
+    void setPosition(int axis, int position);
+
+    /**
+     * Runs the motion thread with the SCHED_FIFO realtime policy.
+     * Usually requires root or CAP_SYS_NICE.
+     *
+     * @param priority SCHED_FIFO priority, 1 (lowest) to 99
+     * @return true on success
+     */
+    bool setRealtimePriority(int priority);
+
+  private:
+    /* Disable implicit copy and assignment operators */
+    MotionPlanner(const MotionPlanner&) = delete;
+    MotionPlanner &operator=(const MotionPlanner&) = delete;
+
+    struct Axis {
+      std::function<void(bool)> step;
+      // position as of the last step taken
+      int position;
+      // position at the end of the queued moves
+      int target;
+    };
+
+    struct Segment {
+      std::vector<int> steps;
+      float speed;
+      float accel;
+      PROFILE_T profile;
+    };
+
+    std::vector<Axis> m_axes;
+    std::deque<Segment> m_queue;
+
+    float m_speed;
+    float m_accel;
+    PROFILE_T m_profile;
+
+    bool m_busy;
+    bool m_abort;
+    bool m_exit;
+    std::exception_ptr m_error;
+
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::thread m_thread;
+
+    int addAxis(std::function<void(bool)> step, int position);
+    void run();
+    void execute(const Segment &seg);
+  };
+}
@@ -0,0 +1,34 @@
+#ifdef SWIGPYTHON
+%module (package="upm", threads="1") motionplanner
+#endif
+
+%include "../common_top.i"
+
+/* BEGIN Java syntax  ------------------------------------------------------- */
+#ifdef SWIGJAVA
+JAVA_JNI_LOADLIBRARY(javaupm_motionplanner)
+#endif
+/* END Java syntax */
+
+/* BEGIN Python syntax  ----------------------------------------------------- */
+#ifdef SWIGPYTHON
+/* wait() and stop() block until the motion thread catches up */
+%nothread;
+%thread upm::MotionPlanner::wait;
+%thread upm::MotionPlanner::stop;
+#endif
+/* END Python syntax */
+
+/* BEGIN Common SWIG syntax ------------------------------------------------- */
+%include "std_vector.i"
+%template(intVector) std::vector<int>;
+
+%import "../stepmotor/stepmotor.hpp"
+%import "../uln200xa/uln200xa_defs.h"
+%import "../uln200xa/uln200xa.hpp"
+
+%{
+#include "motionplanner.hpp"
+%}
+%include "motionplanner.hpp"
+/* END Common SWIG syntax */
@@ -206,6 +206,20 @@ bool AK8975::selfTest()
   return true;
 }
 
+bool AK8975::setMeasurement(const uint8_t *data)
+{
+  if (data[REG_ST2 - REG_ST1] & (ST2_DERR | ST2_HOFL))
+    return false;
+
+  const uint8_t *d = data + (REG_HXL - REG_ST1);
+
+  m_xData = float(int16_t((d[1] << 8) | d[0]));
+  m_yData = float(int16_t((d[3] << 8) | d[2]));
+  m_zData = float(int16_t((d[5] << 8) | d[4]));
+
+  return true;
+}
+
 float AK8975::adjustValue(float value, float adj)
 {
   // apply the proper compensation to value.  This equation is taken
@@ -19,6 +19,9 @@
 #define AK8975_I2C_BUS 0
 #define AK8975_DEFAULT_I2C_ADDR 0x0c
 
+// bytes from REG_ST1 to REG_ST2, a complete measurement
+#define AK8975_MEASUREMENT_SIZE 8
+
 namespace upm {
 
   /**
@@ -181,6 +184,17 @@ namespace upm {
      */
     bool selfTest();
 
+    /**
+     * store a measurement read by another bus master, e.g. an
+     * MPU9150 sampling the magnetometer through its auxiliary I2C
+     * bus.  getMagnetometer() then returns it.
+     *
+     * @param data AK8975_MEASUREMENT_SIZE bytes, read from REG_ST1 on
+     * @return true if the data holds a valid measurement, false (and
+     * nothing stored) on a data error or overflow
+     */
+    bool setMeasurement(const uint8_t *data);
+
     /**
      * return the compensated values for the x, y, and z axes.  The
      * unit of measurement is in micro-teslas (uT).
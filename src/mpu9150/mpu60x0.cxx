@@ -10,6 +10,7 @@
  */
 
 #include <unistd.h>
+#include <algorithm>
 #include <iostream>
 #include <string.h>
 
@@ -18,6 +19,10 @@
 using namespace upm;
 using namespace std;
 
+static int16_t be16(const uint8_t *p)
+{
+  return int16_t((p[0] << 8) | p[1]);
+}
 
 MPU60X0::MPU60X0(int bus, uint8_t address) :
   m_i2c(bus), m_gpioIRQ(0)
@@ -37,6 +42,13 @@ MPU60X0::MPU60X0(int bus, uint8_t address) :
   m_accelScale = 1.0;
   m_gyroScale = 1.0;
 
+  m_fifoSensors = 0;
+  m_fifoExtBytes = 0;
+  m_fifoFrameSize = 0;
+  m_fifoSample = 0;
+  m_fifoOverflows = 0;
+  m_fifoRate = 0;
+
   mraa::Result rv;
   if ( (rv = m_i2c.address(m_addr)) != mraa::SUCCESS)
     {
@@ -390,6 +402,175 @@ uint8_t MPU60X0::getInterruptPinConfig()
   return readReg(REG_INT_PIN_CFG);
 }
 
+float MPU60X0::getSampleRate()
+{
+  uint8_t dlp = (readReg(REG_CONFIG) >> _CONFIG_DLPF_SHIFT)
+    & _CONFIG_DLPF_MASK;
+
+  float gyroRate = (dlp == DLPF_260_256 || dlp == DLPF_RESERVED) ?
+    8000.0 : 1000.0;
+
+  return gyroRate / (1 + getSampleRateDivider());
+}
+
+void MPU60X0::enableFifo(uint8_t sensors, int extBytes)
+{
+  int size = extBytes;
+
+  if (sensors & ACCEL_FIFO_EN)
+    size += 6;
+  if (sensors & TEMP_FIFO_EN)
+    size += 2;
+  if (sensors & XG_FIFO_EN)
+    size += 2;
+  if (sensors & YG_FIFO_EN)
+    size += 2;
+  if (sensors & ZG_FIFO_EN)
+    size += 2;
+
+  if (extBytes < 0 || size == 0 || size > MPU60X0_FIFO_SIZE)
+    throw std::invalid_argument(std::string(__FUNCTION__) +
+                                ": invalid FIFO frame");
+
+  // stop and clear the FIFO before changing its layout
+  writeReg(REG_FIFO_EN, 0);
+  uint8_t ctrl = readReg(REG_USER_CTRL) & ~FIFO_EN;
+  writeReg(REG_USER_CTRL, ctrl | FIFO_RESET);
+
+  m_fifoSensors = sensors;
+  m_fifoExtBytes = extBytes;
+  m_fifoFrameSize = size;
+  m_fifoSample = 0;
+  m_fifoOverflows = 0;
+  m_fifoRate = getSampleRate();
+  m_fifoLastRead = std::chrono::steady_clock::now();
+
+  writeReg(REG_USER_CTRL, ctrl | FIFO_EN);
+  writeReg(REG_FIFO_EN, sensors);
+}
+
+void MPU60X0::disableFifo()
+{
+  writeReg(REG_FIFO_EN, 0);
+  uint8_t ctrl = readReg(REG_USER_CTRL) & ~FIFO_EN;
+  writeReg(REG_USER_CTRL, ctrl | FIFO_RESET);
+
+  m_fifoFrameSize = 0;
+}
+
+int MPU60X0::getFifoCount()
+{
+  uint8_t buf[2];
+
+  readRegs(REG_FIFO_COUNTH, buf, 2);
+
+  return ((buf[0] << 8) | buf[1]);
+}
+
+int MPU60X0::readFifo(FIFO_FRAME_T *frames, int maxFrames)
+{
+  if (!m_fifoFrameSize)
+    throw std::runtime_error(std::string(__FUNCTION__) +
+                             ": FIFO is not enabled");
+
+  std::chrono::steady_clock::time_point now =
+    std::chrono::steady_clock::now();
+  int count = getFifoCount();
+
+  if (count >= MPU60X0_FIFO_SIZE)
+    {
+      // overflowed, or about to: the device drops bytes, not frames,
+      // so start over.  FIFO_RESET is only honoured while FIFO_EN
+      // is clear.
+      uint8_t ctrl = readReg(REG_USER_CTRL) & ~FIFO_EN;
+      writeReg(REG_USER_CTRL, ctrl | FIFO_RESET);
+      writeReg(REG_USER_CTRL, ctrl | FIFO_EN);
+
+      double lost = std::chrono::duration<double>(now -
+                                                  m_fifoLastRead).count()
+        * m_fifoRate;
+      m_fifoSample += std::max(uint32_t(lost),
+                               uint32_t(count / m_fifoFrameSize));
+      m_fifoOverflows++;
+      m_fifoLastRead = now;
+
+      return 0;
+    }
+
+  int n = std::min(count / m_fifoFrameSize, maxFrames);
+  if (n <= 0)
+    return 0;
+
+  uint8_t buf[MPU60X0_FIFO_SIZE];
+  readRegs(REG_FIFO_R_W, buf, n * m_fifoFrameSize);
+  m_fifoLastRead = now;
+
+  for (int i = 0; i < n; i++)
+    {
+      const uint8_t *p = buf + i * m_fifoFrameSize;
+      FIFO_FRAME_T *f = &frames[i];
+
+      memset(f, 0, sizeof(FIFO_FRAME_T));
+      f->sample = m_fifoSample++;
+
+      if (m_fifoSensors & ACCEL_FIFO_EN)
+        {
+          m_accelX = float(be16(p));
+          m_accelY = float(be16(p + 2));
+          m_accelZ = float(be16(p + 4));
+          p += 6;
+
+          f->accelX = m_accelX / m_accelScale;
+          f->accelY = m_accelY / m_accelScale;
+          f->accelZ = m_accelZ / m_accelScale;
+        }
+
+      if (m_fifoSensors & TEMP_FIFO_EN)
+        {
+          m_temp = float(be16(p));
+          p += 2;
+
+          f->temperature = getTemperature();
+        }
+
+      if (m_fifoSensors & XG_FIFO_EN)
+        {
+          m_gyroX = float(be16(p));
+          p += 2;
+          f->gyroX = m_gyroX / m_gyroScale;
+        }
+
+      if (m_fifoSensors & YG_FIFO_EN)
+        {
+          m_gyroY = float(be16(p));
+          p += 2;
+          f->gyroY = m_gyroY / m_gyroScale;
+        }
+
+      if (m_fifoSensors & ZG_FIFO_EN)
+        {
+          m_gyroZ = float(be16(p));
+          p += 2;
+          f->gyroZ = m_gyroZ / m_gyroScale;
+        }
+
+      if (m_fifoExtBytes)
+        decodeFifoExt(p, f);
+    }
+
+  return n;
+}
+
+int MPU60X0::getFifoOverflows()
+{
+  return m_fifoOverflows;
+}
+
+void MPU60X0::decodeFifoExt(const uint8_t *data, FIFO_FRAME_T *frame)
+{
+  (void)data;
+  (void)frame;
+}
 
 void MPU60X0::installISR(int gpio, mraa::Edge level,
                          void (*isr)(void *), void *arg)
@@ -10,6 +10,7 @@
  */
 #pragma once
 
+#include <chrono>
 #include <string>
 #include <vector>
 #include <mraa/common.hpp>
@@ -24,6 +25,8 @@
 #define MPU60X0_I2C_BUS 0
 #define MPU60X0_DEFAULT_I2C_ADDR 0x68
 
+#define MPU60X0_FIFO_SIZE 1024
+
 namespace upm {
 
   /**
@@ -642,6 +645,34 @@ namespace upm {
       LP_WAKE_40                       = 3, // 40hz
     } LP_WAKE_CRTL_T;
 
+    /**
+     * One sample read from the FIFO by readFifo().  Values of sensors
+     * not written to the FIFO are 0.
+     */
+    typedef struct {
+      // number of the sample since enableFifo(), counting samples
+      // lost to a FIFO overflow as well
+      uint32_t sample;
+
+      // acceleration in g
+      float accelX;
+      float accelY;
+      float accelZ;
+
+      // angular rate in degrees/s
+      float gyroX;
+      float gyroY;
+      float gyroZ;
+
+      // temperature in degrees Celsius
+      float temperature;
+
+      // magnetic field in uT (MPU9150 FIFO mode)
+      float magX;
+      float magY;
+      float magZ;
+    } FIFO_FRAME_T;
+
 
     /**
      * mpu60x0 constructor
@@ -896,6 +927,69 @@ namespace upm {
      */
     uint8_t getInterruptPinConfig();
 
+    /**
+     * get the Sample Rate, at which the sensor registers and the FIFO
+     * are updated (see setSampleRateDivider()).
+     *
+     * @return the sample rate in Hz
+     */
+    float getSampleRate();
+
+    /**
+     * clear the FIFO and start writing samples to it.  Each sample of
+     * the selected sensors is appended as one frame, in register
+     * order, followed by the external sensor data bytes.  At higher
+     * sample rates, reading whole batches of frames with readFifo()
+     * costs far less bus time than calling update() for every sample,
+     * and no samples are lost as long as the FIFO is read before it
+     * fills up.
+     *
+     * @param sensors bitmask of FIFO_EN_BITS_T values
+     * @param extBytes number of external sensor data bytes per
+     * sample, for the SLVx_FIFO_EN bits, as configured in the
+     * I2C_SLVx_CTRL registers
+     */
+    void enableFifo(uint8_t sensors=(ACCEL_FIFO_EN | XG_FIFO_EN |
+                                     YG_FIFO_EN | ZG_FIFO_EN),
+                    int extBytes=0);
+
+    /**
+     * stop writing samples to the FIFO and clear it
+     */
+    void disableFifo();
+
+    /**
+     * get the number of bytes in the FIFO
+     *
+     * @return the FIFO count
+     */
+    int getFifoCount();
+
+    /**
+     * read the complete frames in the FIFO, up to maxFrames, in one
+     * burst.  The values of the last frame are also stored as if read
+     * by update().
+     *
+     * When the FIFO fills up, the device drops its oldest bytes
+     * rather than whole frames, so the data left can't be parsed.  The
+     * FIFO is then cleared, and the sample counter advanced by an
+     * estimate of the samples lost, so the gap shows in the sample
+     * numbers of the frames that follow.
+     *
+     * @param frames buffer for the frames
+     * @param maxFrames size of the buffer, in frames
+     * @return the number of frames read
+     */
+    int readFifo(FIFO_FRAME_T *frames, int maxFrames);
+
+    /**
+     * get the number of times the FIFO overflowed since
+     * enableFifo()
+     *
+     * @return the number of overflows
+     */
+    int getFifoOverflows();
+
     /**
      * install an interrupt handler.
      *
@@ -936,6 +1030,15 @@ namespace upm {
     float m_accelScale;
     float m_gyroScale;
 
+    /**
+     * decode the external sensor data bytes of a FIFO frame.  The
+     * default ignores them.
+     *
+     * @param data the extBytes bytes given to enableFifo()
+     * @param frame the frame being read
+     */
+    virtual void decodeFifoExt(const uint8_t *data, FIFO_FRAME_T *frame);
+
   private:
     /* Disable implicit copy and assignment operators */
     MPU60X0(const MPU60X0&) = delete;
@@ -945,5 +1048,17 @@ namespace upm {
     uint8_t m_addr;
 
     mraa::Gpio *m_gpioIRQ;
+
+    // FIFO frame layout, 0 if the FIFO is off
+    uint8_t m_fifoSensors;
+    int m_fifoExtBytes;
+    int m_fifoFrameSize;
+
+    // sample counter, overflows, and the sample rate and time of the
+    // last read to estimate samples lost to an overflow
+    uint32_t m_fifoSample;
+    int m_fifoOverflows;
+    float m_fifoRate;
+    std::chrono::steady_clock::time_point m_fifoLastRead;
   };
 }
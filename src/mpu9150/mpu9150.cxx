@@ -12,6 +12,7 @@
 #include <iostream>
 #include <unistd.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include "mpu9150.hpp"
 
@@ -24,6 +25,7 @@ MPU9150::MPU9150 (int bus, int address, int magAddress, bool enableAk8975) :
   m_magAddress = magAddress;
   m_i2cBus = bus;
   m_enableAk8975 = enableAk8975;
+  m_magFifo = false;
 }
 
 MPU9150::~MPU9150()
@@ -75,10 +77,90 @@ void MPU9150::update()
 {
   MPU60X0::update();
 
-  if (m_mag)
+  if (m_magFifo)
+    {
+      uint8_t data[AK8975_MEASUREMENT_SIZE];
+      readRegs(REG_EXT_SENS_DATA_00, data, AK8975_MEASUREMENT_SIZE);
+      m_mag->setMeasurement(data);
+    }
+  else if (m_mag)
     m_mag->update();
 }
 
+void MPU9150::enableFifoMode(float magRate, bool temperature)
+{
+  if (!m_mag)
+    throw std::runtime_error(std::string(__FUNCTION__) +
+                             ": magnetometer not initialized");
+
+  if (magRate <= 0 || magRate > 100)
+    throw std::invalid_argument(std::string(__FUNCTION__) +
+                                ": magRate must be between 0 and 100");
+
+  // the auxiliary bus samples the magnetometer every dly + 1 samples
+  int dly = int(ceil(getSampleRate() / magRate)) - 1;
+  if (dly < 0)
+    dly = 0;
+  if (dly > _I2C_MST_DLY_MASK)
+    dly = _I2C_MST_DLY_MASK;
+
+  // the host lets go of the auxiliary bus
+  enableI2CBypass(false);
+
+  // slave 0 reads the finished measurement, slave 1 then starts the
+  // next one
+  writeReg(REG_I2C_SLV0_ADDR, I2C_SLV_RW | m_magAddress);
+  writeReg(REG_I2C_SLV0_REG, AK8975::REG_ST1);
+  writeReg(REG_I2C_SLV0_CTRL, I2C_SLV_EN | AK8975_MEASUREMENT_SIZE);
+
+  writeReg(REG_I2C_SLV1_ADDR, m_magAddress);
+  writeReg(REG_I2C_SLV1_REG, AK8975::REG_CNTL);
+  writeReg(REG_I2C_SLV1_DO, AK8975::CNTL_MEASURE);
+  writeReg(REG_I2C_SLV1_CTRL, I2C_SLV_EN | 1);
+
+  writeReg(REG_I2C_SLV4_CTRL, dly << _I2C_MST_DLY_SHIFT);
+  writeReg(REG_I2C_MST_DELAY_CTRL,
+           DELAY_ES_SHADOW | I2C_SLV0_DLY_EN | I2C_SLV1_DLY_EN);
+
+  // hold data ready until the external sensor data is in
+  writeReg(REG_I2C_MST_CTRL, WAIT_FOR_ES | MST_CLK_400);
+  writeReg(REG_USER_CTRL, readReg(REG_USER_CTRL) | I2C_MST_EN);
+
+  m_magFifo = true;
+
+  enableFifo(ACCEL_FIFO_EN | XG_FIFO_EN | YG_FIFO_EN | ZG_FIFO_EN |
+             SLV0_FIFO_EN | (temperature ? TEMP_FIFO_EN : 0),
+             AK8975_MEASUREMENT_SIZE);
+}
+
+void MPU9150::disableFifoMode()
+{
+  disableFifo();
+
+  writeReg(REG_I2C_SLV0_CTRL, 0);
+  writeReg(REG_I2C_SLV1_CTRL, 0);
+  writeReg(REG_USER_CTRL, readReg(REG_USER_CTRL) & ~I2C_MST_EN);
+
+  // let a transfer in progress finish before the host takes over
+  usleep(10000);
+
+  if (!enableI2CBypass(true))
+    throw std::runtime_error(std::string(__FUNCTION__) +
+                             ": Unable to enable I2C bypass");
+
+  m_magFifo = false;
+}
+
+void MPU9150::decodeFifoExt(const uint8_t *data, FIFO_FRAME_T *frame)
+{
+  if (!m_magFifo)
+    return;
+
+  // an invalid measurement leaves the last one in place
+  m_mag->setMeasurement(data);
+  m_mag->getMagnetometer(&frame->magX, &frame->magY, &frame->magZ);
+}
+
 void MPU9150::getMagnetometer(float *x, float *y, float *z)
 {
   float mx, my, mz;
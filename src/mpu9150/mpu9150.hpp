@@ -104,10 +104,39 @@ namespace upm {
      */
     std::vector<float> getMagnetometer();
 
+    /**
+     * Stream accelerometer, gyroscope and magnetometer samples
+     * through the FIFO.  The MPU's auxiliary I2C master takes the
+     * magnetometer over from the host: every few samples it reads the
+     * last AK8975 measurement into the external sensor data registers
+     * and starts the next one, so each FIFO frame carries all nine
+     * axes, sampled together, and readFifo() returns them without any
+     * separate magnetometer transfers.  update() reads the
+     * magnetometer from the external sensor data registers as well.
+     *
+     * init() must have been called with the AK8975 enabled.
+     *
+     * @param magRate Magnetometer sample rate in Hz, at most 100, as an
+     * AK8975 measurement takes up to 9ms.  The rate is rounded to
+     * the sample rate divided by 1 to 32; frames in between repeat
+     * the last magnetometer value.
+     * @param temperature True to include the temperature in the
+     * frames
+     */
+    void enableFifoMode(float magRate=100, bool temperature=false);
+
+    /**
+     * Stop the FIFO and give the magnetometer back to the host, as
+     * after init().
+     */
+    void disableFifoMode();
+
   protected:
     // magnetometer instance
     AK8975* m_mag;
 
+    void decodeFifoExt(const uint8_t *data, FIFO_FRAME_T *frame);
+
 
   private:
       /* Disable implicit copy and assignment operators */
@@ -117,6 +146,8 @@ namespace upm {
     int m_i2cBus;
     uint8_t m_magAddress;
     bool m_enableAk8975;
+    // magnetometer sampled by the auxiliary I2C master
+    bool m_magFifo;
   };
 
 }
@@ -0,0 +1,216 @@
+/* Promise returning async method variants for Node.js
+ *
+ * Methods that block for a conversion or a transmission (an update() in
+ * forced mode, a 1-wire temperature conversion, a radio send) stall the
+ * whole event loop when called from Javascript.  UPM_NODE_ASYNC adds a
+ * METHODAsync() variant that runs the method on the libuv threadpool and
+ * returns a Promise:
+ *
+ *     sensor.updateAsync().then(function() {
+ *         console.log(sensor.getTemperature());
+ *     });
+ *
+ * Calls on the same device are serialized: an async call only starts once
+ * the previous one on that device has finished, so a gateway can poll many
+ * devices in parallel without two threads ever touching one device.  Do not
+ * call the synchronous methods of a device while it has async calls
+ * pending.  The device object is kept alive until its calls have completed.
+ *
+ * Exceptions thrown by the method reject the Promise with an Error.  The
+ * result is passed back as is, as a number (UPM_NODE_ASYNC_NUMBER) or
+ * undefined (UPM_NODE_ASYNC).
+ *
+ * Methods with arguments can be wrapped by hand with an %extend returning
+ * an upm_node_async_t, see sx1276.i.
+ *
+ * Promises need V8 5.1 (Node.js 6) or newer, the macros expand to nothing
+ * for older versions.  This is decided by SWIG, so it tests V8_VERSION from
+ * the SWIG command line; SWIG_V8_VERSION only exists for the C++ compiler.
+ */
+
+#if (SWIG_JAVASCRIPT_V8) && (V8_VERSION >= 0x050100)
+%{
+#include <deque>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <uv.h>
+
+/* A blocking call, with the kind of value it resolves to */
+typedef enum {
+    UPM_NODE_ASYNC_UNDEFINED = 0,
+    UPM_NODE_ASYNC_NUMBER
+} upm_node_async_kind_t;
+
+struct upm_node_async_t {
+    upm_node_async_t() : device(0), kind(UPM_NODE_ASYNC_UNDEFINED) {}
+    upm_node_async_t(void *dev, std::function<double()> fn,
+                     upm_node_async_kind_t k)
+        : device(dev), work(fn), kind(k) {}
+
+    void *device;
+    std::function<double()> work;
+    upm_node_async_kind_t kind;
+};
+
+struct _upm_node_async_job {
+    uv_work_t req;
+    upm_node_async_t call;
+    double value;
+    bool failed;
+    std::string error;
+    v8::Isolate *isolate;
+    v8::Persistent<v8::Context> context;
+    v8::Persistent<v8::Promise::Resolver> resolver;
+    /* keeps the device object from being collected while in use */
+    v8::Persistent<v8::Object> owner;
+};
+
+/* Jobs queued per device, the front one is running.  Only touched from
+ * the event loop thread. */
+static std::map<void *, std::deque<_upm_node_async_job *> > _upm_node_async_queues;
+
+static void _upm_node_async_work(uv_work_t *req)
+{
+    _upm_node_async_job *job = static_cast<_upm_node_async_job *>(req->data);
+
+    try {
+        job->value = job->call.work();
+    } catch (std::exception &e) {
+        job->failed = true;
+        job->error = e.what();
+    } catch (...) {
+        job->failed = true;
+        job->error = "Unknown exception";
+    }
+}
+
+static void _upm_node_async_done(uv_work_t *req, int status);
+
+static void _upm_node_async_start(_upm_node_async_job *job)
+{
+    job->req.data = job;
+    uv_queue_work(uv_default_loop(), &job->req, _upm_node_async_work,
+                  _upm_node_async_done);
+}
+
+static void _upm_node_async_done(uv_work_t *req, int status)
+{
+    _upm_node_async_job *job = static_cast<_upm_node_async_job *>(req->data);
+
+    /* start the next call on this device first, so it overlaps with
+     * the Javascript continuations of this one */
+    std::deque<_upm_node_async_job *> &queue =
+        _upm_node_async_queues[job->call.device];
+    queue.pop_front();
+    if (queue.empty())
+        _upm_node_async_queues.erase(job->call.device);
+    else
+        _upm_node_async_start(queue.front());
+
+    v8::Isolate *isolate = job->isolate;
+    {
+        v8::HandleScope scope(isolate);
+        v8::Local<v8::Context> context =
+            v8::Local<v8::Context>::New(isolate, job->context);
+        v8::Context::Scope contextScope(context);
+        v8::Local<v8::Promise::Resolver> resolver =
+            v8::Local<v8::Promise::Resolver>::New(isolate, job->resolver);
+
+        if (status != 0) {
+            job->failed = true;
+            job->error = uv_strerror(status);
+        }
+
+        if (job->failed) {
+            v8::Local<v8::String> msg =
+                v8::String::NewFromUtf8(isolate, job->error.c_str(),
+                                        v8::NewStringType::kNormal)
+                    .ToLocalChecked();
+            (void) resolver->Reject(context, v8::Exception::Error(msg))
+                .IsJust();
+        } else if (job->call.kind == UPM_NODE_ASYNC_NUMBER) {
+            (void) resolver->Resolve(context,
+                                     v8::Number::New(isolate, job->value))
+                .IsJust();
+        } else {
+            (void) resolver->Resolve(context, v8::Undefined(isolate))
+                .IsJust();
+        }
+
+        job->resolver.Reset();
+        job->owner.Reset();
+        job->context.Reset();
+    }
+    delete job;
+
+    /* we are not called from Javascript, so nothing else will run the
+     * promise reactions */
+    v8::MicrotasksScope::PerformCheckpoint(isolate);
+}
+
+static v8::Local<v8::Value>
+_upm_node_async_submit(const SwigV8Arguments &args,
+                       const upm_node_async_t &call)
+{
+    v8::Isolate *isolate = args.GetIsolate();
+    v8::Local<v8::Context> context = isolate->GetCurrentContext();
+    v8::Local<v8::Promise::Resolver> resolver =
+        v8::Promise::Resolver::New(context).ToLocalChecked();
+
+    _upm_node_async_job *job = new _upm_node_async_job;
+    job->call = call;
+    job->value = 0;
+    job->failed = false;
+    job->isolate = isolate;
+    job->context.Reset(isolate, context);
+    job->resolver.Reset(isolate, resolver);
+    job->owner.Reset(isolate, args.This());
+
+    std::deque<_upm_node_async_job *> &queue =
+        _upm_node_async_queues[call.device];
+    queue.push_back(job);
+    if (queue.size() == 1)
+        _upm_node_async_start(job);
+
+    return resolver->GetPromise();
+}
+%}
+
+%typemap(out) upm_node_async_t {
+    $result = _upm_node_async_submit(args, $1);
+}
+
+/* METHODAsync() for a void METHOD(), resolving to undefined */
+%define UPM_NODE_ASYNC(CLASS, METHOD)
+%extend CLASS {
+    upm_node_async_t METHOD ## Async() {
+        CLASS *dev = $self;
+        return upm_node_async_t(dev, [dev]() { dev->METHOD(); return 0.0; },
+                                UPM_NODE_ASYNC_UNDEFINED);
+    }
+}
+%enddef
+
+/* METHODAsync() for a METHOD() returning a number, bool or enum,
+ * resolving to that value */
+%define UPM_NODE_ASYNC_NUMBER(CLASS, METHOD)
+%extend CLASS {
+    upm_node_async_t METHOD ## Async() {
+        CLASS *dev = $self;
+        return upm_node_async_t(dev, [dev]() { return (double) dev->METHOD(); },
+                                UPM_NODE_ASYNC_NUMBER);
+    }
+}
+%enddef
+
+#else
+
+%define UPM_NODE_ASYNC(CLASS, METHOD)
+%enddef
+
+%define UPM_NODE_ASYNC_NUMBER(CLASS, METHOD)
+%enddef
+
+#endif
@@ -11,22 +11,147 @@
  */
 
 #include <iostream>
-#include <unistd.h>
 #include <string>
 #include <stdexcept>
 #include <stdlib.h>
+#include <chrono>
 
 #include "nrf24l01.hpp"
 
 using namespace upm;
 
+namespace {
+    /* Longest possible transmission: 15 retransmits with 4 ms delays */
+    const int txTimeoutMs = 100;
+
+    /* Bit reversal of a byte */
+    const uint8_t swapTable[256] = {
+        0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0,
+        0x30, 0xB0, 0x70, 0xF0, 0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8,
+        0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8, 0x04, 0x84, 0x44, 0xC4,
+        0x24, 0xA4, 0x64, 0xE4, 0x14, 0x94, 0x54, 0xD4, 0x34, 0xB4, 0x74, 0xF4,
+        0x0C, 0x8C, 0x4C, 0xCC, 0x2C, 0xAC, 0x6C, 0xEC, 0x1C, 0x9C, 0x5C, 0xDC,
+        0x3C, 0xBC, 0x7C, 0xFC, 0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2,
+        0x12, 0x92, 0x52, 0xD2, 0x32, 0xB2, 0x72, 0xF2, 0x0A, 0x8A, 0x4A, 0xCA,
+        0x2A, 0xAA, 0x6A, 0xEA, 0x1A, 0x9A, 0x5A, 0xDA, 0x3A, 0xBA, 0x7A, 0xFA,
+        0x06, 0x86, 0x46, 0xC6, 0x26, 0xA6, 0x66, 0xE6, 0x16, 0x96, 0x56, 0xD6,
+        0x36, 0xB6, 0x76, 0xF6, 0x0E, 0x8E, 0x4E, 0xCE, 0x2E, 0xAE, 0x6E, 0xEE,
+        0x1E, 0x9E, 0x5E, 0xDE, 0x3E, 0xBE, 0x7E, 0xFE, 0x01, 0x81, 0x41, 0xC1,
+        0x21, 0xA1, 0x61, 0xE1, 0x11, 0x91, 0x51, 0xD1, 0x31, 0xB1, 0x71, 0xF1,
+        0x09, 0x89, 0x49, 0xC9, 0x29, 0xA9, 0x69, 0xE9, 0x19, 0x99, 0x59, 0xD9,
+        0x39, 0xB9, 0x79, 0xF9, 0x05, 0x85, 0x45, 0xC5, 0x25, 0xA5, 0x65, 0xE5,
+        0x15, 0x95, 0x55, 0xD5, 0x35, 0xB5, 0x75, 0xF5, 0x0D, 0x8D, 0x4D, 0xCD,
+        0x2D, 0xAD, 0x6D, 0xED, 0x1D, 0x9D, 0x5D, 0xDD, 0x3D, 0xBD, 0x7D, 0xFD,
+        0x03, 0x83, 0x43, 0xC3, 0x23, 0xA3, 0x63, 0xE3, 0x13, 0x93, 0x53, 0xD3,
+        0x33, 0xB3, 0x73, 0xF3, 0x0B, 0x8B, 0x4B, 0xCB, 0x2B, 0xAB, 0x6B, 0xEB,
+        0x1B, 0x9B, 0x5B, 0xDB, 0x3B, 0xBB, 0x7B, 0xFB, 0x07, 0x87, 0x47, 0xC7,
+        0x27, 0xA7, 0x67, 0xE7, 0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7,
+        0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF,
+        0x3F, 0xBF, 0x7F, 0xFF
+    };
+
+    /* BLE CRC24 (polynomial 0x00065B), one byte at a time, MSB first */
+    const uint32_t crcTable[256] = {
+        0x000000, 0x00065B, 0x000CB6, 0x000AED, 0x00196C, 0x001F37, 0x0015DA, 0x001381,
+        0x0032D8, 0x003483, 0x003E6E, 0x003835, 0x002BB4, 0x002DEF, 0x002702, 0x002159,
+        0x0065B0, 0x0063EB, 0x006906, 0x006F5D, 0x007CDC, 0x007A87, 0x00706A, 0x007631,
+        0x005768, 0x005133, 0x005BDE, 0x005D85, 0x004E04, 0x00485F, 0x0042B2, 0x0044E9,
+        0x00CB60, 0x00CD3B, 0x00C7D6, 0x00C18D, 0x00D20C, 0x00D457, 0x00DEBA, 0x00D8E1,
+        0x00F9B8, 0x00FFE3, 0x00F50E, 0x00F355, 0x00E0D4, 0x00E68F, 0x00EC62, 0x00EA39,
+        0x00AED0, 0x00A88B, 0x00A266, 0x00A43D, 0x00B7BC, 0x00B1E7, 0x00BB0A, 0x00BD51,
+        0x009C08, 0x009A53, 0x0090BE, 0x0096E5, 0x008564, 0x00833F, 0x0089D2, 0x008F89,
+        0x0196C0, 0x01909B, 0x019A76, 0x019C2D, 0x018FAC, 0x0189F7, 0x01831A, 0x018541,
+        0x01A418, 0x01A243, 0x01A8AE, 0x01AEF5, 0x01BD74, 0x01BB2F, 0x01B1C2, 0x01B799,
+        0x01F370, 0x01F52B, 0x01FFC6, 0x01F99D, 0x01EA1C, 0x01EC47, 0x01E6AA, 0x01E0F1,
+        0x01C1A8, 0x01C7F3, 0x01CD1E, 0x01CB45, 0x01D8C4, 0x01DE9F, 0x01D472, 0x01D229,
+        0x015DA0, 0x015BFB, 0x015116, 0x01574D, 0x0144CC, 0x014297, 0x01487A, 0x014E21,
+        0x016F78, 0x016923, 0x0163CE, 0x016595, 0x017614, 0x01704F, 0x017AA2, 0x017CF9,
+        0x013810, 0x013E4B, 0x0134A6, 0x0132FD, 0x01217C, 0x012727, 0x012DCA, 0x012B91,
+        0x010AC8, 0x010C93, 0x01067E, 0x010025, 0x0113A4, 0x0115FF, 0x011F12, 0x011949,
+        0x032D80, 0x032BDB, 0x032136, 0x03276D, 0x0334EC, 0x0332B7, 0x03385A, 0x033E01,
+        0x031F58, 0x031903, 0x0313EE, 0x0315B5, 0x030634, 0x03006F, 0x030A82, 0x030CD9,
+        0x034830, 0x034E6B, 0x034486, 0x0342DD, 0x03515C, 0x035707, 0x035DEA, 0x035BB1,
+        0x037AE8, 0x037CB3, 0x03765E, 0x037005, 0x036384, 0x0365DF, 0x036F32, 0x036969,
+        0x03E6E0, 0x03E0BB, 0x03EA56, 0x03EC0D, 0x03FF8C, 0x03F9D7, 0x03F33A, 0x03F561,
+        0x03D438, 0x03D263, 0x03D88E, 0x03DED5, 0x03CD54, 0x03CB0F, 0x03C1E2, 0x03C7B9,
+        0x038350, 0x03850B, 0x038FE6, 0x0389BD, 0x039A3C, 0x039C67, 0x03968A, 0x0390D1,
+        0x03B188, 0x03B7D3, 0x03BD3E, 0x03BB65, 0x03A8E4, 0x03AEBF, 0x03A452, 0x03A209,
+        0x02BB40, 0x02BD1B, 0x02B7F6, 0x02B1AD, 0x02A22C, 0x02A477, 0x02AE9A, 0x02A8C1,
+        0x028998, 0x028FC3, 0x02852E, 0x028375, 0x0290F4, 0x0296AF, 0x029C42, 0x029A19,
+        0x02DEF0, 0x02D8AB, 0x02D246, 0x02D41D, 0x02C79C, 0x02C1C7, 0x02CB2A, 0x02CD71,
+        0x02EC28, 0x02EA73, 0x02E09E, 0x02E6C5, 0x02F544, 0x02F31F, 0x02F9F2, 0x02FFA9,
+        0x027020, 0x02767B, 0x027C96, 0x027ACD, 0x02694C, 0x026F17, 0x0265FA, 0x0263A1,
+        0x0242F8, 0x0244A3, 0x024E4E, 0x024815, 0x025B94, 0x025DCF, 0x025722, 0x025179,
+        0x021590, 0x0213CB, 0x021926, 0x021F7D, 0x020CFC, 0x020AA7, 0x02004A, 0x020611,
+        0x022748, 0x022113, 0x022BFE, 0x022DA5, 0x023E24, 0x02387F, 0x023292, 0x0234C9
+    };
+
+    /* BLE whitening LFSR, indexed by its state: the mask to XOR a data
+     * byte with (LSB first), and the state after 8 shifts */
+    const uint8_t whitenMask[256] = {
+        0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x90, 0x10, 0xD0, 0x50,
+        0xB0, 0x30, 0xF0, 0x70, 0x48, 0xC8, 0x08, 0x88, 0x68, 0xE8, 0x28, 0xA8,
+        0xD8, 0x58, 0x98, 0x18, 0xF8, 0x78, 0xB8, 0x38, 0x24, 0xA4, 0x64, 0xE4,
+        0x04, 0x84, 0x44, 0xC4, 0xB4, 0x34, 0xF4, 0x74, 0x94, 0x14, 0xD4, 0x54,
+        0x6C, 0xEC, 0x2C, 0xAC, 0x4C, 0xCC, 0x0C, 0x8C, 0xFC, 0x7C, 0xBC, 0x3C,
+        0xDC, 0x5C, 0x9C, 0x1C, 0x92, 0x12, 0xD2, 0x52, 0xB2, 0x32, 0xF2, 0x72,
+        0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2, 0xDA, 0x5A, 0x9A, 0x1A,
+        0xFA, 0x7A, 0xBA, 0x3A, 0x4A, 0xCA, 0x0A, 0x8A, 0x6A, 0xEA, 0x2A, 0xAA,
+        0xB6, 0x36, 0xF6, 0x76, 0x96, 0x16, 0xD6, 0x56, 0x26, 0xA6, 0x66, 0xE6,
+        0x06, 0x86, 0x46, 0xC6, 0xFE, 0x7E, 0xBE, 0x3E, 0xDE, 0x5E, 0x9E, 0x1E,
+        0x6E, 0xEE, 0x2E, 0xAE, 0x4E, 0xCE, 0x0E, 0x8E, 0xC9, 0x49, 0x89, 0x09,
+        0xE9, 0x69, 0xA9, 0x29, 0x59, 0xD9, 0x19, 0x99, 0x79, 0xF9, 0x39, 0xB9,
+        0x81, 0x01, 0xC1, 0x41, 0xA1, 0x21, 0xE1, 0x61, 0x11, 0x91, 0x51, 0xD1,
+        0x31, 0xB1, 0x71, 0xF1, 0xED, 0x6D, 0xAD, 0x2D, 0xCD, 0x4D, 0x8D, 0x0D,
+        0x7D, 0xFD, 0x3D, 0xBD, 0x5D, 0xDD, 0x1D, 0x9D, 0xA5, 0x25, 0xE5, 0x65,
+        0x85, 0x05, 0xC5, 0x45, 0x35, 0xB5, 0x75, 0xF5, 0x15, 0x95, 0x55, 0xD5,
+        0x5B, 0xDB, 0x1B, 0x9B, 0x7B, 0xFB, 0x3B, 0xBB, 0xCB, 0x4B, 0x8B, 0x0B,
+        0xEB, 0x6B, 0xAB, 0x2B, 0x13, 0x93, 0x53, 0xD3, 0x33, 0xB3, 0x73, 0xF3,
+        0x83, 0x03, 0xC3, 0x43, 0xA3, 0x23, 0xE3, 0x63, 0x7F, 0xFF, 0x3F, 0xBF,
+        0x5F, 0xDF, 0x1F, 0x9F, 0xEF, 0x6F, 0xAF, 0x2F, 0xCF, 0x4F, 0x8F, 0x0F,
+        0x37, 0xB7, 0x77, 0xF7, 0x17, 0x97, 0x57, 0xD7, 0xA7, 0x27, 0xE7, 0x67,
+        0x87, 0x07, 0xC7, 0x47
+    };
+
+    const uint8_t whitenNext[256] = {
+        0x00, 0x22, 0x44, 0x66, 0x88, 0xAA, 0xCC, 0xEE, 0x32, 0x10, 0x76, 0x54,
+        0xBA, 0x98, 0xFE, 0xDC, 0x64, 0x46, 0x20, 0x02, 0xEC, 0xCE, 0xA8, 0x8A,
+        0x56, 0x74, 0x12, 0x30, 0xDE, 0xFC, 0x9A, 0xB8, 0xC8, 0xEA, 0x8C, 0xAE,
+        0x40, 0x62, 0x04, 0x26, 0xFA, 0xD8, 0xBE, 0x9C, 0x72, 0x50, 0x36, 0x14,
+        0xAC, 0x8E, 0xE8, 0xCA, 0x24, 0x06, 0x60, 0x42, 0x9E, 0xBC, 0xDA, 0xF8,
+        0x16, 0x34, 0x52, 0x70, 0xB2, 0x90, 0xF6, 0xD4, 0x3A, 0x18, 0x7E, 0x5C,
+        0x80, 0xA2, 0xC4, 0xE6, 0x08, 0x2A, 0x4C, 0x6E, 0xD6, 0xF4, 0x92, 0xB0,
+        0x5E, 0x7C, 0x1A, 0x38, 0xE4, 0xC6, 0xA0, 0x82, 0x6C, 0x4E, 0x28, 0x0A,
+        0x7A, 0x58, 0x3E, 0x1C, 0xF2, 0xD0, 0xB6, 0x94, 0x48, 0x6A, 0x0C, 0x2E,
+        0xC0, 0xE2, 0x84, 0xA6, 0x1E, 0x3C, 0x5A, 0x78, 0x96, 0xB4, 0xD2, 0xF0,
+        0x2C, 0x0E, 0x68, 0x4A, 0xA4, 0x86, 0xE0, 0xC2, 0x46, 0x64, 0x02, 0x20,
+        0xCE, 0xEC, 0x8A, 0xA8, 0x74, 0x56, 0x30, 0x12, 0xFC, 0xDE, 0xB8, 0x9A,
+        0x22, 0x00, 0x66, 0x44, 0xAA, 0x88, 0xEE, 0xCC, 0x10, 0x32, 0x54, 0x76,
+        0x98, 0xBA, 0xDC, 0xFE, 0x8E, 0xAC, 0xCA, 0xE8, 0x06, 0x24, 0x42, 0x60,
+        0xBC, 0x9E, 0xF8, 0xDA, 0x34, 0x16, 0x70, 0x52, 0xEA, 0xC8, 0xAE, 0x8C,
+        0x62, 0x40, 0x26, 0x04, 0xD8, 0xFA, 0x9C, 0xBE, 0x50, 0x72, 0x14, 0x36,
+        0xF4, 0xD6, 0xB0, 0x92, 0x7C, 0x5E, 0x38, 0x1A, 0xC6, 0xE4, 0x82, 0xA0,
+        0x4E, 0x6C, 0x0A, 0x28, 0x90, 0xB2, 0xD4, 0xF6, 0x18, 0x3A, 0x5C, 0x7E,
+        0xA2, 0x80, 0xE6, 0xC4, 0x2A, 0x08, 0x6E, 0x4C, 0x3C, 0x1E, 0x78, 0x5A,
+        0xB4, 0x96, 0xF0, 0xD2, 0x0E, 0x2C, 0x4A, 0x68, 0x86, 0xA4, 0xC2, 0xE0,
+        0x58, 0x7A, 0x1C, 0x3E, 0xD0, 0xF2, 0x94, 0xB6, 0x6A, 0x48, 0x2E, 0x0C,
+        0xE2, 0xC0, 0xA6, 0x84
+    };
+}
+
 
 NRF24L01::NRF24L01 (int cs, int ce)
-    : m_callback_obj(NULL), m_spi(0), m_csnPinCtx(cs), m_cePinCtx(ce)
+    : m_callback_obj(NULL), m_spi(0), m_csnPinCtx(cs), m_cePinCtx(ce),
+      m_gpioIrq(NULL), m_irqPending(false)
 {
     init (cs, ce);
 }
 
+NRF24L01::~NRF24L01 ()
+{
+    uninstallISR ();
+}
+
 void
 NRF24L01::init (int chip_select, int chip_enable) {
     mraa::Result error = mraa::SUCCESS;
@@ -83,15 +208,13 @@ NRF24L01::send (uint8_t * value) {
     txPowerUp (); // Set to transmitter mode , Power up
     txFlushBuffer ();
 
-    csOn ();
-    m_spi.writeByte(W_TX_PAYLOAD); // Write cmd to write payload
-    writeBytes (value, NULL, m_payload); // Write payload
-    csOff ();
+    spiTransfer (W_TX_PAYLOAD, value, NULL, m_payload); // Write payload
     ceHigh(); // Start transmission
 
-    while (dataSending ()) { }
-
-    usleep (10000);
+    /* Sleep until TX_DS or MAX_RT, dataSending() then switches back to
+     * receive mode */
+    waitForStatus ((1 << TX_DS) | (1 << MAX_RT), txTimeoutMs);
+    dataSending ();
 }
 
 void
@@ -156,14 +279,21 @@ NRF24L01::dataSending () {
     return false;
 }
 
+bool
+NRF24L01::waitForData (int timeoutMs) {
+    if (dataReady ()) {
+        return true;
+    }
+
+    waitForStatus ((1 << RX_DR), timeoutMs);
+
+    return dataReady ();
+}
+
 void
 NRF24L01::getData (uint8_t * data)  {
-    csOn ();
-    /* Send cmd to read rx payload */
-    m_spi.writeByte(R_RX_PAYLOAD);
-    /* Read payload */
-    writeBytes (data, data, m_payload);
-    csOff ();
+    /* Read rx payload */
+    spiTransfer (R_RX_PAYLOAD, NULL, data, m_payload);
     /* NVI: per product spec, p 67, note c:
      * "The RX_DR IRQ is asserted by a new packet arrival event. The procedure
      * for handling this interrupt should be: 1) read payload through SPI,
@@ -178,7 +308,8 @@ NRF24L01::getData (uint8_t * data)  {
 
 uint8_t
 NRF24L01::getStatus() {
-    return getRegister (STATUS);
+    /* STATUS is shifted out while the command byte is shifted in */
+    return spiTransfer (NOP, NULL, NULL, 0);
 }
 
 bool
@@ -291,6 +422,28 @@ NRF24L01::csOff () {
     return m_csnPinCtx.write(HIGH);
 }
 
+void
+NRF24L01::installISR (int gpio) {
+    // delete any existing ISR and GPIO context
+    uninstallISR ();
+
+    m_gpioIrq = new mraa::Gpio(gpio);
+
+    m_gpioIrq->dir(mraa::DIR_IN);
+    /* IRQ is active low, and stays low until the STATUS flags are cleared */
+    m_gpioIrq->isr(mraa::EDGE_FALLING, &NRF24L01::irqHandler, this);
+}
+
+void
+NRF24L01::uninstallISR () {
+    if (m_gpioIrq) {
+        m_gpioIrq->isrExit();
+        delete m_gpioIrq;
+
+        m_gpioIrq = NULL;
+    }
+}
+
 void
 NRF24L01::pollListener() {
     if (dataReady()) {
@@ -363,14 +516,11 @@ NRF24L01::sendBeaconingMsg (uint8_t * msg) {
         sendCommand (FLUSH_TX); // Clear RX Fifo
         sendCommand (FLUSH_RX); // Clear TX Fifo
 
-        csOn ();
-        m_spi.writeByte(W_TX_PAYLOAD);        // Write cmd to write payload
-        writeBytes (m_bleBuffer, NULL, 32);     // Write payload
-        csOff ();
+        spiTransfer (W_TX_PAYLOAD, m_bleBuffer, NULL, 32); // Write payload
 
         setRegister (CONFIG, 0x12);             // tx on
         ceHigh ();                              // Start transmission
-        usleep (10000);
+        waitForStatus ((1 << TX_DS), 10);       // Sent, or give up after 10ms
         ceLow ();
     }
 }
@@ -381,96 +531,119 @@ NRF24L01::sendBeaconingMsg (uint8_t * msg) {
  * ---------------
  */
 
-void
-NRF24L01::writeBytes (uint8_t * dataout, uint8_t * datain, uint8_t len) {
+uint8_t
+NRF24L01::spiTransfer (uint8_t cmd, const uint8_t * dataout, uint8_t * datain, uint8_t len) {
+    uint8_t txBuf[MAX_BUFFER + 1];
+    uint8_t rxBuf[MAX_BUFFER + 1];
+
     if(len > MAX_BUFFER){
         len = MAX_BUFFER;
     }
-    for (uint8_t i = 0; i < len; i++) {
-        if (datain != NULL) {
-            datain[i] = m_spi.writeByte(dataout[i]);
-        } else {
-            m_spi.writeByte(dataout[i]);
-        }
+
+    txBuf[0] = cmd;
+    if (dataout != NULL) {
+        memcpy (&txBuf[1], dataout, len);
+    } else {
+        memset (&txBuf[1], NOP, len);
+    }
+
+    csOn ();
+    mraa::Result rv = m_spi.transfer(txBuf, rxBuf, len + 1);
+    csOff ();
+
+    if (rv != mraa::SUCCESS) {
+        throw std::runtime_error(std::string(__FUNCTION__) +
+                                 ": Spi.transfer() failed");
     }
+
+    if (datain != NULL) {
+        memcpy (datain, &rxBuf[1], len);
+    }
+
+    return rxBuf[0];
 }
 
 void
 NRF24L01::setRegister (uint8_t reg, uint8_t value) {
-    csOn ();
-    m_spi.writeByte(W_REGISTER | (REGISTER_MASK & reg));
-    m_spi.writeByte(value);
-    csOff ();
+    spiTransfer (W_REGISTER | (REGISTER_MASK & reg), &value, NULL, 1);
 }
 
 uint8_t
 NRF24L01::getRegister (uint8_t reg) {
     uint8_t data = 0;
 
-    csOn ();
-    m_spi.writeByte(R_REGISTER | (REGISTER_MASK & reg));
-    data = m_spi.writeByte(data);
-    csOff ();
+    spiTransfer (R_REGISTER | (REGISTER_MASK & reg), NULL, &data, 1);
 
     return data;
 }
 
 void
 NRF24L01::readRegister (uint8_t reg, uint8_t * value, uint8_t len) {
-    csOn ();
-    m_spi.writeByte(R_REGISTER | (REGISTER_MASK & reg));
-    writeBytes (value, value, len);
-    csOff ();
+    spiTransfer (R_REGISTER | (REGISTER_MASK & reg), NULL, value, len);
 }
 
 void
 NRF24L01::writeRegister (uint8_t reg, uint8_t * value, uint8_t len) {
-    csOn ();
-    m_spi.writeByte(W_REGISTER | (REGISTER_MASK & reg));
-    writeBytes (value, NULL, len);
-    csOff ();
+    spiTransfer (W_REGISTER | (REGISTER_MASK & reg), value, NULL, len);
 }
 
 void
 NRF24L01::sendCommand (uint8_t cmd) {
-    csOn ();
-    m_spi.writeByte(cmd);
-    csOff ();
+    spiTransfer (cmd, NULL, NULL, 0);
+}
+
+uint8_t
+NRF24L01::waitForStatus (uint8_t mask, int timeoutMs) {
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    uint8_t status;
+
+    while (!((status = getStatus ()) & mask)) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+
+        /* Without an IRQ pin, keep polling STATUS */
+        if (m_gpioIrq) {
+            std::unique_lock<std::mutex> lock(m_irqLock);
+            m_irqCond.wait_until(lock, deadline, [this] { return m_irqPending; });
+            m_irqPending = false;
+        }
+    }
+
+    return status;
+}
+
+void
+NRF24L01::irqHandler (void *ctx) {
+    NRF24L01 *This = (NRF24L01 *) ctx;
+
+    {
+        std::lock_guard<std::mutex> lock(This->m_irqLock);
+        This->m_irqPending = true;
+    }
+    This->m_irqCond.notify_all();
 }
 
 void
 NRF24L01::bleCrc (const uint8_t* data, uint8_t len, uint8_t* dst) {
-    uint8_t v, t, d;
+    /* The BLE CRC is computed LSB first, feed the table bit reversed bytes */
+    uint32_t crc = ((uint32_t) dst[0] << 16) | ((uint32_t) dst[1] << 8) | dst[2];
+
     while(len--) {
-        d = *data++;
-        for(v = 0; v < 8; v++, d >>= 1){
-            t = dst[0] >> 7;
-            dst[0] <<= 1;
-            if(dst[1] & 0x80) dst[0] |= 1;
-            dst[1] <<= 1;
-            if(dst[2] & 0x80) dst[1] |= 1;
-            dst[2] <<= 1;
-
-            if(t != (d & 1)) {
-                dst[2] ^= 0x5B;
-                dst[1] ^= 0x06;
-            }
-        }
+        crc = ((crc << 8) & 0xFFFFFF) ^ crcTable[(crc >> 16) ^ swapTable[*data++]];
     }
+
+    dst[0] = crc >> 16;
+    dst[1] = crc >> 8;
+    dst[2] = crc;
 }
 
 void
 NRF24L01::bleWhiten (uint8_t* data, uint8_t len, uint8_t whitenCoeff) {
-    uint8_t  m;
     while(len--) {
-        for(m = 1; m; m <<= 1) {
-            if(whitenCoeff & 0x80){
-                whitenCoeff ^= 0x11;
-                (*data) ^= m;
-            }
-            whitenCoeff <<= 1;
-        }
-        data++;
+        *data++ ^= whitenMask[whitenCoeff];
+        whitenCoeff = whitenNext[whitenCoeff];
     }
 }
 
@@ -496,16 +669,5 @@ NRF24L01::blePacketEncode(uint8_t* packet, uint8_t len, uint8_t chan) {
 
 uint8_t
 NRF24L01::swapbits(uint8_t a) {
-    uint8_t v = 0;
-
-    if(a & 0x80) v |= 0x01;
-    if(a & 0x40) v |= 0x02;
-    if(a & 0x20) v |= 0x04;
-    if(a & 0x10) v |= 0x08;
-    if(a & 0x08) v |= 0x10;
-    if(a & 0x04) v |= 0x20;
-    if(a & 0x02) v |= 0x40;
-    if(a & 0x01) v |= 0x80;
-
-    return v;
+    return swapTable[a];
 }
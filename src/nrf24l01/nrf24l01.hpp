@@ -19,6 +19,8 @@
 
 #include <mraa/spi.hpp>
 #include <cstring>
+#include <mutex>
+#include <condition_variable>
 
 #include "Callback.hpp"
 
@@ -175,6 +177,11 @@ class NRF24L01 {
          */
         NRF24L01 (int cs, int ce);
 
+        /**
+         * NRF24L01 destructor
+         */
+        ~NRF24L01 ();
+
         /**
          * Returns the name of the component
          */
@@ -197,7 +204,9 @@ class NRF24L01 {
         void    configure ();
 
         /**
-         * Sends the buffer data
+         * Sends the buffer data, and waits until it has been sent (or
+         * the retransmits have run out). With an IRQ pin installed the
+         * wait sleeps, otherwise STATUS is polled.
          *
          * @param value Pointer to the buffer
          */
@@ -250,6 +259,15 @@ class NRF24L01 {
          */
         bool    dataReady ();
 
+        /**
+         * Waits for data to arrive. With an IRQ pin installed the wait
+         * sleeps until the RX_DR interrupt, otherwise STATUS is polled.
+         *
+         * @param timeoutMs Maximum time to wait, in milliseconds
+         * @return True if data is ready to be read
+         */
+        bool    waitForData (int timeoutMs);
+
         /**
          * Checks if the transceiver is in the sending mode
          */
@@ -309,6 +327,21 @@ class NRF24L01 {
          */
         void    pollListener ();
 
+        /**
+         * Installs an interrupt service routine on the IRQ pin of the
+         * transceiver. send(), sendBeaconingMsg() and waitForData() then
+         * sleep until the TX_DS, MAX_RT or RX_DR interrupt instead of
+         * polling.
+         *
+         * @param gpio GPIO pin connected to the IRQ pin
+         */
+        void    installISR (int gpio);
+
+        /**
+         * Uninstalls the IRQ interrupt service routine
+         */
+        void    uninstallISR ();
+
         /**
          * Sets the chip enable pin to HIGH
          */
@@ -355,9 +388,12 @@ class NRF24L01 {
         funcPtrVoidVoid dataReceivedHandler;
 
         /**
-         * Writes bytes to an SPI device
+         * Sends a command followed by len bytes in a single SPI transfer,
+         * and returns the STATUS register shifted out with the command.
+         * dataout may be NULL to send NOPs, datain NULL to discard the
+         * received bytes
          */
-        void    writeBytes (uint8_t * dataout, uint8_t * datain, uint8_t len);
+        uint8_t spiTransfer (uint8_t cmd, const uint8_t * dataout, uint8_t * datain, uint8_t len);
         /**
          * Sets the register value on an SPI device [one byte]
          */
@@ -378,6 +414,12 @@ class NRF24L01 {
          * Sends a command to NRF24L01
          */
         void    sendCommand (uint8_t cmd);
+        /**
+         * Waits until any of the STATUS bits in mask is set, or timeout
+         */
+        uint8_t waitForStatus (uint8_t mask, int timeoutMs);
+
+        static void irqHandler (void *ctx);
 
         void bleCrc (const uint8_t* data, uint8_t len, uint8_t* dst);
 
@@ -397,6 +439,11 @@ class NRF24L01 {
 
         mraa::Gpio              m_csnPinCtx;
         mraa::Gpio              m_cePinCtx;
+        mraa::Gpio              *m_gpioIrq;
+
+        std::mutex              m_irqLock;
+        std::condition_variable m_irqCond;
+        bool                    m_irqPending;
 
         std::string             m_name;
 };
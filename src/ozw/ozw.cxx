@@ -14,6 +14,9 @@
 #include <stdexcept>
 #include <string>
 #include <pthread.h>
+#include <string.h>
+#include <memory>
+#include <thread>
 
 #include "platform/Log.h"
 
@@ -28,12 +31,102 @@ using namespace OpenZWave;
 // our singleton instance
 OZW* OZW::m_instance = 0;
 
+namespace upm {
+  // The last known value of a bool, byte, float, int32 or int16
+  // value.  The value is stored in bits (memcpy'd from its type) so
+  // it can be read and written atomically.
+  struct OZW::ValueSnapshot {
+    ValueSnapshot(ValueID const &v) : vid(v), valid(false), bits(0) {}
+
+    ValueID vid;
+    int nodeId;
+    int index;
+    int type;
+    bool writeOnly;
+
+    std::atomic<bool> valid;
+    std::atomic<uint64_t> bits;
+  };
+
+  struct OZW::SnapshotTable {
+    // snapshots by nodeId and value index
+    std::map<int, std::vector<ValueSnapshot *> > nodes;
+    // snapshots by ValueID, owning them.  Snapshots of unchanged
+    // values are shared with the next table.
+    std::map<uint64, std::shared_ptr<ValueSnapshot> > ids;
+  };
+}
+
+// read a value from OpenZWave into its snapshot
+static bool updateSnapshot(ValueID const &vid, std::atomic<uint64_t> &bits)
+{
+  uint64_t val = 0;
+  bool ok = false;
+
+  switch (vid.GetType())
+    {
+    case ValueID::ValueType_Bool:
+      {
+        bool v;
+        if ((ok = Manager::Get()->GetValueAsBool(vid, &v)))
+          memcpy(&val, &v, sizeof(v));
+        break;
+      }
+
+    case ValueID::ValueType_Byte:
+      {
+        uint8_t v;
+        if ((ok = Manager::Get()->GetValueAsByte(vid, &v)))
+          memcpy(&val, &v, sizeof(v));
+        break;
+      }
+
+    case ValueID::ValueType_Decimal:
+      {
+        float v;
+        if ((ok = Manager::Get()->GetValueAsFloat(vid, &v)))
+          memcpy(&val, &v, sizeof(v));
+        break;
+      }
+
+    case ValueID::ValueType_Int:
+      {
+        int32_t v;
+        if ((ok = Manager::Get()->GetValueAsInt(vid, &v)))
+          memcpy(&val, &v, sizeof(v));
+        break;
+      }
+
+    case ValueID::ValueType_Short:
+      {
+        int16_t v;
+        if ((ok = Manager::Get()->GetValueAsShort(vid, &v)))
+          memcpy(&val, &v, sizeof(v));
+        break;
+      }
+
+    default:
+      break;
+    }
+
+  if (ok)
+    bits.store(val, std::memory_order_release);
+
+  return ok;
+}
+
 OZW::OZW()
 {
   m_initialized = false;
   m_mgrCreated = false;
   m_driverFailed = false;
   m_homeId = 0;
+  m_nextSubId = 0;
+
+  m_snapshots.store(0);
+  m_snapshotPhase.store(0);
+  m_snapshotReaders[0].store(0);
+  m_snapshotReaders[1].store(0);
 
   pthread_mutexattr_t mutexAttrib;
   pthread_mutexattr_init(&mutexAttrib);
@@ -46,6 +139,14 @@ OZW::OZW()
                                ": pthread_mutex_init(nodeLock) failed");
     }
 
+  // recursive, so handlers can remove themselves
+  if (pthread_mutex_init(&m_subLock, &mutexAttrib))
+    {
+      pthread_mutexattr_destroy(&mutexAttrib);
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": pthread_mutex_init(subLock) failed");
+    }
+
   pthread_mutexattr_destroy(&mutexAttrib);
 
   if (pthread_mutex_init(&m_initLock, NULL))
@@ -84,6 +185,7 @@ OZW::~OZW()
     }
 
   pthread_mutex_destroy(&m_nodeLock);
+  pthread_mutex_destroy(&m_subLock);
   pthread_mutex_destroy(&m_initLock);
   pthread_cond_destroy(&m_initCond);
 
@@ -97,6 +199,8 @@ OZW::~OZW()
     }
   // empty the map
   m_zwNodeMap.clear();
+
+  delete m_snapshots.load();
 }
 
 OZW* OZW::instance()
@@ -196,15 +300,20 @@ bool OZW::init(string devicePath, bool isHID)
       (*it).second->updateVIDMap();
       (*it).second->setAutoUpdate(true);
     }
+  rebuildSnapshots();
+  m_initialized = true;
   unlockNodes();
 
-  m_initialized = true;
   return true;
 }
 
 void OZW::notificationHandler(Notification const* notification, void *ctx)
 {
   upm::OZW *This = (upm::OZW *)ctx;
+  // set if a snapshot was updated, handlers are called after
+  // unlocking
+  int changedNode = -1;
+  int changedIndex = -1;
   
   This->lockNodes();
 
@@ -242,6 +351,9 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
             This->m_zwNodeMap.erase(nodeId);
           }
 
+        if (This->m_initialized)
+          This->rebuildSnapshots();
+
         break;
       }
 
@@ -251,6 +363,9 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
           cerr << "### ### VALUE ADDED " << endl;
         This->m_zwNodeMap[nodeId]->addValueID(notification->GetValueID());
 
+        if (This->m_initialized)
+          This->rebuildSnapshots();
+
         break;
       }
       
@@ -260,12 +375,29 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
           cerr << "### ### VALUE DELETED " << endl;
         This->m_zwNodeMap[nodeId]->removeValueID(notification->GetValueID());
 
+        if (This->m_initialized)
+          This->rebuildSnapshots();
+
         break;
       }
 
     case Notification::Type_ValueChanged:
       {
-        // might be able to do something with this someday...
+        // we are the writer here, no need to register as a reader
+        const SnapshotTable *table = This->m_snapshots.load();
+        if (!table)
+          break;
+
+        auto it = table->ids.find(notification->GetValueID().GetId());
+        if (it == table->ids.end())
+          break;
+
+        ValueSnapshot *snap = (*it).second.get();
+        if (!snap->writeOnly && updateSnapshot(snap->vid, snap->bits))
+          snap->valid.store(true, std::memory_order_release);
+
+        changedNode = snap->nodeId;
+        changedIndex = snap->index;
         break;
       }
 
@@ -283,6 +415,9 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
         // empty the map
         This->m_zwNodeMap.clear();
 
+        if (This->m_initialized)
+          This->rebuildSnapshots();
+
         break;
       }
 
@@ -331,6 +466,253 @@ void OZW::notificationHandler(Notification const* notification, void *ctx)
     }
 
   This->unlockNodes();
+
+  if (changedNode < 0)
+    return;
+
+  pthread_mutex_lock(&This->m_subLock);
+
+  // iterate over a copy, handlers may add or remove handlers
+  std::vector<ValueChangedSub> subs = This->m_valueChangedSubs;
+  bool queued = false;
+  for (auto it = subs.cbegin(); it != subs.cend(); ++it)
+    {
+      if (!subMatches(*it, changedNode, changedIndex))
+        continue;
+
+      if ((*it).handler)
+        {
+          (*it).handler(changedNode, changedIndex, (*it).ctx);
+          continue;
+        }
+
+      // overlapping watches only queue the change once
+      if (queued)
+        continue;
+
+      VALUE_CHANGE_T change;
+      change.nodeId = changedNode;
+      change.index = changedIndex;
+
+      {
+        std::lock_guard<std::mutex> lock(This->m_changeLock);
+        if (This->m_valueChanges.size() >= 64)
+          This->m_valueChanges.pop_front();
+        This->m_valueChanges.push_back(change);
+      }
+      This->m_changeCond.notify_all();
+      queued = true;
+    }
+
+  pthread_mutex_unlock(&This->m_subLock);
+}
+
+void OZW::rebuildSnapshots()
+{
+  const SnapshotTable *old = m_snapshots.load();
+  SnapshotTable *table = new SnapshotTable;
+
+  for (auto it = m_zwNodeMap.cbegin(); it != m_zwNodeMap.cend(); ++it)
+    {
+      const zwNode::valueMap_t &values = (*it).second->valueMap();
+      std::vector<ValueSnapshot *> &snaps = table->nodes[(*it).first];
+
+      snaps.resize(values.size(), 0);
+
+      for (auto vit = values.cbegin(); vit != values.cend(); ++vit)
+        {
+          int index = (*vit).first;
+          ValueID const &vid = (*vit).second;
+          std::shared_ptr<ValueSnapshot> snap;
+
+          // index and vid never change for an existing snapshot, so
+          // keep it if the value kept its index
+          if (old)
+            {
+              auto oit = old->ids.find(vid.GetId());
+              if (oit != old->ids.end() && (*oit).second->index == index)
+                snap = (*oit).second;
+            }
+
+          if (!snap)
+            {
+              snap = std::make_shared<ValueSnapshot>(vid);
+              snap->nodeId = (*it).first;
+              snap->index = index;
+              snap->type = vid.GetType();
+              snap->writeOnly = Manager::Get()->IsValueWriteOnly(vid);
+
+              if (!snap->writeOnly && updateSnapshot(vid, snap->bits))
+                snap->valid.store(true, std::memory_order_release);
+            }
+
+          if (index >= 0 && index < (int)snaps.size())
+            snaps[index] = snap.get();
+          table->ids[vid.GetId()] = snap;
+        }
+    }
+
+  m_snapshots.store(table);
+
+  // the snapshots still in use are shared with the new table, so
+  // this only frees those of removed values
+  if (old)
+    {
+      waitSnapshotReaders();
+      delete old;
+    }
+}
+
+void OZW::waitSnapshotReaders()
+{
+  // Flip the phase and wait for the readers of the previous one,
+  // twice.  A reader that saw the old table registered in one of
+  // the two phases before it loaded it, while new readers always
+  // register in the current phase, so neither wait can starve.
+  for (int i = 0; i < 2; i++)
+    {
+      unsigned int phase = m_snapshotPhase.fetch_xor(1);
+      while (m_snapshotReaders[phase].load() != 0)
+        std::this_thread::yield();
+    }
+}
+
+bool OZW::readSnapshot(int nodeId, int index, int type, void *val, size_t len)
+{
+  // register as a reader, so the table we load is not freed under us
+  unsigned int phase = m_snapshotPhase.load() & 1;
+  m_snapshotReaders[phase].fetch_add(1);
+
+  bool rv = false;
+  const SnapshotTable *table = m_snapshots.load();
+
+  if (table)
+    {
+      auto it = table->nodes.find(nodeId & 0xff);
+      if (it != table->nodes.end() && index >= 0
+          && index < (int)(*it).second.size())
+        {
+          const ValueSnapshot *snap = (*it).second[index];
+
+          // anything else is handled (and reported) by the slow path
+          if (snap && !snap->writeOnly && snap->type == type
+              && snap->valid.load(std::memory_order_acquire))
+            {
+              uint64_t bits = snap->bits.load(std::memory_order_acquire);
+              memcpy(val, &bits, len);
+              rv = true;
+            }
+        }
+    }
+
+  m_snapshotReaders[phase].fetch_sub(1);
+
+  return rv;
+}
+
+int OZW::addValueChangedHandler(int nodeId, int index,
+                                valueChangedHandler_t handler, void *ctx)
+{
+  if (!handler)
+    throw std::invalid_argument(std::string(__FUNCTION__) +
+                                ": handler must not be NULL");
+
+  ValueChangedSub sub;
+  sub.nodeId = (nodeId < 0) ? -1 : (nodeId & 0xff);
+  sub.index = index;
+  sub.handler = handler;
+  sub.ctx = ctx;
+
+  pthread_mutex_lock(&m_subLock);
+  sub.id = m_nextSubId++;
+  m_valueChangedSubs.push_back(sub);
+  pthread_mutex_unlock(&m_subLock);
+
+  return sub.id;
+}
+
+int OZW::watchValueChanges(int nodeId, int index)
+{
+  ValueChangedSub sub;
+  sub.nodeId = (nodeId < 0) ? -1 : (nodeId & 0xff);
+  sub.index = index;
+  sub.handler = 0;
+  sub.ctx = 0;
+
+  pthread_mutex_lock(&m_subLock);
+  sub.id = m_nextSubId++;
+  m_valueChangedSubs.push_back(sub);
+  pthread_mutex_unlock(&m_subLock);
+
+  return sub.id;
+}
+
+OZW::VALUE_CHANGE_T OZW::getValueChange(int timeout)
+{
+  std::unique_lock<std::mutex> lock(m_changeLock);
+  VALUE_CHANGE_T change;
+
+  change.nodeId = -1;
+  change.index = -1;
+
+  auto pending = [this] { return !m_valueChanges.empty(); };
+
+  if (timeout < 0)
+    m_changeCond.wait(lock, pending);
+  else if (!m_changeCond.wait_for(lock, std::chrono::milliseconds(timeout),
+                                  pending))
+    return change;
+
+  change = m_valueChanges.front();
+  m_valueChanges.pop_front();
+
+  return change;
+}
+
+bool OZW::subMatches(const ValueChangedSub &sub, int nodeId, int index)
+{
+  if (sub.nodeId >= 0 && sub.nodeId != nodeId)
+    return false;
+  if (sub.index >= 0 && sub.index != index)
+    return false;
+
+  return true;
+}
+
+void OZW::removeValueChangedHandler(int id)
+{
+  pthread_mutex_lock(&m_subLock);
+
+  for (auto it = m_valueChangedSubs.begin();
+       it != m_valueChangedSubs.end(); ++it)
+    {
+      if ((*it).id == id)
+        {
+          m_valueChangedSubs.erase(it);
+          break;
+        }
+    }
+
+  // drop the queued changes no remaining watch asked for
+  {
+    std::lock_guard<std::mutex> lock(m_changeLock);
+
+    for (auto it = m_valueChanges.begin(); it != m_valueChanges.end(); )
+      {
+        bool watched = false;
+        for (auto sit = m_valueChangedSubs.cbegin();
+             sit != m_valueChangedSubs.cend() && !watched; ++sit)
+          watched = !(*sit).handler
+            && subMatches(*sit, (*it).nodeId, (*it).index);
+
+        if (watched)
+          ++it;
+        else
+          it = m_valueChanges.erase(it);
+      }
+  }
+
+  pthread_mutex_unlock(&m_subLock);
 }
 
 void OZW::dumpNodes(bool all)
@@ -791,6 +1173,11 @@ bool OZW::isValuePolled(int nodeId, int index)
 
 bool OZW::getValueAsBool(int nodeId, int index)
 {
+  // lock-free fast path
+  bool val;
+  if (readSnapshot(nodeId, index, ValueID::ValueType_Bool, &val, sizeof(val)))
+    return val;
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -818,6 +1205,11 @@ bool OZW::getValueAsBool(int nodeId, int index)
 
 uint8_t OZW::getValueAsByte(int nodeId, int index)
 {
+  // lock-free fast path
+  uint8_t val;
+  if (readSnapshot(nodeId, index, ValueID::ValueType_Byte, &val, sizeof(val)))
+    return val;
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -845,6 +1237,11 @@ uint8_t OZW::getValueAsByte(int nodeId, int index)
 
 float OZW::getValueAsFloat(int nodeId, int index)
 {
+  // lock-free fast path
+  float val;
+  if (readSnapshot(nodeId, index, ValueID::ValueType_Decimal, &val, sizeof(val)))
+    return val;
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -872,6 +1269,11 @@ float OZW::getValueAsFloat(int nodeId, int index)
 
 int OZW::getValueAsInt32(int nodeId, int index)
 {
+  // lock-free fast path
+  int32_t val;
+  if (readSnapshot(nodeId, index, ValueID::ValueType_Int, &val, sizeof(val)))
+    return int(val);
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
@@ -899,6 +1301,11 @@ int OZW::getValueAsInt32(int nodeId, int index)
 
 int OZW::getValueAsInt16(int nodeId, int index)
 {
+  // lock-free fast path
+  int16_t val;
+  if (readSnapshot(nodeId, index, ValueID::ValueType_Short, &val, sizeof(val)))
+    return int(val);
+
   if (isValueWriteOnly(nodeId, index))
     {
       cerr << __FUNCTION__ << ": Node " << nodeId << " index " << index
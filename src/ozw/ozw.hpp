@@ -12,6 +12,11 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
 
 #include "Manager.h"
 #include "Notification.h"
@@ -74,6 +79,15 @@ namespace upm {
    * (inherited) by your driver, and your driver should wrap and
    * expose only those methods needed by the user.  Take a look at
    * some of the drivers (like aeotecss6) to see how this works.
+   *
+   * Once the network is initialized, the bool, byte, float, int32
+   * and int16 values of all nodes are kept in a snapshot table that
+   * is updated from OpenZWave's value changed notifications.  The
+   * corresponding getValueAs*() methods read from this table without
+   * taking any locks, so they never wait behind notification
+   * processing.  Use addValueChangedHandler(), or watchValueChanges()
+   * and getValueChange() from the language bindings, to be told about
+   * changes instead of polling.
    */
 
   // forward declaration of private zwNode data
@@ -84,6 +98,19 @@ namespace upm {
 
     typedef std::map<uint8_t, zwNode *> zwNodeMap_t;
 
+    /**
+     * Value changed handler, see addValueChangedHandler()
+     */
+    typedef void (*valueChangedHandler_t)(int nodeId, int index, void *ctx);
+
+    /**
+     * A value change queued by watchValueChanges()
+     */
+    typedef struct {
+      int nodeId;             // -1 on timeout
+      int index;
+    } VALUE_CHANGE_T;
+
     /**
      * Get our singleton instance, initializing it if neccessary.  All
      * requests to this class should be done through this instance
@@ -447,6 +474,59 @@ namespace upm {
      */
     int getValueAsInt16(int nodeId, int index);
 
+    /**
+     * Register a handler to be called when a value changes.  The
+     * handler is called from the OpenZWave notification thread, after
+     * the value snapshot read by the getValueAs*() methods has been
+     * updated.  It must not block for long, as it delays the
+     * processing of further notifications.
+     *
+     * @param nodeId The node ID, or -1 for all nodes
+     * @param index The value index (see dumpNodes()), or -1 for all
+     * values of the node
+     * @param handler The handler to call
+     * @param ctx A pointer passed to the handler
+     * @return An ID to pass to removeValueChangedHandler()
+     */
+    int addValueChangedHandler(int nodeId, int index,
+                               valueChangedHandler_t handler, void *ctx);
+
+    /**
+     * Remove a handler registered with addValueChangedHandler().
+     * When this returns the handler is not being called, and will not
+     * be called again.  For a watch, the queued changes no other
+     * watch matches are dropped.
+     *
+     * @param id The ID returned by addValueChangedHandler() or
+     * watchValueChanges()
+     */
+    void removeValueChangedHandler(int id);
+
+    /**
+     * Queue the changes of a value for getValueChange(), rather than
+     * calling a handler.  Unlike addValueChangedHandler(), this can be
+     * used from the language bindings.  The queue is shared by all
+     * watches, a change matched by several watches is queued once.
+     * It holds up to 64 changes, the oldest changes are dropped on
+     * overflow.
+     *
+     * @param nodeId The node ID, or -1 for all nodes
+     * @param index The value index (see dumpNodes()), or -1 for all
+     * values of the node
+     * @return An ID to pass to removeValueChangedHandler()
+     */
+    int watchValueChanges(int nodeId, int index);
+
+    /**
+     * Remove the oldest change from the queue filled by
+     * watchValueChanges(), waiting for one if the queue is empty.
+     * Read the new value with the getValueAs*() methods.
+     *
+     * @param timeout milliseconds to wait, or -1 to wait forever
+     * @return the change, with nodeId set to -1 on timeout
+     */
+    VALUE_CHANGE_T getValueChange(int timeout=-1);
+
     /**
      * Issue a refresh request for a value on a node.  OpenZWave will
      * query the value and update it's internal state when the device
@@ -590,6 +670,49 @@ namespace upm {
     // for coordinating access to the node list
     pthread_mutex_t m_nodeLock;
 
+    // Snapshot of the typed values, read without taking any locks.
+    // The table (nodeId/index to snapshot) is rebuilt and published
+    // through m_snapshots whenever values are added or removed.
+    // Readers announce themselves in m_snapshotReaders[] for the
+    // current m_snapshotPhase, RCU style, and the writer frees the
+    // table it replaced only after waiting for the readers of both
+    // phases to leave.
+    struct ValueSnapshot;
+    struct SnapshotTable;
+
+    std::atomic<const SnapshotTable *> m_snapshots;
+    std::atomic<unsigned int> m_snapshotPhase;
+    std::atomic<unsigned int> m_snapshotReaders[2];
+
+    // rebuild the snapshot table, with m_nodeLock held
+    void rebuildSnapshots();
+    // wait until no reader can still see a replaced table
+    void waitSnapshotReaders();
+    bool readSnapshot(int nodeId, int index, int type, void *val,
+                      size_t len);
+
+    // value changed handlers
+    struct ValueChangedSub {
+      int id;
+      int nodeId;
+      int index;
+      valueChangedHandler_t handler; // NULL to queue the changes
+      void *ctx;
+    };
+
+    static bool subMatches(const ValueChangedSub &sub, int nodeId,
+                           int index);
+
+    std::vector<ValueChangedSub> m_valueChangedSubs;
+    int m_nextSubId;
+    // held while calling handlers, so removal can wait for them
+    pthread_mutex_t m_subLock;
+
+    // changes queued for getValueChange()
+    std::deque<VALUE_CHANGE_T> m_valueChanges;
+    std::mutex m_changeLock;
+    std::condition_variable m_changeCond;
+
     // We use these to determine init failure or success (if OpenZWave
     // has successfully queried essential data about the network).
     pthread_mutex_t m_initLock;
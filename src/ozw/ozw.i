@@ -13,6 +13,10 @@ JAVA_JNI_LOADLIBRARY(javaupm_ozw)
 /* BEGIN Common SWIG syntax ------------------------------------------------- */
 %pointer_functions(float, floatp);
 
+/* C handlers can't be called from the bindings, use watchValueChanges()
+ * and getValueChange() instead */
+%ignore upm::OZW::addValueChangedHandler;
+
 %{
 #include "ozwinterface.hpp"
 #include "ozw.hpp"
@@ -82,6 +82,16 @@ namespace upm {
      */
     bool indexToValueID(int index, OpenZWave::ValueID *vid);
 
+    /**
+     * Return the map of value indexes to ValueIDs.
+     *
+     * @return The value map
+     */
+    const valueMap_t &valueMap()
+    {
+      return m_values;
+    }
+
     /**
      * Dump various information about the ValueIDs stored in this
      * node.
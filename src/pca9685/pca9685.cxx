@@ -11,16 +11,44 @@
 
 #include <unistd.h>
 #include <math.h>
+#include <string.h>
 #include <iostream>
 #include <string>
 #include <stdexcept>
 
-#include "upm_string_parser.hpp"
+#include "upm_init_program.hpp"
 #include "pca9685.hpp"
 
 using namespace upm;
 using namespace std;
 
+namespace {
+  enum {
+    INIT_MODE_SLEEP,
+    INIT_AUTO_INCREMENT,
+    INIT_LED_FULL_ON,
+    INIT_LED_FULL_OFF,
+    INIT_LED_ON_TIME,
+    INIT_LED_OFF_TIME,
+    INIT_PRESCALE,
+    INIT_PRESCALE_FROM_HZ
+  };
+
+  // init string commands
+  const InitCommand initCommands[] = {
+    { "writeByte",      "ii", INIT_WRITE8,    0 },
+    { "writeWord",      "ii", INIT_WRITE16LE, 0 },
+    { "modeSleep",      "i",  INIT_CALL,      INIT_MODE_SLEEP },
+    { "autoIncrement",  "i",  INIT_CALL,      INIT_AUTO_INCREMENT },
+    { "ledFullOn",      "ii", INIT_CALL,      INIT_LED_FULL_ON },
+    { "ledFullOff",     "ii", INIT_CALL,      INIT_LED_FULL_OFF },
+    { "ledOnTime",      "ii", INIT_CALL,      INIT_LED_ON_TIME },
+    { "ledOffTime",     "ii", INIT_CALL,      INIT_LED_OFF_TIME },
+    { "prescale",       "i",  INIT_CALL,      INIT_PRESCALE },
+    { "prescaleFromHz", "ff", INIT_CALL,      INIT_PRESCALE_FROM_HZ },
+  };
+}
+
 
 PCA9685::PCA9685(int bus, uint8_t address, bool raw)
 {
@@ -57,17 +85,18 @@ PCA9685::PCA9685(int bus, uint8_t address, bool raw)
 
   // enable restart by default.
   enableRestart(true);
+
+  m_frameDirty = 0;
+  m_frameKnown = 0;
 }
 
 PCA9685::PCA9685(std::string initStr) : mraaIo(initStr)
 {
   mraa_io_descriptor* descs = mraaIo.getMraaDescriptors();
 
-  std::vector<std::string> upmTokens;
-
-  if(mraaIo.getLeftoverStr() != "") {
-    upmTokens = UpmStringParser::parse(mraaIo.getLeftoverStr());
-  }
+  // check the init string before touching the device
+  InitProgram::Ptr program =
+    InitProgram::compile(mraaIo.getLeftoverStr(), initCommands, 32);
 
   if(!descs->i2cs)
   {
@@ -89,64 +118,42 @@ PCA9685::PCA9685(std::string initStr) : mraaIo(initStr)
   // enable restart by default.
   enableRestart(true);
 
-  std::string::size_type sz;
-
-  for (std::string tok : upmTokens) {
-    if(tok.substr(0,10) == "writeByte:") {
-      uint8_t reg = std::stoi(tok.substr(10),&sz,0);
-      tok = tok.substr(10);
-      uint8_t byte = std::stoi(tok.substr(sz+1),nullptr,0);
-      writeByte(reg, byte);
-    }
-    if(tok.substr(0,10) == "writeWord:") {
-      uint8_t reg = std::stoi(tok.substr(10),&sz,0);
-      tok = tok.substr(10);
-      uint16_t word = std::stoi(tok.substr(sz+1),nullptr,0);
-      writeWord(reg, word);
-    }
-    if(tok.substr(0,10) == "modeSleep:") {
-      bool sleep = std::stoi(tok.substr(10),nullptr,0);
-      setModeSleep(sleep);
-    }
-    if(tok.substr(0,14) == "autoIncrement:") {
-      bool ai = std::stoi(tok.substr(14),nullptr,0);
-      enableAutoIncrement(ai);
-    }
-    if(tok.substr(0,10) == "ledFullOn:") {
-      uint8_t led = std::stoi(tok.substr(10),&sz,0);
-      tok = tok.substr(10);
-      bool val = std::stoi(tok.substr(sz+1),nullptr,0);
-      ledFullOn(led, val);
-    }
-    if(tok.substr(0,11) == "ledFullOff:") {
-      uint8_t led = std::stoi(tok.substr(11),&sz,0);
-      tok = tok.substr(11);
-      bool val = std::stoi(tok.substr(sz+1),nullptr,0);
-      ledFullOff(led, val);
-    }
-    if(tok.substr(0,10) == "ledOnTime:") {
-      uint8_t led = std::stoi(tok.substr(10),&sz,0);
-      tok = tok.substr(10);
-      uint16_t time = std::stoi(tok.substr(sz+1),nullptr,0);
-      ledOnTime(led, time);
-    }
-    if(tok.substr(0,11) == "ledOffTime:") {
-      uint8_t led = std::stoi(tok.substr(11),&sz,0);
-      tok = tok.substr(11);
-      uint16_t time = std::stoi(tok.substr(sz+1),nullptr,0);
-      ledOnTime(led, time);
-    }
-    if(tok.substr(0,9) == "prescale:") {
-      uint8_t prescale = std::stoi(tok.substr(9),nullptr,0);
-      setPrescale(prescale);
-    }
-    if(tok.substr(0,15) == "prescaleFromHz:") {
-      float hz = std::stof(tok.substr(15),&sz);
-      tok = tok.substr(15);
-      float oscFreq = std::stof(tok.substr(sz+1),nullptr);
-      setPrescaleFromHz(hz, oscFreq);
-    }
-  }
+  m_frameDirty = 0;
+  m_frameKnown = 0;
+
+  program->run(
+    [this](uint8_t reg, const uint8_t *data, size_t len) {
+      writeRegs(reg, data, len);
+    },
+    [this](const InitOp &op) {
+      switch (op.id)
+        {
+        case INIT_MODE_SLEEP:
+          setModeSleep(op.intArg(0));
+          break;
+        case INIT_AUTO_INCREMENT:
+          enableAutoIncrement(op.intArg(0));
+          break;
+        case INIT_LED_FULL_ON:
+          ledFullOn(op.intArg(0), op.intArg(1));
+          break;
+        case INIT_LED_FULL_OFF:
+          ledFullOff(op.intArg(0), op.intArg(1));
+          break;
+        case INIT_LED_ON_TIME:
+          ledOnTime(op.intArg(0), op.intArg(1));
+          break;
+        case INIT_LED_OFF_TIME:
+          ledOffTime(op.intArg(0), op.intArg(1));
+          break;
+        case INIT_PRESCALE:
+          setPrescale(op.intArg(0));
+          break;
+        case INIT_PRESCALE_FROM_HZ:
+          setPrescaleFromHz(op.floatArg(0), op.floatArg(1));
+          break;
+        }
+    });
 }
 
 PCA9685::~PCA9685()
@@ -155,8 +162,22 @@ PCA9685::~PCA9685()
   mraa_i2c_stop(m_i2c);
 }
 
+void PCA9685::invalidateLedRegs(uint8_t reg)
+{
+  // the LED registers written outside of flushFrame() no longer match
+  // the shadow copy
+  if (reg >= REG_ALL_LED_ON_L && reg <= REG_ALL_LED_OFF_H)
+    m_frameKnown = 0;
+  else if (reg >= REG_LED0_ON_L && reg <= REG_LED15_OFF_H)
+    m_frameKnown &= ~(1 << ((reg - REG_LED0_ON_L) / 4));
+}
+
 bool PCA9685::writeByte(uint8_t reg, uint8_t byte)
 {
+  invalidateLedRegs(reg);
+  if (reg == REG_MODE1)
+    m_autoIncrement = (byte & MODE1_AI);
+
   mraa_result_t rv = mraa_i2c_write_byte_data(m_i2c, byte, reg);
 
   if (rv != MRAA_SUCCESS)
@@ -171,6 +192,10 @@ bool PCA9685::writeByte(uint8_t reg, uint8_t byte)
 
 bool PCA9685::writeWord(uint8_t reg, uint16_t word)
 {
+  invalidateLedRegs(reg);
+  if (reg == REG_MODE1)
+    m_autoIncrement = (word & MODE1_AI);
+
   mraa_result_t rv = mraa_i2c_write_word_data(m_i2c, word, reg);
 
   if (rv != MRAA_SUCCESS)
@@ -378,3 +403,178 @@ bool PCA9685::setPrescaleFromHz(float hz, float oscFreq)
 
   return setPrescale(uint8_t(prescale));
 }
+
+void PCA9685::stageChannel(uint8_t led, const uint8_t regs[4])
+{
+  if (led > 15 && (led != PCA9685_ALL_LED))
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": led value must be between 0-15 or " +
+                              "PCA9685_ALL_LED (255)");
+    }
+
+  int first = (led == PCA9685_ALL_LED) ? 0 : led;
+  int last = (led == PCA9685_ALL_LED) ? 15 : led;
+
+  for (int i = first; i <= last; i++)
+    {
+      memcpy(&m_frame[i * 4], regs, 4);
+      m_frameDirty |= (1 << i);
+    }
+}
+
+void PCA9685::stageLed(uint8_t led, uint16_t onTime, uint16_t offTime)
+{
+  if (onTime > 4095 || offTime > 4095)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": time value must be between 0-4095");
+    }
+
+  uint8_t regs[4] = { uint8_t(onTime & 0xff), uint8_t(onTime >> 8),
+                      uint8_t(offTime & 0xff), uint8_t(offTime >> 8) };
+
+  stageChannel(led, regs);
+}
+
+void PCA9685::stageLedFullOn(uint8_t led)
+{
+  uint8_t regs[4] = { 0x00, 0x10, 0x00, 0x00 };
+
+  stageChannel(led, regs);
+}
+
+void PCA9685::stageLedFullOff(uint8_t led)
+{
+  uint8_t regs[4] = { 0x00, 0x00, 0x00, 0x10 };
+
+  stageChannel(led, regs);
+}
+
+void PCA9685::discardFrame()
+{
+  // restore what we know the device holds, the rest is not written
+  // until it is staged again
+  for (int i = 0; i < 16; i++)
+    if (m_frameKnown & (1 << i))
+      memcpy(&m_frame[i * 4], &m_shadow[i * 4], 4);
+
+  m_frameDirty = 0;
+}
+
+bool PCA9685::writeLedRegs(uint8_t reg, const uint8_t *data, int len)
+{
+  uint8_t buf[1 + sizeof(m_frame)];
+
+  buf[0] = reg;
+  memcpy(&buf[1], data, len);
+
+  if (mraa_i2c_write(m_i2c, buf, len + 1) != MRAA_SUCCESS)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": mraa_i2c_write() failed");
+      return false;
+    }
+
+  return true;
+}
+
+bool PCA9685::writeRegs(uint8_t reg, const uint8_t *data, int len)
+{
+  // a burst needs auto-increment, and must not change it midway
+  if (len == 1 || !m_autoIncrement || reg == REG_MODE1)
+    {
+      for (int i = 0; i < len; i++)
+        writeByte(reg + i, data[i]);
+      return true;
+    }
+
+  for (int i = 0; i < len; i++)
+    invalidateLedRegs(reg + i);
+
+  return writeLedRegs(reg, data, len);
+}
+
+bool PCA9685::flushFrame()
+{
+  // LEDs that were staged with the value the device already has need
+  // not be written
+  uint16_t changed = 0;
+
+  for (int i = 0; i < 16; i++)
+    {
+      if (!(m_frameDirty & (1 << i)))
+        continue;
+
+      if (!(m_frameKnown & (1 << i)) ||
+          memcmp(&m_frame[i * 4], &m_shadow[i * 4], 4))
+        changed |= (1 << i);
+    }
+
+  m_frameDirty = 0;
+
+  if (!changed)
+    return true;
+
+  // when every LED ends up the same, the ALL_LED registers set them
+  // all with 4 bytes instead of 64
+  bool same = (changed == 0xffff);
+  for (int i = 1; same && i < 16; i++)
+    if (memcmp(&m_frame[i * 4], &m_frame[0], 4))
+      same = false;
+
+  if (same)
+    {
+      m_frameKnown = 0;
+      writeRegs(REG_ALL_LED_ON_L, &m_frame[0], 4);
+
+      memcpy(m_shadow, m_frame, sizeof(m_frame));
+      m_frameKnown = 0xffff;
+      return true;
+    }
+
+  // one burst per run of changed LEDs.  Runs are joined across LEDs
+  // whose value is known, those are simply rewritten, so a typical
+  // frame goes out in a single write (or register by register, if an
+  // init string turned auto-increment off).
+  int i = 0;
+  while (i < 16)
+    {
+      if (!(changed & (1 << i)))
+        {
+          i++;
+          continue;
+        }
+
+      int first = i, last = i;
+      for (int j = i + 1; j < 16; j++)
+        {
+          if (changed & (1 << j))
+            last = j;
+          else if (!(m_frameKnown & (1 << j)))
+            break;
+        }
+
+      uint16_t run = 0;
+      for (int j = first; j <= last; j++)
+        {
+          if (!(changed & (1 << j)))
+            memcpy(&m_frame[j * 4], &m_shadow[j * 4], 4);
+          run |= (1 << j);
+        }
+
+      // until the write succeeded, the device state of the run is
+      // unknown
+      m_frameKnown &= ~run;
+      writeRegs(REG_LED0_ON_L + first * 4, &m_frame[first * 4],
+                (last - first + 1) * 4);
+
+      memcpy(&m_shadow[first * 4], &m_frame[first * 4],
+             (last - first + 1) * 4);
+      m_frameKnown |= run;
+
+      i = last + 1;
+    }
+
+  return true;
+}
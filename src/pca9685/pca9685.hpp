@@ -296,6 +296,52 @@ namespace upm {
      */
     void enableRestart(bool enabled) { m_restartEnabled = enabled; };
 
+    /**
+     * Stages the on and off times (0-4,095) of an LED for the next
+     * flushFrame(), clearing its FULL ON and FULL OFF bits.  Nothing
+     * is written to the device.
+     *
+     * @param led LED number; valid values are 0-15, PCA9685_ALL_LED
+     * @param onTime 12-bit value at which point the LED turns on
+     * @param offTime 12-bit value at which point the LED turns off
+     */
+    void stageLed(uint8_t led, uint16_t onTime, uint16_t offTime);
+
+    /**
+     * Stages an LED as fully on for the next flushFrame().
+     *
+     * @param led LED number; valid values are 0-15, PCA9685_ALL_LED
+     */
+    void stageLedFullOn(uint8_t led);
+
+    /**
+     * Stages an LED as fully off for the next flushFrame().
+     *
+     * @param led LED number; valid values are 0-15, PCA9685_ALL_LED
+     */
+    void stageLedFullOff(uint8_t led);
+
+    /**
+     * Drops all staged LED changes that were not flushed yet.
+     */
+    void discardFrame();
+
+    /**
+     * Writes all staged LED changes to the device in a single
+     * auto-increment burst, covering the LEDs from the first to the
+     * last one that changed.  LEDs staged with the value they already
+     * have are skipped.  If all 16 LEDs change to the same value, the
+     * ALL_LED registers are written instead.
+     *
+     * With MODE2_OCH cleared (the power-up default) the outputs change
+     * on the I2C STOP, so all LEDs of the frame switch in the same PWM
+     * cycle.  When driving several controllers, stage every one of
+     * them first and flush them back to back.
+     *
+     * @return True if successful, or if there was nothing to write
+     */
+    bool flushFrame();
+
   private:
     /**
      * Enables the I2C register auto-increment. This needs to be enabled
@@ -306,7 +352,24 @@ namespace upm {
      */
     bool enableAutoIncrement(bool ai);
 
+    // write the LED registers of a frame in one burst
+    bool writeLedRegs(uint8_t reg, const uint8_t *data, int len);
+    // write consecutive registers, in one burst if possible
+    bool writeRegs(uint8_t reg, const uint8_t *data, int len);
+    void stageChannel(uint8_t led, const uint8_t regs[4]);
+    void invalidateLedRegs(uint8_t reg);
+
     bool m_restartEnabled;
+    // MODE1_AI as last written
+    bool m_autoIncrement;
+    // staged LED registers, ON_L, ON_H, OFF_L, OFF_H per LED
+    uint8_t m_frame[16 * 4];
+    // LEDs staged since the last flush
+    uint16_t m_frameDirty;
+    // LED registers last written to the device
+    uint8_t m_shadow[16 * 4];
+    // LEDs whose registers on the device are known to match m_shadow
+    uint16_t m_frameKnown;
     mraa::MraaIo mraaIo;
     mraa_i2c_context m_i2c;
     uint8_t m_addr;
@@ -18,6 +18,7 @@
 #include <iostream>
 #include <string>
 #include <stdexcept>
+#include <chrono>
 
 #include "pn532.hpp"
 
@@ -25,9 +26,6 @@ using namespace upm;
 using namespace std;
 
 
-#define PN532_PACKBUFFSIZ 64
-static uint8_t pn532_packetbuffer[PN532_PACKBUFFSIZ];
-
 static uint8_t pn532ack[] = {0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00};
 static uint32_t pn532_firmwarerev = 0x00320106;
 
@@ -41,6 +39,9 @@ PN532::PN532(int irq, int reset, int bus, uint8_t address):
   m_ATQA = 0;
   m_isrInstalled = false;
   m_irqRcvd = false;
+  m_resetPending = false;
+  m_pollRunning = false;
+  m_targetHeld = false;
 
   memset(m_uid, 0, 7);
   memset(m_key, 0, 6);
@@ -63,6 +64,8 @@ PN532::PN532(int irq, int reset, int bus, uint8_t address):
 
 PN532::~PN532()
 {
+  stopAutoPoll();
+
   if (m_isrInstalled)
     m_gpioIRQ.isrExit();
 }
@@ -71,17 +74,30 @@ bool PN532::init()
 {
   m_gpioReset.write(1);
   m_gpioReset.write(0);
-  usleep(400000);
+  m_resetRelease = std::chrono::steady_clock::now()
+    + std::chrono::milliseconds(400);
+  m_resetPending = true;
 
   // install an interrupt handler
-  m_gpioIRQ.isr(mraa::EDGE_FALLING, dataReadyISR, this);
-  m_isrInstalled = true;
-
-  m_gpioReset.write(1);
+  if (!m_isrInstalled)
+    {
+      m_gpioIRQ.isr(mraa::EDGE_FALLING, dataReadyISR, this);
+      m_isrInstalled = true;
+    }
 
   return true;
 }
 
+void PN532::finishReset()
+{
+  if (!m_resetPending)
+    return;
+
+  std::this_thread::sleep_until(m_resetRelease);
+  m_gpioReset.write(1);
+  m_resetPending = false;
+}
+
 /**************************************************************************/
 /*! 
     @brief  Prints a hexadecimal value in plain characters
@@ -139,24 +155,33 @@ static void PrintHexChar(const uint8_t * data, const uint32_t numBytes)
 /**************************************************************************/
 uint32_t PN532::getFirmwareVersion()
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   uint32_t response = 0;
 
-  pn532_packetbuffer[0] = CMD_GETFIRMWAREVERSION;
+  m_packetBuffer[0] = CMD_GETFIRMWAREVERSION;
   
-  if (! sendCommandCheckAck(pn532_packetbuffer, 1))
+  if (! sendCommandCheckAck(m_packetBuffer, 1))
     return 0;
   
+  if (!waitForReady(1000)) {
+    if (m_pn532Debug)
+      cerr << __FUNCTION__ << ": Response never received" << endl;
+
+    return 0;
+  }
+
   // read data packet
-  readData(pn532_packetbuffer, 12);
+  readData(m_packetBuffer, 12);
   
   int offset = 7;  // Skip the ready byte when using I2C
 
   response <<= 8;
-  response |= pn532_packetbuffer[offset++];
+  response |= m_packetBuffer[offset++];
   response <<= 8;
-  response |= pn532_packetbuffer[offset++];
+  response |= m_packetBuffer[offset++];
   response <<= 8;
-  response |= pn532_packetbuffer[offset++];
+  response |= m_packetBuffer[offset++];
 
   if (response != pn532_firmwarerev)
     fprintf(stderr, 
@@ -183,6 +208,8 @@ uint32_t PN532::getFirmwareVersion()
 bool PN532::sendCommandCheckAck(uint8_t *cmd, uint8_t cmdlen, 
                                 uint16_t timeout)
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   // clear any outstanding irq's
   isReady();
   
@@ -216,19 +243,28 @@ bool PN532::sendCommandCheckAck(uint8_t *cmd, uint8_t cmdlen,
 /**************************************************************************/
 bool PN532::SAMConfig(void)
 {
-  pn532_packetbuffer[0] = CMD_SAMCONFIGURATION;
-  pn532_packetbuffer[1] = 0x01; // normal mode;
-  pn532_packetbuffer[2] = 0x14; // timeout 50ms * 20 = 1 second
-  pn532_packetbuffer[3] = 0x01; // use IRQ pin!
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
+  m_packetBuffer[0] = CMD_SAMCONFIGURATION;
+  m_packetBuffer[1] = 0x01; // normal mode;
+  m_packetBuffer[2] = 0x14; // timeout 50ms * 20 = 1 second
+  m_packetBuffer[3] = 0x01; // use IRQ pin!
   
-  if (! sendCommandCheckAck(pn532_packetbuffer, 4))
+  if (! sendCommandCheckAck(m_packetBuffer, 4))
     return false;
 
+  if (!waitForReady(1000)) {
+    if (m_pn532Debug)
+      cerr << __FUNCTION__ << ": Response never received" << endl;
+
+    return false;
+  }
+
   // read data packet
-  readData(pn532_packetbuffer, 8);
+  readData(m_packetBuffer, 8);
   
   int offset = 6;
-  return  (pn532_packetbuffer[offset] == 0x15);
+  return  (m_packetBuffer[offset] == 0x15);
 }
 
 /**************************************************************************/
@@ -243,17 +279,19 @@ bool PN532::SAMConfig(void)
 /**************************************************************************/
 bool PN532::setPassiveActivationRetries(uint8_t maxRetries)
 {
-  pn532_packetbuffer[0] = CMD_RFCONFIGURATION;
-  pn532_packetbuffer[1] = 5;    // Config item 5 (MaxRetries)
-  pn532_packetbuffer[2] = 0xFF; // MxRtyATR (default = 0xFF)
-  pn532_packetbuffer[3] = 0x01; // MxRtyPSL (default = 0x01)
-  pn532_packetbuffer[4] = maxRetries;
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
+  m_packetBuffer[0] = CMD_RFCONFIGURATION;
+  m_packetBuffer[1] = 5;    // Config item 5 (MaxRetries)
+  m_packetBuffer[2] = 0xFF; // MxRtyATR (default = 0xFF)
+  m_packetBuffer[3] = 0x01; // MxRtyPSL (default = 0x01)
+  m_packetBuffer[4] = maxRetries;
 
   if (m_mifareDebug)
     cerr << __FUNCTION__ << ": Setting MxRtyPassiveActivation to " 
          << (int)maxRetries << endl;
   
-  if (! sendCommandCheckAck(pn532_packetbuffer, 5))
+  if (! sendCommandCheckAck(m_packetBuffer, 5))
     return false;  // no ACK
   
   return true;
@@ -277,12 +315,14 @@ bool PN532::setPassiveActivationRetries(uint8_t maxRetries)
 bool PN532::readPassiveTargetID(BAUD_T cardbaudrate, uint8_t * uid, 
                                 uint8_t * uidLength, uint16_t timeout)
 {
-  pn532_packetbuffer[0] = CMD_INLISTPASSIVETARGET;
-  pn532_packetbuffer[1] = 1;  // max 1 cards at once (we can set this
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
+  m_packetBuffer[0] = CMD_INLISTPASSIVETARGET;
+  m_packetBuffer[1] = 1;  // max 1 cards at once (we can set this
                               // to 2 later)
-  pn532_packetbuffer[2] = cardbaudrate;
+  m_packetBuffer[2] = cardbaudrate;
   
-  if (!sendCommandCheckAck(pn532_packetbuffer, 3, timeout))
+  if (!sendCommandCheckAck(m_packetBuffer, 3, timeout))
     {
       if (m_pn532Debug)
         cerr << __FUNCTION__ << ": No card(s) read" << endl;
@@ -302,7 +342,7 @@ bool PN532::readPassiveTargetID(BAUD_T cardbaudrate, uint8_t * uid,
   }
   
   // read data packet
-  readData(pn532_packetbuffer, 20);
+  readData(m_packetBuffer, 20);
 
   // check some basic stuff
 
@@ -324,22 +364,22 @@ bool PN532::readPassiveTargetID(BAUD_T cardbaudrate, uint8_t * uid,
   // 00 02      18          NXP Mifare Classic 4K     4 bytes
   
   if (m_mifareDebug)
-    cerr << __FUNCTION__ << ": Found " <<  (int)pn532_packetbuffer[7] << " tags"
+    cerr << __FUNCTION__ << ": Found " <<  (int)m_packetBuffer[7] << " tags"
          << endl;
 
   // only one card can be handled currently
-  if (pn532_packetbuffer[7] != 1) 
+  if (m_packetBuffer[7] != 1) 
     return false;
     
-  uint16_t sens_res = pn532_packetbuffer[9];
+  uint16_t sens_res = m_packetBuffer[9];
   sens_res <<= 8;
-  sens_res |= pn532_packetbuffer[10];
+  sens_res |= m_packetBuffer[10];
 
   // store these for later retrieval, they can be used to more accurately
   // ID the type of card.
 
   m_ATQA = sens_res;
-  m_SAK = pn532_packetbuffer[11]; // SEL_RES
+  m_SAK = m_packetBuffer[11]; // SEL_RES
 
   if (m_mifareDebug)
     {
@@ -350,19 +390,21 @@ bool PN532::readPassiveTargetID(BAUD_T cardbaudrate, uint8_t * uid,
   /* Card appears to be Mifare Classic */
   // JET: How so?
 
-  *uidLength = pn532_packetbuffer[12];
+  *uidLength = m_packetBuffer[12];
   if (m_mifareDebug)
     fprintf(stderr, "UID: "); 
 
-  for (uint8_t i=0; i < pn532_packetbuffer[12]; i++) 
+  for (uint8_t i=0; i < m_packetBuffer[12]; i++) 
     {
-      uid[i] = pn532_packetbuffer[13+i];
+      uid[i] = m_packetBuffer[13+i];
       if (m_mifareDebug)
         fprintf(stderr, "0x%02x ", uid[i]); 
     }
   if (m_mifareDebug)
     fprintf(stderr, "\n");
 
+  m_targetHeld = true;
+
   return true;
 }
 
@@ -379,6 +421,8 @@ bool PN532::readPassiveTargetID(BAUD_T cardbaudrate, uint8_t * uid,
 bool PN532::inDataExchange(uint8_t * send, uint8_t sendLength,
                            uint8_t * response, uint8_t * responseLength)
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   if (sendLength > PN532_PACKBUFFSIZ-2) {
     if (m_pn532Debug)
       cerr << __FUNCTION__ << ": APDU length too long for packet buffer"
@@ -388,13 +432,13 @@ bool PN532::inDataExchange(uint8_t * send, uint8_t sendLength,
   }
   uint8_t i;
   
-  pn532_packetbuffer[0] = CMD_INDATAEXCHANGE; // 0x40
-  pn532_packetbuffer[1] = m_inListedTag;
+  m_packetBuffer[0] = CMD_INDATAEXCHANGE; // 0x40
+  m_packetBuffer[1] = m_inListedTag;
   for (i=0; i<sendLength; ++i) {
-    pn532_packetbuffer[i+2] = send[i];
+    m_packetBuffer[i+2] = send[i];
   }
   
-  if (!sendCommandCheckAck(pn532_packetbuffer,sendLength+2,1000)) {
+  if (!sendCommandCheckAck(m_packetBuffer,sendLength+2,1000)) {
     if (m_pn532Debug)
       cerr << __FUNCTION__ << ": Could not send ADPU" << endl;
 
@@ -408,14 +452,14 @@ bool PN532::inDataExchange(uint8_t * send, uint8_t sendLength,
     return false;
   }
 
-  readData(pn532_packetbuffer, sizeof(pn532_packetbuffer));
+  readData(m_packetBuffer, sizeof(m_packetBuffer));
   
-  if (pn532_packetbuffer[0] == 0 && pn532_packetbuffer[1] == 0 &&
-      pn532_packetbuffer[2] == 0xff)
+  if (m_packetBuffer[0] == 0 && m_packetBuffer[1] == 0 &&
+      m_packetBuffer[2] == 0xff)
     {
       
-      uint8_t length = pn532_packetbuffer[3];
-      if (pn532_packetbuffer[4]!=(uint8_t)(~length+1))
+      uint8_t length = m_packetBuffer[3];
+      if (m_packetBuffer[4]!=(uint8_t)(~length+1))
         {
           if (m_pn532Debug)
             fprintf(stderr, "Length check invalid: 0x%02x != 0x%02x\n", length,
@@ -423,10 +467,10 @@ bool PN532::inDataExchange(uint8_t * send, uint8_t sendLength,
 
           return false;
         }
-      if (pn532_packetbuffer[5]==PN532_PN532TOHOST && 
-          pn532_packetbuffer[6]==RSP_INDATAEXCHANGE)
+      if (m_packetBuffer[5]==PN532_PN532TOHOST && 
+          m_packetBuffer[6]==RSP_INDATAEXCHANGE)
         {
-          if ((pn532_packetbuffer[7] & 0x3f)!=0)
+          if ((m_packetBuffer[7] & 0x3f)!=0)
             {
               if (m_pn532Debug)
                 cerr << __FUNCTION__ << ": Status code indicates an error" 
@@ -442,7 +486,7 @@ bool PN532::inDataExchange(uint8_t * send, uint8_t sendLength,
           }
           
           for (i=0; i<length; ++i) {
-            response[i] = pn532_packetbuffer[8+i];
+            response[i] = m_packetBuffer[8+i];
           }
           *responseLength = length;
           
@@ -450,7 +494,7 @@ bool PN532::inDataExchange(uint8_t * send, uint8_t sendLength,
         } 
       else {
         fprintf(stderr, "Don't know how to handle this command: 0x%02x\n",
-                pn532_packetbuffer[6]);
+                m_packetBuffer[6]);
         return false;
       } 
     } 
@@ -468,16 +512,18 @@ bool PN532::inDataExchange(uint8_t * send, uint8_t sendLength,
 /**************************************************************************/
 bool PN532::inListPassiveTarget() 
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   m_inListedTag = 0;
 
-  pn532_packetbuffer[0] = CMD_INLISTPASSIVETARGET;
-  pn532_packetbuffer[1] = 1;
-  pn532_packetbuffer[2] = 0;
+  m_packetBuffer[0] = CMD_INLISTPASSIVETARGET;
+  m_packetBuffer[1] = 1;
+  m_packetBuffer[2] = 0;
   
   if (m_pn532Debug)
     cerr << __FUNCTION__ << ": About to inList passive target" << endl;
 
-  if (!sendCommandCheckAck(pn532_packetbuffer,3,1000)) {
+  if (!sendCommandCheckAck(m_packetBuffer,3,1000)) {
     if (m_pn532Debug)
       cerr << __FUNCTION__ << ": Could not send inlist message" << endl;
 
@@ -488,31 +534,33 @@ bool PN532::inListPassiveTarget()
     return false;
   }
 
-  readData(pn532_packetbuffer, sizeof(pn532_packetbuffer));
+  readData(m_packetBuffer, sizeof(m_packetBuffer));
   
-  if (pn532_packetbuffer[0] == 0 && pn532_packetbuffer[1] == 0 && 
-      pn532_packetbuffer[2] == 0xff) {
+  if (m_packetBuffer[0] == 0 && m_packetBuffer[1] == 0 && 
+      m_packetBuffer[2] == 0xff) {
 
-    uint8_t length = pn532_packetbuffer[3];
-    if (pn532_packetbuffer[4]!=(uint8_t)(~length+1)) {
+    uint8_t length = m_packetBuffer[3];
+    if (m_packetBuffer[4]!=(uint8_t)(~length+1)) {
       if (m_pn532Debug)
         fprintf(stderr, "Length check invalid: 0x%02x != 0x%02x\n", length,
                 (~length)+1);
 
       return false;
     }
-    if (pn532_packetbuffer[5]==PN532_PN532TOHOST && 
-        pn532_packetbuffer[6]==RSP_INLISTPASSIVETARGET) {
-      if (pn532_packetbuffer[7] != 1) {
+    if (m_packetBuffer[5]==PN532_PN532TOHOST && 
+        m_packetBuffer[6]==RSP_INLISTPASSIVETARGET) {
+      if (m_packetBuffer[7] != 1) {
         cerr << __FUNCTION__ << ": Unhandled number of tags inlisted: "
-             << (int)pn532_packetbuffer[7] << endl;
+             << (int)m_packetBuffer[7] << endl;
         return false;
       }
       
-      m_inListedTag = pn532_packetbuffer[8];
+      m_inListedTag = m_packetBuffer[8];
       if (m_pn532Debug)
         cerr << __FUNCTION__ << ": Tag number: " << (int)m_inListedTag << endl;
-      
+
+      m_targetHeld = true;
+
       return true;
     } else {
       if (m_pn532Debug)
@@ -533,6 +581,284 @@ bool PN532::inListPassiveTarget()
 }
 
 
+/**************************************************************************/
+/*! 
+  @brief  Releases all inlisted targets
+*/
+/**************************************************************************/
+bool PN532::inRelease()
+{
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
+  m_packetBuffer[0] = CMD_INRELEASE;
+  m_packetBuffer[1] = 0;    // all targets
+
+  if (!sendCommandCheckAck(m_packetBuffer, 2))
+    return false;
+
+  if (!waitForReady(1000))
+    return false;
+
+  readData(m_packetBuffer, 10);
+
+  m_inListedTag = 0;
+  m_targetHeld = false;
+
+  return true;
+}
+
+/**************************************************************************/
+/*! 
+  @brief  Releases the targets inlisted by the application
+*/
+/**************************************************************************/
+bool PN532::releaseTarget()
+{
+  return inRelease();
+}
+
+/**************************************************************************/
+/*! 
+  @brief  Polls once for up to 2 ISO14443A targets with InAutoPoll
+
+  @param  tags     Array of 2 that will hold the tags found
+  @param  numTags  Number of tags found
+
+  @returns true if the poll completed, false on an error
+*/
+/**************************************************************************/
+bool PN532::autoPoll(TAG_EVENT_INFO_T *tags, int *numTags)
+{
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
+  *numTags = 0;
+
+  // skip the poll while the application holds a target, releasing it
+  // would drop the target and its MIFARE authentication
+  if (m_targetHeld)
+    return false;
+
+  // release the targets activated by the last poll, so tags still in
+  // the field are found again
+  inRelease();
+
+  m_packetBuffer[0] = CMD_INAUTOPOLL;
+  m_packetBuffer[1] = 0x01; // PollNr, one polling
+  m_packetBuffer[2] = 0x01; // Period, 1 * 150ms
+  m_packetBuffer[3] = 0x10; // Type, Mifare card (ISO14443A 106 kbps)
+
+  if (!sendCommandCheckAck(m_packetBuffer, 4))
+    return false;
+
+  if (!waitForReady(1000))
+    {
+      if (m_pn532Debug)
+        cerr << __FUNCTION__ << ": Response never received" << endl;
+
+      return false;
+    }
+
+  readData(m_packetBuffer, sizeof(m_packetBuffer));
+
+  /* response:
+
+     b0..6          Frame header and preamble (b6 = 0x61)
+     b7             NbTg
+     b8..           per target: Type, Len, Len bytes of data; for
+                    type 0x10: Tg, SENS_RES (2), SEL_RES, NFCIDLength,
+                    NFCID                                            */
+
+  if (m_packetBuffer[5] != PN532_PN532TOHOST
+      || m_packetBuffer[6] != CMD_INAUTOPOLL + 1)
+    {
+      if (m_pn532Debug)
+        cerr << __FUNCTION__ << ": Unexpected response" << endl;
+
+      return false;
+    }
+
+  int nbTg = m_packetBuffer[7];
+  int offset = 8;
+
+  for (int i = 0; i < nbTg && i < 2; i++)
+    {
+      if (offset + 2 > PN532_PACKBUFFSIZ)
+        break;
+
+      uint8_t type = m_packetBuffer[offset];
+      uint8_t len = m_packetBuffer[offset + 1];
+      uint8_t *data = &m_packetBuffer[offset + 2];
+
+      offset += 2 + len;
+      if (offset > PN532_PACKBUFFSIZ)
+        break;
+
+      if (type != 0x10 || len < 5 || data[4] > 7 || data[4] > len - 5)
+        continue;
+
+      TAG_EVENT_INFO_T *tag = &tags[(*numTags)++];
+
+      memset(tag, 0, sizeof(TAG_EVENT_INFO_T));
+      tag->atqa = (data[1] << 8) | data[2];
+      tag->sak = data[3];
+      tag->uidLen = data[4];
+      memcpy(tag->uid, &data[5], tag->uidLen);
+
+      // the first target is inlisted, like with inListPassiveTarget()
+      if (*numTags == 1)
+        m_inListedTag = data[0];
+    }
+
+  return true;
+}
+
+static bool sameTag(const PN532::TAG_EVENT_INFO_T &a,
+                    const PN532::TAG_EVENT_INFO_T &b)
+{
+  return (a.uidLen == b.uidLen && !memcmp(a.uid, b.uid, a.uidLen));
+}
+
+void PN532::autoPollThread(int interval)
+{
+  // tags in the field, and how many polls they have been missing from
+  TAG_EVENT_INFO_T present[2];
+  int missed[2];
+  int numPresent = 0;
+
+  std::unique_lock<std::mutex> lock(m_pollLock);
+
+  while (m_pollRunning)
+    {
+      lock.unlock();
+
+      TAG_EVENT_INFO_T found[2];
+      int numFound;
+      bool ok = autoPoll(found, &numFound);
+
+      lock.lock();
+
+      if (ok)
+        {
+          std::deque<TAG_EVENT_INFO_T> events;
+
+          // departures, after missing two polls in a row
+          for (int i = 0; i < numPresent; )
+            {
+              bool seen = false;
+              for (int j = 0; j < numFound; j++)
+                if (sameTag(present[i], found[j]))
+                  seen = true;
+
+              missed[i] = seen ? 0 : missed[i] + 1;
+              if (missed[i] >= 2)
+                {
+                  present[i].event = TAG_EVENT_DEPARTED;
+                  events.push_back(present[i]);
+
+                  present[i] = present[numPresent - 1];
+                  missed[i] = missed[numPresent - 1];
+                  numPresent--;
+                }
+              else
+                i++;
+            }
+
+          // arrivals
+          for (int j = 0; j < numFound; j++)
+            {
+              bool known = false;
+              for (int i = 0; i < numPresent; i++)
+                if (sameTag(present[i], found[j]))
+                  known = true;
+
+              if (known || numPresent >= 2)
+                continue;
+
+              present[numPresent] = found[j];
+              missed[numPresent] = 0;
+              numPresent++;
+
+              found[j].event = TAG_EVENT_ARRIVED;
+              events.push_back(found[j]);
+            }
+
+          for (auto &event : events)
+            {
+              if (m_tagEvents.size() >= 32)
+                m_tagEvents.pop_front();
+              m_tagEvents.push_back(event);
+            }
+
+          if (!events.empty())
+            m_eventCond.notify_all();
+        }
+
+      // give other users of the device a chance between polls
+      m_pollCond.wait_for(lock, std::chrono::milliseconds(interval),
+                          [this] { return !m_pollRunning; });
+    }
+}
+
+/**************************************************************************/
+/*! 
+  @brief  Starts continuous card detection in a background thread
+*/
+/**************************************************************************/
+void PN532::startAutoPoll(int interval)
+{
+  stopAutoPoll();
+
+  std::lock_guard<std::mutex> lock(m_pollLock);
+
+  m_tagEvents.clear();
+  m_pollRunning = true;
+  m_pollThread = std::thread(&PN532::autoPollThread, this, interval);
+}
+
+/**************************************************************************/
+/*! 
+  @brief  Stops continuous card detection
+*/
+/**************************************************************************/
+void PN532::stopAutoPoll()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_pollLock);
+    m_pollRunning = false;
+  }
+  m_pollCond.notify_all();
+
+  if (m_pollThread.joinable())
+    m_pollThread.join();
+}
+
+/**************************************************************************/
+/*! 
+  @brief  Returns the oldest auto poll event, waiting for one if needed
+*/
+/**************************************************************************/
+PN532::TAG_EVENT_INFO_T PN532::getTagEvent(int timeout)
+{
+  std::unique_lock<std::mutex> lock(m_pollLock);
+  TAG_EVENT_INFO_T event;
+
+  memset(&event, 0, sizeof(TAG_EVENT_INFO_T));
+  event.event = TAG_EVENT_NONE;
+
+  auto pending = [this] { return !m_tagEvents.empty(); };
+
+  if (timeout < 0)
+    m_eventCond.wait(lock, pending);
+  else if (!m_eventCond.wait_for(lock, std::chrono::milliseconds(timeout),
+                                 pending))
+    return event;
+
+  event = m_tagEvents.front();
+  m_tagEvents.pop_front();
+
+  return event;
+}
+
 /***** Mifare Classic Functions ******/
 /*  MIFARE CLASSIC DESCRIPTION
     ==========================
@@ -728,6 +1054,8 @@ bool PN532::mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen,
                                              uint8_t keyNumber,
                                              uint8_t * keyData)
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   uint8_t i;
   
   // Hang on to the key and uid data
@@ -745,22 +1073,22 @@ bool PN532::mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen,
     }
   
   // Prepare the authentication command //
-  pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;   /* Data Exchange Header */
-  pn532_packetbuffer[1] = 1;                              /* Max card numbers */
-  pn532_packetbuffer[2] = (keyNumber) ? MIFARE_CMD_AUTH_B : MIFARE_CMD_AUTH_A;
-  pn532_packetbuffer[3] = blockNumber;                    /* Block
+  m_packetBuffer[0] = CMD_INDATAEXCHANGE;   /* Data Exchange Header */
+  m_packetBuffer[1] = 1;                              /* Max card numbers */
+  m_packetBuffer[2] = (keyNumber) ? MIFARE_CMD_AUTH_B : MIFARE_CMD_AUTH_A;
+  m_packetBuffer[3] = blockNumber;                    /* Block
                                                              Number
                                                              (1K =
                                                              0..63, 4K
                                                              =
                                                              0..255 */
-  memcpy (pn532_packetbuffer+4, m_key, 6);
+  memcpy (m_packetBuffer+4, m_key, 6);
   for (i = 0; i < m_uidLen; i++)
     {
-      pn532_packetbuffer[10+i] = m_uid[i];                /* 4 byte card ID */
+      m_packetBuffer[10+i] = m_uid[i];                /* 4 byte card ID */
     }
   
-  if (! sendCommandCheckAck(pn532_packetbuffer, 10+m_uidLen))
+  if (! sendCommandCheckAck(m_packetBuffer, 10+m_uidLen))
     return false;
   
   if (!waitForReady(1000)) {
@@ -771,18 +1099,18 @@ bool PN532::mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen,
   }
 
   // Read the response packet
-  readData(pn532_packetbuffer, 12);
+  readData(m_packetBuffer, 12);
   
   // check if the response is valid and we are authenticated???
   // for an auth success it should be bytes 5-7: 0xD5 0x41 0x00
   // Mifare auth error is technically byte 7: 0x14 but anything other
   // and 0x00 is not good
-  if (pn532_packetbuffer[7] != 0x00)
+  if (m_packetBuffer[7] != 0x00)
     {
       if (m_pn532Debug)
         {
           fprintf(stderr, "Authentication failed: ");
-          PrintHexChar(pn532_packetbuffer, 12);
+          PrintHexChar(m_packetBuffer, 12);
         }
 
       return false;
@@ -806,21 +1134,23 @@ bool PN532::mifareclassic_AuthenticateBlock (uint8_t * uid, uint8_t uidLen,
 /**************************************************************************/
 bool PN532::mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data)
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   if (m_mifareDebug)
     cerr << __FUNCTION__ << ": Trying to read 16 bytes from block " 
          << (int)blockNumber << endl;
   
   /* Prepare the command */
-  pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;                      /* Card number */
-  pn532_packetbuffer[2] = MIFARE_CMD_READ;        /* Mifare Read
+  m_packetBuffer[0] = CMD_INDATAEXCHANGE;
+  m_packetBuffer[1] = 1;                      /* Card number */
+  m_packetBuffer[2] = MIFARE_CMD_READ;        /* Mifare Read
                                                      command = 0x30 */
-  pn532_packetbuffer[3] = blockNumber;            /* Block Number
+  m_packetBuffer[3] = blockNumber;            /* Block Number
                                                      (0..63 for 1K,
                                                      0..255 for 4K) */
   
   /* Send the command */
-  if (! sendCommandCheckAck(pn532_packetbuffer, 4))
+  if (! sendCommandCheckAck(m_packetBuffer, 4))
     {
       if (m_mifareDebug)
         cerr << __FUNCTION__ << ": Failed to receive ACK for read command" 
@@ -829,23 +1159,30 @@ bool PN532::mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data)
       return false;
     }
   
+  if (!waitForReady(1000)) {
+    if (m_pn532Debug)
+      cerr << __FUNCTION__ << ": Response never received" << endl;
+
+    return false;
+  }
+
   /* Read the response packet */
-  readData(pn532_packetbuffer, 26);
+  readData(m_packetBuffer, 26);
   
   /* If byte 8 isn't 0x00 we probably have an error */
-  if (pn532_packetbuffer[7] != 0x00)
+  if (m_packetBuffer[7] != 0x00)
     {
       if (m_mifareDebug)
         {
           fprintf(stderr, "Unexpected response: ");
-          PrintHexChar(pn532_packetbuffer, 26);
+          PrintHexChar(m_packetBuffer, 26);
         }
       return false;
     }
   
   /* Copy the 16 data bytes to the output buffer        */
   /* Block content starts at byte 9 of a valid response */
-  memcpy (data, pn532_packetbuffer+8, 16);
+  memcpy (data, m_packetBuffer+8, 16);
   
   /* Display data for debug if requested */
   if (m_mifareDebug)
@@ -857,6 +1194,51 @@ bool PN532::mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data)
   return true;
 }
 
+/**************************************************************************/
+/*! 
+  Reads a range of 16-byte data blocks, authenticating each sector
+  once.
+
+  @param  uid           Pointer to a byte array containing the card UID
+  @param  uidLen        The length (in bytes) of the card's UID
+  @param  firstBlock    The first block to read
+  @param  count         Number of blocks to read
+  @param  keyNumber     Which key type to use during authentication
+  (0 = MIFARE_CMD_AUTH_A, 1 = MIFARE_CMD_AUTH_B)
+  @param  keyData       Pointer to a byte array containing the 6 byte
+  key value
+  @param  data          Pointer to the byte array that will hold the
+  retrieved data, 16 * count bytes
+    
+  @returns 1 if everything executed properly, 0 for an error
+*/
+/**************************************************************************/
+bool PN532::mifareclassic_ReadDataBlocks (uint8_t * uid, uint8_t uidLen,
+                                          uint8_t firstBlock, uint8_t count,
+                                          uint8_t keyNumber,
+                                          uint8_t * keyData, uint8_t * data)
+{
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
+  for (int i = 0; i < count; i++)
+    {
+      uint8_t block = firstBlock + i;
+
+      // a sector is authenticated once, on its first block read
+      if (i == 0 || mifareclassic_IsFirstBlock(block))
+        {
+          if (!mifareclassic_AuthenticateBlock(uid, uidLen, block, keyNumber,
+                                               keyData))
+            return false;
+        }
+
+      if (!mifareclassic_ReadDataBlock(block, data + (i * 16)))
+        return false;
+    }
+
+  return true;
+}
+
 /**************************************************************************/
 /*! 
   Tries to write an entire 16-byte data block at the specified block
@@ -871,21 +1253,23 @@ bool PN532::mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data)
 /**************************************************************************/
 bool PN532::mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t * data)
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   if (m_mifareDebug)
     fprintf(stderr, "Trying to write 16 bytes to block %d\n", blockNumber);
   
   /* Prepare the first command */
-  pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;                      /* Card number */
-  pn532_packetbuffer[2] = MIFARE_CMD_WRITE;       /* Mifare Write
+  m_packetBuffer[0] = CMD_INDATAEXCHANGE;
+  m_packetBuffer[1] = 1;                      /* Card number */
+  m_packetBuffer[2] = MIFARE_CMD_WRITE;       /* Mifare Write
                                                      command = 0xA0 */
-  pn532_packetbuffer[3] = blockNumber;            /* Block Number
+  m_packetBuffer[3] = blockNumber;            /* Block Number
                                                      (0..63 for 1K,
                                                      0..255 for 4K) */
-  memcpy (pn532_packetbuffer+4, data, 16);          /* Data Payload */
+  memcpy (m_packetBuffer+4, data, 16);          /* Data Payload */
   
   /* Send the command */
-  if (! sendCommandCheckAck(pn532_packetbuffer, 20))
+  if (! sendCommandCheckAck(m_packetBuffer, 20))
     {
       if (m_mifareDebug)
         cerr << __FUNCTION__ << ": Failed to receive ACK for write command"
@@ -893,10 +1277,16 @@ bool PN532::mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t * data)
 
       return false;
     }  
-  usleep(10000);
+
+  if (!waitForReady(1000)) {
+    if (m_pn532Debug)
+      cerr << __FUNCTION__ << ": Response never received" << endl;
+
+    return false;
+  }
   
   /* Read the response packet */
-  readData(pn532_packetbuffer, 26);
+  readData(m_packetBuffer, 26);
   
   return true;
 }
@@ -910,6 +1300,8 @@ bool PN532::mifareclassic_WriteDataBlock (uint8_t blockNumber, uint8_t * data)
 /**************************************************************************/
 bool PN532::mifareclassic_FormatNDEF (void)
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   uint8_t sectorbuffer1[16] = {0x14, 0x01, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 
                                0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1};
   uint8_t sectorbuffer2[16] = {0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1, 0x03, 0xE1,
@@ -955,6 +1347,8 @@ bool PN532::mifareclassic_WriteNDEFURI (uint8_t sectorNumber,
                                         NDEF_URI_T uriIdentifier,
                                         const char * url)
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   if (!url)
     return false;
 
@@ -1133,6 +1527,8 @@ bool PN532::mifareclassic_WriteNDEFURI (uint8_t sectorNumber,
 /**************************************************************************/
 bool PN532::ntag2xx_ReadPage (uint8_t page, uint8_t * buffer)
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   // TAG Type       PAGES   USER START    USER STOP
   // --------       -----   ----------    ---------
   // NTAG 203       42      4             39
@@ -1150,14 +1546,14 @@ bool PN532::ntag2xx_ReadPage (uint8_t page, uint8_t * buffer)
     fprintf(stderr, "Reading page %d\n", page);
 
   /* Prepare the command */
-  pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;                   /* Card number */
-  pn532_packetbuffer[2] = MIFARE_CMD_READ;     /* Mifare Read command = 0x30 */
-  pn532_packetbuffer[3] = page;                /* Page Number (0..63
+  m_packetBuffer[0] = CMD_INDATAEXCHANGE;
+  m_packetBuffer[1] = 1;                   /* Card number */
+  m_packetBuffer[2] = MIFARE_CMD_READ;     /* Mifare Read command = 0x30 */
+  m_packetBuffer[3] = page;                /* Page Number (0..63
                                                   in most cases) */
 
   /* Send the command */
-  if (! sendCommandCheckAck(pn532_packetbuffer, 4))
+  if (! sendCommandCheckAck(m_packetBuffer, 4))
     {
       if (m_mifareDebug)
         cerr << __FUNCTION__ << ": Failed to receive ACK for write command"
@@ -1166,31 +1562,38 @@ bool PN532::ntag2xx_ReadPage (uint8_t page, uint8_t * buffer)
       return false;
     }
   
+  if (!waitForReady(1000)) {
+    if (m_pn532Debug)
+      cerr << __FUNCTION__ << ": Response never received" << endl;
+
+    return false;
+  }
+
   /* Read the response packet */
-  readData(pn532_packetbuffer, 26);
+  readData(m_packetBuffer, 26);
 
   if (m_mifareDebug)
     {
       fprintf(stderr, "Received: \n");
-      PrintHexChar(pn532_packetbuffer, 26);
+      PrintHexChar(m_packetBuffer, 26);
     }
 
   /* If byte 8 isn't 0x00 we probably have an error */
-  if (pn532_packetbuffer[7] == 0x00)
+  if (m_packetBuffer[7] == 0x00)
     {
       /* Copy the 4 data bytes to the output buffer         */
       /* Block content starts at byte 9 of a valid response */
       /* Note that the command actually reads 16 byte or 4  */
       /* pages at a time ... we simply discard the last 12  */
       /* bytes                                              */
-      memcpy (buffer, pn532_packetbuffer+8, 4);
+      memcpy (buffer, m_packetBuffer+8, 4);
     }
   else
     {
       if (m_mifareDebug)
         {
           fprintf(stderr, "Unexpected response reading block: \n");
-          PrintHexChar(pn532_packetbuffer, 26);
+          PrintHexChar(m_packetBuffer, 26);
         }
 
       return false;
@@ -1207,6 +1610,70 @@ bool PN532::ntag2xx_ReadPage (uint8_t page, uint8_t * buffer)
   return true;
 }
 
+/**************************************************************************/
+/*! 
+  Reads a range of 4-byte pages, 4 pages per READ command.
+
+  @param  page        The first page number
+  @param  count       Number of pages to read
+  @param  buffer      Pointer to the byte array that will hold the
+  retrieved data, 4 * count bytes
+*/
+/**************************************************************************/
+bool PN532::ntag2xx_ReadPages (uint8_t page, uint8_t count, uint8_t * buffer)
+{
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
+  if (page + count > 231)
+    {
+      cerr << __FUNCTION__ << ": Page value out of range" << endl;
+      return false;
+    }
+
+  while (count)
+    {
+      uint8_t num = (count < 4) ? count : 4;
+
+      m_packetBuffer[0] = CMD_INDATAEXCHANGE;
+      m_packetBuffer[1] = 1;                   /* Card number */
+      m_packetBuffer[2] = MIFARE_CMD_READ;     /* returns 4 pages */
+      m_packetBuffer[3] = page;
+
+      if (!sendCommandCheckAck(m_packetBuffer, 4))
+        return false;
+
+      if (!waitForReady(1000))
+        {
+          if (m_pn532Debug)
+            cerr << __FUNCTION__ << ": Response never received" << endl;
+
+          return false;
+        }
+
+      readData(m_packetBuffer, 26);
+
+      if (m_packetBuffer[7] != 0x00)
+        {
+          if (m_mifareDebug)
+            {
+              fprintf(stderr, "Unexpected response reading page %d: \n",
+                      page);
+              PrintHexChar(m_packetBuffer, 26);
+            }
+
+          return false;
+        }
+
+      memcpy(buffer, m_packetBuffer+8, num * 4);
+
+      buffer += num * 4;
+      page += num;
+      count -= num;
+    }
+
+  return true;
+}
+
 /**************************************************************************/
 /*! 
   Tries to write an entire 4-byte page at the specified block
@@ -1221,6 +1688,8 @@ bool PN532::ntag2xx_ReadPage (uint8_t page, uint8_t * buffer)
 /**************************************************************************/
 bool PN532::ntag2xx_WritePage (uint8_t page, uint8_t * data)
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   // TAG Type       PAGES   USER START    USER STOP
   // --------       -----   ----------    ---------
   // NTAG 203       42      4             39
@@ -1238,18 +1707,18 @@ bool PN532::ntag2xx_WritePage (uint8_t page, uint8_t * data)
     fprintf(stderr, "Trying to write 4 byte page %d\n", page);
   
   /* Prepare the first command */
-  pn532_packetbuffer[0] = CMD_INDATAEXCHANGE;
-  pn532_packetbuffer[1] = 1;    /* Card number */
-  pn532_packetbuffer[2] = MIFARE_ULTRALIGHT_CMD_WRITE; /* Mifare
+  m_packetBuffer[0] = CMD_INDATAEXCHANGE;
+  m_packetBuffer[1] = 1;    /* Card number */
+  m_packetBuffer[2] = MIFARE_ULTRALIGHT_CMD_WRITE; /* Mifare
                                                           Ultralight
                                                           Write
                                                           command =
                                                           0xA2 */
-  pn532_packetbuffer[3] = page; /* Page Number (0..63 for most cases) */
-  memcpy (pn532_packetbuffer+4, data, 4); /* Data Payload */
+  m_packetBuffer[3] = page; /* Page Number (0..63 for most cases) */
+  memcpy (m_packetBuffer+4, data, 4); /* Data Payload */
 
   /* Send the command */
-  if (! sendCommandCheckAck(pn532_packetbuffer, 8))
+  if (! sendCommandCheckAck(m_packetBuffer, 8))
     {
       if (m_mifareDebug)
         cerr << __FUNCTION__ << ": Failed to receive ACK for write command"
@@ -1258,10 +1727,16 @@ bool PN532::ntag2xx_WritePage (uint8_t page, uint8_t * data)
       // Return Failed Signal
       return false;
     }  
-  usleep(10000);
+
+  if (!waitForReady(1000)) {
+    if (m_pn532Debug)
+      cerr << __FUNCTION__ << ": Response never received" << endl;
+
+    return false;
+  }
   
   /* Read the response packet */
-  readData(pn532_packetbuffer, 26);
+  readData(m_packetBuffer, 26);
  
   // Return OK Signal
   return true;
@@ -1285,6 +1760,8 @@ bool PN532::ntag2xx_WritePage (uint8_t page, uint8_t * data)
 bool PN532::ntag2xx_WriteNDEFURI (NDEF_URI_T uriIdentifier, char * url, 
                                   uint8_t dataLen)
 {
+  std::lock_guard<std::recursive_mutex> lock(m_cmdLock);
+
   uint8_t pageBuffer[4] = { 0, 0, 0, 0 };
   
   // Remove NDEF record overhead from the URI data (pageHeader below)
@@ -1399,6 +1876,8 @@ bool PN532::readAck()
 /**************************************************************************/
 bool PN532::isReady()
 {
+  std::lock_guard<std::mutex> lock(m_irqLock);
+
   // ALWAYS clear the m_irqRcvd flag if set.
   if (m_irqRcvd)
     {
@@ -1413,24 +1892,24 @@ bool PN532::isReady()
 /*! 
   @brief  Waits until the PN532 is ready.
 
-  @param  timeout   Timeout before giving up
+  @param  timeout   Timeout before giving up (in ms), 0 to wait forever
 */
 /**************************************************************************/
 bool PN532::waitForReady(uint16_t timeout)
 {
-  uint16_t timer = 0;
-  while(!isReady())
+  std::unique_lock<std::mutex> lock(m_irqLock);
+
+  // sleep until the IRQ handler signals us
+  if (timeout != 0)
     {
-      if (timeout != 0)
-        {
-          timer += 10;
-          if (timer > timeout)
-            {
-              return false;
-            }
-        }
-      usleep(10000);
+      if (!m_irqCond.wait_for(lock, std::chrono::milliseconds(timeout),
+                              [this] { return m_irqRcvd; }))
+        return false;
     }
+  else
+    m_irqCond.wait(lock, [this] { return m_irqRcvd; });
+
+  m_irqRcvd = false;
   return true;
 }
 
@@ -1448,7 +1927,6 @@ void PN532::readData(uint8_t* buff, uint8_t n)
   int rv;
 
   memset(buf, 0, n+2);
-  usleep(2000); 
 
   rv = m_i2c.read(buf, n + 2);
 
@@ -1485,6 +1963,9 @@ void PN532::writeCommand(uint8_t* cmd, uint8_t cmdlen)
 {
   // I2C command write.
 
+  // release the reset started by init(), if still pending
+  finishReset();
+
   cmdlen++;
 
   usleep(2000);     // 2ms max in case board needs to wake up
@@ -1537,13 +2018,18 @@ void PN532::dataReadyISR(void *ctx)
 {
   upm::PN532 *This = (upm::PN532 *)ctx;
 
-  // if debugging is enabled, indicate when an interrupt occurred, and
-  // a previously triggered interrupt was still set.
-  if (This->m_pn532Debug)
-    if (This->m_irqRcvd)
-      cerr << __FUNCTION__ << ": INFO: Unhandled IRQ detected." << endl;
+  {
+    std::lock_guard<std::mutex> lock(This->m_irqLock);
 
-  This->m_irqRcvd = true;
+    // if debugging is enabled, indicate when an interrupt occurred, and
+    // a previously triggered interrupt was still set.
+    if (This->m_pn532Debug)
+      if (This->m_irqRcvd)
+        cerr << __FUNCTION__ << ": INFO: Unhandled IRQ detected." << endl;
+
+    This->m_irqRcvd = true;
+  }
+  This->m_irqCond.notify_all();
 }
 
 PN532::TAG_TYPE_T PN532::tagType()
@@ -18,6 +18,11 @@
 
 #include <string.h>
 #include <string>
+#include <deque>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include <mraa/common.hpp>
 #include <mraa/i2c.hpp>
 
@@ -26,6 +31,8 @@
 #define PN532_I2C_BUS 0
 #define PN532_DEFAULT_I2C_ADDR (0x48 >> 1)
 
+#define PN532_PACKBUFFSIZ 64
+
 #define PN532_PREAMBLE                      (0x00)
 #define PN532_STARTCODE1                    (0x00)
 #define PN532_STARTCODE2                    (0xFF)
@@ -182,6 +189,26 @@ namespace upm {
       TAG_TYPE_NFC2                       = 2 /* ultralight or NTAG2XX */
     } TAG_TYPE_T;
 
+    /**
+     * Tag events reported in auto poll mode
+     */
+    typedef enum {
+      TAG_EVENT_NONE                      = 0, /* timeout, no event */
+      TAG_EVENT_ARRIVED                   = 1,
+      TAG_EVENT_DEPARTED                  = 2
+    } TAG_EVENT_T;
+
+    /**
+     * A tag arriving in, or departing from the field
+     */
+    typedef struct {
+      TAG_EVENT_T event;
+      uint8_t uid[7];         // ISO14443A uid
+      uint8_t uidLen;         // uid len, 4 or 7
+      uint16_t atqa;          // ATQA (SENS_RES)
+      uint8_t sak;            // SAK (SEL_RES)
+    } TAG_EVENT_INFO_T;
+
     /**
      * pn532 constructor
      *
@@ -199,7 +226,10 @@ namespace upm {
     ~PN532();
     
     /**
-     * set up initial values and start operation
+     * set up initial values and start operation.  This puts the
+     * chip into reset, which has to be held for 400ms.  Rather than
+     * sleeping here, the reset is released by the first command, so
+     * other devices can be set up in the meantime.
      *
      * @return true if successful
      */
@@ -244,7 +274,8 @@ namespace upm {
     bool setPassiveActivationRetries(uint8_t maxRetries);
  
     /**
-     *  waits for an ISO14443A target to enter the field
+     *  waits for an ISO14443A target to enter the field.  The
+     *  target is held, pausing startAutoPoll(), until releaseTarget().
      *
      * @param  cardbaudrate  baud rate of the card, one of the BAUD_T values
      * @param  uid Pointer to the array that will be populated with the
@@ -274,12 +305,57 @@ namespace upm {
 
     /**
      * 'InLists' a passive target. PN532 acting as reader/initiator,
-     * peer acting as card/responder.
+     * peer acting as card/responder.  The target is held, pausing
+     * startAutoPoll(), until releaseTarget().
      *     
      * @return true if everything executed properly, false for an error
      */
     bool inListPassiveTarget();
 
+    /**
+     * starts continuous card detection.  A background thread keeps
+     * issuing InAutoPoll commands for up to 2 ISO14443A targets
+     * (MaxTg=2), and queues a TAG_EVENT_ARRIVED event when a tag
+     * enters the field, and a TAG_EVENT_DEPARTED event when it has been
+     * missing from two consecutive polls.  Retrieve the events with
+     * getTagEvent().
+     *
+     * Each poll reactivates the tags in the field, so card operations
+     * (e.g. mifareclassic_ReadDataBlocks()) on a tag inlisted by a
+     * poll must authenticate again after the next poll.  To keep a
+     * target and its authentication across polls, inlist it with
+     * readPassiveTargetID() or inListPassiveTarget(): polling is
+     * paused while the application holds a target, until
+     * releaseTarget() is called.  Card operations are serialized with
+     * the polls, and may be issued from another thread.
+     *
+     * @param interval milliseconds to pause between polls
+     */
+    void startAutoPoll(int interval=50);
+
+    /**
+     * stops continuous card detection started with startAutoPoll()
+     */
+    void stopAutoPoll();
+
+    /**
+     * releases the targets inlisted with readPassiveTargetID() or
+     * inListPassiveTarget(), resuming the polls of startAutoPoll()
+     *
+     * @return true if everything executed properly, false for an error
+     */
+    bool releaseTarget();
+
+    /**
+     * removes the oldest event from the auto poll event queue, waiting
+     * for one if the queue is empty.  The queue holds up to 32 events,
+     * the oldest events are dropped on overflow.
+     *
+     * @param timeout milliseconds to wait, or -1 to wait forever
+     * @return the event, with event set to TAG_EVENT_NONE on timeout
+     */
+    TAG_EVENT_INFO_T getTagEvent(int timeout=-1);
+
     /**
      *  Indicates whether the specified block number is the first block
      *  in the sector (block 0 relative to the current sector)
@@ -330,6 +406,29 @@ namespace upm {
      */
     bool mifareclassic_ReadDataBlock (uint8_t blockNumber, uint8_t * data);
 
+    /**
+     *  reads a range of 16-byte data blocks, authenticating each
+     *  sector once with the given key before reading its blocks.  A
+     *  tag reported by the auto poll mode can be read in one call.
+     *
+     *  @param  uid           Pointer to a byte array containing the card UID
+     *  @param  uidLen        The length (in bytes) of the card's UID
+     *  @param  firstBlock    The first block to read
+     *  @param  count         Number of blocks to read
+     *  @param  keyNumber     Which key type to use during authentication
+     *  (0 = MIFARE_CMD_AUTH_A, 1 = MIFARE_CMD_AUTH_B)
+     *  @param  keyData       Pointer to a byte array containing the 6
+     *  byte key value
+     *  @param  data          Pointer to the byte array that will hold the
+     *  retrieved data, 16 * count bytes
+     *
+     *  @return true if everything executed properly, false for an error
+     */
+    bool mifareclassic_ReadDataBlocks (uint8_t * uid, uint8_t uidLen,
+                                       uint8_t firstBlock, uint8_t count,
+                                       uint8_t keyNumber, uint8_t * keyData,
+                                       uint8_t * data);
+
     /**
      *  tries to write an entire 16-byte data block at the specified block
      *  address.
@@ -380,6 +479,20 @@ namespace upm {
      */
     bool ntag2xx_ReadPage (uint8_t page, uint8_t * buffer);
 
+    /**
+     * read a range of 4-byte pages.  The READ command returns 4 pages
+     * at a time, so this takes a quarter of the commands of reading
+     * the pages one by one.
+     *
+     * @param  page        The first page number
+     * @param  count       Number of pages to read
+     * @param  buffer      Pointer to the byte array that will hold the
+     * retrieved data, 4 * count bytes
+     *
+     * @return true if everything executed properly, false for an error
+     */
+    bool ntag2xx_ReadPages (uint8_t page, uint8_t count, uint8_t * buffer);
+
     /**
      *  write an entire 4-byte page at the specified block address
      *
@@ -465,11 +578,38 @@ namespace upm {
     bool waitForReady(uint16_t timeout);
     void readData(uint8_t* buff, uint8_t n);
     void writeCommand(uint8_t* cmd, uint8_t cmdlen);
+    void finishReset();
 
   private:
     static void dataReadyISR(void *ctx);
     bool m_isrInstalled;
-    volatile bool m_irqRcvd;
+    bool m_irqRcvd;
+
+    // reset started by init(), released by the first command
+    bool m_resetPending;
+    std::chrono::steady_clock::time_point m_resetRelease;
+    std::mutex m_irqLock;
+    std::condition_variable m_irqCond;
+
+    // serializes commands between the auto poll thread and the API
+    std::recursive_mutex m_cmdLock;
+
+    // auto poll
+    bool autoPoll(TAG_EVENT_INFO_T *tags, int *numTags);
+    bool inRelease();
+    void autoPollThread(int interval);
+
+    std::thread m_pollThread;
+    bool m_pollRunning;
+    std::deque<TAG_EVENT_INFO_T> m_tagEvents;
+    std::mutex m_pollLock;
+    std::condition_variable m_pollCond;
+    std::condition_variable m_eventCond;
+    // a target inlisted by the application, polls are skipped
+    bool m_targetHeld;
+
+    // command and response frames, per device
+    uint8_t m_packetBuffer[PN532_PACKBUFFSIZ];
 
     uint8_t m_addr;
 
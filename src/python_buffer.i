@@ -0,0 +1,81 @@
+/* Zero-copy bulk read typemaps for Python
+ *
+ * Functions taking a (TYPE *buffer, size_t len) argument pair accept any
+ * writable, C-contiguous object supporting the buffer protocol (numpy
+ * arrays, bytearray, memoryview, array.array) with a matching element
+ * type.  The driver fills the object's memory in place, len is the
+ * number of elements it holds:
+ *
+ *     buf = numpy.empty(3 * 64, dtype=numpy.float32)
+ *     n = sensor.readBufferSamples(buf)
+ *
+ * The buffer stays exported (and can not be resized) for the duration of
+ * the call, so these typemaps are safe to combine with releasing the GIL:
+ *
+ *     #ifdef SWIGPYTHON
+ *     %module (package="upm", threads="1") foo
+ *     #endif
+ *     %nothread;
+ *     %thread upm::Foo::update;
+ *     %thread upm::Foo::readSamples;
+ */
+
+%{
+/* Check a buffer protocol format string against the struct module
+ * type codes in types.  Byte order prefixes are accepted if they
+ * match the native order. */
+static int _upm_buffer_format_ok(const char *format, const char *types)
+{
+    if (!format)
+        format = "B";
+
+    if (*format == '@' || *format == '=')
+        format++;
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    else if (*format == '<')
+        format++;
+#else
+    else if (*format == '>' || *format == '!')
+        format++;
+#endif
+
+    return (format[0] != '\0' && format[1] == '\0'
+            && strchr(types, format[0]) != NULL);
+}
+%}
+
+%define UPM_PYTHON_BUFFER(TYPE, TYPES)
+%typemap(in) (TYPE *buffer, size_t len) (Py_buffer view) {
+    if (PyObject_GetBuffer($input, &view,
+                           PyBUF_WRITABLE | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS))
+        SWIG_fail;
+
+    if (view.itemsize != sizeof(TYPE)
+        || !_upm_buffer_format_ok(view.format, TYPES))
+    {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_TypeError,
+                        "in method '$symname', expected a writable "
+                        "buffer of " #TYPE);
+        SWIG_fail;
+    }
+
+    $1 = (TYPE *) view.buf;
+    $2 = (size_t) (view.len / sizeof(TYPE));
+}
+
+%typemap(freearg) (TYPE *buffer, size_t len) {
+    if ($1)
+        PyBuffer_Release(&view$argnum);
+}
+
+%typemap(typecheck, precedence=SWIG_TYPECHECK_POINTER)
+    (TYPE *buffer, size_t len) {
+    $1 = PyObject_CheckBuffer($input) ? 1 : 0;
+}
+%enddef
+
+UPM_PYTHON_BUFFER(uint8_t, "Bbc")
+UPM_PYTHON_BUFFER(int16_t, "h")
+UPM_PYTHON_BUFFER(uint16_t, "H")
+UPM_PYTHON_BUFFER(float, "f")
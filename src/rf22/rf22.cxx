@@ -14,7 +14,9 @@
 
 #include <cstring>
 #include <cmath>
+#include <chrono>
 #include <sys/time.h>
+#include <unistd.h>
 #include "rf22.hpp"
 
 using namespace upm;
@@ -69,6 +71,14 @@ RF22::RF22(int spiBus, int slaveSelectPin, int interruptPin)
     _rxGood = 0;
     _rxBad = 0;
     _txGood = 0;
+    _bufLen = 0;
+    _txBufSentIndex = 0;
+    _rxBufLen = 0;
+    _rxHead = 0;
+    _rxCount = 0;
+    _rxDropped = 0;
+    _lastRssi = 0;
+    memset(_rxHeaders, 0, sizeof(_rxHeaders));
     
     //Initialize the SPI bus and pins, MRAA will log any failures here
     // start the SPI library:
@@ -88,6 +98,7 @@ RF22::RF22(int spiBus, int slaveSelectPin, int interruptPin)
 
 RF22::~RF22()
 {
+    mraa_gpio_isr_exit(_irq);
     mraa_spi_stop(_spi);
     mraa_gpio_close(_cs);
     mraa_gpio_close(_irq);
@@ -174,6 +185,8 @@ uint8_t RF22::init()
 // C++ level interrupt handler for this instance
 void RF22::handleInterrupt()
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
     uint8_t _lastInterruptFlags[2] = {};
     // Read the interrupt flags which clears the interrupt
     spiBurstRead(RF22_REG_03_INTERRUPT_STATUS1, _lastInterruptFlags, 2);
@@ -215,6 +228,7 @@ void RF22::handleInterrupt()
         // Could retransmit if we wanted
         // RF22 transitions automatically to Idle
         _mode = RF22_MODE_IDLE;
+        _cond.notify_all();
     }
     if (_lastInterruptFlags[0] & RF22_IPKVALID)
     {
@@ -225,7 +239,7 @@ void RF22::handleInterrupt()
         // First make sure we dont overflow the buffer in the case of a stupid length
         // or partial bad receives
         if (   len >  RF22_MAX_MESSAGE_LEN
-            || len < _bufLen)
+            || len < _rxBufLen)
         {
             _rxBad++;
             _mode = RF22_MODE_IDLE;
@@ -233,11 +247,36 @@ void RF22::handleInterrupt()
             return; // Hmmm receiver buffer overflow. 
         }
 
-        spiBurstRead(RF22_REG_7F_FIFO_ACCESS, _buf + _bufLen, len - _bufLen);
+        spiBurstRead(RF22_REG_7F_FIFO_ACCESS, _rxBuf + _rxBufLen, len - _rxBufLen);
         _rxGood++;
-        _bufLen = len;
+        _rxBufLen = len;
+
+        if (_rxCount < RF22_RX_QUEUE_LEN)
+        {
+            RxPacket& packet = _rxQueue[(_rxHead + _rxCount) % RF22_RX_QUEUE_LEN];
+            uint8_t headers[4];
+
+            // The received headers are consecutive, so one burst gets them all
+            spiBurstRead(RF22_REG_47_RECEIVED_HEADER3, headers, sizeof(headers));
+            memcpy(packet.data, _rxBuf, len);
+            packet.len = len;
+            packet.headerTo = headers[0];
+            packet.headerFrom = headers[1];
+            packet.headerId = headers[2];
+            packet.headerFlags = headers[3];
+            packet.rssi = _lastRssi;
+            packet.timestamp = getTimestamp();
+            _rxCount++;
+        }
+        else
+            _rxDropped++;
+
+        // The RF22 goes idle after a packet, restart the receiver so
+        // messages keep being queued without waiting for the consumer
+        clearRxBuf();
         _mode = RF22_MODE_IDLE;
-        _rxBufValid = true;
+        setModeRx();
+        _cond.notify_all();
     }
     if (_lastInterruptFlags[0] & RF22_ICRCERROR)
     {
@@ -257,7 +296,14 @@ void RF22::handleInterrupt()
 void RF22::isr(void* args)
 {
     RF22* This = (RF22*)(args);
-    This->handleInterrupt();
+
+    // nIRQ stays low while any enabled interrupt is pending. Keep servicing
+    // until it is released, as edges that arrive while the handler runs
+    // are not seen.
+    int passes = 0;
+    do
+        This->handleInterrupt();
+    while (mraa_gpio_read(This->_irq) == 0 && ++passes < 8);
 }
 
 void RF22::reset()
@@ -279,44 +325,36 @@ void RF22::spiWrite(uint8_t reg, uint8_t val)
     spiBurstWrite (reg, &val, 1);
 }
 
+// The whole burst, register address and data, goes out in a single SPI
+// transfer, from buffers on the stack. The GPIO chip select is slow enough
+// to meet the setup and hold times without extra delays.
 void RF22::spiBurstRead(uint8_t reg, uint8_t* dest, uint8_t len)
 {
-    uint8_t *request = new uint8_t[len + 1]();
-    uint8_t *response = new uint8_t[len + 1]();
+    uint8_t request[256] = {};
+    uint8_t response[256];
 
     request[0] = reg & ~RF22_SPI_WRITE_MASK;
-    memcpy (&request[1], dest, len);
 
-    mraa_gpio_write(_cs, 0x1);
+    std::lock_guard<std::recursive_mutex> lock(_lock);
     mraa_gpio_write(_cs, 0x0);
-    usleep(100);
     mraa_spi_transfer_buf(_spi, request, response, len + 1);
-    usleep(100);
     mraa_gpio_write(_cs, 0x1);
 
     memcpy (dest, &response[1], len);
-
-    delete[] request;
-    delete[] response;
 }
 
 void RF22::spiBurstWrite(uint8_t reg, const uint8_t* src, uint8_t len)
 {
-    uint8_t *request = new uint8_t[len + 1]();
-    uint8_t *response = new uint8_t[len + 1]();
+    uint8_t request[256];
+    uint8_t response[256];
 
     request[0] = reg | RF22_SPI_WRITE_MASK;
     memcpy (&request[1], src, len);
 
-    mraa_gpio_write(_cs, 0x1);
+    std::lock_guard<std::recursive_mutex> lock(_lock);
     mraa_gpio_write(_cs, 0x0);
-    usleep(100);
     mraa_spi_transfer_buf(_spi, request, response, len + 1);
-    usleep(100);
     mraa_gpio_write(_cs, 0x1);
-
-    delete[] request;
-    delete[] response;
 }
 
 uint8_t RF22::statusRead()
@@ -333,10 +371,15 @@ uint8_t RF22::adcRead(uint8_t adcsel,
     spiWrite(RF22_REG_0F_ADC_CONFIGURATION, configuration | RF22_ADCSTART);
     spiWrite(RF22_REG_10_ADC_SENSOR_AMP_OFFSET, adcoffs);
 
-    // Conversion time is nominally 305usec
-    // Wait for the DONE bit
-    while (!(spiRead(RF22_REG_0F_ADC_CONFIGURATION) & RF22_ADCDONE))
-    ;
+    // Conversion time is nominally 305usec, sleep through it rather than
+    // hammering the bus, then wait for the DONE bit
+    usleep(305);
+    for (int i = 0; i < 100; i++)
+    {
+        if (spiRead(RF22_REG_0F_ADC_CONFIGURATION) & RF22_ADCDONE)
+            break;
+        usleep(10);
+    }
     // Return the value  
     return spiRead(RF22_REG_11_ADC_VALUE);
 }
@@ -438,6 +481,7 @@ void RF22::setMode(uint8_t mode)
 
 void RF22::setModeIdle()
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
     if (_mode != RF22_MODE_IDLE)
     {
         setMode(_idleMode);
@@ -447,6 +491,7 @@ void RF22::setModeIdle()
 
 void RF22::setModeRx()
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
     if (_mode != RF22_MODE_RX)
     {
         setMode(_idleMode | RF22_RXON);
@@ -456,6 +501,7 @@ void RF22::setModeRx()
 
 void RF22::setModeTx()
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
     if (_mode != RF22_MODE_TX)
     {
         setMode(_idleMode | RF22_TXON);
@@ -519,44 +565,38 @@ void RF22::setSyncWords(const uint8_t* syncWords, uint8_t len)
 
 void RF22::clearRxBuf()
 {
-    _bufLen = 0;
-    _rxBufValid = false;
+    _rxBufLen = 0;
 }
 
 uint8_t RF22::available()
 {
-    if (!_rxBufValid)
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    if (_mode != RF22_MODE_TX)
     setModeRx(); // Make sure we are receiving
-    return _rxBufValid;
+    return _rxCount > 0;
 }
 
 // Blocks until a valid message is received
 void RF22::waitAvailable()
 {
-    while (!available())
-    ;
+    std::unique_lock<std::recursive_mutex> lock(_lock);
+    _cond.wait(lock, [this] { return available(); });
 }
 
 // Blocks until a valid message is received or timeout expires
 // Return true if there is a message available
 bool RF22::waitAvailableTimeout(unsigned long timeout)
 {
-    unsigned long endtime = getTimestamp() + timeout;
-    unsigned long currenttime = getTimestamp();
-    while (currenttime < endtime) {
-        currenttime = getTimestamp();
-        if (available()) {
-            return true;
-        }
-    }
-        
-    return false;
+    std::unique_lock<std::recursive_mutex> lock(_lock);
+    return _cond.wait_for(lock, std::chrono::microseconds(timeout),
+                          [this] { return available(); });
 }
 
 void RF22::waitPacketSent()
 {
-    while (_mode == RF22_MODE_TX)
-    ; // Wait for any previous transmit to finish
+    // Wait for any previous transmit to finish
+    std::unique_lock<std::recursive_mutex> lock(_lock);
+    _cond.wait(lock, [this] { return _mode != RF22_MODE_TX; });
 }
 
 // Diagnostic help
@@ -566,16 +606,53 @@ void RF22::printBuffer(const char* prompt, const uint8_t* buf, uint8_t len)
 
 uint8_t RF22::recv(uint8_t* buf, uint8_t* len)
 {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
     if (!available())
         return false;
 
-    if (*len > _bufLen)
-        *len = _bufLen;
-    memcpy(buf, _buf, *len);
-    clearRxBuf();
+    RxPacket& packet = _rxQueue[_rxHead];
+    if (*len > packet.len)
+        *len = packet.len;
+    memcpy(buf, packet.data, *len);
+    _rxHeaders[0] = packet.headerTo;
+    _rxHeaders[1] = packet.headerFrom;
+    _rxHeaders[2] = packet.headerId;
+    _rxHeaders[3] = packet.headerFlags;
+
+    _rxHead = (_rxHead + 1) % RF22_RX_QUEUE_LEN;
+    _rxCount--;
     return true;
 }
 
+bool RF22::recvPacket(RxPacket& packet)
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    if (!available())
+        return false;
+
+    packet = _rxQueue[_rxHead];
+    _rxHeaders[0] = packet.headerTo;
+    _rxHeaders[1] = packet.headerFrom;
+    _rxHeaders[2] = packet.headerId;
+    _rxHeaders[3] = packet.headerFlags;
+
+    _rxHead = (_rxHead + 1) % RF22_RX_QUEUE_LEN;
+    _rxCount--;
+    return true;
+}
+
+uint8_t RF22::rxQueued()
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    return _rxCount;
+}
+
+uint16_t RF22::rxDropped()
+{
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    return _rxDropped;
+}
+
 void RF22::clearTxBuf()
 {
     _bufLen = 0;
@@ -584,7 +661,8 @@ void RF22::clearTxBuf()
 
 void RF22::startTransmit()
 {
-    sendNextFragment(); // Actually the first fragment
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+    sendNextFragment(RF22_FIFO_SIZE); // Actually the first fragment, into an empty FIFO
     spiWrite(RF22_REG_3E_PACKET_LENGTH, _bufLen); // Total length that will be sent
     setModeTx(); // Start the transmitter, turns off the receiver
 }
@@ -601,6 +679,7 @@ uint8_t RF22::send(const uint8_t* data, uint8_t len)
 {
     waitPacketSent();
 
+    std::lock_guard<std::recursive_mutex> lock(_lock);
     if (!fillTxBuf(data, len))
         return false;
     startTransmit();
@@ -627,16 +706,16 @@ uint8_t RF22::appendTxBuf(const uint8_t* data, uint8_t len)
     return true;
 }
 
-// Assumption: there is currently <= RF22_TXFFAEM_THRESHOLD bytes in the Tx FIFO
-void RF22::sendNextFragment()
+// Assumption: there is currently <= RF22_FIFO_SIZE - room bytes in the Tx FIFO
+void RF22::sendNextFragment(uint8_t room)
 {
     if (_txBufSentIndex < _bufLen)
     {
     // Some left to send?
     uint8_t len = _bufLen - _txBufSentIndex;
     // But dont send too much
-    if (len > (RF22_FIFO_SIZE - RF22_TXFFAEM_THRESHOLD - 1))
-        len = (RF22_FIFO_SIZE - RF22_TXFFAEM_THRESHOLD - 1);
+    if (len > room)
+        len = room;
     spiBurstWrite(RF22_REG_7F_FIFO_ACCESS, _buf + _txBufSentIndex, len);
     _txBufSentIndex += len;
     }
@@ -646,12 +725,12 @@ void RF22::sendNextFragment()
 // That means it should only be called after a RXFFAFULL interrupt
 void RF22::readNextFragment()
 {
-    if (((uint16_t)_bufLen + RF22_RXFFAFULL_THRESHOLD) > RF22_MAX_MESSAGE_LEN)
+    if (((uint16_t)_rxBufLen + RF22_RXFFAFULL_THRESHOLD) > RF22_MAX_MESSAGE_LEN)
     return; // Hmmm receiver overflow. Should never occur
 
     // Read the RF22_RXFFAFULL_THRESHOLD octets that should be there
-    spiBurstRead(RF22_REG_7F_FIFO_ACCESS, _buf + _bufLen, RF22_RXFFAFULL_THRESHOLD);
-    _bufLen += RF22_RXFFAFULL_THRESHOLD;
+    spiBurstRead(RF22_REG_7F_FIFO_ACCESS, _rxBuf + _rxBufLen, RF22_RXFFAFULL_THRESHOLD);
+    _rxBufLen += RF22_RXFFAFULL_THRESHOLD;
 }
 
 // Clear the FIFOs
@@ -707,22 +786,22 @@ void RF22::setHeaderFlags(uint8_t flags)
 
 uint8_t RF22::headerTo()
 {
-    return spiRead(RF22_REG_47_RECEIVED_HEADER3);
+    return _rxHeaders[0];
 }
 
 uint8_t RF22::headerFrom()
 {
-    return spiRead(RF22_REG_48_RECEIVED_HEADER2);
+    return _rxHeaders[1];
 }
 
 uint8_t RF22::headerId()
 {
-    return spiRead(RF22_REG_49_RECEIVED_HEADER1);
+    return _rxHeaders[2];
 }
 
 uint8_t RF22::headerFlags()
 {
-    return spiRead(RF22_REG_4A_RECEIVED_HEADER0);
+    return _rxHeaders[3];
 }
 
 uint8_t RF22::lastRssi()
@@ -17,6 +17,9 @@
 #include <stdint.h>
 #include <mraa.h>
 
+#include <mutex>
+#include <condition_variable>
+
 // This is the bit in the SPI address that marks it as a write
 #define RF22_SPI_WRITE_MASK 0x80
 
@@ -27,8 +30,13 @@
 // Rx FIFO during reception
 // Can be pre-defined to a smaller size (to save SRAM) prior to including this header
 #ifndef RF22_MAX_MESSAGE_LEN
-//#define RF22_MAX_MESSAGE_LEN 255
-#define RF22_MAX_MESSAGE_LEN 64
+#define RF22_MAX_MESSAGE_LEN 255
+#endif
+
+// Number of received messages that are queued until recv() or recvPacket()
+// picks them up. Messages arriving while the queue is full are dropped.
+#ifndef RF22_RX_QUEUE_LEN
+#define RF22_RX_QUEUE_LEN 8
 #endif
 
 // Max number of octets the RF22 Rx and Tx FIFOs can hold
@@ -39,9 +47,11 @@
 #define RF22_MODE_RX           1
 #define RF22_MODE_TX           2
 
-// These values we set for FIFO thresholds are actually the same as the POR values
-#define RF22_TXFFAEM_THRESHOLD 4
-#define RF22_RXFFAFULL_THRESHOLD 55
+// FIFO thresholds. Unlike the POR values (4 and 55) these leave half the FIFO
+// as slack, which covers the interrupt latency of a Linux user space handler
+// at the higher data rates
+#define RF22_TXFFAEM_THRESHOLD 32
+#define RF22_RXFFAFULL_THRESHOLD 32
 
 // This is the default node address,
 #define RF22_DEFAULT_NODE_ADDRESS 0
@@ -498,6 +508,21 @@ public:
     OOK_Rb40Bw335        ///< OOK, No Manchester, Rb = 40kbs,   Rx Bandwidth = 335kHz
     } ModemConfigChoice;
 
+    /**
+     * @brief A received message, as queued by the interrupt handler
+     */
+    typedef struct
+    {
+    uint8_t    data[RF22_MAX_MESSAGE_LEN]; ///< Message data
+    uint8_t    len;          ///< Number of octets in data
+    uint8_t    headerTo;     ///< TO header
+    uint8_t    headerFrom;   ///< FROM header
+    uint8_t    headerId;     ///< ID header
+    uint8_t    headerFlags;  ///< FLAGS header
+    uint8_t    rssi;         ///< RSSI, measured when the preamble was received
+    uint64_t   timestamp;    ///< Time of reception, gettimeofday() in microseconds
+    } RxPacket;
+
     /**
      * Constructor. You can have multiple instances, but each instance must have its own
      * interrupt and slave select pin. After constructing, you must call init() to initialize the interface
@@ -707,7 +732,9 @@ public:
 
     /**
      * Starts the receiver and checks whether a received message is available.
-     * This can be called multiple times in a timeout loop
+     * This can be called multiple times in a timeout loop.
+     * Once started, the receiver stays on, and the interrupt handler queues
+     * up to RF22_RX_QUEUE_LEN messages.
      * @return true if a complete, valid message has been received and is able to be retrieved by
      * recv()
      */
@@ -721,7 +748,7 @@ public:
 
     /**
      * Starts the receiver and blocks until a received message is available or a timeout
-     * @param[in] timeout Maximum time to wait in milliseconds.
+     * @param[in] timeout Maximum time to wait in microseconds.
      * @return true if a message is available
      */
     bool           waitAvailableTimeout(unsigned long timeout);
@@ -739,6 +766,29 @@ public:
      */
     uint8_t        recv(uint8_t* buf, uint8_t* len);
 
+    /**
+     * Turns the receiver on if it not already on, and takes the oldest
+     * message from the receive queue, if any, without blocking.
+     * Unlike recv(), this returns the headers, RSSI and time of reception
+     * of the message as well.
+     * @param[out] packet Set to the received message
+     * @return true if a message was taken from the queue
+     */
+    bool           recvPacket(RxPacket& packet);
+
+    /**
+     * Returns the number of received messages waiting in the queue
+     * @return Number of queued messages
+     */
+    uint8_t        rxQueued();
+
+    /**
+     * Returns the number of valid messages that were dropped because
+     * the receive queue was full
+     * @return Number of dropped messages
+     */
+    uint16_t       rxDropped();
+
     /**
      * Waits until any previous transmit packet is finished being transmitted with waitPacketSent().
      * Then loads a message into the transmitter and starts the transmitter. Note that a message length
@@ -763,25 +813,25 @@ public:
     void           setPromiscuous(uint8_t promiscuous);
 
     /**
-     * Returns the TO header of the last received message
+     * Returns the TO header of the last message returned by recv()
      * @return The TO header
      */
     uint8_t        headerTo();
 
     /**
-     * Returns the FROM header of the last received message
+     * Returns the FROM header of the last message returned by recv()
      * @return The FROM header
      */
     uint8_t        headerFrom();
 
     /**
-     * Returns the ID header of the last received message
+     * Returns the ID header of the last message returned by recv()
      * @return The ID header
      */
     uint8_t        headerId();
 
     /**
-     * Returns the FLAGS header of the last received message
+     * Returns the FLAGS header of the last message returned by recv()
      * @return The FLAGS header
      */
     uint8_t        headerFlags();
@@ -826,7 +876,8 @@ public:
 protected:
     /**
      * This is a low level function to handle the interrupts for one instance of RF22.
-     * Called automatically when interrupt pin goes low, should not need to be called by user.
+     * Called automatically from the interrupt thread when interrupt pin goes low,
+     * should not need to be called by user.
      */
     void           handleInterrupt();
 
@@ -862,8 +913,9 @@ protected:
      * Internal function to load the next fragment of 
      * the current message into the transmitter FIFO
      * Internal use only
+     * @param[in] room Number of octets that may be loaded
      */
-    void           sendNextFragment();
+    void           sendNextFragment(uint8_t room = RF22_FIFO_SIZE - RF22_TXFFAEM_THRESHOLD - 1);
 
     /**
      * Function to copy the next fragment from 
@@ -957,13 +1009,30 @@ private:
     uint8_t             _idleMode;
     uint8_t             _deviceType;
 
-    // These volatile members may get changed in the interrupt service routine
+    // Serializes SPI transfers and the state shared with the
+    // interrupt thread
+    std::recursive_mutex          _lock;
+    // Signalled by the interrupt thread when a message was sent or received
+    std::condition_variable_any   _cond;
+
+    // Message being transmitted
     volatile uint8_t    _bufLen;
     uint8_t             _buf[RF22_MAX_MESSAGE_LEN];
-
-    volatile uint8_t    _rxBufValid;
     volatile uint8_t    _txBufSentIndex;
-  
+
+    // Message being received
+    volatile uint8_t    _rxBufLen;
+    uint8_t             _rxBuf[RF22_MAX_MESSAGE_LEN];
+
+    // Received messages, oldest at _rxHead
+    RxPacket            _rxQueue[RF22_RX_QUEUE_LEN];
+    volatile uint8_t    _rxHead;
+    volatile uint8_t    _rxCount;
+    volatile uint16_t   _rxDropped;
+
+    // Headers of the last message returned by recv()
+    uint8_t             _rxHeaders[4];
+
     volatile uint16_t   _rxBad;
     volatile uint16_t   _rxGood;
     volatile uint16_t   _txGood;
@@ -7,9 +7,26 @@
 #endif
 
 %include "arrays_java.i"
+%include "../java_buffer.i"
 %apply uint8_t *INOUT { uint8_t* len };
 %apply signed char[] {uint8_t*};
 
+/* ByteBuffer overloads of send() and recv() */
+%extend upm::RF22 {
+    uint8_t send(uint8_t *buffer, size_t len) {
+        if (len > RF22_MAX_MESSAGE_LEN)
+            throw std::invalid_argument("send: message too long");
+        return $self->send(buffer, (uint8_t) len);
+    }
+
+    int recv(uint8_t *buffer, size_t len) {
+        uint8_t n = (len > RF22_MAX_MESSAGE_LEN) ? RF22_MAX_MESSAGE_LEN : len;
+        if (!$self->recv(buffer, &n))
+            return -1;
+        return n;
+    }
+}
+
 JAVA_JNI_LOADLIBRARY(javaupm_rf22)
 #endif
 /* END Java syntax */
@@ -36,6 +36,7 @@ rsc_context rsc_init(int bus, int cs_ee_pin, int cs_adc_pin) {
     }
 
     dev->spi_bus_number = bus;
+    dev->settling = false;
 
     dev->spi = mraa_spi_init(dev->spi_bus_number);
     if(dev->spi == NULL)
@@ -103,11 +104,22 @@ rsc_context rsc_init(int bus, int cs_ee_pin, int cs_adc_pin) {
     rsc_set_mode(dev, NORMAL_MODE);
 
     rsc_get_temperature(dev);
-    upm_delay_ms(50);
+
+    // let the ADC settle, but wait for that in the first read rather
+    // than here
+    dev->ready = upm_clock_deadline_us(50000);
+    dev->settling = true;
 
     return dev;
 }
 
+static void _wait_ready(rsc_context dev) {
+    if(dev->settling) {
+        upm_delay_until_ns(&dev->ready, 0);
+        dev->settling = false;
+    }
+}
+
 upm_result_t rsc_close(rsc_context dev) {
     free(dev);
     return UPM_SUCCESS;
@@ -374,6 +386,8 @@ upm_result_t rsc_set_mode(rsc_context dev, RSC_MODE mode) {
 }
 
 upm_result_t rsc_adc_read(rsc_context dev, READING_T type, uint8_t* data) { 
+    _wait_ready(dev);
+
     uint8_t tx[2]={0};
     tx[0] = RSC_ADC_WREG|((1<<2)&RSC_ADC_REG_MASK);
 
@@ -17,6 +17,7 @@
 #include <string.h>
 
 #include "upm.h"
+#include "upm_utilities.h"
 #include "mraa/spi.h"
 #include "mraa/gpio.h"
 
@@ -49,6 +50,9 @@ typedef struct _rsc_context {
     RSC_DATA_RATE          data_rate;
     RSC_MODE               mode;
     uint16_t               t_raw;
+    // the ADC is not to be accessed before ready, if settling
+    bool                   settling;
+    upm_clock_t            ready;
 } *rsc_context;
 
 /**
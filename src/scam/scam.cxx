@@ -23,6 +23,45 @@ using namespace std;
 
 static const int maxRetries = 100;
 
+// Baud rates supported by the camera, fastest first.  The camera
+// derives its rate from a 3.6864MHz clock, divided by (div1 + 1) *
+// (div2 + 1).
+struct baudEntry {
+  unsigned int baud;
+  speed_t speed;
+  uint8_t div1;
+  uint8_t div2;
+};
+
+static const baudEntry baudTable[] = {
+  { 921600, B921600, 0x01, 0x01 },
+  { 460800, B460800, 0x03, 0x01 },
+  { 230400, B230400, 0x07, 0x01 },
+  { 115200, B115200, 0x0f, 0x01 },
+  { 57600,  B57600,  0x1f, 0x01 },
+};
+
+static const unsigned int baudTableLen =
+  sizeof(baudTable) / sizeof(baudTable[0]);
+
+static const baudEntry *findBaud(unsigned int baud)
+{
+  for (unsigned int i = 0; i < baudTableLen; i++)
+    if (baudTable[i].baud == baud)
+      return &baudTable[i];
+
+  return NULL;
+}
+
+static const baudEntry *findSpeed(speed_t speed)
+{
+  for (unsigned int i = 0; i < baudTableLen; i++)
+    if (baudTable[i].speed == speed)
+      return &baudTable[i];
+
+  return NULL;
+}
+
 SCAM::SCAM(int uart, uint8_t camAddr)
 {
   m_ttyFd = -1;
@@ -31,6 +70,8 @@ SCAM::SCAM(int uart, uint8_t camAddr)
   m_camAddr = (camAddr << 5);
 
   m_picTotalLen = 0;
+  m_pktLen = MAX_PKT_LEN;
+  m_baud = 0;
 
   if ( !(m_uart = mraa_uart_init(uart)) )
     {
@@ -166,6 +207,9 @@ bool SCAM::setupTty(speed_t baud)
       return false;
     }
 
+  const baudEntry *entry = findSpeed(baud);
+  m_baud = (entry) ? entry->baud : 0;
+
   return true;
 }
 
@@ -177,29 +221,25 @@ void SCAM::drainInput()
     readData(&ch, 1);
 }
 
-bool SCAM::init()
+bool SCAM::sync(int retries)
 {
   const unsigned int pktLen = 6;
   uint8_t cmd[pktLen] = {0xaa, static_cast<uint8_t>(0x0d|m_camAddr), 0x00,
                          0x00, 0x00, 0x00};
   uint8_t resp[pktLen];
-  int retries = 0;
+  int tries = 0;
 
   while (true)
     {
-      if (retries++ > maxRetries)
-        {
-          throw std::runtime_error(std::string(__FUNCTION__) +
-                                   ": maximum retries exceeded");
-          return false;
-        }
+      if (tries++ > retries)
+        return false;
 
       writeData(cmd, pktLen);
 
       if (!dataAvailable(500))
         continue;
 
-      if (readData(resp, pktLen) != pktLen)
+      if (!readFully(resp, pktLen, 100))
         continue;
 
       if (resp[0] == 0xaa 
@@ -208,7 +248,7 @@ bool SCAM::init()
           && resp[4] == 0 
           && resp[5] == 0)
         {
-          if (readData(resp, pktLen) != pktLen)
+          if (!readFully(resp, pktLen, 100))
             continue;
           else
             {
@@ -230,6 +270,18 @@ bool SCAM::init()
   return true;
 }
 
+bool SCAM::init()
+{
+  if (!sync(maxRetries))
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": maximum retries exceeded");
+      return false;
+    }
+
+  return true;
+}
+
 bool SCAM::preCapture(PIC_FORMATS_T fmt)
 {
   const unsigned int pktLen = 6;
@@ -270,48 +322,20 @@ bool SCAM::preCapture(PIC_FORMATS_T fmt)
 bool SCAM::doCapture()
 {
   const unsigned int pktLen = 6;
-  uint8_t cmd[pktLen] = { 0xaa, static_cast<uint8_t>(0x06 | m_camAddr), 0x08,
-                          static_cast<uint8_t>(MAX_PKT_LEN & 0xff),
-                          static_cast<uint8_t>((MAX_PKT_LEN >> 8)) & 0xff, 0};
+  uint8_t cmd[pktLen] = { 0xaa, static_cast<uint8_t>(0x05 | m_camAddr), 0x00,
+                          0x00, 0x00, 0x00 };
   uint8_t resp[pktLen];
   int retries = 0;
   
   m_picTotalLen = 0;
 
-  while (true)
+  if (!setPacketSizeCmd(m_pktLen, maxRetries))
     {
-      if (retries++ > maxRetries)
-        {
-          throw std::runtime_error(std::string(__FUNCTION__) +
-                                   ": maximum retries exceeded");
-          return false;
-        }
-
-      drainInput();
-      writeData(cmd, pktLen);
-      usleep(100000);
-
-      if (!dataAvailable(100))
-        continue;
-
-      if (readData(resp, pktLen) != pktLen)
-        continue;
-
-      if (resp[0] == 0xaa 
-          && resp[1] == (0x0e | m_camAddr) 
-          && resp[2] == 0x06 
-          && resp[4] == 0 
-          && resp[5] == 0)
-        break;
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                               ": maximum retries exceeded");
+      return false;
     }
 
-  cmd[1] = 0x05 | m_camAddr;
-  cmd[2] = 0;
-  cmd[3] = 0;
-  cmd[4] = 0;
-  cmd[5] = 0;
-
-  retries = 0;
   while (true)
     {
       if (retries++ > maxRetries)
@@ -378,6 +402,30 @@ bool SCAM::doCapture()
   return true;
 }
 
+static bool writeFileCB(const uint8_t *data, int len, void *arg)
+{
+  return (fwrite(data, len, 1, (FILE *)arg) == 1);
+}
+
+struct bufferSink {
+  uint8_t *buffer;
+  int len;
+  int offset;
+};
+
+static bool copyBufferCB(const uint8_t *data, int len, void *arg)
+{
+  bufferSink *sink = (bufferSink *)arg;
+
+  if (sink->offset + len > sink->len)
+    return false;
+
+  memcpy(sink->buffer + sink->offset, data, len);
+  sink->offset += len;
+
+  return true;
+}
+
 bool SCAM::storeImage(const char *fname)
 {
   if (!fname)
@@ -404,74 +452,325 @@ bool SCAM::storeImage(const char *fname)
                                string(strerror(errno)));
       return false;
     }
-  
-  /// let the games begin...
+
+  int picLen = m_picTotalLen;
+  int rv;
+
+  try
+    {
+      rv = fetchImage(writeFileCB, file);
+    }
+  catch (...)
+    {
+      fclose(file);
+      throw;
+    }
+
+  fclose(file);
+
+  return (rv == picLen);
+}
+
+int SCAM::captureImage(uint8_t *buffer, int len)
+{
+  if (!buffer)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": buffer is NULL");
+      return 0;
+    }
+
+  if (len < m_picTotalLen)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": buffer is smaller than the image size");
+      return 0;
+    }
+
+  bufferSink sink = { buffer, len, 0 };
+
+  return fetchImage(copyBufferCB, &sink);
+}
+
+int SCAM::captureImage(IMAGE_DATA_CB_T cb, void *arg)
+{
+  if (!cb)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": callback is NULL");
+      return 0;
+    }
+
+  return fetchImage(cb, arg);
+}
+
+bool SCAM::readFully(uint8_t *buffer, int len, unsigned int millis)
+{
+  int got = 0;
+
+  while (got < len)
+    {
+      if (!dataAvailable(millis))
+        return false;
+
+      int rv = readData(buffer + got, len - got);
+      if (rv <= 0)
+        return false;
+
+      got += rv;
+    }
+
+  return true;
+}
+
+void SCAM::requestPacket(unsigned int id)
+{
   const unsigned int pktLen = 6;
-  unsigned int pktCnt = (m_picTotalLen) / (MAX_PKT_LEN - 6);
-  if ((m_picTotalLen % (MAX_PKT_LEN-6)) != 0) 
+  uint8_t cmd[pktLen] = { 0xaa, static_cast<uint8_t>(0x0e | m_camAddr), 0x00,
+                          0x00, static_cast<uint8_t>(id & 0xff),
+                          static_cast<uint8_t>((id >> 8) & 0xff) };
+
+  writeData(cmd, pktLen);
+}
+
+int SCAM::fetchImage(IMAGE_DATA_CB_T cb, void *arg)
+{
+  if (!m_picTotalLen)
+    {
+      throw std::runtime_error(std::string(__FUNCTION__) +
+                    ": Picture length is zero, you need to capture first.");
+
+      return 0;
+    }
+
+  /// let the games begin...
+  const unsigned int dataLen = m_pktLen - 6;
+  unsigned int pktCnt = (m_picTotalLen) / dataLen;
+  if ((m_picTotalLen % dataLen) != 0) 
     pktCnt += 1;
   
-  uint8_t cmd[pktLen] = { 0xaa, static_cast<uint8_t>(0x0e | m_camAddr), 0x00,
-                          0x00, 0x00, 0x00 };
-  uint8_t pkt[MAX_PKT_LEN];
+  uint8_t pkt[MAX_SUPPORTED_PKT_LEN];
   int retries = 0;
-  
-  for (unsigned int i = 0; i < pktCnt; i++)
+  int total = 0;
+  bool aborted = false;
+
+  drainInput();
+  requestPacket(0);
+
+  for (unsigned int i = 0; i < pktCnt; )
     {
-      cmd[4] = i & 0xff;
-      cmd[5] = (i >> 8) & 0xff;
-      
-      retries = 0;
+      // every packet but the last one is full
+      int cnt = m_picTotalLen - (i * dataLen);
+      if (cnt > (int)dataLen)
+        cnt = dataLen;
 
-    retry:
+      // packet is ID (2), size (2), data (cnt) and checksum (2)
+      bool valid = readFully(pkt, cnt + 6, 1000);
 
-      usleep(10000);
+      if (valid)
+        {
+          unsigned int id = pkt[0] | (pkt[1] << 8);
+          int size = pkt[2] | (pkt[3] << 8);
 
-      drainInput();
-      writeData(cmd, pktLen);
+          valid = (id == i && size == cnt);
+        }
 
-      if (!dataAvailable(1000))
+      if (valid)
         {
-          if (retries++ > maxRetries)
+          unsigned char sum = 0;
+          for (int y = 0; y < cnt + 4; y++)
             {
-              throw std::runtime_error(std::string(__FUNCTION__) +
-                                       ": timeout, maximum retries exceeded");
-              return false;
+              sum += pkt[y];
             }
-          goto retry;
+          valid = (sum == pkt[cnt + 4]);
         }
 
-      uint16_t cnt = readData(pkt, MAX_PKT_LEN);
-      
-      unsigned char sum = 0;
-      for (int y = 0; y < cnt - 2; y++)
-        {
-          sum += pkt[y];
-        }
-      if (sum != pkt[cnt-2])
+      if (!valid)
         {
-          if (retries++ <= maxRetries)
-            goto retry;
-          else
+          if (retries++ > maxRetries)
             {
-              fclose(file);
+              endTransfer(true);
               throw std::runtime_error(std::string(__FUNCTION__) +
-                                       ": cksum error, maximum retries exceeded");
-              return false;
+                                       ": maximum retries exceeded");
+              return total;
             }
+
+          // let the camera finish whatever it was sending, then ask again
+          usleep(10000);
+          drainInput();
+          requestPacket(i);
+          continue;
         }
 
-      fwrite((const uint8_t *)&pkt[4], cnt - 6, 1, file);
+      // request the next packet before handing this one off, so the
+      // camera is sending while the caller consumes the data
+      if (i + 1 < pktCnt)
+        requestPacket(i + 1);
+
+      retries = 0;
+
+      if (!cb(&pkt[4], cnt, arg))
+        {
+          aborted = true;
+          break;
+        }
+
+      total += cnt;
+      i++;
     }
 
-  cmd[4] = 0xf0;
-  cmd[5] = 0xf0;
-  writeData(cmd, pktLen);
+  endTransfer(aborted);
 
-  fclose(file);
+  return total;
+}
+
+void SCAM::endTransfer(bool aborted)
+{
+  const unsigned int pktLen = 6;
+  uint8_t cmd[pktLen] = { 0xaa, static_cast<uint8_t>(0x0e | m_camAddr), 0x00,
+                          0x00, 0xf0, 0xf0 };
+
+  // let the camera finish a packet in flight
+  if (aborted)
+    usleep(10000);
+  writeData(cmd, pktLen);
 
   // reset the pic length to 0 for another run.
   m_picTotalLen = 0;
+}
 
-  return true;
+void SCAM::setPacketSize(unsigned int len)
+{
+  if (len < 64 || len > MAX_SUPPORTED_PKT_LEN)
+    {
+      throw std::out_of_range(std::string(__FUNCTION__) +
+                              ": len must be between 64 and 512");
+      return;
+    }
+
+  m_pktLen = len;
+}
+
+bool SCAM::setPacketSizeCmd(unsigned int len, int retries)
+{
+  const unsigned int pktLen = 6;
+  uint8_t cmd[pktLen] = { 0xaa, static_cast<uint8_t>(0x06 | m_camAddr), 0x08,
+                          static_cast<uint8_t>(len & 0xff),
+                          static_cast<uint8_t>((len >> 8) & 0xff), 0};
+  uint8_t resp[pktLen];
+  int tries = 0;
+
+  while (tries++ <= retries)
+    {
+      drainInput();
+      writeData(cmd, pktLen);
+      usleep(100000);
+
+      if (!dataAvailable(100))
+        continue;
+
+      if (!readFully(resp, pktLen, 100))
+        continue;
+
+      // a NAK means the camera does not support this size
+      if (resp[0] == 0xaa
+          && resp[1] == (0x0f | m_camAddr))
+        return false;
+
+      if (resp[0] == 0xaa 
+          && resp[1] == (0x0e | m_camAddr) 
+          && resp[2] == 0x06 
+          && resp[4] == 0 
+          && resp[5] == 0)
+        return true;
+    }
+
+  return false;
+}
+
+unsigned int SCAM::negotiatePacketSize()
+{
+  for (unsigned int len = MAX_SUPPORTED_PKT_LEN; len > MAX_PKT_LEN; len /= 2)
+    {
+      if (setPacketSizeCmd(len, 3))
+        {
+          m_pktLen = len;
+          return m_pktLen;
+        }
+    }
+
+  m_pktLen = MAX_PKT_LEN;
+  return m_pktLen;
+}
+
+bool SCAM::setBaudRate(unsigned int baud)
+{
+  const baudEntry *entry = findBaud(baud);
+
+  if (!entry)
+    {
+      throw std::invalid_argument(std::string(__FUNCTION__) +
+                                  ": unsupported baud rate");
+      return false;
+    }
+
+  const unsigned int pktLen = 6;
+  uint8_t cmd[pktLen] = { 0xaa, static_cast<uint8_t>(0x07 | m_camAddr),
+                          entry->div1, entry->div2, 0x00, 0x00 };
+  uint8_t resp[pktLen];
+  bool acked = false;
+
+  for (int tries = 0; tries < 3 && !acked; tries++)
+    {
+      drainInput();
+      writeData(cmd, pktLen);
+
+      if (!readFully(resp, pktLen, 100))
+        continue;
+
+      if (resp[0] == 0xaa 
+          && resp[1] == (0x0e | m_camAddr) 
+          && resp[2] == 0x07)
+        acked = true;
+    }
+
+  if (!acked)
+    return false;
+
+  // give the camera a moment to switch over, then follow it.  Once
+  // it has acked, it only listens at the new rate, so there is no
+  // going back.
+  usleep(10000);
+  setupTty(entry->speed);
+
+  for (int tries = 0; tries < 3; tries++)
+    {
+      if (sync(10))
+        return true;
+
+      usleep(100000);
+      drainInput();
+    }
+
+  throw std::runtime_error(std::string(__FUNCTION__) +
+                           ": camera switched rates but does not respond");
+  return false;
+}
+
+unsigned int SCAM::negotiateBaudRate(unsigned int maxBaud)
+{
+  for (unsigned int i = 0; i < baudTableLen; i++)
+    {
+      if (baudTable[i].baud > maxBaud)
+        continue;
+
+      // nothing left to gain
+      if (baudTable[i].baud <= m_baud)
+        break;
+
+      if (setBaudRate(baudTable[i].baud))
+        break;
+    }
+
+  return m_baud;
 }
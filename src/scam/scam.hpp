@@ -68,6 +68,15 @@ namespace upm {
 
     static const unsigned int MAX_PKT_LEN = 128;
 
+    // The largest packet size the OV528 based cameras accept
+    static const unsigned int MAX_SUPPORTED_PKT_LEN = 512;
+
+    /**
+     * Callback type used by captureImage() to deliver image data as it
+     * arrives.  Return false from the callback to abort the transfer.
+     */
+    typedef bool (*IMAGE_DATA_CB_T)(const uint8_t *data, int len, void *arg);
+
     typedef enum {
       FORMAT_VGA                   = 7, // 640x480
       FORMAT_CIF                   = 5, // 352*288
@@ -159,6 +168,84 @@ namespace upm {
      */
     bool storeImage(const char *fname);
 
+    /**
+     * Reads the captured image into a user-supplied buffer.  The
+     * buffer must be at least getImageSize() bytes long.  The request
+     * for the next packet is sent as soon as the current one has been
+     * received, so the camera is transmitting while the previous
+     * packet is verified and copied.
+     *
+     * @param buffer Buffer to hold the image
+     * @param len Length of the buffer
+     * @return Number of bytes stored in the buffer
+     */
+    int captureImage(uint8_t *buffer, int len);
+
+    /**
+     * Streams the captured image to a callback, one packet payload at
+     * a time, in order.  Use this to forward the image to a socket or
+     * other sink without an intermediate file.
+     *
+     * @param cb Callback to receive the image data
+     * @param arg User argument passed to the callback
+     * @return Number of bytes delivered to the callback
+     */
+    int captureImage(IMAGE_DATA_CB_T cb, void *arg);
+
+    /**
+     * Sets the packet size used when transferring an image.  Larger
+     * packets mean fewer round trips per image.  The size is sent to
+     * the camera as part of doCapture().
+     *
+     * @param len Packet size in bytes, between 64 and
+     * MAX_SUPPORTED_PKT_LEN
+     */
+    void setPacketSize(unsigned int len);
+
+    /**
+     * Returns the packet size currently used for image transfers.
+     *
+     * @return Packet size in bytes
+     */
+    unsigned int getPacketSize() { return m_pktLen; };
+
+    /**
+     * Finds the largest packet size the camera will accept, starting
+     * at MAX_SUPPORTED_PKT_LEN and halving down to MAX_PKT_LEN.  The
+     * chosen size is used for subsequent captures.  The camera must
+     * have been initialized with init() first.
+     *
+     * @return The negotiated packet size in bytes
+     */
+    unsigned int negotiatePacketSize();
+
+    /**
+     * Asks the camera to switch to a new baud rate, then switches the
+     * local tty to match.  Supported rates are 57600, 115200, 230400,
+     * 460800 and 921600.  Not all camera modules support rates above
+     * 115200, so the new link is verified with a sync sequence.  A
+     * camera that has acked the switch only listens at the new rate,
+     * so the sync is retried at that rate rather than going back.
+     *
+     * @param baud Desired baud rate, in bits per second
+     * @return True if the camera is now communicating at the new
+     * rate, false if it refused the rate and the old one is still in
+     * use
+     * @throws std::runtime_error if the camera acked the new rate but
+     * does not respond at it
+     */
+    bool setBaudRate(unsigned int baud);
+
+    /**
+     * Switches to the highest baud rate, up to maxBaud, at which the
+     * camera still responds.  The camera must have been initialized
+     * with init() first.
+     *
+     * @param maxBaud Highest baud rate to try
+     * @return The baud rate in use after negotiation
+     */
+    unsigned int negotiateBaudRate(unsigned int maxBaud=921600);
+
     /**
      * Returns the picture length. Note: this is only valid after
      * doCapture() has run successfully.
@@ -176,6 +263,16 @@ namespace upm {
 
     uint8_t m_camAddr;
     int m_picTotalLen;
+    unsigned int m_pktLen;
+    unsigned int m_baud;
+
+    bool sync(int retries);
+    bool readFully(uint8_t *buffer, int len, unsigned int millis);
+    void requestPacket(unsigned int id);
+    bool setPacketSizeCmd(unsigned int len, int retries);
+    int fetchImage(IMAGE_DATA_CB_T cb, void *arg);
+    // send the end of transfer command and forget the picture
+    void endTransfer(bool aborted);
   };
 }
 
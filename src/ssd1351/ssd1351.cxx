@@ -11,11 +11,13 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <stdexcept>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "ssd1351.hpp"
 
@@ -167,6 +169,70 @@ SSD1351::drawPixel(int16_t x, int16_t y, uint16_t color) {
           writeData(color);
       }
 }
+void
+SSD1351::drawImage(int16_t x, int16_t y, int16_t w, int16_t h,
+                   uint8_t *buffer, size_t len) {
+    if (w <= 0 || h <= 0)
+        return;
+
+    if (len < (size_t)w * h * 2) {
+        throw std::invalid_argument(string(__FUNCTION__) +
+                                    ": buffer too small for the image");
+    }
+
+    // clip to the screen
+    int x0 = max<int>(x, 0);
+    int y0 = max<int>(y, 0);
+    int x1 = min<int>(x + w, SSD1351WIDTH);
+    int y1 = min<int>(y + h, SSD1351HEIGHT);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+
+    size_t rowLen = (x1 - x0) * 2;
+    uint8_t *row = buffer + ((size_t)(y0 - y) * w + (x0 - x)) * 2;
+
+    if (m_usemap) {
+        for (int i = y0; i < y1; i++, row += w * 2)
+            memcpy(&m_map[(i * SSD1351WIDTH + x0) * 2], row, rowLen);
+        return;
+    }
+
+    writeCommand(SSD1351_CMD_SETCOLUMN);
+    writeData(x0);
+    writeData(x1 - 1);
+
+    writeCommand(SSD1351_CMD_SETROW);
+    writeData(y0);
+    writeData(y1 - 1);
+
+    writeCommand(SSD1351_CMD_WRITERAM);
+    dcHigh();
+
+    if (x1 - x0 == w) {
+        // whole rows are contiguous in the buffer
+        writePixels(row, (y1 - y0) * rowLen);
+    } else {
+        for (int i = y0; i < y1; i++, row += w * 2)
+            writePixels(row, rowLen);
+    }
+}
+
+void
+SSD1351::writePixels(uint8_t *buffer, size_t len) {
+    // same transfer size as refresh()
+    const size_t maxTransfer = SSD1351HEIGHT * SSD1351WIDTH * 2 / BLOCKS;
+
+    while (len) {
+        size_t n = min(len, maxTransfer);
+        if (m_spi.transfer(buffer, NULL, n) != mraa::SUCCESS) {
+            throw std::runtime_error(string(__FUNCTION__) +
+                                     ": SPI transfer failed");
+        }
+        buffer += n;
+        len -= n;
+    }
+}
+
 void
 SSD1351::refresh () {
     writeCommand(SSD1351_CMD_WRITERAM);
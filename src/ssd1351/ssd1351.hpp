@@ -135,6 +135,24 @@ class SSD1351 : public GFX{
          */
         void drawPixel (int16_t x, int16_t y, uint16_t color);
 
+        /**
+         * Draws an image.  Parts outside of the screen are clipped.
+         * With the memory map in use the image is copied to the display
+         * buffer, otherwise it is written to the chip in as few SPI
+         * transfers as possible.
+         *
+         * @param x Axis on the horizontal scale of upper-left corner
+         * @param y Axis on the vertical scale of upper-left corner
+         * @param w Width of the image in pixels
+         * @param h Height of the image in pixels
+         * @param buffer w * h RGB (16-bit) pixels, row by row, each
+         * high byte first
+         * @param len Size of buffer in bytes
+         * @throws std::invalid_argument if buffer is too small
+         */
+        void drawImage (int16_t x, int16_t y, int16_t w, int16_t h,
+                        uint8_t *buffer, size_t len);
+
         /**
          * Copies the buffer to the chip via the SPI bus
          */
@@ -176,5 +194,7 @@ class SSD1351 : public GFX{
         mraa::Gpio      m_rst;
 
         std::string     m_name;
+
+        void writePixels (uint8_t *buffer, size_t len);
 };
 }
@@ -2,6 +2,8 @@
 
 /* BEGIN Java syntax  ------------------------------------------------------- */
 #ifdef SWIGJAVA
+%include "../java_buffer.i"
+
 %ignore font;
 %ignore m_map;
 
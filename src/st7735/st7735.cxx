@@ -9,6 +9,7 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <stdexcept>
@@ -138,6 +139,35 @@ ST7735::drawPixel(int16_t x, int16_t y, uint16_t color) {
     refresh ();
 }
 
+void
+ST7735::drawImage(int16_t x, int16_t y, int16_t w, int16_t h,
+                  uint8_t *buffer, size_t len) {
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    if (len < (size_t)w * h * 2) {
+        throw std::invalid_argument(std::string(__FUNCTION__) +
+                                    ": buffer too small for the image");
+    }
+
+    // clip to the screen
+    int x0 = std::max<int>(x, 0);
+    int y0 = std::max<int>(y, 0);
+    int x1 = std::min<int>(x + w, m_width);
+    int y1 = std::min<int>(y + h, m_height);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    uint8_t *row = buffer + ((size_t)(y0 - y) * w + (x0 - x)) * 2;
+    for (int i = y0; i < y1; i++, row += w * 2) {
+        memcpy(&m_map[(i * m_width + x0) * 2], row, (x1 - x0) * 2);
+    }
+
+    refresh ();
+}
+
 void
 ST7735::refresh () {
     rsHIGH ();
@@ -575,6 +575,23 @@ class ST7735 : public GFX {
          */
         void drawPixel (int16_t x, int16_t y, uint16_t color);
 
+        /**
+         * Draws an image.  Parts outside of the screen are clipped.
+         * The image is copied to the screen buffer, which is then sent to
+         * the chip, like drawPixel() does.
+         *
+         * @param x Axis on the horizontal scale of upper-left corner
+         * @param y Axis on the vertical scale of upper-left corner
+         * @param w Width of the image in pixels
+         * @param h Height of the image in pixels
+         * @param buffer w * h RGB (16-bit) pixels, row by row, each
+         * high byte first
+         * @param len Size of buffer in bytes
+         * @throws std::invalid_argument if buffer is too small
+         */
+        void drawImage (int16_t x, int16_t y, int16_t w, int16_t h,
+                        uint8_t *buffer, size_t len);
+
         /**
          * Copies the buffer to the chip via the SPI.
          */
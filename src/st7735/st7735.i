@@ -3,6 +3,7 @@
 /* BEGIN Java syntax  ------------------------------------------------------- */
 #ifdef SWIGJAVA
 %include "arrays_java.i"
+%include "../java_buffer.i"
 %ignore m_map;
 %ignore Bcmd;
 %ignore font;
@@ -15,6 +15,7 @@
 #include <stdexcept>
 #include <stdlib.h>
 #include <time.h>
+#include <errno.h>
 #include "stepmotor.hpp"
 
 using namespace upm;
@@ -34,7 +35,8 @@ StepMotor::StepMotor (int dirPin, int stePin, int steps, int enPin)
                                ": Could not initialize dirPin as output");
         return;
     }
-    m_dirPinCtx.write(0);
+    m_dirPinCtx.write(LOW);
+    m_forward = false;
 
     if (m_stePinCtx.dir(mraa::DIR_OUT) != mraa::SUCCESS) {
         throw std::runtime_error(string(__FUNCTION__) +
@@ -91,10 +93,13 @@ StepMotor::step (int ticks) {
 mraa::Result
 StepMotor::stepForward (int ticks) {
     dirForward();
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
     for (int i = 0; i < ticks; i++) {
         move();
         m_position++;
-        delayus(m_delay - MINPULSE_US - OVERHEAD_US);
+        sleepUntil(next, m_delay);
     }
     return mraa::SUCCESS;
 }
@@ -102,11 +107,28 @@ StepMotor::stepForward (int ticks) {
 mraa::Result
 StepMotor::stepBackward (int ticks) {
     dirBackward();
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
     for (int i = 0; i < ticks; i++) {
         move();
         m_position--;
-        delayus(m_delay - MINPULSE_US - OVERHEAD_US);
+        sleepUntil(next, m_delay);
+    }
+    return mraa::SUCCESS;
+}
+
+mraa::Result
+StepMotor::singleStep (bool forward) {
+    if (forward != m_forward) {
+        if (forward)
+            dirForward();
+        else
+            dirBackward();
     }
+
+    move();
+    m_position += forward ? 1 : -1;
     return mraa::SUCCESS;
 }
 
@@ -140,6 +162,7 @@ StepMotor::dirForward () {
         throw std::runtime_error(string(__FUNCTION__) +
                                        ": Could not write to dirPin");
     }
+    m_forward = true;
     return error;
 }
 
@@ -150,20 +173,35 @@ StepMotor::dirBackward () {
         throw std::runtime_error(string(__FUNCTION__) +
                                        ": Could not write to dirPin");
     }
+    m_forward = false;
     return error;
 }
 
 void upm::StepMotor::delayus (int us) {
+    // only used for the few microseconds of the step pulse, too short
+    // to sleep for
     int diff = 0;
     struct timespec gettime_now;
 
-    clock_gettime(CLOCK_REALTIME, &gettime_now);
+    clock_gettime(CLOCK_MONOTONIC, &gettime_now);
     int start = gettime_now.tv_nsec;
     while (diff < us * 1000)
     {
-        clock_gettime(CLOCK_REALTIME, &gettime_now);
+        clock_gettime(CLOCK_MONOTONIC, &gettime_now);
         diff = gettime_now.tv_nsec - start;
         if (diff < 0)
             diff += 1000000000;
     }
 }
+
+void upm::StepMotor::sleepUntil (struct timespec &next, int us) {
+    // advance the absolute deadline and sleep until it, so the time
+    // spent toggling the pins does not add up over a move
+    next.tv_nsec += (long)us * 1000;
+    while (next.tv_nsec >= 1000000000) {
+        next.tv_nsec -= 1000000000;
+        next.tv_sec++;
+    }
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+}
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <string>
+#include <time.h>
 #include <mraa/pwm.hpp>
 #include <mraa/common.hpp>
 #include <mraa/gpio.hpp>
@@ -49,11 +50,13 @@ namespace upm {
  * can also control an enable pin if one is available and connected.
  *
  * The implementation is synchronous and thus blocking while the stepper motor
- * is in motion. However it is possible to send the commands via threading and
- * the performance of the library will be very good given a low CPU load. On a
- * busy system though you will notice some jitter especially at higher speeds.
- * It is possible to reduce this effect to some extent by using smoothing
- * and/or microstepping on stepper drivers that support such features.
+ * is in motion. Steps are timed against absolute deadlines, so the speed
+ * does not drift with the system load, although on a busy system you will
+ * notice some jitter especially at higher speeds. It is possible to reduce
+ * this effect to some extent by using smoothing and/or microstepping on
+ * stepper drivers that support such features. For non-blocking moves with
+ * acceleration ramps, or to coordinate several motors, see the
+ * motionplanner library.
  *
  * @image html stepmotor.jpg
  * <br><em>EasyDriver Sensor image provided by SparkFun* under
@@ -117,6 +120,16 @@ class StepMotor {
          */
         mraa::Result stepBackward (int ticks);
 
+        /**
+         * Moves the motor a single step, without any delay. Intended for
+         * callers doing their own step timing, such as MotionPlanner. The
+         * direction pin is only written when the direction changes.
+         *
+         * @param forward true to step forward (clockwise), false to step
+         * backward
+         */
+        mraa::Result singleStep (bool forward);
+
         /**
          * Sets the current position. Useful if the motor is not at 0 when the
          * driver is initialized.
@@ -154,10 +167,12 @@ class StepMotor {
         int                 m_delay;
         int                 m_steps;
         int                 m_position;
+        bool                m_forward;
 
         mraa::Result dirForward ();
         mraa::Result dirBackward ();
         void move ();
         void delayus (int us);
+        void sleepUntil (struct timespec &next, int us);
     };
 }
@@ -10,6 +10,7 @@
  */
 
 #include <unistd.h>
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <sstream>
@@ -69,6 +70,16 @@ SX1276::SX1276(uint8_t chipRev, int bus, int cs, int resetPin, int dio0,
   m_gpioCS.dir(mraa::DIR_OUT);
   csOff();
 
+  upm_reg_cache_init(&m_regCache);
+  upm_reg_cache_set_nonvolatile(&m_regCache, COM_RegFrfMsb, COM_RegOcp);
+  upm_reg_cache_set_nonvolatile(&m_regCache, FSK_RegPacketConfig1,
+                                FSK_RegPacketConfig2);
+  upm_reg_cache_set_nonvolatile(&m_regCache, LOR_RegInvertIQ,
+                                LOR_RegInvertIQ);
+  upm_reg_cache_set_nonvolatile(&m_regCache, COM_RegDioMapping1,
+                                COM_RegDioMapping2);
+  upm_reg_cache_set_nonvolatile(&m_regCache, COM_RegPaDac, COM_RegPaDac);
+
   m_gpioReset.dir(mraa::DIR_IN);
 
   // 10ms for POR
@@ -150,6 +161,10 @@ SX1276::~SX1276()
 
 uint8_t SX1276::readReg(uint8_t reg)
 {
+  uint8_t val;
+  if (upm_reg_cache_get(&m_regCache, reg, &val))
+    return val;
+
   uint8_t pkt[2] = {static_cast<uint8_t>(reg & 0x7f), 0};
 
   csOn();
@@ -162,23 +177,33 @@ uint8_t SX1276::readReg(uint8_t reg)
     }
   csOff();
 
+  upm_reg_cache_put(&m_regCache, reg, pkt[1]);
+
   return pkt[1];
 }
 
 bool SX1276::writeReg(uint8_t reg, uint8_t val)
 {
+  // skip writes that would not change a cached register
+  uint8_t cached;
+  if (upm_reg_cache_get(&m_regCache, reg, &cached) && cached == val)
+    return true;
+
   uint8_t pkt[2] = {static_cast<uint8_t>(reg | m_writeMode), val};
 
   csOn();
   if (m_spi.transfer(pkt, NULL, 2))
     {
       csOff();
+      upm_reg_cache_invalidate(&m_regCache, reg);
       throw std::runtime_error(string(__FUNCTION__) +
                                ": Spi.transfer() failed");
       return false;
     }
   csOff();
 
+  upm_reg_cache_put(&m_regCache, reg, val);
+
   return true;
 }
 
@@ -257,6 +282,8 @@ void SX1276::reset()
   usleep(1000); // 1ms
   m_gpioReset.dir(mraa::DIR_IN);
   usleep(10000); // 10ms
+
+  upm_reg_cache_invalidate_all(&m_regCache);
 }
 
 
@@ -398,6 +425,8 @@ void SX1276::setModem(RADIO_MODEM_T modem)
       // turn off lora
       reg = (readReg(COM_RegOpMode) & ~OPMODE_LongRangeMode);
       writeReg(COM_RegOpMode, reg);
+      // the FSK register bank is now mapped
+      upm_reg_cache_invalidate_all(&m_regCache);
       
       writeReg(COM_RegDioMapping1, 0x00);
       writeReg(COM_RegDioMapping2, 0x30); // DIO5=ModeReady
@@ -409,6 +438,8 @@ void SX1276::setModem(RADIO_MODEM_T modem)
       // turn lora on
       reg = (readReg(COM_RegOpMode) | OPMODE_LongRangeMode);
       writeReg(COM_RegOpMode, reg);
+      // the LoRa register bank is now mapped
+      upm_reg_cache_invalidate_all(&m_regCache);
       
       writeReg(COM_RegDioMapping1, 0x00);
       writeReg(COM_RegDioMapping2, 0x00);
@@ -1495,6 +1526,12 @@ SX1276::RADIO_EVENT_T SX1276::setRx(uint32_t timeout)
   return m_radioEvent;
 }
 
+size_t SX1276::getRxBuffer(uint8_t *buffer, size_t len)
+{
+  size_t n = std::min(len, (size_t)getRxLen());
+  memcpy(buffer, m_rxBuffer, n);
+  return n;
+}
 
 void SX1276::startCAD()
 {
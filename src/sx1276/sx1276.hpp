@@ -29,6 +29,8 @@
 #include <mraa/spi.hpp>
 #include <mraa/gpio.hpp>
 
+#include "upm_reg_cache.h"
+
 // Our crystal oscillator frequency (32Mhz)
 #define FXOSC_FREQ 32000000.0
 
@@ -1828,6 +1830,16 @@ namespace upm {
       return (uint8_t*)m_rxBuffer;
     };
 
+    /**
+     * Upon a successful receive, this method can be used to copy the
+     * received packet into a buffer of your own.
+     *
+     * @param buffer The buffer to copy the packet to
+     * @param len The size of the buffer in bytes
+     * @return The number of bytes copied, at most len
+     */
+    size_t getRxBuffer(uint8_t *buffer, size_t len);
+
     /**
      * Upon a successful receive, this method can be used to retrieve
      * the received packet's Received Signal Strength Indicator (RSSI)
@@ -2007,6 +2019,12 @@ namespace upm {
     // for coordinating interrupt access
     pthread_mutex_t m_intrLock;
 
+    // shadow copies of the configuration registers.  Some cached
+    // registers mean different things in the FSK and LoRa banks
+    // (0x30, 0x31 and 0x33), so correctness relies on setModem()
+    // dropping the cache whenever it switches banks.
+    upm_reg_cache_t m_regCache;
+
     void lockIntrs() { pthread_mutex_lock(&m_intrLock); };
     void unlockIntrs() { pthread_mutex_unlock(&m_intrLock); };
 
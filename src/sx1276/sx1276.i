@@ -6,12 +6,36 @@
 %include "../java_buffer.i"
 
 %ignore getRxBuffer();
-%ignore send(uint8_t *buffer, uint8_t size, int txTimeout);
+%apply (uint8_t *buffer, size_t len) { (uint8_t *buffer, uint8_t size) };
 
 JAVA_JNI_LOADLIBRARY(javaupm_sx1276)
 #endif
 /* END Java syntax */
 
+/* BEGIN Javascript syntax  ------------------------------------------------- */
+#ifdef SWIGJAVASCRIPT
+%include "../node_async.i"
+
+#if (SWIG_JAVASCRIPT_V8) && (V8_VERSION >= 0x050100)
+%extend upm::SX1276 {
+    upm_node_async_t sendStrAsync(std::string buffer, int timeout) {
+        upm::SX1276 *dev = $self;
+        return upm_node_async_t(dev, [dev, buffer, timeout]() {
+                return (double) dev->sendStr(buffer, timeout);
+            }, UPM_NODE_ASYNC_NUMBER);
+    }
+
+    upm_node_async_t setRxAsync(uint32_t timeout) {
+        upm::SX1276 *dev = $self;
+        return upm_node_async_t(dev, [dev, timeout]() {
+                return (double) dev->setRx(timeout);
+            }, UPM_NODE_ASYNC_NUMBER);
+    }
+}
+#endif
+#endif
+/* END Javascript syntax */
+
 /* BEGIN Common SWIG syntax ------------------------------------------------- */
 %pointer_functions(float, floatp);
 
@@ -34,7 +34,7 @@ uln200xa_context uln200xa_init(int stepsPerRev, unsigned int i1,
 
     dev->stepsPerRev = stepsPerRev;
     dev->currentStep = 0;
-    dev->stepDelay = 0;
+    dev->stepDelayUs = 0;
     dev->stepDirection = 1;          // default is forward
 
     // make sure MRAA is initialized
@@ -110,7 +110,7 @@ void uln200xa_set_speed(const uln200xa_context dev, unsigned int speed)
 {
     assert(dev != NULL);
 
-    dev->stepDelay = 60 * 1000 / dev->stepsPerRev / speed;
+    dev->stepDelayUs = 60UL * 1000000 / dev->stepsPerRev / speed;
 }
 
 void uln200xa_set_direction(const uln200xa_context dev,
@@ -204,31 +204,49 @@ static void uln200xa_stepper_step(const uln200xa_context dev)
     }
 }
 
+static void uln200xa_advance(const uln200xa_context dev, int direction)
+{
+    dev->currentStep += direction;
+
+    if (direction == 1)
+    {
+        if (dev->currentStep >= dev->stepsPerRev)
+            dev->currentStep = 0;
+    }
+    else
+    {
+        if (dev->currentStep <= 0)
+            dev->currentStep = dev->stepsPerRev;
+    }
+
+    uln200xa_stepper_step(dev);
+}
+
 void uln200xa_stepper_steps(const uln200xa_context dev, unsigned int steps)
 {
     assert(dev != NULL);
 
+    // schedule the steps against absolute deadlines, so the time
+    // spent writing the GPIOs does not slow the motor down
+    upm_clock_t next = upm_clock_init();
+
     while (steps > 0)
     {
-        upm_delay_ms(dev->stepDelay);
-        dev->currentStep += dev->stepDirection;
-
-        if (dev->stepDirection == 1)
-        {
-            if (dev->currentStep >= dev->stepsPerRev)
-                dev->currentStep = 0;
-        }
-        else
-        {
-            if (dev->currentStep <= 0)
-                dev->currentStep = dev->stepsPerRev;
-        }
+        upm_delay_until_ns(&next, (uint64_t)dev->stepDelayUs * 1000);
 
         steps--;
-        uln200xa_stepper_step(dev);
+        uln200xa_advance(dev, dev->stepDirection);
     }
 }
 
+void uln200xa_single_step(const uln200xa_context dev,
+                          ULN200XA_DIRECTION_T dir)
+{
+    assert(dev != NULL);
+
+    uln200xa_advance(dev, (dir == ULN200XA_DIR_CCW) ? -1 : 1);
+}
+
 void uln200xa_release(const uln200xa_context dev)
 {
     assert(dev !=NULL);
@@ -47,6 +47,11 @@ void ULN200XA::stepperSteps(unsigned int steps)
     uln200xa_stepper_steps(m_uln200xa, steps);
 }
 
+void ULN200XA::singleStep(ULN200XA_DIRECTION_T dir)
+{
+    uln200xa_single_step(m_uln200xa, dir);
+}
+
 void ULN200XA::release()
 {
     uln200xa_release(m_uln200xa);
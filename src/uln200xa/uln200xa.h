@@ -42,7 +42,7 @@ extern "C" {
 
         int      stepsPerRev;
         int      currentStep;
-        uint32_t stepDelay;
+        uint32_t stepDelayUs;
         int      stepDirection;
 
     } *uln200xa_context;
@@ -91,6 +91,17 @@ extern "C" {
      */
     void uln200xa_stepper_steps(const uln200xa_context dev, unsigned int steps);
 
+    /**
+     * Moves the stepper motor a single step in the given direction,
+     * without any delay.  For callers doing their own step timing,
+     * such as the motionplanner library.  The direction set with
+     * uln200xa_set_direction() is not changed.
+     * @param dev Device context
+     * @param dir Direction to step in
+     */
+    void uln200xa_single_step(const uln200xa_context dev,
+                              ULN200XA_DIRECTION_T dir);
+
     /**
      * Releases the stepper motor by removing power
      *
@@ -86,6 +86,15 @@ namespace upm {
      */
     void stepperSteps(unsigned int steps);
 
+    /**
+     * Moves the stepper motor a single step in the given direction,
+     * without any delay.  For callers doing their own step timing,
+     * such as MotionPlanner.  The direction set with setDirection() is
+     * not changed.
+     * @param dir Direction to step in
+     */
+    void singleStep(ULN200XA_DIRECTION_T dir);
+
     /**
      * Releases the stepper motor by removing power
      *
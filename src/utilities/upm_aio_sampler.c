@@ -0,0 +1,703 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _POSIX_C_SOURCE
+// clock_gettime(), pthread_condattr_setclock()
+# define _POSIX_C_SOURCE 200809L
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "upm_platform.h"
+#include "upm_aio_sampler.h"
+
+#define UPM_AIO_PI 3.14159265358979323846
+
+upm_result_t upm_fft(float *re, float *im, size_t n)
+{
+    assert(re != NULL && im != NULL);
+
+    if (n == 0 || (n & (n - 1)))
+        return UPM_ERROR_INVALID_SIZE;
+
+    // bit reversal permutation
+    for (size_t i = 1, j = 0; i < n; i++)
+    {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j |= bit;
+
+        if (i < j)
+        {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    // butterflies, twiddles kept in double so they do not drift over
+    // a long stage
+    for (size_t len = 2; len <= n; len <<= 1)
+    {
+        double ang = -2.0 * UPM_AIO_PI / len;
+        double wr_step = cos(ang), wi_step = sin(ang);
+
+        for (size_t i = 0; i < n; i += len)
+        {
+            double wr = 1.0, wi = 0.0;
+            for (size_t k = 0; k < len / 2; k++)
+            {
+                size_t a = i + k, b = a + len / 2;
+                float tr = (float)(re[b] * wr - im[b] * wi);
+                float ti = (float)(re[b] * wi + im[b] * wr);
+
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+
+                double t = wr * wr_step - wi * wi_step;
+                wi = wr * wi_step + wi * wr_step;
+                wr = t;
+            }
+        }
+    }
+
+    return UPM_SUCCESS;
+}
+
+float upm_spectrum_peak(const float *mag, size_t n, float rate_hz)
+{
+    assert(mag != NULL);
+
+    size_t bins = n / 2 + 1;
+    if (bins < 3)
+        return 0.0f;
+
+    size_t k = 1;
+    for (size_t i = 2; i < bins; i++)
+        if (mag[i] > mag[k])
+            k = i;
+
+    // fit a parabola through the peak and its neighbours
+    float delta = 0.0f;
+    if (k + 1 < bins)
+    {
+        float a = mag[k - 1], b = mag[k], c = mag[k + 1];
+        float d = a - 2.0f * b + c;
+        if (d < 0.0f)
+            delta = 0.5f * (a - c) / d;
+    }
+
+    return ((float)k + delta) * rate_hz / (float)n;
+}
+
+#if defined(UPM_PLATFORM_LINUX)
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "upm_iio_stream.h"
+
+// samples per read from an IIO buffer
+#define IIO_BLOCK 64
+
+struct _upm_aio_sampler {
+    // timed source
+    upm_sample_read_t read;
+    void *ctx;
+
+    // or IIO source
+    upm_iio_stream_context stream;
+    int channel;
+    float block[IIO_BLOCK];
+
+    float rate;
+    float attack_ms;
+    float release_ms;
+    // envelope follower and DC tracker coefficients for the rate
+    float attack;
+    float release;
+    float dc_coef;
+
+    // history ring, the latest unread entries are readable
+    float *ring;
+    size_t capacity;
+    size_t head;
+    size_t fill;
+    size_t unread;
+
+    // running statistics
+    uint64_t count;
+    double mean;
+    double m2;
+    double sumsq;
+    float min;
+    float max;
+    int tracking;
+    double dc;
+    double envelope;
+    uint64_t overruns;
+    uint64_t dropped;
+
+    pthread_mutex_t lock;
+    // wakes the thread to stop, and readers when samples arrive
+    pthread_cond_t wake;
+    pthread_cond_t avail;
+    pthread_t thread;
+    int running;
+    int stopping;
+    int failed;
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static struct timespec to_timespec(uint64_t ns)
+{
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000ull;
+    ts.tv_nsec = ns % 1000000000ull;
+    return ts;
+}
+
+// one pole smoothing coefficient for a time constant
+static float smoothing(float tau_ms, float rate)
+{
+    if (tau_ms <= 0.0f)
+        return 1.0f;
+    return (float)(1.0 - exp(-1000.0 / (tau_ms * rate)));
+}
+
+static void update_coefs(upm_aio_sampler_context dev)
+{
+    dev->attack = smoothing(dev->attack_ms, dev->rate);
+    dev->release = smoothing(dev->release_ms, dev->rate);
+    // slow enough to pass mains and audio frequencies
+    dev->dc_coef = smoothing(500.0f, dev->rate);
+}
+
+// Add a sample to the history and statistics, with the lock held
+static void push(upm_aio_sampler_context dev, float v, int readable)
+{
+    dev->ring[dev->head] = v;
+    dev->head = (dev->head + 1) % dev->capacity;
+    if (dev->fill < dev->capacity)
+        dev->fill++;
+
+    if (readable)
+    {
+        if (dev->unread < dev->capacity)
+            dev->unread++;
+        else
+            dev->dropped++;
+    }
+
+    dev->count++;
+    double d = v - dev->mean;
+    dev->mean += d / (double)dev->count;
+    dev->m2 += d * (v - dev->mean);
+    dev->sumsq += (double)v * v;
+    if (dev->count == 1 || v < dev->min)
+        dev->min = v;
+    if (dev->count == 1 || v > dev->max)
+        dev->max = v;
+
+    if (!dev->tracking)
+    {
+        dev->dc = v;
+        dev->tracking = 1;
+    }
+    dev->dc += dev->dc_coef * (v - dev->dc);
+    double x = fabs(v - dev->dc);
+    dev->envelope += ((x > dev->envelope) ? dev->attack : dev->release)
+        * (x - dev->envelope);
+}
+
+static upm_aio_sampler_context alloc_sampler(float rate_hz, size_t capacity)
+{
+    if (!(rate_hz > 0.0f) || capacity == 0)
+        return NULL;
+
+    upm_aio_sampler_context dev =
+        (upm_aio_sampler_context)calloc(1, sizeof(struct _upm_aio_sampler));
+    if (!dev)
+        return NULL;
+
+    dev->ring = (float *)calloc(capacity, sizeof(float));
+    if (!dev->ring)
+    {
+        free(dev);
+        return NULL;
+    }
+
+    dev->capacity = capacity;
+    dev->rate = rate_hz;
+    dev->attack_ms = 1.0f;
+    dev->release_ms = 100.0f;
+    dev->channel = -1;
+    update_coefs(dev);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&dev->lock, NULL);
+    pthread_cond_init(&dev->wake, &attr);
+    pthread_cond_init(&dev->avail, &attr);
+    pthread_condattr_destroy(&attr);
+
+    return dev;
+}
+
+upm_aio_sampler_context upm_aio_sampler_init(upm_sample_read_t read,
+                                             void *ctx, float rate_hz,
+                                             size_t capacity)
+{
+    if (!read)
+        return NULL;
+
+    upm_aio_sampler_context dev = alloc_sampler(rate_hz, capacity);
+    if (!dev)
+        return NULL;
+
+    dev->read = read;
+    dev->ctx = ctx;
+
+    return dev;
+}
+
+upm_aio_sampler_context upm_aio_sampler_init_iio(int device,
+                                                 const char *channel,
+                                                 float rate_hz,
+                                                 size_t capacity)
+{
+    assert(channel != NULL);
+
+    upm_aio_sampler_context dev = alloc_sampler(rate_hz, capacity);
+    if (!dev)
+        return NULL;
+
+    dev->stream = upm_iio_stream_init(device);
+    if (!dev->stream
+        || upm_iio_stream_enable(dev->stream, 4 * IIO_BLOCK) != UPM_SUCCESS
+        || upm_iio_stream_open(dev->stream) != UPM_SUCCESS
+        || (dev->channel = upm_iio_stream_find_channel(dev->stream,
+                                                       channel)) < 0
+        // raw codes
+        || upm_iio_stream_set_scale(dev->stream, dev->channel,
+                                    1.0f) != UPM_SUCCESS)
+    {
+        upm_aio_sampler_close(dev);
+        return NULL;
+    }
+
+    return dev;
+}
+
+void upm_aio_sampler_close(upm_aio_sampler_context dev)
+{
+    if (!dev)
+        return;
+
+    upm_aio_sampler_stop(dev);
+
+    if (dev->stream)
+    {
+        upm_iio_stream_disable(dev->stream);
+        upm_iio_stream_close(dev->stream);
+    }
+
+    pthread_cond_destroy(&dev->avail);
+    pthread_cond_destroy(&dev->wake);
+    pthread_mutex_destroy(&dev->lock);
+    free(dev->ring);
+    free(dev);
+}
+
+upm_result_t upm_aio_sampler_set_rate(upm_aio_sampler_context dev,
+                                      float rate_hz)
+{
+    assert(dev != NULL);
+
+    if (!(rate_hz > 0.0f))
+        return UPM_ERROR_INVALID_PARAMETER;
+
+    pthread_mutex_lock(&dev->lock);
+    int running = dev->running;
+    if (!running)
+    {
+        dev->rate = rate_hz;
+        update_coefs(dev);
+    }
+    pthread_mutex_unlock(&dev->lock);
+
+    return running ? UPM_ERROR_NOT_SUPPORTED : UPM_SUCCESS;
+}
+
+float upm_aio_sampler_get_rate(const upm_aio_sampler_context dev)
+{
+    assert(dev != NULL);
+
+    return dev->rate;
+}
+
+void upm_aio_sampler_set_envelope(upm_aio_sampler_context dev,
+                                  float attack_ms, float release_ms)
+{
+    assert(dev != NULL);
+
+    pthread_mutex_lock(&dev->lock);
+    dev->attack_ms = attack_ms;
+    dev->release_ms = release_ms;
+    update_coefs(dev);
+    pthread_mutex_unlock(&dev->lock);
+}
+
+// Sleep until an absolute deadline, with the lock held.  Returns 0 if
+// woken to stop.
+static int wait_until(upm_aio_sampler_context dev, uint64_t deadline)
+{
+    struct timespec ts = to_timespec(deadline);
+
+    while (!dev->stopping)
+    {
+        int rv = pthread_cond_timedwait(&dev->wake, &dev->lock, &ts);
+        if (rv == ETIMEDOUT)
+            return 1;
+    }
+
+    return 0;
+}
+
+// Take samples on the deadline grid until count are taken (count 0:
+// until stopped), with the lock held.  The lock is released while
+// sleeping and reading.
+static upm_result_t acquire_timed(upm_aio_sampler_context dev, float *out,
+                                  size_t count, int readable)
+{
+    const double period = 1e9 / dev->rate;
+    const uint64_t start = now_ns();
+    uint64_t k = 0;
+
+    for (size_t i = 0; count == 0 || i < count; i++)
+    {
+        if (!wait_until(dev, start + (uint64_t)(k * period)))
+            break;
+
+        float v;
+        pthread_mutex_unlock(&dev->lock);
+        upm_result_t rv = dev->read(dev->ctx, &v);
+        pthread_mutex_lock(&dev->lock);
+        if (rv != UPM_SUCCESS)
+            return rv;
+
+        push(dev, v, readable);
+        if (out)
+            out[i] = v;
+        if (readable)
+            pthread_cond_broadcast(&dev->avail);
+
+        // skip deadlines that have passed by a whole period rather
+        // than taking a burst of late samples
+        k++;
+        uint64_t now = now_ns();
+        uint64_t next = start + (uint64_t)(k * period);
+        if (now > next && now - next >= period)
+        {
+            uint64_t missed = (uint64_t)((now - next) / period);
+            k += missed;
+            dev->overruns += missed;
+        }
+    }
+
+    return UPM_SUCCESS;
+}
+
+// Read samples from the IIO buffer until count are taken (count 0:
+// until stopped), with the lock held
+static upm_result_t acquire_iio(upm_aio_sampler_context dev, float *out,
+                                size_t count, int readable)
+{
+    float *data[UPM_IIO_STREAM_MAX_CHANNELS] = { NULL };
+    data[dev->channel] = dev->block;
+
+    size_t taken = 0;
+    while (!dev->stopping && (count == 0 || taken < count))
+    {
+        size_t want = IIO_BLOCK;
+        if (count && count - taken < want)
+            want = count - taken;
+
+        pthread_mutex_unlock(&dev->lock);
+        int n = upm_iio_stream_read(dev->stream, data, NULL, want, 100);
+        pthread_mutex_lock(&dev->lock);
+        if (n < 0)
+            return UPM_ERROR_OPERATION_FAILED;
+        // a timeout only matters if nobody can stop us
+        if (n == 0 && count)
+            return UPM_ERROR_TIMED_OUT;
+
+        for (int i = 0; i < n; i++)
+        {
+            push(dev, dev->block[i], readable);
+            if (out)
+                out[taken] = dev->block[i];
+            taken++;
+        }
+        if (readable && n)
+            pthread_cond_broadcast(&dev->avail);
+    }
+
+    return UPM_SUCCESS;
+}
+
+upm_result_t upm_aio_sampler_capture(upm_aio_sampler_context dev,
+                                     float *out, size_t count)
+{
+    assert(dev != NULL);
+
+    upm_result_t rv;
+
+    // a count of 0 means "until stopped" to the acquisition loops,
+    // and nothing can stop a capture
+    if (count == 0)
+        return UPM_ERROR_INVALID_PARAMETER;
+
+    pthread_mutex_lock(&dev->lock);
+    if (dev->running)
+        rv = UPM_ERROR_NOT_SUPPORTED;
+    else if (dev->stream)
+        rv = acquire_iio(dev, out, count, 0);
+    else
+        rv = acquire_timed(dev, out, count, 0);
+    pthread_mutex_unlock(&dev->lock);
+
+    return rv;
+}
+
+static void *sampler_thread(void *arg)
+{
+    upm_aio_sampler_context dev = (upm_aio_sampler_context)arg;
+
+    pthread_mutex_lock(&dev->lock);
+    upm_result_t rv = dev->stream ? acquire_iio(dev, NULL, 0, 1)
+        : acquire_timed(dev, NULL, 0, 1);
+    if (rv != UPM_SUCCESS)
+    {
+        dev->failed = 1;
+        pthread_cond_broadcast(&dev->avail);
+    }
+    pthread_mutex_unlock(&dev->lock);
+
+    return NULL;
+}
+
+upm_result_t upm_aio_sampler_start(upm_aio_sampler_context dev)
+{
+    assert(dev != NULL);
+
+    pthread_mutex_lock(&dev->lock);
+    if (dev->running)
+    {
+        pthread_mutex_unlock(&dev->lock);
+        return UPM_SUCCESS;
+    }
+
+    dev->stopping = 0;
+    dev->failed = 0;
+    dev->unread = 0;
+    dev->running = 1;
+    pthread_mutex_unlock(&dev->lock);
+
+    if (pthread_create(&dev->thread, NULL, sampler_thread, dev))
+    {
+        pthread_mutex_lock(&dev->lock);
+        dev->running = 0;
+        pthread_mutex_unlock(&dev->lock);
+        return UPM_ERROR_NO_RESOURCES;
+    }
+
+    return UPM_SUCCESS;
+}
+
+void upm_aio_sampler_stop(upm_aio_sampler_context dev)
+{
+    assert(dev != NULL);
+
+    pthread_mutex_lock(&dev->lock);
+    if (!dev->running)
+    {
+        pthread_mutex_unlock(&dev->lock);
+        return;
+    }
+    dev->stopping = 1;
+    pthread_cond_broadcast(&dev->wake);
+    pthread_mutex_unlock(&dev->lock);
+
+    pthread_join(dev->thread, NULL);
+
+    pthread_mutex_lock(&dev->lock);
+    dev->running = 0;
+    dev->stopping = 0;
+    // wake readers waiting for samples that will not come
+    pthread_cond_broadcast(&dev->avail);
+    pthread_mutex_unlock(&dev->lock);
+}
+
+int upm_aio_sampler_read(upm_aio_sampler_context dev, float *buf, size_t len,
+                         int timeout_ms)
+{
+    assert(dev != NULL && buf != NULL);
+
+    pthread_mutex_lock(&dev->lock);
+
+    if (timeout_ms != 0)
+    {
+        struct timespec ts = to_timespec(now_ns()
+                                         + (uint64_t)timeout_ms * 1000000ull);
+
+        while (!dev->unread && dev->running && !dev->failed)
+        {
+            if (timeout_ms < 0)
+                pthread_cond_wait(&dev->avail, &dev->lock);
+            else if (pthread_cond_timedwait(&dev->avail, &dev->lock,
+                                            &ts) == ETIMEDOUT)
+                break;
+        }
+    }
+
+    int rv;
+    if (!dev->unread && dev->failed)
+        rv = -1;
+    else
+    {
+        size_t n = (len < dev->unread) ? len : dev->unread;
+        size_t idx = (dev->head + dev->capacity - dev->unread) % dev->capacity;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            buf[i] = dev->ring[idx];
+            idx = (idx + 1) % dev->capacity;
+        }
+        dev->unread -= n;
+        rv = (int)n;
+    }
+
+    pthread_mutex_unlock(&dev->lock);
+
+    return rv;
+}
+
+void upm_aio_sampler_get_stats(upm_aio_sampler_context dev,
+                               upm_aio_stats_t *stats)
+{
+    assert(dev != NULL && stats != NULL);
+
+    pthread_mutex_lock(&dev->lock);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->count = dev->count;
+    stats->overruns = dev->overruns;
+    stats->dropped = dev->dropped;
+    stats->envelope = (float)dev->envelope;
+
+    if (dev->count)
+    {
+        stats->mean = (float)dev->mean;
+        stats->rms = (float)sqrt(dev->sumsq / dev->count);
+        stats->ac_rms = (float)sqrt(dev->m2 / dev->count);
+        stats->min = dev->min;
+        stats->max = dev->max;
+        stats->peak = (float)fmax(dev->max - dev->mean, dev->mean - dev->min);
+    }
+
+    pthread_mutex_unlock(&dev->lock);
+}
+
+void upm_aio_sampler_reset_stats(upm_aio_sampler_context dev)
+{
+    assert(dev != NULL);
+
+    pthread_mutex_lock(&dev->lock);
+    dev->count = 0;
+    dev->mean = 0.0;
+    dev->m2 = 0.0;
+    dev->sumsq = 0.0;
+    dev->min = 0.0f;
+    dev->max = 0.0f;
+    dev->overruns = 0;
+    dev->dropped = 0;
+    pthread_mutex_unlock(&dev->lock);
+}
+
+upm_result_t upm_aio_sampler_spectrum(upm_aio_sampler_context dev,
+                                      float *mag, size_t n)
+{
+    assert(dev != NULL && mag != NULL);
+
+    if (n < 2 || (n & (n - 1)) || n > dev->capacity)
+        return UPM_ERROR_INVALID_SIZE;
+
+    float *re = (float *)malloc(2 * n * sizeof(float));
+    if (!re)
+        return UPM_ERROR_NO_RESOURCES;
+    float *im = re + n;
+
+    pthread_mutex_lock(&dev->lock);
+    if (dev->fill < n)
+    {
+        pthread_mutex_unlock(&dev->lock);
+        free(re);
+        return UPM_ERROR_NO_DATA;
+    }
+    size_t idx = (dev->head + dev->capacity - n) % dev->capacity;
+    for (size_t i = 0; i < n; i++)
+    {
+        re[i] = dev->ring[idx];
+        idx = (idx + 1) % dev->capacity;
+    }
+    pthread_mutex_unlock(&dev->lock);
+
+    double mean = 0.0;
+    for (size_t i = 0; i < n; i++)
+        mean += re[i];
+    mean /= n;
+
+    // Hann window, its coherent gain is 1/2
+    for (size_t i = 0; i < n; i++)
+    {
+        double w = 0.5 - 0.5 * cos(2.0 * UPM_AIO_PI * i / n);
+        re[i] = (float)((re[i] - mean) * w);
+        im[i] = 0.0f;
+    }
+
+    upm_fft(re, im, n);
+
+    for (size_t i = 0; i <= n / 2; i++)
+    {
+        // one sided: the energy of the negative frequencies is folded
+        // into every bin but DC and Nyquist
+        float scale = (i == 0 || i == n / 2) ? 2.0f / n : 4.0f / n;
+        mag[i] = scale * sqrtf(re[i] * re[i] + im[i] * im[i]);
+    }
+
+    free(re);
+
+    return UPM_SUCCESS;
+}
+
+#endif /* UPM_PLATFORM_LINUX */
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef UPM_AIO_SAMPLER_H_
+#define UPM_AIO_SAMPLER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "upm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file upm_aio_sampler.h
+ * @brief Timed acquisition of analog samples
+ *
+ * Sampling an analog input with a sleep between reads makes the sample
+ * period the sleep time plus the read and scheduling latency, which
+ * varies from read to read.  The sampler instead takes sample k at
+ * start + k / rate, sleeping until that absolute deadline, so latency
+ * delays single samples but never accumulates.  A deadline that has
+ * already passed by a whole period is skipped and counted as an
+ * overrun, keeping the remaining samples on the grid.
+ *
+ * On an ADC with an IIO trigger buffer the samples are timed by the
+ * hardware instead and read in blocks through upm_iio_stream.
+ *
+ * Samples are acquired either in the calling thread, a block at a time
+ * (upm_aio_sampler_capture()), or continuously by a background thread
+ * (upm_aio_sampler_start()) and fetched with upm_aio_sampler_read().
+ * Either way they update running statistics (mean, RMS, extremes and
+ * an envelope follower) and are kept in a ring buffer of recent
+ * history, from which upm_aio_sampler_spectrum() computes a windowed
+ * FFT.
+ *
+ * Sample values are in whatever unit the source returns, usually raw
+ * ADC counts.
+ */
+
+/**
+ * Read one sample, called at each sampling deadline
+ */
+typedef upm_result_t (*upm_sample_read_t)(void *ctx, float *value);
+
+/**
+ * Running statistics since the last reset
+ */
+typedef struct _upm_aio_stats {
+    /* samples seen */
+    uint64_t count;
+    float mean;
+    /* RMS of the samples, and of the samples minus their mean */
+    float rms;
+    float ac_rms;
+    float min;
+    float max;
+    /* largest deviation from the mean */
+    float peak;
+    /* current envelope of the deviation from the DC level */
+    float envelope;
+    /* sampling deadlines missed */
+    uint64_t overruns;
+    /* samples lost because they were not read in time */
+    uint64_t dropped;
+} upm_aio_stats_t;
+
+typedef struct _upm_aio_sampler *upm_aio_sampler_context;
+
+/**
+ * Create a sampler timing reads of a source with absolute deadlines.
+ *
+ * @param read Sample read function
+ * @param ctx Context passed to read
+ * @param rate_hz Sample rate in Hz
+ * @param capacity Samples of history to keep
+ * @return Sampler context, or NULL on failure
+ */
+upm_aio_sampler_context upm_aio_sampler_init(upm_sample_read_t read,
+                                             void *ctx, float rate_hz,
+                                             size_t capacity);
+
+/**
+ * Create a sampler reading a channel of an IIO ADC through its trigger
+ * buffer.  The channel must be enabled and a trigger set up at the
+ * given rate beforehand; the rate is only used to interpret the
+ * samples (envelope times, spectrum frequencies).  Samples are raw ADC
+ * codes.
+ *
+ * @param device IIO device number
+ * @param channel Scan element name, e.g. "voltage0"
+ * @param rate_hz Sample rate of the trigger in Hz
+ * @param capacity Samples of history to keep
+ * @return Sampler context, or NULL on failure
+ */
+upm_aio_sampler_context upm_aio_sampler_init_iio(int device,
+                                                 const char *channel,
+                                                 float rate_hz,
+                                                 size_t capacity);
+
+/**
+ * Stop the sampler if running and free it.
+ *
+ * @param dev Sampler context
+ */
+void upm_aio_sampler_close(upm_aio_sampler_context dev);
+
+/**
+ * Change the sample rate.  Not possible while running.
+ *
+ * @param dev Sampler context
+ * @param rate_hz Sample rate in Hz
+ * @return UPM result
+ */
+upm_result_t upm_aio_sampler_set_rate(upm_aio_sampler_context dev,
+                                      float rate_hz);
+
+/**
+ * Sample rate in Hz.
+ *
+ * @param dev Sampler context
+ * @return Sample rate
+ */
+float upm_aio_sampler_get_rate(const upm_aio_sampler_context dev);
+
+/**
+ * Set the time constants of the envelope follower.  The defaults are
+ * 1 ms attack and 100 ms release.
+ *
+ * @param dev Sampler context
+ * @param attack_ms Rise time constant in milliseconds
+ * @param release_ms Decay time constant in milliseconds
+ */
+void upm_aio_sampler_set_envelope(upm_aio_sampler_context dev,
+                                  float attack_ms, float release_ms);
+
+/**
+ * Acquire count samples in the calling thread.  The samples are added
+ * to the statistics and the history, and copied to out unless it is
+ * NULL.  Not possible while running.
+ *
+ * @param dev Sampler context
+ * @param out Array of count samples, or NULL
+ * @param count Number of samples, at least 1
+ * @return UPM result
+ */
+upm_result_t upm_aio_sampler_capture(upm_aio_sampler_context dev,
+                                     float *out, size_t count);
+
+/**
+ * Start acquiring samples in a background thread.
+ *
+ * @param dev Sampler context
+ * @return UPM result
+ */
+upm_result_t upm_aio_sampler_start(upm_aio_sampler_context dev);
+
+/**
+ * Stop the background thread.  Samples not read yet stay readable.
+ *
+ * @param dev Sampler context
+ */
+void upm_aio_sampler_stop(upm_aio_sampler_context dev);
+
+/**
+ * Fetch samples acquired by the background thread, oldest first.
+ * Waits up to timeout_ms for the first one.  If they are not read in
+ * time, the oldest samples are overwritten and counted as dropped.
+ *
+ * @param dev Sampler context
+ * @param buf Array of len samples
+ * @param len Maximum number of samples
+ * @param timeout_ms Maximum time to wait in milliseconds, 0 to not
+ * wait, -1 to wait forever
+ * @return Number of samples, 0 on timeout, -1 if acquisition failed
+ */
+int upm_aio_sampler_read(upm_aio_sampler_context dev, float *buf, size_t len,
+                         int timeout_ms);
+
+/**
+ * Get the statistics since the last reset.
+ *
+ * @param dev Sampler context
+ * @param stats Statistics
+ */
+void upm_aio_sampler_get_stats(upm_aio_sampler_context dev,
+                               upm_aio_stats_t *stats);
+
+/**
+ * Restart the statistics.  The envelope and the history are kept.
+ *
+ * @param dev Sampler context
+ */
+void upm_aio_sampler_reset_stats(upm_aio_sampler_context dev);
+
+/**
+ * Amplitude spectrum of the latest n samples of history.  The mean is
+ * removed and a Hann window applied; bin i, at i * rate / n Hz, holds
+ * the amplitude of that frequency component in sample units.
+ *
+ * @param dev Sampler context
+ * @param mag Array of n / 2 + 1 amplitudes
+ * @param n Number of samples, a power of 2 no larger than the history
+ * @return UPM result, UPM_ERROR_NO_DATA if fewer than n samples were
+ * acquired yet
+ */
+upm_result_t upm_aio_sampler_spectrum(upm_aio_sampler_context dev,
+                                      float *mag, size_t n);
+
+/**
+ * In place complex FFT.
+ *
+ * @param re Real parts
+ * @param im Imaginary parts
+ * @param n Number of points, a power of 2
+ * @return UPM result
+ */
+upm_result_t upm_fft(float *re, float *im, size_t n);
+
+/**
+ * Frequency of the strongest non-DC component of an amplitude
+ * spectrum, interpolated between bins.
+ *
+ * @param mag Amplitude spectrum from upm_aio_sampler_spectrum()
+ * @param n Number of samples the spectrum was computed from
+ * @param rate_hz Sample rate in Hz
+ * @return Frequency in Hz
+ */
+float upm_spectrum_peak(const float *mag, size_t n, float rate_hz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPM_AIO_SAMPLER_H_ */
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "upm_bringup.hpp"
+
+using namespace upm;
+
+namespace {
+    enum State { PENDING, RUNNING, DONE, FAILED };
+
+    struct Job {
+        /* previous device on the same bus, or -1 */
+        int busPrev;
+        /* devices named in after */
+        std::vector<size_t> deps;
+        State state;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    double msSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now()
+                                                         - start).count();
+    }
+}
+
+void BringUp::add(const std::string &name, const std::string &bus,
+                  InitFunc init, const std::vector<std::string> &after)
+{
+    for (const Device &d : m_devices)
+        if (d.name == name)
+            throw std::invalid_argument(std::string(__FUNCTION__) +
+                                        ": duplicate device name " + name);
+
+    Device d;
+    d.name = name;
+    d.bus = bus;
+    d.init = init;
+    d.after = after;
+    m_devices.push_back(d);
+}
+
+std::vector<BringUpResult> BringUp::run(unsigned int maxThreads)
+{
+    size_t count = m_devices.size();
+    std::vector<BringUpResult> results(count);
+    std::vector<Job> jobs(count);
+    std::map<std::string, size_t> byName;
+    std::map<std::string, size_t> lastOnBus;
+    std::set<std::string> buses;
+    unsigned int chains = 0;
+
+    for (size_t i = 0; i < count; i++)
+        byName[m_devices[i].name] = i;
+
+    // resolve the ordering up front, so a bad manifest fails before
+    // any device is touched
+    for (size_t i = 0; i < count; i++)
+    {
+        const Device &d = m_devices[i];
+        Job &job = jobs[i];
+
+        job.state = PENDING;
+        job.busPrev = -1;
+        if (!d.bus.empty())
+        {
+            auto it = lastOnBus.find(d.bus);
+            if (it != lastOnBus.end())
+                job.busPrev = it->second;
+            lastOnBus[d.bus] = i;
+            buses.insert(d.bus);
+        }
+        else
+            chains++;
+
+        for (const std::string &name : d.after)
+        {
+            auto it = byName.find(name);
+            if (it == byName.end())
+                throw std::invalid_argument(std::string(__FUNCTION__) +
+                                            ": " + d.name +
+                                            " waits for unknown device " +
+                                            name);
+            job.deps.push_back(it->second);
+        }
+
+        results[i].name = d.name;
+        results[i].bus = d.bus;
+        results[i].ok = false;
+        results[i].startMs = 0;
+        results[i].initMs = 0;
+    }
+
+    chains += buses.size();
+    unsigned int nthreads = chains;
+    if (maxThreads && maxThreads < nthreads)
+        nthreads = maxThreads;
+
+    std::mutex lock;
+    std::condition_variable cond;
+    size_t pending = count;
+    unsigned int running = 0;
+    Clock::time_point start = Clock::now();
+
+    // Pick the first device that may start, mark the ones that never
+    // will.  Called with the lock held, returns count if none.
+    auto next = [&]() -> size_t {
+        for (size_t i = 0; i < count; i++)
+        {
+            Job &job = jobs[i];
+            if (job.state != PENDING)
+                continue;
+
+            if (job.busPrev >= 0 && (jobs[job.busPrev].state == PENDING ||
+                                     jobs[job.busPrev].state == RUNNING))
+                continue;
+
+            bool ready = true;
+            std::string failed;
+            for (size_t dep : job.deps)
+            {
+                if (jobs[dep].state == FAILED && failed.empty())
+                    failed = m_devices[dep].name;
+                else if (jobs[dep].state != DONE)
+                    ready = false;
+            }
+
+            if (!failed.empty())
+            {
+                job.state = FAILED;
+                results[i].error = "skipped, " + failed + " failed";
+                pending--;
+                // devices waiting for this one may be decided now
+                i = (size_t)-1;
+                continue;
+            }
+
+            if (ready)
+                return i;
+        }
+
+        // nothing can start and nothing is running: the rest wait for
+        // each other
+        if (pending && !running)
+        {
+            for (size_t i = 0; i < count; i++)
+                if (jobs[i].state == PENDING)
+                {
+                    jobs[i].state = FAILED;
+                    results[i].error = "skipped, circular wait";
+                }
+            pending = 0;
+        }
+
+        return count;
+    };
+
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> guard(lock);
+
+        while (pending)
+        {
+            size_t i = next();
+            if (i == count)
+            {
+                if (pending)
+                    cond.wait(guard);
+                continue;
+            }
+
+            jobs[i].state = RUNNING;
+            pending--;
+            running++;
+            guard.unlock();
+
+            BringUpResult &r = results[i];
+            r.startMs = msSince(start);
+            try
+            {
+                m_devices[i].init();
+                r.ok = true;
+            }
+            catch (const std::exception &e)
+            {
+                r.error = e.what();
+            }
+            catch (...)
+            {
+                r.error = "unknown exception";
+            }
+            r.initMs = msSince(start) - r.startMs;
+
+            guard.lock();
+            jobs[i].state = r.ok ? DONE : FAILED;
+            running--;
+            cond.notify_all();
+        }
+
+        // wake the others, there is nothing left for them
+        cond.notify_all();
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 1; t < nthreads; t++)
+        threads.push_back(std::thread(worker));
+    if (nthreads)
+        worker();
+    for (std::thread &t : threads)
+        t.join();
+
+    return results;
+}
+
+std::string BringUp::busKey(const std::string &initStr)
+{
+    std::istringstream in(initStr);
+    std::string tok;
+
+    while (std::getline(in, tok, ','))
+    {
+        size_t colon = tok.find(':');
+        if (colon == std::string::npos)
+            continue;
+
+        std::string type = tok.substr(0, colon);
+        std::string rest = tok.substr(colon + 1);
+        std::string bus = rest.substr(0, rest.find(':'));
+
+        if (bus.empty())
+            continue;
+        if (type == "i")
+            return "i2c:" + bus;
+        if (type == "s")
+            return "spi:" + bus;
+        if (type == "u")
+            return "uart:" + bus;
+    }
+
+    return "";
+}
+
+std::string BringUp::report(const std::vector<BringUpResult> &results)
+{
+    std::ostringstream out;
+    double total = 0, serial = 0;
+    char line[160];
+
+    for (const BringUpResult &r : results)
+    {
+        snprintf(line, sizeof(line), "%-20s %-10s %9.1f ms %9.1f ms  ",
+                 r.name.c_str(), r.bus.empty() ? "-" : r.bus.c_str(),
+                 r.startMs, r.initMs);
+        out << line << (r.ok ? "ok" : r.error) << std::endl;
+
+        if (r.startMs + r.initMs > total)
+            total = r.startMs + r.initMs;
+        serial += r.initMs;
+    }
+
+    snprintf(line, sizeof(line), "total %.1f ms, %.1f ms one at a time",
+             total, serial);
+    out << line << std::endl;
+
+    return out.str();
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace upm {
+
+    /**
+     * @brief Outcome of bringing up one device
+     */
+    struct BringUpResult {
+        /** Device name, as given to BringUp::add() */
+        std::string name;
+        /** Bus key */
+        std::string bus;
+        /** True if the init function returned normally */
+        bool ok;
+        /** Exception message, or why the device was skipped */
+        std::string error;
+        /** Start of the init function, in milliseconds from run() */
+        double startMs;
+        /** Time spent in the init function, in milliseconds */
+        double initMs;
+    };
+
+    /**
+     * @brief Concurrent bring-up of a set of devices
+     *
+     * Constructing devices one after another makes the total start up
+     * time the sum of every driver's reset and settle delays.  BringUp
+     * takes a manifest of devices, each with an init function (usually
+     * constructing the driver object) and the bus it sits on, and runs
+     * the init functions of devices on different buses concurrently.
+     * Devices on the same bus are brought up one at a time, in the
+     * order they were added, and a device can also be made to wait
+     * for other devices, e.g. a sensor switched on through a GPIO:
+     *
+     *   upm::BringUp b;
+     *   b.add("power", "", [&] { pwr.reset(new mraa::Gpio(7));
+     *                            pwr->dir(mraa::DIR_OUT_HIGH); });
+     *   b.add("mux", "i2c:0", [&] { mux.reset(new upm::TCA9548A(0)); });
+     *   b.add("lcd", "i2c:0", [&] { lcd.reset(new upm::Lcm1602(0, 0x27)); });
+     *   b.add("nfc", "i2c:1", [&] { nfc.reset(new upm::PN532(...));
+     *                               nfc->init(); });
+     *   b.add("rsc", "spi:0", [&] { rsc.reset(new upm::RSC(0, 9, 8)); },
+     *         {"power"});
+     *   std::cout << upm::BringUp::report(b.run());
+     *
+     * Init functions report failure by throwing, as the driver
+     * constructors do; the other devices are still brought up, except
+     * those waiting for the failed one.
+     *
+     * Drivers keep the bus to themselves while they sleep through a
+     * settle delay.  Where a driver records a ready deadline instead
+     * (see upm_clock_deadline_us()), its init returns early and the
+     * next device on the bus is brought up during the wait.
+     */
+    class BringUp {
+    public:
+        typedef std::function<void()> InitFunc;
+
+        /**
+         * Add a device to the manifest.
+         *
+         * @param name Unique device name
+         * @param bus Bus key, any string naming the bus, e.g. "i2c:0"
+         * (see busKey()).  Empty if the device shares no bus.
+         * @param init Init function
+         * @param after Names of devices that must be up first
+         */
+        void add(const std::string &name, const std::string &bus,
+                 InitFunc init,
+                 const std::vector<std::string> &after =
+                 std::vector<std::string>());
+
+        /**
+         * Bring up every device in the manifest and wait for them.
+         *
+         * @param maxThreads Number of devices brought up at the same
+         * time at most, 0 for as many as the buses allow
+         * @return One result per device, in manifest order
+         */
+        std::vector<BringUpResult> run(unsigned int maxThreads = 0);
+
+        /**
+         * Bus key for a device from its MRAA init string, e.g. "i2c:1"
+         * for "i:1:0x40" or "spi:0" for "s:0:9".  The first I2C, SPI
+         * or UART descriptor counts.
+         *
+         * @param initStr Init string
+         * @return Bus key, empty if the string names no bus
+         */
+        static std::string busKey(const std::string &initStr);
+
+        /**
+         * Format results as text, one line per device, followed by the
+         * total time.
+         *
+         * @param results Results from run()
+         * @return String
+         */
+        static std::string report(const std::vector<BringUpResult> &results);
+
+    private:
+        struct Device {
+            std::string name;
+            std::string bus;
+            InitFunc init;
+            std::vector<std::string> after;
+        };
+
+        std::vector<Device> m_devices;
+    };
+}
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "upm_platform.h"
+#include "upm_bus_stats.h"
+
+#if defined(UPM_PLATFORM_LINUX)
+#include <pthread.h>
+
+static pthread_mutex_t _list_lock = PTHREAD_MUTEX_INITIALIZER;
+# define LIST_LOCK()    pthread_mutex_lock(&_list_lock)
+# define LIST_UNLOCK()  pthread_mutex_unlock(&_list_lock)
+#else
+# define LIST_LOCK()
+# define LIST_UNLOCK()
+#endif
+
+// Counters are updated by the thread doing the I/O and may be read
+// concurrently by a scraper, so use relaxed atomics.  Only the
+// individual counters are atomic, not the block as a whole.
+#define STAT_ADD(var, val) __atomic_fetch_add(&(var), (val), __ATOMIC_RELAXED)
+#define STAT_GET(var)      __atomic_load_n(&(var), __ATOMIC_RELAXED)
+#define STAT_SET(var, val) __atomic_store_n(&(var), (val), __ATOMIC_RELAXED)
+
+static upm_bus_stats_t *_stats_list = NULL;
+
+static int _hist_index(uint64_t ns)
+{
+    if (ns < 2 * UPM_BUS_HIST_SUB_COUNT)
+        return (int)ns;
+
+    int msb = 63 - __builtin_clzll(ns);
+    if (msb >= UPM_BUS_HIST_MAX_BITS)
+        return UPM_BUS_HIST_BUCKETS - 1;
+
+    int shift = msb - UPM_BUS_HIST_SUB_BITS;
+
+    return ((shift + 1) * UPM_BUS_HIST_SUB_COUNT)
+        + (int)((ns >> shift) - UPM_BUS_HIST_SUB_COUNT);
+}
+
+// Highest value that maps to bucket idx
+static uint64_t _hist_upper(int idx)
+{
+    if (idx < 2 * UPM_BUS_HIST_SUB_COUNT)
+        return idx;
+
+    int shift = (idx / UPM_BUS_HIST_SUB_COUNT) - 1;
+    uint64_t base = (uint64_t)((idx % UPM_BUS_HIST_SUB_COUNT)
+                               + UPM_BUS_HIST_SUB_COUNT) << shift;
+
+    return base + ((uint64_t)1 << shift) - 1;
+}
+
+void upm_bus_hist_init(upm_bus_hist_t *hist)
+{
+    for (int i = 0; i < UPM_BUS_HIST_BUCKETS; i++)
+        STAT_SET(hist->counts[i], 0);
+    STAT_SET(hist->count, 0);
+    STAT_SET(hist->total_ns, 0);
+    STAT_SET(hist->min_ns, UINT64_MAX);
+    STAT_SET(hist->max_ns, 0);
+}
+
+void upm_bus_hist_record(upm_bus_hist_t *hist, uint64_t ns)
+{
+    STAT_ADD(hist->counts[_hist_index(ns)], 1);
+    STAT_ADD(hist->count, 1);
+    STAT_ADD(hist->total_ns, ns);
+
+    uint64_t cur = STAT_GET(hist->min_ns);
+    while (ns < cur
+           && !__atomic_compare_exchange_n(&hist->min_ns, &cur, ns, 0,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    cur = STAT_GET(hist->max_ns);
+    while (ns > cur
+           && !__atomic_compare_exchange_n(&hist->max_ns, &cur, ns, 0,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+uint64_t upm_bus_hist_percentile(const upm_bus_hist_t *hist,
+                                 double percentile)
+{
+    uint64_t count = STAT_GET(hist->count);
+    if (!count)
+        return 0;
+
+    if (percentile < 0.0)
+        percentile = 0.0;
+    if (percentile > 100.0)
+        percentile = 100.0;
+
+    uint64_t target = (uint64_t)((percentile / 100.0) * count + 0.5);
+    if (!target)
+        target = 1;
+
+    uint64_t max = STAT_GET(hist->max_ns);
+    uint64_t seen = 0;
+    for (int i = 0; i < UPM_BUS_HIST_BUCKETS; i++)
+    {
+        seen += STAT_GET(hist->counts[i]);
+        if (seen >= target)
+        {
+            uint64_t val = _hist_upper(i);
+            return (val > max) ? max : val;
+        }
+    }
+
+    return max;
+}
+
+uint64_t upm_bus_hist_mean(const upm_bus_hist_t *hist)
+{
+    uint64_t count = STAT_GET(hist->count);
+    if (!count)
+        return 0;
+
+    return STAT_GET(hist->total_ns) / count;
+}
+
+uint64_t upm_bus_hist_min(const upm_bus_hist_t *hist)
+{
+    if (!STAT_GET(hist->count))
+        return 0;
+
+    return STAT_GET(hist->min_ns);
+}
+
+upm_bus_stats_t *upm_bus_stats_register(const char *name, int bus, int addr)
+{
+    upm_bus_stats_t *stats =
+        (upm_bus_stats_t *)calloc(1, sizeof(upm_bus_stats_t));
+
+    if (!stats)
+    {
+        printf("%s: calloc() failed\n", __FUNCTION__);
+        return NULL;
+    }
+
+    strncpy(stats->name, name ? name : "", sizeof(stats->name) - 1);
+    stats->bus = bus;
+    stats->addr = addr;
+    upm_bus_hist_init(&stats->latency);
+
+    LIST_LOCK();
+    stats->next = _stats_list;
+    _stats_list = stats;
+    LIST_UNLOCK();
+
+    return stats;
+}
+
+void upm_bus_stats_unregister(upm_bus_stats_t *stats)
+{
+    if (!stats)
+        return;
+
+    LIST_LOCK();
+    upm_bus_stats_t **pp = &_stats_list;
+    while (*pp && *pp != stats)
+        pp = &(*pp)->next;
+    if (*pp)
+        *pp = stats->next;
+    LIST_UNLOCK();
+
+    free(stats);
+}
+
+void upm_bus_stats_record(upm_bus_stats_t *stats, uint64_t ns,
+                          int rd, int wr, int ok)
+{
+    if (!stats)
+        return;
+
+    STAT_ADD(stats->transactions, 1);
+    if (rd > 0)
+        STAT_ADD(stats->bytes_read, (uint64_t)rd);
+    if (wr > 0)
+        STAT_ADD(stats->bytes_written, (uint64_t)wr);
+    if (!ok)
+        STAT_ADD(stats->errors, 1);
+
+    upm_bus_hist_record(&stats->latency, ns);
+}
+
+void upm_bus_stats_reset(upm_bus_stats_t *stats)
+{
+    if (!stats)
+        return;
+
+    STAT_SET(stats->transactions, 0);
+    STAT_SET(stats->bytes_read, 0);
+    STAT_SET(stats->bytes_written, 0);
+    STAT_SET(stats->errors, 0);
+
+    upm_bus_hist_init(&stats->latency);
+}
+
+void upm_bus_stats_reset_all(void)
+{
+    LIST_LOCK();
+    for (upm_bus_stats_t *s = _stats_list; s; s = s->next)
+        upm_bus_stats_reset(s);
+    LIST_UNLOCK();
+}
+
+void upm_bus_stats_foreach(upm_bus_stats_cb_t cb, void *arg)
+{
+    if (!cb)
+        return;
+
+    LIST_LOCK();
+    for (upm_bus_stats_t *s = _stats_list; s; s = s->next)
+        cb(s, arg);
+    LIST_UNLOCK();
+}
+
+static void _dump_one(const upm_bus_stats_t *s, void *arg)
+{
+    FILE *fp = (FILE *)arg;
+
+    fprintf(fp, "%s bus=%d addr=%d txns=%" PRIu64 " rd=%" PRIu64
+            " wr=%" PRIu64 " errs=%" PRIu64
+            " min=%" PRIu64 " mean=%" PRIu64 " p50=%" PRIu64
+            " p90=%" PRIu64 " p99=%" PRIu64 " max=%" PRIu64 "\n",
+            s->name, s->bus, s->addr,
+            STAT_GET(s->transactions), STAT_GET(s->bytes_read),
+            STAT_GET(s->bytes_written), STAT_GET(s->errors),
+            upm_bus_hist_min(&s->latency), upm_bus_hist_mean(&s->latency),
+            upm_bus_hist_percentile(&s->latency, 50.0),
+            upm_bus_hist_percentile(&s->latency, 90.0),
+            upm_bus_hist_percentile(&s->latency, 99.0),
+            STAT_GET(s->latency.max_ns));
+}
+
+void upm_bus_stats_dump(FILE *fp)
+{
+    if (!fp)
+        return;
+
+    upm_bus_stats_foreach(_dump_one, fp);
+}
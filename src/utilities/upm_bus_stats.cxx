@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "upm_platform.h"
+#include "upm_bus_stats.h"
+#include "upm_bus_stats.hpp"
+
+using namespace upm;
+
+// the counters are updated with relaxed atomics by the I/O threads,
+// see upm_bus_stats.c
+#define STAT_GET(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+
+static void snapshot(const upm_bus_stats_t *s, void *arg)
+{
+    std::vector<BusStats> *list = (std::vector<BusStats> *)arg;
+    BusStats b;
+
+    b.name = s->name;
+    b.bus = s->bus;
+    b.addr = s->addr;
+    b.transactions = STAT_GET(s->transactions);
+    b.bytesRead = STAT_GET(s->bytes_read);
+    b.bytesWritten = STAT_GET(s->bytes_written);
+    b.errors = STAT_GET(s->errors);
+    b.latencyMin = upm_bus_hist_min(&s->latency);
+    b.latencyMean = upm_bus_hist_mean(&s->latency);
+    b.latencyP50 = upm_bus_hist_percentile(&s->latency, 50.0);
+    b.latencyP90 = upm_bus_hist_percentile(&s->latency, 90.0);
+    b.latencyP99 = upm_bus_hist_percentile(&s->latency, 99.0);
+    b.latencyMax = STAT_GET(s->latency.max_ns);
+
+    list->push_back(b);
+}
+
+std::vector<BusStats> upm::getBusStats()
+{
+    std::vector<BusStats> list;
+
+    upm_bus_stats_foreach(snapshot, &list);
+
+    return list;
+}
+
+void upm::resetBusStats()
+{
+    upm_bus_stats_reset_all();
+}
+
+std::string upm::dumpBusStats()
+{
+#if defined(UPM_PLATFORM_LINUX)
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *fp = open_memstream(&buf, &len);
+
+    if (!fp)
+        return std::string();
+
+    upm_bus_stats_dump(fp);
+    fclose(fp);
+
+    std::string rv(buf, len);
+    free(buf);
+
+    return rv;
+#else
+    // no open_memstream(), use upm_bus_stats_dump() or getBusStats()
+    return std::string();
+#endif
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef UPM_BUS_STATS_H_
+#define UPM_BUS_STATS_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "upm_utilities.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file upm_bus_stats.h
+ * @brief Per-device bus transaction statistics
+ *
+ * Drivers built with UPM_BUS_STATS defined (cmake -DBUILDBUSSTATS=on)
+ * register a statistics block for each device they open, and record
+ * every transaction made by their register access helpers: the
+ * number of bytes read and written, failures and the time spent on
+ * the bus.
+ *
+ * Without UPM_BUS_STATS the driver side macros below compile to
+ * nothing.  The query API is always available, and simply reports no
+ * devices.
+ */
+
+/* Latency histogram resolution.  Values are kept in log-linear
+ * buckets: 2^UPM_BUS_HIST_SUB_BITS linear buckets per power of two,
+ * for a worst case relative error of 1/8 (12.5%). */
+#define UPM_BUS_HIST_SUB_BITS   3
+#define UPM_BUS_HIST_SUB_COUNT  (1 << UPM_BUS_HIST_SUB_BITS)
+/* Highest tracked latency, 2^40ns (~18 minutes) */
+#define UPM_BUS_HIST_MAX_BITS   40
+#define UPM_BUS_HIST_BUCKETS \
+    ((UPM_BUS_HIST_MAX_BITS - UPM_BUS_HIST_SUB_BITS + 1) * UPM_BUS_HIST_SUB_COUNT)
+
+/**
+ * Latency histogram, in nanoseconds
+ */
+typedef struct _upm_bus_hist {
+    uint64_t counts[UPM_BUS_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t total_ns;
+    /* UINT64_MAX until the first value, see upm_bus_hist_min() */
+    uint64_t min_ns;
+    uint64_t max_ns;
+} upm_bus_hist_t;
+
+/**
+ * Statistics for a single device
+ */
+typedef struct _upm_bus_stats {
+    /* driver name, e.g. "bmp280" */
+    char name[16];
+    /* bus number, and I2C address (-1 for SPI) */
+    int bus;
+    int addr;
+
+    uint64_t transactions;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+    uint64_t errors;
+
+    upm_bus_hist_t latency;
+
+    struct _upm_bus_stats *next;
+} upm_bus_stats_t;
+
+/**
+ * Callback type for upm_bus_stats_foreach()
+ */
+typedef void (*upm_bus_stats_cb_t)(const upm_bus_stats_t *stats, void *arg);
+
+/**
+ * Allocate a statistics block for a device and add it to the global
+ * list.  Drivers should use UPM_BUS_STATS_REGISTER() instead.
+ *
+ * @param name Driver name, truncated to 15 characters
+ * @param bus Bus number
+ * @param addr I2C address, or -1 for SPI
+ * @return New statistics block, or NULL on allocation failure
+ */
+upm_bus_stats_t *upm_bus_stats_register(const char *name, int bus, int addr);
+
+/**
+ * Remove a statistics block from the global list and free it.
+ *
+ * @param stats Block returned by upm_bus_stats_register(), may be NULL
+ */
+void upm_bus_stats_unregister(upm_bus_stats_t *stats);
+
+/**
+ * Record a bus transaction.  Drivers should use UPM_BUS_STATS_END()
+ * instead.
+ *
+ * @param stats Statistics block, may be NULL
+ * @param ns Time spent on the bus, in nanoseconds
+ * @param rd Number of bytes read
+ * @param wr Number of bytes written
+ * @param ok Zero if the transaction failed
+ */
+void upm_bus_stats_record(upm_bus_stats_t *stats, uint64_t ns,
+                          int rd, int wr, int ok);
+
+/**
+ * Zero all counters and the latency histogram of a device.
+ *
+ * @param stats Statistics block
+ */
+void upm_bus_stats_reset(upm_bus_stats_t *stats);
+
+/**
+ * Zero the counters of every registered device.
+ */
+void upm_bus_stats_reset_all(void);
+
+/**
+ * Call cb for every registered device, with the device list locked.
+ * The callback must not open or close devices.
+ *
+ * @param cb Callback
+ * @param arg Passed to the callback
+ */
+void upm_bus_stats_foreach(upm_bus_stats_cb_t cb, void *arg);
+
+/**
+ * Print the statistics of every registered device, one line per
+ * device.
+ *
+ * @param fp Output stream
+ */
+void upm_bus_stats_dump(FILE *fp);
+
+/**
+ * Empty a latency histogram.
+ *
+ * @param hist Histogram
+ */
+void upm_bus_hist_init(upm_bus_hist_t *hist);
+
+/**
+ * Add a value to a latency histogram.
+ *
+ * @param hist Histogram
+ * @param ns Value in nanoseconds
+ */
+void upm_bus_hist_record(upm_bus_hist_t *hist, uint64_t ns);
+
+/**
+ * Return the value at a given percentile of a latency histogram.
+ * The result is the upper bound of the bucket holding that
+ * percentile, clamped to the recorded maximum.
+ *
+ * @param hist Histogram
+ * @param percentile Percentile, from 0.0 to 100.0
+ * @return Latency in nanoseconds, or 0 if the histogram is empty
+ */
+uint64_t upm_bus_hist_percentile(const upm_bus_hist_t *hist,
+                                 double percentile);
+
+/**
+ * Return the mean of a latency histogram.
+ *
+ * @param hist Histogram
+ * @return Mean latency in nanoseconds, or 0 if the histogram is empty
+ */
+uint64_t upm_bus_hist_mean(const upm_bus_hist_t *hist);
+
+/**
+ * Return the lowest value of a latency histogram.
+ *
+ * @param hist Histogram
+ * @return Minimum latency in nanoseconds, or 0 if the histogram is empty
+ */
+uint64_t upm_bus_hist_min(const upm_bus_hist_t *hist);
+
+/*
+ * Driver side hooks.  Typical use in a register read helper:
+ *
+ *     UPM_BUS_STATS_BEGIN(clk);
+ *     int rv = mraa_i2c_read_bytes_data(dev->i2c, reg, buffer, len);
+ *     UPM_BUS_STATS_END(dev->bus_stats, clk, len, 1, rv == len);
+ *
+ * The context always carries the upm_bus_stats_t pointer, so the
+ * structure layout does not depend on UPM_BUS_STATS.
+ */
+#if defined(UPM_BUS_STATS)
+
+# define UPM_BUS_STATS_REGISTER(stats, name, bus, addr) \
+    ((stats) = upm_bus_stats_register((name), (bus), (addr)))
+# define UPM_BUS_STATS_UNREGISTER(stats) \
+    do { upm_bus_stats_unregister(stats); (stats) = NULL; } while (0)
+# define UPM_BUS_STATS_BEGIN(clk) \
+    upm_clock_t clk = upm_clock_init()
+# define UPM_BUS_STATS_END(stats, clk, rd, wr, ok) \
+    upm_bus_stats_record((stats), upm_elapsed_ns(&(clk)), (rd), (wr), (ok))
+
+#else
+
+# define UPM_BUS_STATS_REGISTER(stats, name, bus, addr) ((void)0)
+# define UPM_BUS_STATS_UNREGISTER(stats) ((void)0)
+# define UPM_BUS_STATS_BEGIN(clk) ((void)0)
+# define UPM_BUS_STATS_END(stats, clk, rd, wr, ok) ((void)0)
+
+#endif /* UPM_BUS_STATS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPM_BUS_STATS_H_ */
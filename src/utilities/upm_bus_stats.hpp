@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace upm {
+
+    /**
+     * @brief Bus statistics for one device
+     *
+     * A snapshot of the counters kept for a device opened by a driver
+     * built with bus statistics enabled (cmake -DBUILDBUSSTATS=on).
+     * See upm_bus_stats.h.
+     */
+    struct BusStats {
+        /** Driver name */
+        std::string name;
+        /** Bus number */
+        int bus;
+        /** I2C address, or -1 for SPI */
+        int addr;
+
+        uint64_t transactions;
+        uint64_t bytesRead;
+        uint64_t bytesWritten;
+        uint64_t errors;
+
+        /** Latency distribution, in nanoseconds */
+        uint64_t latencyMin;
+        uint64_t latencyMean;
+        uint64_t latencyP50;
+        uint64_t latencyP90;
+        uint64_t latencyP99;
+        uint64_t latencyMax;
+    };
+
+    /**
+     * Return a snapshot of the statistics of every open device.  The
+     * list is empty unless drivers were built with bus statistics
+     * enabled.
+     *
+     * @return Vector of BusStats
+     */
+    std::vector<BusStats> getBusStats();
+
+    /**
+     * Zero the statistics of every open device.
+     */
+    void resetBusStats();
+
+    /**
+     * Return the statistics of every open device as text, one line
+     * per device.  Only available on Linux.
+     *
+     * @return String, empty on other platforms
+     */
+    std::string dumpBusStats();
+}
@@ -0,0 +1,584 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _POSIX_C_SOURCE
+# define _POSIX_C_SOURCE 200809L
+#endif
+/* realpath() */
+#ifndef _XOPEN_SOURCE
+# define _XOPEN_SOURCE 700
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "upm_cal_store.h"
+
+#define CAL_MAGIC "UPMC"
+#define CAL_VERSION 1
+#define CAL_HEADER_SIZE 8
+#define CAL_MAX_BLOB 65535
+#define CAL_MAX_PATH 4096
+
+typedef struct _cal_entry {
+    char *key;
+    uint8_t *blob;
+    size_t len;
+    struct _cal_entry *next;
+} cal_entry_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t g_idle = PTHREAD_COND_INITIALIZER;
+
+/* store file, once resolved */
+static char g_path[CAL_MAX_PATH];
+static bool g_path_known = false;
+
+/* background writer */
+static cal_entry_t *g_queue = NULL;
+static bool g_writing = false;
+static bool g_thread_started = false;
+static upm_result_t g_last_result = UPM_SUCCESS;
+
+/* serializes file access between threads; fcntl() locks only work
+ * between processes */
+static pthread_mutex_t g_io_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t crc32(const uint8_t *buf, size_t len)
+{
+    uint32_t crc = 0xffffffff;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= buf[i];
+        for (int b = 0; b < 8; b++)
+            crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+
+    return ~crc;
+}
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, v & 0xffff);
+    put16(p + 2, v >> 16);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static void free_entries(cal_entry_t *e)
+{
+    while (e)
+    {
+        cal_entry_t *next = e->next;
+        free(e->key);
+        free(e->blob);
+        free(e);
+        e = next;
+    }
+}
+
+static cal_entry_t *new_entry(const char *key, size_t keylen,
+                              const void *blob, size_t len)
+{
+    cal_entry_t *e = calloc(1, sizeof(cal_entry_t));
+    if (!e)
+        return NULL;
+
+    e->key = malloc(keylen + 1);
+    e->blob = malloc(len ? len : 1);
+    if (!e->key || !e->blob)
+    {
+        free_entries(e);
+        return NULL;
+    }
+
+    memcpy(e->key, key, keylen);
+    e->key[keylen] = 0;
+    memcpy(e->blob, blob, len);
+    e->len = len;
+
+    return e;
+}
+
+static cal_entry_t *find_entry(cal_entry_t *list, const char *key)
+{
+    for (; list; list = list->next)
+        if (!strcmp(list->key, key))
+            return list;
+
+    return NULL;
+}
+
+static upm_result_t check_args(const char *key, const void *blob, size_t len)
+{
+    if (!key || !*key || strlen(key) > UPM_CAL_STORE_MAX_KEY || !blob)
+        return UPM_ERROR_INVALID_PARAMETER;
+    if (len > CAL_MAX_BLOB)
+        return UPM_ERROR_INVALID_SIZE;
+
+    return UPM_SUCCESS;
+}
+
+/* Copy the store file name to path, false if the store is off */
+static bool get_path(char *path)
+{
+    pthread_mutex_lock(&g_lock);
+
+    if (!g_path_known)
+    {
+        const char *env = getenv("UPM_CAL_STORE");
+
+        g_path[0] = 0;
+        if (env && strlen(env) < CAL_MAX_PATH)
+            strcpy(g_path, env);
+        g_path_known = true;
+    }
+
+    strcpy(path, g_path);
+
+    pthread_mutex_unlock(&g_lock);
+
+    return path[0] != 0;
+}
+
+/* Read and check the store file.  A missing or damaged file reads as
+ * an empty store. */
+static cal_entry_t *read_store(const char *path)
+{
+    cal_entry_t *list = NULL, **tail = &list;
+    uint8_t *buf = NULL;
+    struct stat st;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return NULL;
+
+    if (fstat(fd, &st) || st.st_size < CAL_HEADER_SIZE + 4
+        || !(buf = malloc(st.st_size)))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = st.st_size, got = 0;
+    while (got < size)
+    {
+        ssize_t n = read(fd, buf + got, size - got);
+        if (n <= 0)
+            break;
+        got += n;
+    }
+    close(fd);
+
+    if (got != size || memcmp(buf, CAL_MAGIC, 4) || buf[4] != CAL_VERSION
+        || get32(buf + size - 4) != crc32(buf, size - 4))
+    {
+        fprintf(stderr, "%s: ignoring damaged calibration store %s\n",
+                __FUNCTION__, path);
+        free(buf);
+        return NULL;
+    }
+
+    size_t pos = CAL_HEADER_SIZE, end = size - 4;
+    int count = get16(buf + 6);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (pos + 1 > end)
+            break;
+        size_t keylen = buf[pos++];
+        if (pos + keylen + 2 > end)
+            break;
+        const char *key = (const char *)buf + pos;
+        pos += keylen;
+        size_t len = get16(buf + pos);
+        pos += 2;
+        if (pos + len > end)
+            break;
+
+        cal_entry_t *e = new_entry(key, keylen, buf + pos, len);
+        if (!e)
+            break;
+        *tail = e;
+        tail = &e->next;
+        pos += len;
+    }
+
+    free(buf);
+
+    return list;
+}
+
+/* Write the store to a temporary file and rename it over the old one */
+static upm_result_t write_store(const char *path, const cal_entry_t *list)
+{
+    char tmp[CAL_MAX_PATH + 8];
+    size_t size = CAL_HEADER_SIZE + 4;
+    int count = 0;
+    const cal_entry_t *e;
+
+    for (e = list; e; e = e->next, count++)
+        size += 1 + strlen(e->key) + 2 + e->len;
+
+    if (count > 0xffff)
+        return UPM_ERROR_OUT_OF_RANGE;
+
+    uint8_t *buf = malloc(size), *p = buf;
+    if (!buf)
+        return UPM_ERROR_NO_RESOURCES;
+
+    memcpy(p, CAL_MAGIC, 4);
+    p[4] = CAL_VERSION;
+    p[5] = 0;
+    put16(p + 6, count);
+    p += CAL_HEADER_SIZE;
+
+    for (e = list; e; e = e->next)
+    {
+        size_t keylen = strlen(e->key);
+        *p++ = keylen;
+        memcpy(p, e->key, keylen);
+        p += keylen;
+        put16(p, e->len);
+        p += 2;
+        memcpy(p, e->blob, e->len);
+        p += e->len;
+    }
+    put32(p, crc32(buf, size - 4));
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    upm_result_t rv = UPM_ERROR_OPERATION_FAILED;
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0)
+    {
+        size_t done = 0;
+        while (done < size)
+        {
+            ssize_t n = write(fd, buf + done, size - done);
+            if (n <= 0)
+                break;
+            done += n;
+        }
+
+        if (done == size && !fsync(fd))
+            rv = UPM_SUCCESS;
+        close(fd);
+
+        if (rv == UPM_SUCCESS && rename(tmp, path))
+            rv = UPM_ERROR_OPERATION_FAILED;
+        if (rv != UPM_SUCCESS)
+            unlink(tmp);
+    }
+
+    if (rv != UPM_SUCCESS)
+        fprintf(stderr, "%s: writing %s failed: %s\n", __FUNCTION__, path,
+                strerror(errno));
+
+    free(buf);
+
+    return rv;
+}
+
+/* Merge updates into the store file, under the process and file locks */
+static upm_result_t save_entries(const cal_entry_t *updates)
+{
+    char path[CAL_MAX_PATH], lockpath[CAL_MAX_PATH + 8];
+    struct flock fl;
+    upm_result_t rv;
+
+    if (!get_path(path))
+        return UPM_SUCCESS;
+
+    snprintf(lockpath, sizeof(lockpath), "%s.lock", path);
+
+    pthread_mutex_lock(&g_io_lock);
+
+    int lockfd = open(lockpath, O_RDWR | O_CREAT, 0644);
+    if (lockfd >= 0)
+    {
+        memset(&fl, 0, sizeof(fl));
+        fl.l_type = F_WRLCK;
+        fl.l_whence = SEEK_SET;
+        while (fcntl(lockfd, F_SETLKW, &fl) < 0 && errno == EINTR);
+    }
+
+    cal_entry_t *list = read_store(path);
+    cal_entry_t **tail = &list;
+    while (*tail)
+        tail = &(*tail)->next;
+
+    rv = UPM_SUCCESS;
+    for (const cal_entry_t *u = updates; u && rv == UPM_SUCCESS; u = u->next)
+    {
+        cal_entry_t *e = find_entry(list, u->key);
+        if (e)
+        {
+            uint8_t *blob = malloc(u->len ? u->len : 1);
+            if (!blob)
+            {
+                rv = UPM_ERROR_NO_RESOURCES;
+                break;
+            }
+            memcpy(blob, u->blob, u->len);
+            free(e->blob);
+            e->blob = blob;
+            e->len = u->len;
+        }
+        else
+        {
+            if (!(e = new_entry(u->key, strlen(u->key), u->blob, u->len)))
+            {
+                rv = UPM_ERROR_NO_RESOURCES;
+                break;
+            }
+            *tail = e;
+            tail = &e->next;
+        }
+    }
+
+    if (rv == UPM_SUCCESS)
+        rv = write_store(path, list);
+
+    free_entries(list);
+
+    // closing the descriptor releases the lock
+    if (lockfd >= 0)
+        close(lockfd);
+
+    pthread_mutex_unlock(&g_io_lock);
+
+    return rv;
+}
+
+upm_result_t upm_cal_store_set_path(const char *path)
+{
+    if (path && strlen(path) >= CAL_MAX_PATH)
+        return UPM_ERROR_INVALID_PARAMETER;
+
+    pthread_mutex_lock(&g_lock);
+    strcpy(g_path, path ? path : "");
+    g_path_known = true;
+    pthread_mutex_unlock(&g_lock);
+
+    return UPM_SUCCESS;
+}
+
+bool upm_cal_store_enabled(void)
+{
+    char path[CAL_MAX_PATH];
+
+    return get_path(path);
+}
+
+upm_result_t upm_cal_store_load(const char *key, void *blob, size_t len)
+{
+    char path[CAL_MAX_PATH];
+    upm_result_t rv;
+
+    if ((rv = check_args(key, blob, len)))
+        return rv;
+
+    if (!get_path(path))
+        return UPM_ERROR_NO_DATA;
+
+    pthread_mutex_lock(&g_io_lock);
+    cal_entry_t *list = read_store(path);
+    pthread_mutex_unlock(&g_io_lock);
+
+    cal_entry_t *e = find_entry(list, key);
+    if (!e)
+        rv = UPM_ERROR_NO_DATA;
+    else if (e->len != len)
+        rv = UPM_ERROR_INVALID_SIZE;
+    else
+        memcpy(blob, e->blob, len);
+
+    free_entries(list);
+
+    return rv;
+}
+
+upm_result_t upm_cal_store_save(const char *key, const void *blob,
+                                size_t len)
+{
+    upm_result_t rv;
+
+    if ((rv = check_args(key, blob, len)))
+        return rv;
+
+    cal_entry_t e = { (char *)key, (uint8_t *)blob, len, NULL };
+
+    return save_entries(&e);
+}
+
+static void *writer_thread(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&g_lock);
+    for (;;)
+    {
+        while (!g_queue)
+            pthread_cond_wait(&g_work, &g_lock);
+
+        cal_entry_t *batch = g_queue;
+        g_queue = NULL;
+        g_writing = true;
+        pthread_mutex_unlock(&g_lock);
+
+        upm_result_t rv = save_entries(batch);
+        free_entries(batch);
+
+        pthread_mutex_lock(&g_lock);
+        g_writing = false;
+        g_last_result = rv;
+        pthread_cond_broadcast(&g_idle);
+    }
+
+    return NULL;
+}
+
+static void flush_at_exit(void)
+{
+    upm_cal_store_flush();
+}
+
+upm_result_t upm_cal_store_save_async(const char *key, const void *blob,
+                                      size_t len)
+{
+    upm_result_t rv;
+
+    if ((rv = check_args(key, blob, len)))
+        return rv;
+
+    if (!upm_cal_store_enabled())
+        return UPM_SUCCESS;
+
+    cal_entry_t *e = new_entry(key, strlen(key), blob, len);
+    if (!e)
+        return UPM_ERROR_NO_RESOURCES;
+
+    pthread_mutex_lock(&g_lock);
+
+    if (!g_thread_started)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, writer_thread, NULL))
+        {
+            pthread_mutex_unlock(&g_lock);
+            free_entries(e);
+            // no background thread, save right away
+            return upm_cal_store_save(key, blob, len);
+        }
+        pthread_detach(thread);
+        atexit(flush_at_exit);
+        g_thread_started = true;
+    }
+
+    // replace a queued blob for the same key
+    cal_entry_t **p = &g_queue;
+    while (*p && strcmp((*p)->key, key))
+        p = &(*p)->next;
+    if (*p)
+    {
+        e->next = (*p)->next;
+        (*p)->next = NULL;
+        free_entries(*p);
+    }
+    *p = e;
+
+    pthread_cond_signal(&g_work);
+    pthread_mutex_unlock(&g_lock);
+
+    return UPM_SUCCESS;
+}
+
+upm_result_t upm_cal_store_flush(void)
+{
+    upm_result_t rv;
+
+    pthread_mutex_lock(&g_lock);
+    while (g_queue || g_writing)
+        pthread_cond_wait(&g_idle, &g_lock);
+    rv = g_last_result;
+    pthread_mutex_unlock(&g_lock);
+
+    return rv;
+}
+
+upm_result_t upm_cal_store_iio_key(const char *driver, int device,
+                                   char *key, size_t len)
+{
+    char path[CAL_MAX_PATH];
+    char real[CAL_MAX_PATH];
+    char name[64];
+    char *parent;
+    FILE *f;
+    int bus, addr, end = 0, n;
+
+    if (!driver || !key || !len || device < 0)
+        return UPM_ERROR_INVALID_PARAMETER;
+
+    /* the chip, as identified by the kernel driver */
+    snprintf(path, sizeof(path), "/sys/bus/iio/devices/iio:device%d/name",
+             device);
+    if (!(f = fopen(path, "r")))
+        return UPM_ERROR_NO_DATA;
+    if (!fgets(name, sizeof(name), f))
+    {
+        fclose(f);
+        return UPM_ERROR_NO_DATA;
+    }
+    fclose(f);
+    name[strcspn(name, "\n")] = 0;
+
+    /* the device the IIO device hangs off, e.g. the I2C client "1-006a";
+     * unlike the IIO device number it does not depend on probe order */
+    snprintf(path, sizeof(path), "/sys/bus/iio/devices/iio:device%d",
+             device);
+    if (!realpath(path, real))
+        return UPM_ERROR_OPERATION_FAILED;
+    if (!(parent = strrchr(real, '/')) || parent == real)
+        return UPM_ERROR_OPERATION_FAILED;
+    *parent = 0;
+    parent = strrchr(real, '/') + 1;
+
+    if (sscanf(parent, "%d-%x%n", &bus, &addr, &end) == 2 && !parent[end])
+        n = snprintf(key, len, "%s/%s/i2c-%d/%02x", driver, name, bus, addr);
+    else
+        n = snprintf(key, len, "%s/%s/%s", driver, name, parent);
+
+    if (n < 0 || (size_t)n >= len)
+        return UPM_ERROR_INVALID_SIZE;
+
+    return UPM_SUCCESS;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef UPM_CAL_STORE_H_
+#define UPM_CAL_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "upm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file upm_cal_store.h
+ * @brief Persistent store for sensor calibration data
+ *
+ * Sensors that calibrate themselves at run time (gyro bias, compass
+ * hard and soft iron, the BNO055's fusion offsets) lose that state on
+ * every restart and deliver degraded data until they have learned it
+ * again.  The calibration store keeps one blob of calibration data per
+ * device in a single binary file, so drivers can restore it when the
+ * device is opened and save it again whenever calibration improves.
+ *
+ * The store is off until a file is given, either with
+ * upm_cal_store_set_path() or in the UPM_CAL_STORE environment
+ * variable; while it is off, loads find nothing and saves do nothing.
+ *
+ * Devices are identified by a key naming the driver, the chip ID and
+ * where the device is attached, for example "bno055/a0/i2c-1/28" or
+ * "mmc35240/mmc35240/i2c-1/30", so calibration is never applied to
+ * another part.
+ *
+ * The file is a header, the entries (key length, key, blob length,
+ * blob) and a CRC-32 of everything before it.  Saves rewrite the whole
+ * file to a temporary and rename it over the old one, under a lock
+ * file, so readers and concurrent processes always see a complete
+ * file.  A damaged file is ignored and replaced on the next save.
+ */
+
+/** Longest key, in characters */
+#define UPM_CAL_STORE_MAX_KEY 255
+
+/**
+ * Set the store file, overriding UPM_CAL_STORE.
+ *
+ * @param path File name, or NULL to turn the store off
+ * @return UPM result
+ */
+upm_result_t upm_cal_store_set_path(const char *path);
+
+/**
+ * Whether a store file is set.
+ *
+ * @return true if the store is on
+ */
+bool upm_cal_store_enabled(void);
+
+/**
+ * Load the calibration blob saved for a device.
+ *
+ * @param key Device key
+ * @param blob Buffer for the blob
+ * @param len Size of the blob, which must match the size saved
+ * @return UPM result, UPM_ERROR_NO_DATA if there is no blob for the
+ * key (or the store is off), UPM_ERROR_INVALID_SIZE if its size
+ * differs
+ */
+upm_result_t upm_cal_store_load(const char *key, void *blob, size_t len);
+
+/**
+ * Save the calibration blob of a device, replacing any saved before,
+ * and return once it is on disk.
+ *
+ * @param key Device key
+ * @param blob Calibration data
+ * @param len Size of the blob, at most 65535 bytes
+ * @return UPM result
+ */
+upm_result_t upm_cal_store_save(const char *key, const void *blob,
+                                size_t len);
+
+/**
+ * Queue the calibration blob of a device to be saved by a background
+ * thread, so a driver can save from its update path without waiting
+ * for the disk.  Queued blobs for the same key are replaced by the
+ * latest one, and all queued blobs go to disk in one write.  Pending
+ * saves are flushed at exit.
+ *
+ * @param key Device key
+ * @param blob Calibration data
+ * @param len Size of the blob, at most 65535 bytes
+ * @return UPM result
+ */
+upm_result_t upm_cal_store_save_async(const char *key, const void *blob,
+                                      size_t len);
+
+/**
+ * Wait until all queued saves are on disk.
+ *
+ * @return UPM result of the last background write
+ */
+upm_result_t upm_cal_store_flush(void);
+
+/**
+ * Build the key of a device handled by a kernel IIO driver.  IIO
+ * device numbers follow the probe order, which can change between
+ * boots, so the key is made from the chip name reported by the driver
+ * and the parent device instead: "<driver>/<name>/i2c-<bus>/<address>"
+ * for I2C devices, "<driver>/<name>/<parent>" otherwise.
+ *
+ * @param driver Driver name, the first key component
+ * @param device IIO device number
+ * @param key Buffer for the key
+ * @param len Size of the buffer
+ * @return UPM result, UPM_ERROR_NO_DATA if there is no such device
+ */
+upm_result_t upm_cal_store_iio_key(const char *driver, int device,
+                                   char *key, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPM_CAL_STORE_H_ */
@@ -0,0 +1,600 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _POSIX_C_SOURCE
+// open(), poll(), directory access
+# define _POSIX_C_SOURCE 200809L
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "upm_platform.h"
+#include "upm_iio_stream.h"
+
+#if defined(UPM_PLATFORM_LINUX)
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+/* Decoders for channels using all bits of their storage, the usual
+ * case, one per storage size, byte order and sign */
+#define UPM_IIO_DECODE(NAME, TYPE, ASSEMBLE)                            \
+    static void decode_##NAME(const upm_iio_channel_t *chan,            \
+                              const uint8_t *src, size_t stride,        \
+                              size_t count, float *dst)                 \
+    {                                                                   \
+        const float offset = chan->offset;                              \
+        const float scale = chan->scale;                                \
+        for (size_t i = 0; i < count; i++, src += stride)               \
+        {                                                               \
+            const uint8_t *p = src;                                     \
+            dst[i] = ((float)(TYPE)(ASSEMBLE) + offset) * scale;        \
+        }                                                               \
+    }
+
+#define LE16 ((uint16_t)p[0] | (uint16_t)p[1] << 8)
+#define BE16 ((uint16_t)p[1] | (uint16_t)p[0] << 8)
+#define LE32 ((uint32_t)p[0] | (uint32_t)p[1] << 8 | \
+              (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24)
+#define BE32 ((uint32_t)p[3] | (uint32_t)p[2] << 8 | \
+              (uint32_t)p[1] << 16 | (uint32_t)p[0] << 24)
+
+UPM_IIO_DECODE(s8, int8_t, p[0])
+UPM_IIO_DECODE(u8, uint8_t, p[0])
+UPM_IIO_DECODE(s16le, int16_t, LE16)
+UPM_IIO_DECODE(u16le, uint16_t, LE16)
+UPM_IIO_DECODE(s16be, int16_t, BE16)
+UPM_IIO_DECODE(u16be, uint16_t, BE16)
+UPM_IIO_DECODE(s32le, int32_t, LE32)
+UPM_IIO_DECODE(u32le, uint32_t, LE32)
+UPM_IIO_DECODE(s32be, int32_t, BE32)
+UPM_IIO_DECODE(u32be, uint32_t, BE32)
+
+static uint64_t assemble(const upm_iio_channel_t *chan, const uint8_t *p)
+{
+    uint64_t u64 = 0;
+
+    if (chan->big_endian)
+        for (unsigned int i = 0; i < chan->bytes; i++)
+            u64 = (u64 << 8) | p[i];
+    else
+        for (unsigned int i = chan->bytes; i > 0; i--)
+            u64 = (u64 << 8) | p[i - 1];
+
+    return u64;
+}
+
+/* Any other layout: shifted or partial storage, 64 bit */
+static int64_t raw_value(const upm_iio_channel_t *chan, const uint8_t *p)
+{
+    uint64_t mask = (chan->bits >= 64) ? ~0ULL : ((1ULL << chan->bits) - 1);
+    uint64_t u64 = (assemble(chan, p) >> chan->shift) & mask;
+
+    if (chan->is_signed)
+    {
+        uint64_t sign = 1ULL << (chan->bits - 1);
+        return (int64_t)((u64 ^ sign) - sign);
+    }
+
+    return (int64_t)u64;
+}
+
+static void decode_generic(const upm_iio_channel_t *chan, const uint8_t *src,
+                           size_t stride, size_t count, float *dst)
+{
+    for (size_t i = 0; i < count; i++, src += stride)
+        dst[i] = ((float)raw_value(chan, src) + chan->offset) * chan->scale;
+}
+
+static upm_iio_decode_t select_decoder(const upm_iio_channel_t *chan)
+{
+    if (chan->shift != 0 || chan->bits != chan->bytes * 8)
+        return decode_generic;
+
+    switch (chan->bytes)
+    {
+    case 1:
+        return chan->is_signed ? decode_s8 : decode_u8;
+    case 2:
+        if (chan->big_endian)
+            return chan->is_signed ? decode_s16be : decode_u16be;
+        return chan->is_signed ? decode_s16le : decode_u16le;
+    case 4:
+        if (chan->big_endian)
+            return chan->is_signed ? decode_s32be : decode_u32be;
+        return chan->is_signed ? decode_s32le : decode_u32le;
+    default:
+        return decode_generic;
+    }
+}
+
+/* Read a sysfs attribute of the device into buf, without the
+ * trailing newline */
+static bool read_attr(const upm_iio_stream_context dev, const char *attr,
+                      char *buf, size_t len)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dev->sysfs_dir, attr);
+
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return false;
+
+    bool ok = (fgets(buf, len, f) != NULL);
+    fclose(f);
+
+    if (ok)
+        buf[strcspn(buf, "\n")] = '\0';
+
+    return ok;
+}
+
+static bool read_float_attr(const upm_iio_stream_context dev,
+                            const char *attr, float *val)
+{
+    char buf[64];
+
+    return read_attr(dev, attr, buf, sizeof(buf))
+        && sscanf(buf, "%f", val) == 1;
+}
+
+static upm_result_t write_int_attr(const upm_iio_stream_context dev,
+                                   const char *attr, int val)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dev->sysfs_dir, attr);
+
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return UPM_ERROR_OPERATION_FAILED;
+
+    bool ok = (fprintf(f, "%d", val) > 0);
+    // sysfs reports errors on close
+    if (fclose(f) != 0)
+        ok = false;
+
+    return ok ? UPM_SUCCESS : UPM_ERROR_OPERATION_FAILED;
+}
+
+/* Channel type, e.g. accel for accel_x and voltage for voltage0 */
+static void channel_type(const char *name, char *type, size_t len)
+{
+    snprintf(type, len, "%s", name);
+
+    char *p = strrchr(type, '_');
+    if (p)
+        *p = '\0';
+    else
+        for (p = type + strlen(type); p > type && p[-1] >= '0' && p[-1] <= '9';)
+            *--p = '\0';
+}
+
+/* Processed value parameters, per channel or shared by the type */
+static float channel_attr(const upm_iio_stream_context dev, const char *name,
+                          const char *attr, float def)
+{
+    char path[128], type[32];
+    float val;
+
+    snprintf(path, sizeof(path), "in_%s_%s", name, attr);
+    if (read_float_attr(dev, path, &val))
+        return val;
+
+    channel_type(name, type, sizeof(type));
+    snprintf(path, sizeof(path), "in_%s_%s", type, attr);
+    if (read_float_attr(dev, path, &val))
+        return val;
+
+    return def;
+}
+
+/* Parse an element type, [be|le]:[s|u]bits/storagebits[>>shift] */
+static bool parse_type(const char *type, upm_iio_channel_t *chan)
+{
+    char endian, sign;
+    unsigned int storage, shift = 0;
+
+    if (sscanf(type, "%ce:%c%u/%u>>%u", &endian, &sign, &chan->bits,
+               &storage, &shift) < 4)
+        return false;
+
+    // repeated elements are not supported
+    if (strchr(type, 'X'))
+        return false;
+
+    if (chan->bits < 1 || chan->bits > 64 || storage % 8 || storage > 64
+        || storage < 8 || chan->bits + shift > storage)
+        return false;
+
+    chan->big_endian = (endian == 'b');
+    chan->is_signed = (sign == 's');
+    chan->bytes = storage / 8;
+    chan->shift = shift;
+
+    return true;
+}
+
+static int compare_index(const void *a, const void *b)
+{
+    return ((const upm_iio_channel_t *)a)->index
+        - ((const upm_iio_channel_t *)b)->index;
+}
+
+static upm_result_t compile_channel(upm_iio_stream_context dev,
+                                    const char *element)
+{
+    char attr[128], buf[64];
+
+    if (dev->num_channels >= UPM_IIO_STREAM_MAX_CHANNELS)
+        return UPM_ERROR_OUT_OF_RANGE;
+
+    upm_iio_channel_t *chan = &dev->channels[dev->num_channels];
+    memset(chan, 0, sizeof(*chan));
+
+    // in_<name>_en
+    size_t len = strlen(element) - strlen("in_") - strlen("_en");
+    if (len >= sizeof(chan->name))
+        return UPM_ERROR_OUT_OF_RANGE;
+    memcpy(chan->name, element + strlen("in_"), len);
+    chan->name[len] = '\0';
+
+    snprintf(attr, sizeof(attr), "scan_elements/in_%s_index", chan->name);
+    if (!read_attr(dev, attr, buf, sizeof(buf))
+        || sscanf(buf, "%d", &chan->index) != 1)
+        return UPM_ERROR_OPERATION_FAILED;
+
+    snprintf(attr, sizeof(attr), "scan_elements/in_%s_type", chan->name);
+    if (!read_attr(dev, attr, buf, sizeof(buf)) || !parse_type(buf, chan))
+        return UPM_ERROR_OPERATION_FAILED;
+
+    chan->scale = channel_attr(dev, chan->name, "scale", 1.0);
+    chan->offset = channel_attr(dev, chan->name, "offset", 0.0);
+    chan->decode = select_decoder(chan);
+
+    dev->num_channels++;
+
+    return UPM_SUCCESS;
+}
+
+/* Find the x/y/z channels of the first type with a mount matrix */
+static void compile_mount_matrix(upm_iio_stream_context dev)
+{
+    dev->rotate = false;
+
+    for (int i = 0; i < dev->num_channels && !dev->rotate; i++)
+    {
+        char type[32], name[40], attr[64], buf[128];
+        const char *name_x = dev->channels[i].name;
+        size_t len = strlen(name_x);
+
+        if (len < 2 || strcmp(name_x + len - 2, "_x"))
+            continue;
+
+        channel_type(name_x, type, sizeof(type));
+        dev->axes[0] = i;
+        snprintf(name, sizeof(name), "%s_y", type);
+        dev->axes[1] = upm_iio_stream_find_channel(dev, name);
+        snprintf(name, sizeof(name), "%s_z", type);
+        dev->axes[2] = upm_iio_stream_find_channel(dev, name);
+
+        if (dev->axes[1] < 0 || dev->axes[2] < 0)
+            continue;
+
+        snprintf(attr, sizeof(attr), "in_%s_mount_matrix", type);
+        if (!read_attr(dev, attr, buf, sizeof(buf))
+            && !read_attr(dev, "in_mount_matrix", buf, sizeof(buf)))
+            return;
+
+        float *m = dev->matrix;
+        if (sscanf(buf, "%f, %f, %f; %f, %f, %f; %f, %f, %f",
+                   &m[0], &m[1], &m[2], &m[3], &m[4], &m[5],
+                   &m[6], &m[7], &m[8]) != 9)
+            return;
+
+        // skip the identity
+        static const float identity[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+        dev->rotate = (memcmp(m, identity, sizeof(identity)) != 0);
+        return;
+    }
+}
+
+static upm_result_t compile_layout(upm_iio_stream_context dev)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/scan_elements", dev->sysfs_dir);
+
+    DIR *dir = opendir(path);
+    if (!dir)
+        return UPM_ERROR_NO_RESOURCES;
+
+    dev->num_channels = 0;
+    dev->timestamp = -1;
+
+    upm_result_t rv = UPM_SUCCESS;
+    struct dirent *ent;
+    while (rv == UPM_SUCCESS && (ent = readdir(dir)) != NULL)
+    {
+        char attr[300], buf[16];
+        size_t len = strlen(ent->d_name);
+
+        if (strncmp(ent->d_name, "in_", 3) || len < 7
+            || strcmp(ent->d_name + len - 3, "_en"))
+            continue;
+
+        snprintf(attr, sizeof(attr), "scan_elements/%s", ent->d_name);
+        if (!read_attr(dev, attr, buf, sizeof(buf)) || atoi(buf) != 1)
+            continue;
+
+        rv = compile_channel(dev, ent->d_name);
+    }
+    closedir(dir);
+
+    if (rv != UPM_SUCCESS)
+        return rv;
+
+    if (dev->num_channels == 0)
+        return UPM_ERROR_NO_DATA;
+
+    // elements are packed in index order, each aligned to its size,
+    // and the scan is padded to a multiple of the largest
+    qsort(dev->channels, dev->num_channels, sizeof(upm_iio_channel_t),
+          compare_index);
+
+    size_t offset = 0, align = 1;
+    for (int i = 0; i < dev->num_channels; i++)
+    {
+        upm_iio_channel_t *chan = &dev->channels[i];
+
+        if (offset % chan->bytes)
+            offset += chan->bytes - offset % chan->bytes;
+        chan->location = offset;
+        offset += chan->bytes;
+
+        if (chan->bytes > align)
+            align = chan->bytes;
+
+        if (!strcmp(chan->name, "timestamp"))
+            dev->timestamp = i;
+    }
+    if (offset % align)
+        offset += align - offset % align;
+    dev->scan_size = offset;
+
+    compile_mount_matrix(dev);
+
+    return UPM_SUCCESS;
+}
+
+upm_iio_stream_context upm_iio_stream_init_path(const char *sysfs_dir,
+                                                const char *devnode)
+{
+    assert(sysfs_dir != NULL && devnode != NULL);
+
+    upm_iio_stream_context dev =
+        (upm_iio_stream_context)calloc(1, sizeof(struct _upm_iio_stream));
+    if (!dev)
+        return NULL;
+
+    dev->fd = -1;
+    dev->timestamp = -1;
+
+    if (snprintf(dev->sysfs_dir, sizeof(dev->sysfs_dir), "%s", sysfs_dir)
+        >= (int)sizeof(dev->sysfs_dir)
+        || snprintf(dev->devnode, sizeof(dev->devnode), "%s", devnode)
+        >= (int)sizeof(dev->devnode))
+    {
+        free(dev);
+        return NULL;
+    }
+
+    return dev;
+}
+
+upm_iio_stream_context upm_iio_stream_init(int device)
+{
+    char sysfs_dir[64], devnode[64];
+
+    snprintf(sysfs_dir, sizeof(sysfs_dir), "/sys/bus/iio/devices/iio:device%d",
+             device);
+    snprintf(devnode, sizeof(devnode), "/dev/iio:device%d", device);
+
+    return upm_iio_stream_init_path(sysfs_dir, devnode);
+}
+
+void upm_iio_stream_close(upm_iio_stream_context dev)
+{
+    if (!dev)
+        return;
+
+    upm_iio_stream_release(dev);
+    free(dev->buf);
+    free(dev);
+}
+
+upm_result_t upm_iio_stream_enable(upm_iio_stream_context dev,
+                                   unsigned int length)
+{
+    assert(dev != NULL);
+
+    // the length can not be changed while the buffer is enabled
+    upm_result_t rv = write_int_attr(dev, "buffer/length", length);
+    if (rv != UPM_SUCCESS)
+        return rv;
+
+    return write_int_attr(dev, "buffer/enable", 1);
+}
+
+upm_result_t upm_iio_stream_disable(upm_iio_stream_context dev)
+{
+    assert(dev != NULL);
+
+    upm_iio_stream_release(dev);
+
+    return write_int_attr(dev, "buffer/enable", 0);
+}
+
+upm_result_t upm_iio_stream_open(upm_iio_stream_context dev)
+{
+    assert(dev != NULL);
+
+    upm_iio_stream_release(dev);
+
+    upm_result_t rv = compile_layout(dev);
+    if (rv != UPM_SUCCESS)
+    {
+        dev->num_channels = 0;
+        return rv;
+    }
+
+    dev->fd = open(dev->devnode, O_RDONLY | O_NONBLOCK);
+    if (dev->fd < 0)
+    {
+        dev->num_channels = 0;
+        return UPM_ERROR_NO_RESOURCES;
+    }
+
+    return UPM_SUCCESS;
+}
+
+void upm_iio_stream_release(upm_iio_stream_context dev)
+{
+    assert(dev != NULL);
+
+    if (dev->fd >= 0)
+        close(dev->fd);
+    dev->fd = -1;
+    dev->num_channels = 0;
+    dev->pending = 0;
+}
+
+int upm_iio_stream_num_channels(const upm_iio_stream_context dev)
+{
+    assert(dev != NULL);
+
+    return dev->num_channels;
+}
+
+int upm_iio_stream_find_channel(const upm_iio_stream_context dev,
+                                const char *name)
+{
+    assert(dev != NULL && name != NULL);
+
+    for (int i = 0; i < dev->num_channels; i++)
+        if (!strcmp(dev->channels[i].name, name))
+            return i;
+
+    return -1;
+}
+
+upm_result_t upm_iio_stream_set_scale(upm_iio_stream_context dev,
+                                      int channel, float scale)
+{
+    assert(dev != NULL);
+
+    if (channel < 0 || channel >= dev->num_channels)
+        return UPM_ERROR_OUT_OF_RANGE;
+
+    dev->channels[channel].scale = scale;
+
+    return UPM_SUCCESS;
+}
+
+int upm_iio_stream_read(upm_iio_stream_context dev, float **data,
+                        int64_t *timestamps, size_t max_scans,
+                        int timeout_ms)
+{
+    assert(dev != NULL && data != NULL);
+
+    if (dev->fd < 0 && upm_iio_stream_open(dev) != UPM_SUCCESS)
+        return -1;
+
+    if (dev->rotate && (!data[dev->axes[0]] || !data[dev->axes[1]]
+                        || !data[dev->axes[2]]))
+        return -1;
+
+    if (max_scans == 0)
+        return 0;
+
+    size_t want = max_scans * dev->scan_size;
+    if (dev->buf_size < want)
+    {
+        uint8_t *buf = (uint8_t *)realloc(dev->buf, want);
+        if (!buf)
+            return -1;
+        dev->buf = buf;
+        dev->buf_size = want;
+    }
+
+    if (timeout_ms != 0)
+    {
+        struct pollfd pfd = { dev->fd, POLLIN, 0 };
+        int rv = poll(&pfd, 1, timeout_ms);
+
+        if (rv < 0)
+            return (errno == EINTR) ? 0 : -1;
+        if (rv == 0)
+            return 0;
+    }
+
+    // one read() gets all scans available, up to max_scans
+    ssize_t n = read(dev->fd, dev->buf + dev->pending, want - dev->pending);
+    if (n < 0)
+        return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+    dev->pending += n;
+
+    size_t scans = dev->pending / dev->scan_size;
+
+    for (int i = 0; i < dev->num_channels; i++)
+    {
+        const upm_iio_channel_t *chan = &dev->channels[i];
+
+        if (i == dev->timestamp)
+        {
+            if (timestamps)
+                for (size_t s = 0; s < scans; s++)
+                    timestamps[s] = raw_value(chan, dev->buf + chan->location
+                                              + s * dev->scan_size);
+        }
+        else if (data[i])
+            chan->decode(chan, dev->buf + chan->location, dev->scan_size,
+                         scans, data[i]);
+    }
+
+    if (dev->rotate)
+    {
+        const float *m = dev->matrix;
+        float *x = data[dev->axes[0]];
+        float *y = data[dev->axes[1]];
+        float *z = data[dev->axes[2]];
+
+        for (size_t s = 0; s < scans; s++)
+        {
+            float vx = x[s], vy = y[s], vz = z[s];
+
+            x[s] = vx * m[0] + vy * m[1] + vz * m[2];
+            y[s] = vx * m[3] + vy * m[4] + vz * m[5];
+            z[s] = vx * m[6] + vy * m[7] + vz * m[8];
+        }
+    }
+
+    // keep an incomplete scan for the next read
+    size_t used = scans * dev->scan_size;
+    memmove(dev->buf, dev->buf + used, dev->pending - used);
+    dev->pending -= used;
+
+    return (int)scans;
+}
+
+#endif /* UPM_PLATFORM_LINUX */
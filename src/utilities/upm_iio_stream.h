@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef UPM_IIO_STREAM_H_
+#define UPM_IIO_STREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "upm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file upm_iio_stream.h
+ * @brief Block reader for Linux IIO buffers
+ *
+ * An IIO trigger buffer delivers scans, one sample of each enabled
+ * scan element packed according to the element's type, through the
+ * /dev/iio:deviceN character device.  Instead of taking one callback
+ * per scan and decoding every channel from its type description, the
+ * stream reads as many scans as are available in one read() and
+ * decodes them a channel at a time into separate float arrays (one
+ * array per channel, structure of arrays).
+ *
+ * The scan layout is compiled when the stream is opened: the enabled
+ * elements, their offsets in the scan, byte order, sign, shift, scale
+ * and offset are read from sysfs once, and each channel gets a decode
+ * routine specialized for its storage format.  A mount matrix, if the
+ * device has one, is applied to the x/y/z channels of the same type.
+ *
+ * The scan elements must be enabled before the stream is opened and
+ * not changed while it is open.  The stream must not be combined with
+ * mraa_iio_trigger_buffer() on the same device, they would compete for
+ * the scans.
+ */
+
+/** Maximum number of enabled scan elements */
+#define UPM_IIO_STREAM_MAX_CHANNELS 16
+
+struct _upm_iio_channel;
+
+/**
+ * Decode count samples of a channel, stride bytes apart, into floats
+ */
+typedef void (*upm_iio_decode_t)(const struct _upm_iio_channel *chan,
+                                 const uint8_t *src, size_t stride,
+                                 size_t count, float *dst);
+
+/**
+ * Compiled scan element
+ */
+typedef struct _upm_iio_channel {
+    /* element name without the in_ prefix, e.g. accel_x */
+    char name[32];
+    int index;
+    /* byte offset in the scan */
+    size_t location;
+    /* storage size in bytes, used bits and right shift */
+    unsigned int bytes;
+    unsigned int bits;
+    unsigned int shift;
+    int is_signed;
+    int big_endian;
+    /* processed value = (raw + offset) * scale */
+    float offset;
+    float scale;
+    upm_iio_decode_t decode;
+} upm_iio_channel_t;
+
+/**
+ * IIO stream context
+ */
+typedef struct _upm_iio_stream {
+    char sysfs_dir[256];
+    char devnode[256];
+    int fd;
+
+    upm_iio_channel_t channels[UPM_IIO_STREAM_MAX_CHANNELS];
+    int num_channels;
+    size_t scan_size;
+    /* index of the timestamp channel, or -1 */
+    int timestamp;
+
+    /* channels the mount matrix applies to, if rotate */
+    int rotate;
+    int axes[3];
+    float matrix[9];
+
+    /* raw scans, and bytes of an incomplete scan at its start */
+    uint8_t *buf;
+    size_t buf_size;
+    size_t pending;
+} *upm_iio_stream_context;
+
+/**
+ * Create a stream for IIO device number device, using
+ * /sys/bus/iio/devices/iio:deviceN and /dev/iio:deviceN.
+ *
+ * @param device IIO device number
+ * @return Stream context, or NULL on failure
+ */
+upm_iio_stream_context upm_iio_stream_init(int device);
+
+/**
+ * Create a stream for an IIO device at explicit paths, e.g. a fake
+ * sysfs tree for testing.
+ *
+ * @param sysfs_dir The device's sysfs directory
+ * @param devnode The device's character device, or any file holding
+ * raw scans
+ * @return Stream context, or NULL on failure
+ */
+upm_iio_stream_context upm_iio_stream_init_path(const char *sysfs_dir,
+                                                const char *devnode);
+
+/**
+ * Close the device node if open and free the context.  The buffer
+ * is left enabled if it was.
+ *
+ * @param dev Stream context
+ */
+void upm_iio_stream_close(upm_iio_stream_context dev);
+
+/**
+ * Set the buffer length, in scans, and enable the buffer.
+ *
+ * @param dev Stream context
+ * @param length Buffer length, in scans
+ * @return UPM result
+ */
+upm_result_t upm_iio_stream_enable(upm_iio_stream_context dev,
+                                   unsigned int length);
+
+/**
+ * Close the device node if open and disable the buffer.
+ *
+ * @param dev Stream context
+ * @return UPM result
+ */
+upm_result_t upm_iio_stream_disable(upm_iio_stream_context dev);
+
+/**
+ * Compile the scan layout of the enabled scan elements and open the
+ * device node.  Called by upm_iio_stream_read() if needed.  Any
+ * scale set with upm_iio_stream_set_scale() is reset to the sysfs
+ * value.
+ *
+ * @param dev Stream context
+ * @return UPM result
+ */
+upm_result_t upm_iio_stream_open(upm_iio_stream_context dev);
+
+/**
+ * Close the device node, e.g. before changing the enabled scan
+ * elements.  The next read compiles the layout again.
+ *
+ * @param dev Stream context
+ */
+void upm_iio_stream_release(upm_iio_stream_context dev);
+
+/**
+ * Number of channels in a scan, 0 if the stream is not open.
+ *
+ * @param dev Stream context
+ * @return Number of channels
+ */
+int upm_iio_stream_num_channels(const upm_iio_stream_context dev);
+
+/**
+ * Look up a channel by element name, e.g. "accel_x".
+ *
+ * @param dev Stream context
+ * @param name Element name without the in_ prefix
+ * @return Channel index, or -1 if the element is not enabled
+ */
+int upm_iio_stream_find_channel(const upm_iio_stream_context dev,
+                                const char *name);
+
+/**
+ * Override the scale of a channel, e.g. to convert to other units.
+ *
+ * @param dev Stream context
+ * @param channel Channel index
+ * @param scale New scale
+ * @return UPM result
+ */
+upm_result_t upm_iio_stream_set_scale(upm_iio_stream_context dev,
+                                      int channel, float scale);
+
+/**
+ * Read and decode up to max_scans scans.  Waits up to timeout_ms for
+ * the first scan, then returns whatever is available without blocking.
+ *
+ * data[i] receives the processed values of channel i, and must hold
+ * max_scans floats, or be NULL to skip the channel.  The timestamp
+ * channel, if enabled, is returned in nanoseconds in timestamps
+ * instead, which may also be NULL.  If a mount matrix applies, the
+ * x, y and z arrays it rotates must all be given.
+ *
+ * @param dev Stream context
+ * @param data Array of upm_iio_stream_num_channels() output arrays
+ * @param timestamps Array of max_scans timestamps, or NULL
+ * @param max_scans Maximum number of scans to read
+ * @param timeout_ms Maximum time to wait in milliseconds, 0 to not
+ * wait, -1 to wait forever
+ * @return Number of scans read, 0 on timeout, -1 on error
+ */
+int upm_iio_stream_read(upm_iio_stream_context dev, float **data,
+                        int64_t *timestamps, size_t max_scans,
+                        int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPM_IIO_STREAM_H_ */
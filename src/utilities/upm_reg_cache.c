@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "upm_reg_cache.h"
+
+#define BIT_WORD(reg) ((reg) >> 5)
+#define BIT_MASK(reg) ((uint32_t)1 << ((reg) & 0x1f))
+
+void upm_reg_cache_init(upm_reg_cache_t *cache)
+{
+    assert(cache != NULL);
+
+    memset(cache, 0, sizeof(upm_reg_cache_t));
+}
+
+void upm_reg_cache_set_nonvolatile(upm_reg_cache_t *cache, uint8_t first,
+                                   uint8_t last)
+{
+    assert(cache != NULL);
+
+    for (int reg = first; reg <= last; reg++)
+        cache->nonvolatile[BIT_WORD(reg)] |= BIT_MASK(reg);
+}
+
+void upm_reg_cache_set_volatile(upm_reg_cache_t *cache, uint8_t first,
+                                uint8_t last)
+{
+    assert(cache != NULL);
+
+    for (int reg = first; reg <= last; reg++)
+    {
+        cache->nonvolatile[BIT_WORD(reg)] &= ~BIT_MASK(reg);
+        cache->valid[BIT_WORD(reg)] &= ~BIT_MASK(reg);
+    }
+}
+
+bool upm_reg_cache_get(const upm_reg_cache_t *cache, uint8_t reg,
+                       uint8_t *val)
+{
+    assert(cache != NULL);
+
+    // check the (fixed) annotation first, so volatile registers never
+    // look at the cached data
+    if (!(cache->nonvolatile[BIT_WORD(reg)] & BIT_MASK(reg)))
+        return false;
+
+    if (!(cache->valid[BIT_WORD(reg)] & BIT_MASK(reg)))
+        return false;
+
+    if (val)
+        *val = cache->values[reg];
+
+    return true;
+}
+
+void upm_reg_cache_put(upm_reg_cache_t *cache, uint8_t reg, uint8_t val)
+{
+    assert(cache != NULL);
+
+    if (!(cache->nonvolatile[BIT_WORD(reg)] & BIT_MASK(reg)))
+        return;
+
+    cache->values[reg] = val;
+    cache->valid[BIT_WORD(reg)] |= BIT_MASK(reg);
+}
+
+void upm_reg_cache_invalidate(upm_reg_cache_t *cache, uint8_t reg)
+{
+    assert(cache != NULL);
+
+    cache->valid[BIT_WORD(reg)] &= ~BIT_MASK(reg);
+}
+
+void upm_reg_cache_invalidate_all(upm_reg_cache_t *cache)
+{
+    assert(cache != NULL);
+
+    memset(cache->valid, 0, sizeof(cache->valid));
+}
+
+upm_result_t upm_reg_cache_update_bits(upm_reg_cache_t *cache, uint8_t reg,
+                                       uint8_t mask, uint8_t bits,
+                                       upm_reg_read_t read,
+                                       upm_reg_write_t write, void *ctx)
+{
+    assert(cache != NULL);
+    assert(read != NULL && write != NULL);
+
+    uint8_t val;
+    upm_result_t rv;
+
+    if (!upm_reg_cache_get(cache, reg, &val))
+    {
+        if ((rv = read(ctx, reg, &val)) != UPM_SUCCESS)
+            return rv;
+
+        upm_reg_cache_put(cache, reg, val);
+    }
+
+    uint8_t newVal = (val & ~mask) | (bits & mask);
+
+    // skip the write if nothing changes, but only if we actually know
+    // what the device holds
+    if (newVal == val && upm_reg_cache_get(cache, reg, NULL))
+        return UPM_SUCCESS;
+
+    if ((rv = write(ctx, reg, newVal)) != UPM_SUCCESS)
+    {
+        upm_reg_cache_invalidate(cache, reg);
+        return rv;
+    }
+
+    upm_reg_cache_put(cache, reg, newVal);
+
+    return UPM_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef UPM_REG_CACHE_H_
+#define UPM_REG_CACHE_H_
+
+#include <stdint.h>
+
+#include "upm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file upm_reg_cache.h
+ * @brief Shadow register cache for 8-bit register mapped devices
+ *
+ * Most configuration setters in the C drivers read a register just to
+ * change a few bits and write it back.  For registers that only change
+ * when the host writes them (non-volatile in the sense of this cache,
+ * e.g. control and configuration registers), the last value written or
+ * read can be kept on the host, saving the read, and a write that
+ * would not change the register can be skipped entirely.
+ *
+ * Every register starts out volatile.  A driver marks its control
+ * registers non-volatile, and invalidates the cache whenever the
+ * device may change them behind its back (soft reset, register bank
+ * switches, ...).
+ */
+
+/**
+ * Shadow register cache for a 256 register address space
+ */
+typedef struct _upm_reg_cache {
+    /* registers that may be cached */
+    uint32_t nonvolatile[8];
+    /* registers whose cached value is valid */
+    uint32_t valid[8];
+    uint8_t values[256];
+} upm_reg_cache_t;
+
+/**
+ * Register read function for upm_reg_cache_update_bits()
+ */
+typedef upm_result_t (*upm_reg_read_t)(void *ctx, uint8_t reg, uint8_t *val);
+
+/**
+ * Register write function for upm_reg_cache_update_bits()
+ */
+typedef upm_result_t (*upm_reg_write_t)(void *ctx, uint8_t reg, uint8_t val);
+
+/**
+ * Initialize a cache.  All registers are volatile.
+ *
+ * @param cache Cache to initialize
+ */
+void upm_reg_cache_init(upm_reg_cache_t *cache);
+
+/**
+ * Mark a range of registers as non-volatile, i.e. only changed by
+ * host writes, and therefore cacheable.
+ *
+ * @param cache Register cache
+ * @param first First register in the range
+ * @param last Last register in the range (inclusive)
+ */
+void upm_reg_cache_set_nonvolatile(upm_reg_cache_t *cache, uint8_t first,
+                                   uint8_t last);
+
+/**
+ * Mark a range of registers as volatile, and drop any cached values
+ * for them.
+ *
+ * @param cache Register cache
+ * @param first First register in the range
+ * @param last Last register in the range (inclusive)
+ */
+void upm_reg_cache_set_volatile(upm_reg_cache_t *cache, uint8_t first,
+                                uint8_t last);
+
+/**
+ * Look up a register.
+ *
+ * @param cache Register cache
+ * @param reg Register
+ * @param val Set to the cached value, if any
+ * @return true if the register is non-volatile and its value is cached
+ */
+bool upm_reg_cache_get(const upm_reg_cache_t *cache, uint8_t reg,
+                       uint8_t *val);
+
+/**
+ * Store the value of a register that was just read from, or written
+ * to the device.  Ignored for volatile registers.
+ *
+ * @param cache Register cache
+ * @param reg Register
+ * @param val Register value
+ */
+void upm_reg_cache_put(upm_reg_cache_t *cache, uint8_t reg, uint8_t val);
+
+/**
+ * Drop the cached value of a register, e.g. after a failed write.
+ *
+ * @param cache Register cache
+ * @param reg Register
+ */
+void upm_reg_cache_invalidate(upm_reg_cache_t *cache, uint8_t reg);
+
+/**
+ * Drop all cached values, e.g. after a device reset.  The volatile
+ * annotations are kept.
+ *
+ * @param cache Register cache
+ */
+void upm_reg_cache_invalidate_all(upm_reg_cache_t *cache);
+
+/**
+ * Change the bits of a register selected by mask to bits.  The
+ * register is read only if it is not cached, and written only if its
+ * value changes.  Neither read nor write need to be cache aware.
+ *
+ * @param cache Register cache
+ * @param reg Register
+ * @param mask Bits to change
+ * @param bits New value of those bits
+ * @param read Register read function
+ * @param write Register write function
+ * @param ctx Passed to read and write, normally the device context
+ * @return UPM result
+ */
+upm_result_t upm_reg_cache_update_bits(upm_reg_cache_t *cache, uint8_t reg,
+                                       uint8_t mask, uint8_t bits,
+                                       upm_reg_read_t read,
+                                       upm_reg_write_t write, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPM_REG_CACHE_H_ */
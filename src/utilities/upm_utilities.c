@@ -195,6 +195,51 @@ void upm_delay_ns(uint64_t time)
 #endif
 }
 
+void upm_delay_until_ns(upm_clock_t *clock, uint64_t period)
+{
+    assert((clock != NULL) && "upm_delay_until_ns, clock cannot be NULL");
+
+#if defined(UPM_PLATFORM_LINUX)
+
+    uint64_t nsec = clock->tv_nsec + period;
+    clock->tv_sec += nsec / 1000000000UL;
+    clock->tv_nsec = nsec % 1000000000UL;
+
+    // sleep on the absolute deadline, so being interrupted or
+    // scheduled late does not push back the following deadlines
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, clock, NULL) == EINTR);
+
+#elif defined(UPM_PLATFORM_ZEPHYR)
+
+    *clock += (uint64_t)period * sys_clock_hw_cycles_per_sec / 1000000000UL;
+    while ((int32_t)(sys_cycle_get_32() - (uint32_t)*clock) < 0); // spin
+
+#else
+#error "Unknown platform, valid platforms are {UPM_PLATFORM_ZEPHYR, UPM_PLATFORM_LINUX}"
+#endif
+}
+
+upm_clock_t upm_clock_deadline_us(uint32_t time)
+{
+    upm_clock_t clock = upm_clock_init();
+
+#if defined(UPM_PLATFORM_LINUX)
+
+    uint64_t nsec = clock.tv_nsec + (uint64_t)time * 1000;
+    clock.tv_sec += nsec / 1000000000UL;
+    clock.tv_nsec = nsec % 1000000000UL;
+
+#elif defined(UPM_PLATFORM_ZEPHYR)
+
+    clock += (uint64_t)time * sys_clock_hw_cycles_per_sec / 1000000UL;
+
+#else
+#error "Unknown platform, valid platforms are {UPM_PLATFORM_ZEPHYR, UPM_PLATFORM_LINUX}"
+#endif
+
+    return clock;
+}
+
 upm_clock_t upm_clock_init(void)
 {
     upm_clock_t clock = {0};
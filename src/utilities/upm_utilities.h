@@ -80,6 +80,44 @@ void upm_delay_us(uint32_t time);
  */
 void upm_delay_ns(uint64_t time);
 
+/**
+ * Advance a clock by a period, and delay until the clock's new time
+ * is reached.  Returns immediately if that time has already passed.
+ * Calling this repeatedly with the same clock produces a fixed rate
+ * schedule which, unlike upm_delay_us() and friends, does not drift
+ * by the time spent between calls.
+ *
+ * For *nix operating systems, this sleeps on an absolute MONOTONIC
+ * deadline.
+ *
+ * Example:
+ *      upm_clock_t next = upm_clock_init();
+ *      while (...) {
+ *          upm_delay_until_ns(&next, period_ns);
+ *          ... do periodic stuff ...
+ *      }
+ *
+ * @param clock A upm_clock_t initialized by upm_clock_init(), updated
+ * to the new deadline
+ * @param period The number of nanoseconds to advance the clock by
+ */
+void upm_delay_until_ns(upm_clock_t *clock, uint64_t period);
+
+/**
+ * Return a clock set to a time in the future, to be waited for with
+ * upm_delay_until_ns(&clock, 0).
+ *
+ * This is meant for settle times.  Rather than sleeping right after a
+ * command that takes a while to complete (a reset, a mode change), a
+ * driver can record when the device will be ready and wait for that
+ * before it next talks to the device, so whatever the caller does in
+ * between, e.g. bringing up other devices, overlaps the wait.
+ *
+ * @param time The number of microseconds from now
+ * @return The upm_clock_t set to the deadline
+ */
+upm_clock_t upm_clock_deadline_us(uint32_t time);
+
 /**
  * Initialize a clock.  This can be used with upm_elapsed_ms() and
  * upm_elapsed_us() for measuring a duration.
@@ -7,8 +7,15 @@ JAVA_JNI_LOADLIBRARY(javaupm_utilities)
 /* END Java syntax */
 
 /* BEGIN Common SWIG syntax ------------------------------------------------- */
+%include "std_string.i"
+%include "std_vector.i"
+
 %{
 #include "upm_utilities.hpp"
+#include "upm_bus_stats.hpp"
 %}
 %include "upm_utilities.hpp"
+%include "upm_bus_stats.hpp"
+
+%template(BusStatsVector) std::vector<upm::BusStats>;
 /* END Common SWIG syntax */
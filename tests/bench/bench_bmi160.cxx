@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bmi160.h"
+#include "upm_bench.hpp"
+
+using namespace upm;
+
+static const int bus = 0;
+static const uint8_t addr = 0x69;
+
+// BMI160 register model with fixed gyro/accel samples
+class Bmi160Model : public sim::RegisterDevice {
+public:
+    Bmi160Model()
+    {
+        set(BMI160_USER_CHIP_ID_ADDR, BMI160_CHIP_ID);
+        setReadOnly(BMI160_USER_CHIP_ID_ADDR);
+
+        // gyro x/y/z, then accel x/y/z, little endian
+        static const uint8_t data[12] = {
+            0x10, 0x00, 0x20, 0x00, 0x30, 0x00,
+            0x00, 0x01, 0x00, 0x02, 0x00, 0x40
+        };
+
+        set(BMI160_USER_DATA_8_ADDR, data, sizeof(data));
+        for (unsigned int i = 0; i < sizeof(data); i++)
+            setReadOnly(BMI160_USER_DATA_8_ADDR + i);
+
+        // the sensor time counts up on every read of its LSB
+        onRead([](RegisterDevice &dev, uint8_t reg) {
+                if (reg == BMI160_USER_SENSORTIME_0_ADDR)
+                {
+                    uint32_t t = dev.get(reg) | (dev.get(reg + 1) << 8)
+                        | (dev.get(reg + 2) << 16);
+                    t++;
+                    dev.set(reg, t & 0xff);
+                    dev.set(reg + 1, (t >> 8) & 0xff);
+                    dev.set(reg + 2, (t >> 16) & 0xff);
+                }
+            });
+    }
+};
+
+bool bench::bmi160(const Options &opts, Result &res)
+{
+    sim::reset();
+
+    Bmi160Model model;
+    sim::TraceDevice trace;
+
+    if (opts.replay.empty())
+        sim::attachI2c(bus, addr, &model);
+    else
+    {
+        trace.loadI2c(opts.replay, bus, addr);
+        sim::attachI2c(bus, addr, &trace);
+    }
+
+    bmi160_context dev = bmi160_init(bus, addr, -1, false);
+    if (!dev)
+        return false;
+
+    measure(opts, res, [&]() { bmi160_update(dev); });
+
+    res.mismatches = trace.mismatches();
+
+    bmi160_close(dev);
+
+    return true;
+}
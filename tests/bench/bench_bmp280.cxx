@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <math.h>
+
+#include "bmp280.h"
+#include "upm_bench.hpp"
+
+using namespace upm;
+
+static const int bus = 0;
+static const uint8_t addr = 0x77;
+
+// BMP280 register model loaded with the compensation example from the
+// datasheet, section 3.12.  Expect 25.08C and 100653.27Pa.
+class Bmp280Model : public sim::RegisterDevice {
+public:
+    Bmp280Model()
+    {
+        set(BMP280_REG_CHIPID, BMP280_CHIPID);
+        setReadOnly(BMP280_REG_CHIPID);
+
+        static const int16_t calib[12] = {
+            (int16_t)27504, 26435, -1000,
+            (int16_t)36477, -10685, 3024, 2855, 140, -7, 15500, -14600, 6000
+        };
+
+        for (int i = 0; i < 12; i++)
+        {
+            set(BMP280_REG_CALIB00 + (i * 2), (uint16_t)calib[i] & 0xff);
+            set(BMP280_REG_CALIB00 + (i * 2) + 1, (uint16_t)calib[i] >> 8);
+        }
+
+        const uint32_t pres = 415148;
+        const uint32_t temp = 519888;
+        uint8_t data[6] = {
+            (uint8_t)(pres >> 12), (uint8_t)(pres >> 4), (uint8_t)(pres << 4),
+            (uint8_t)(temp >> 12), (uint8_t)(temp >> 4), (uint8_t)(temp << 4)
+        };
+
+        set(BMP280_REG_PRESSURE_MSB, data, 6);
+        for (int i = 0; i < 6; i++)
+            setReadOnly(BMP280_REG_PRESSURE_MSB + i);
+
+        // a forced conversion completes immediately, and the part
+        // returns to sleep mode
+        onWrite([](RegisterDevice &dev, uint8_t reg, uint8_t val) {
+                if (reg == BMP280_REG_CTRL_MEAS
+                    && ((val & 0x03) == BMP280_MODE_FORCED))
+                    dev.set(reg, val & ~0x03);
+            });
+    }
+};
+
+bool bench::bmp280(const Options &opts, Result &res)
+{
+    sim::reset();
+
+    Bmp280Model model;
+    sim::TraceDevice trace;
+
+    if (opts.replay.empty())
+        sim::attachI2c(bus, addr, &model);
+    else
+    {
+        trace.loadI2c(opts.replay, bus, addr);
+        sim::attachI2c(bus, addr, &trace);
+    }
+
+    bmp280_context dev = bmp280_init(bus, addr, -1);
+    if (!dev)
+        return false;
+
+    measure(opts, res, [&]() { bmp280_update(dev); });
+
+    res.valid = (fabs(bmp280_get_temperature(dev) - 25.08) < 0.01
+                 && fabs(bmp280_get_pressure(dev) - 100653.27) < 1.0);
+    res.mismatches = trace.mismatches();
+
+    bmp280_close(dev);
+
+    return true;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "bno055.h"
+#include "upm_bench.hpp"
+
+using namespace upm;
+
+static const int bus = 0;
+static const uint8_t addr = BNO055_DEFAULT_ADDR;
+
+// BNO055 register model, two pages selected through the page id
+// register, with a fixed set of fusion and raw outputs.
+class Bno055Model : public sim::RegisterDevice {
+public:
+    Bno055Model() : RegisterDevice(2, BNO055_REG_PAGE_ID)
+    {
+        set(BNO055_REG_CHIP_ID, BNO055_CHIPID, 0);
+        setReadOnly(BNO055_REG_CHIP_ID);
+
+        set(BNO055_REG_TEMPERATURE, 24, 0);
+
+        // accel, mag, gyro, euler, quaternion, linear accel, gravity
+        for (int i = 0; i < 44; i++)
+            set(BNO055_REG_ACC_DATA_X_LSB + i, (uint8_t)(i * 3), 0);
+
+        // fully calibrated
+        set(BNO055_REG_CALIB_STAT, 0xff, 0);
+    }
+};
+
+bool bench::bno055(const Options &opts, Result &res)
+{
+    sim::reset();
+
+    Bno055Model model;
+    sim::TraceDevice trace;
+
+    if (opts.replay.empty())
+        sim::attachI2c(bus, addr, &model);
+    else
+    {
+        trace.loadI2c(opts.replay, bus, addr);
+        sim::attachI2c(bus, addr, &trace);
+    }
+
+    bno055_context dev = bno055_init(bus, addr, NULL);
+    if (!dev)
+        return false;
+
+    measure(opts, res, [&]() { bno055_update(dev); });
+
+    res.valid = (bno055_get_temperature(dev) == 24.0);
+    res.mismatches = trace.mismatches();
+
+    bno055_close(dev);
+
+    return true;
+}
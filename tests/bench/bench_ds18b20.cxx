@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include "ds18b20.h"
+#include "upm_bench.hpp"
+
+using namespace upm;
+
+static const int uart = 0;
+
+// DS18B20 scratchpad model, reading 25.0625C at 12 bits
+class Ds18b20Model : public sim::OneWireDevice {
+public:
+    Ds18b20Model(const uint8_t romCode[8]) :
+        OneWireDevice(romCode), m_pos(0), m_writePos(0), m_cmd(0)
+    {
+        static const uint8_t defaults[9] = {
+            0x91, 0x01, 0x4b, 0x46, 0x7f, 0xff, 0x0f, 0x10, 0x00
+        };
+
+        memcpy(m_scratch, defaults, sizeof(m_scratch));
+        m_scratch[8] = sim::crc8(m_scratch, 8);
+    }
+
+    void command(uint8_t cmd)
+    {
+        m_cmd = cmd;
+        m_pos = 0;
+        m_writePos = 0;
+    }
+
+    uint8_t readByte()
+    {
+        if (m_cmd == DS18B20_CMD_READ_SCRATCHPAD && m_pos < 9)
+            return m_scratch[m_pos++];
+
+        return 0xff;
+    }
+
+    void writeByte(uint8_t byte)
+    {
+        // TH, TL and config
+        if (m_cmd == DS18B20_CMD_WRITE_SCRATCHPAD && m_writePos < 3)
+        {
+            m_scratch[2 + m_writePos++] = byte;
+            m_scratch[8] = sim::crc8(m_scratch, 8);
+        }
+    }
+
+private:
+    uint8_t m_scratch[9];
+    int m_pos;
+    int m_writePos;
+    uint8_t m_cmd;
+};
+
+bool bench::ds18b20(const Options &opts, Result &res)
+{
+    sim::reset();
+
+    static const uint8_t rom[8] = {
+        DS18B20_FAMILY_CODE, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x00
+    };
+    Ds18b20Model model(rom);
+
+    sim::attachOneWire(uart, &model);
+
+    ds18b20_context dev = ds18b20_init(uart);
+    if (!dev)
+        return false;
+
+    measure(opts, res, [&]() { ds18b20_update(dev, 0); });
+
+    res.valid = (ds18b20_get_temperature(dev, 0) == 25.0625);
+
+    ds18b20_close(dev);
+
+    return true;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdexcept>
+
+#include "h3lis331dl.hpp"
+#include "upm_bench.hpp"
+
+using namespace upm;
+
+static const int bus = 0;
+static const uint8_t addr = H3LIS331DL_DEFAULT_I2C_ADDR;
+
+// H3LIS331DL register model with fixed samples
+class H3lis331dlModel : public sim::RegisterDevice {
+public:
+    H3lis331dlModel()
+    {
+        setAutoIncrementFlag(0x80);
+
+        set(H3LIS331DL::REG_WHOAMI, 0x32);
+        setReadOnly(H3LIS331DL::REG_WHOAMI);
+
+        // x = 100, y = -200, z = 1000
+        static const uint8_t data[6] = {
+            0x64, 0x00, 0x38, 0xff, 0xe8, 0x03
+        };
+
+        set(H3LIS331DL::REG_OUT_X_L, data, sizeof(data));
+        for (unsigned int i = 0; i < sizeof(data); i++)
+            setReadOnly(H3LIS331DL::REG_OUT_X_L + i);
+    }
+};
+
+bool bench::h3lis331dl(const Options &opts, Result &res)
+{
+    sim::reset();
+
+    H3lis331dlModel model;
+    sim::TraceDevice trace;
+
+    if (opts.replay.empty())
+        sim::attachI2c(bus, addr, &model);
+    else
+    {
+        trace.loadI2c(opts.replay, bus, addr);
+        sim::attachI2c(bus, addr, &trace);
+    }
+
+    H3LIS331DL *dev = 0;
+    try
+    {
+        dev = new H3LIS331DL(bus, addr);
+        dev->init();
+    }
+    catch (std::exception &e)
+    {
+        delete dev;
+        return false;
+    }
+
+    measure(opts, res, [&]() { dev->update(); });
+
+    int x, y, z;
+    dev->getRawXYZ(&x, &y, &z);
+    res.valid = (x == 100 && y == -200 && z == 1000);
+    res.mismatches = trace.mismatches();
+
+    delete dev;
+
+    return true;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <math.h>
+
+#include <stdexcept>
+
+#include "lsm9ds0.hpp"
+#include "upm_bench.hpp"
+
+using namespace upm;
+
+static const int bus = 0;
+static const uint8_t gAddr = LSM9DS0_DEFAULT_GYRO_ADDR;
+static const uint8_t xmAddr = LSM9DS0_DEFAULT_XM_ADDR;
+
+// LSM9DS0 gyroscope or accelerometer/magnetometer register model
+class Lsm9ds0Model : public sim::RegisterDevice {
+public:
+    explicit Lsm9ds0Model(uint8_t whoami)
+    {
+        setAutoIncrementFlag(0x80);
+
+        set(0x0f, whoami);
+        setReadOnly(0x0f);
+    }
+
+    // fixed output registers
+    void output(uint8_t reg, const uint8_t *data, int len)
+    {
+        set(reg, data, len);
+        for (int i = 0; i < len; i++)
+            setReadOnly(reg + i);
+    }
+};
+
+// gyro x/y/z = 1000, -1000, 2000
+static const uint8_t gyroData[6] = { 0xe8, 0x03, 0x18, 0xfc, 0xd0, 0x07 };
+
+// temperature -16, mag status, mag x/y/z = 500, -500, 1000
+static const uint8_t tempMagData[9] = {
+    0xf0, 0x0f, 0x00, 0xf4, 0x01, 0x0c, 0xfe, 0xe8, 0x03
+};
+
+// accel x/y/z = 0, 0, 16384
+static const uint8_t accelData[6] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x40 };
+
+bool bench::lsm9ds0(const Options &opts, Result &res)
+{
+    sim::reset();
+
+    Lsm9ds0Model gModel(0xd4), xmModel(0x49);
+    gModel.output(LSM9DS0::REG_OUT_X_L_G, gyroData, sizeof(gyroData));
+    xmModel.output(LSM9DS0::REG_OUT_TEMP_L_XM, tempMagData,
+                   sizeof(tempMagData));
+    xmModel.output(LSM9DS0::REG_OUT_X_L_A, accelData, sizeof(accelData));
+    sim::TraceDevice gTrace, xmTrace;
+
+    if (opts.replay.empty())
+    {
+        sim::attachI2c(bus, gAddr, &gModel);
+        sim::attachI2c(bus, xmAddr, &xmModel);
+    }
+    else
+    {
+        gTrace.loadI2c(opts.replay, bus, gAddr);
+        xmTrace.loadI2c(opts.replay, bus, xmAddr);
+        sim::attachI2c(bus, gAddr, &gTrace);
+        sim::attachI2c(bus, xmAddr, &xmTrace);
+    }
+
+    LSM9DS0 *dev = 0;
+    try
+    {
+        dev = new LSM9DS0(bus);
+        dev->init();
+    }
+    catch (std::exception &e)
+    {
+        delete dev;
+        return false;
+    }
+
+    measure(opts, res, [&]() { dev->update(); });
+
+    // default scales: 8.75 mdps, 0.061 mg and 0.08 mgauss per LSB
+    float gx, gy, gz, ax, ay, az, mx, my, mz;
+    dev->getGyroscope(&gx, &gy, &gz);
+    dev->getAccelerometer(&ax, &ay, &az);
+    dev->getMagnetometer(&mx, &my, &mz);
+
+    res.valid = (fabs(gx - 8.75) < 0.01 && fabs(gy + 8.75) < 0.01
+                 && fabs(gz - 17.5) < 0.01
+                 && fabs(ax) < 0.001 && fabs(ay) < 0.001
+                 && fabs(az - 0.999) < 0.001
+                 && fabs(mx - 0.04) < 0.001 && fabs(my + 0.04) < 0.001
+                 && fabs(mz - 0.08) < 0.001
+                 && fabs(dev->getTemperature() + 6.25) < 0.01);
+    res.mismatches = gTrace.mismatches() + xmTrace.mismatches();
+
+    delete dev;
+
+    return true;
+}
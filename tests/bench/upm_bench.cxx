@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "upm_bench.hpp"
+
+using namespace upm;
+
+// Bus transactions allowed per update().  A driver change that makes
+// update() more expensive fails the benchmark run, lower these when a
+// driver gets cheaper.
+static const struct {
+    const char *name;
+    bool (*run)(const bench::Options &opts, bench::Result &res);
+    double maxTransactions;
+} benchmarks[] = {
+    { "bmp280",     bench::bmp280,     1 },
+    { "bmi160",     bench::bmi160,     3 },
+    { "bno055",     bench::bno055,     3 },
+    { "ds18b20",    bench::ds18b20,    11 },
+    { "h3lis331dl", bench::h3lis331dl, 1 },
+    { "lsm9ds0",    bench::lsm9ds0,    3 },
+};
+
+static uint64_t cpuTimeNs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+void bench::measure(const Options &opts, Result &res,
+                    std::function<void ()> update)
+{
+    sim::resetStats();
+
+    uint64_t start = cpuTimeNs();
+    for (int i = 0; i < opts.iterations; i++)
+        update();
+    res.cpuNs = cpuTimeNs() - start;
+
+    res.iterations = opts.iterations;
+    res.stats = sim::stats();
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-n iterations] [-r record.trace] "
+            "[-p replay.trace] [driver ...]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    bench::Options opts;
+    std::string record;
+    int opt;
+
+    opts.iterations = 100;
+
+    while ((opt = getopt(argc, argv, "n:r:p:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            opts.iterations = atoi(optarg);
+            break;
+        case 'r':
+            record = optarg;
+            break;
+        case 'p':
+            opts.replay = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (opts.iterations < 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!record.empty() && !sim::startRecording(record))
+    {
+        fprintf(stderr, "Could not open %s for writing\n", record.c_str());
+        return 1;
+    }
+
+    printf("%-10s %10s %10s %10s %8s %12s %12s\n", "driver", "txns/upd",
+           "bytes/upd", "errs/upd", "cpu us", "delay us", "bus us@100k");
+
+    int failures = 0;
+    size_t count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // optionally only run the drivers named on the command line
+        if (optind < argc)
+        {
+            bool selected = false;
+            for (int j = optind; j < argc; j++)
+                if (!strcmp(argv[j], benchmarks[i].name))
+                    selected = true;
+            if (!selected)
+                continue;
+        }
+
+        bench::Result res;
+
+        if (!benchmarks[i].run(opts, res))
+        {
+            printf("%-10s FAILED: init failed\n", benchmarks[i].name);
+            failures++;
+            continue;
+        }
+
+        const sim::Stats &st = res.stats;
+        double n = res.iterations;
+        double txns = st.transactions / n;
+
+        // each byte is 9 bits on the wire, plus an address byte and
+        // start/stop per transaction
+        double busUs = ((st.bytes() + st.transactions) * 9 + st.transactions * 2)
+            * 10.0 / n;
+
+        printf("%-10s %10.2f %10.2f %10.2f %8.2f %12.2f %12.2f\n",
+               benchmarks[i].name, txns, st.bytes() / n, st.errors / n,
+               res.cpuNs / 1000.0 / n, st.delayNs / 1000.0 / n, busUs);
+
+        if (txns > benchmarks[i].maxTransactions)
+        {
+            printf("%-10s FAILED: %.2f transactions per update, budget is "
+                   "%.2f\n", benchmarks[i].name, txns,
+                   benchmarks[i].maxTransactions);
+            failures++;
+        }
+
+        if (st.errors)
+        {
+            printf("%-10s FAILED: %llu bus errors\n", benchmarks[i].name,
+                   (unsigned long long)st.errors);
+            failures++;
+        }
+
+        if (res.mismatches)
+        {
+            printf("%-10s FAILED: %u writes did not match the trace\n",
+                   benchmarks[i].name, res.mismatches);
+            failures++;
+        }
+
+        if (!res.valid)
+        {
+            printf("%-10s FAILED: driver returned unexpected data\n",
+                   benchmarks[i].name);
+            failures++;
+        }
+    }
+
+    sim::stopRecording();
+
+    return (failures) ? 1 : 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <string>
+
+#include "upm_sim.hpp"
+
+namespace upm {
+namespace bench {
+
+    struct Options {
+        // number of update() calls to measure
+        int iterations;
+        // replay I2C traffic from this trace instead of device models
+        std::string replay;
+    };
+
+    struct Result {
+        int iterations;
+        // bus traffic and delays over all iterations
+        sim::Stats stats;
+        // CPU time over all iterations
+        uint64_t cpuNs;
+        // replayed writes that did not match the trace
+        unsigned int mismatches;
+        // false if the driver reported wrong data
+        bool valid;
+
+        Result() : iterations(0), cpuNs(0), mismatches(0), valid(true) {}
+    };
+
+    /* Run update() opts.iterations times and fill in res */
+    void measure(const Options &opts, Result &res,
+                 std::function<void ()> update);
+
+    /* Per driver benchmarks, each returns false if the driver could
+     * not be initialized */
+    bool bmp280(const Options &opts, Result &res);
+    bool bmi160(const Options &opts, Result &res);
+    bool bno055(const Options &opts, Result &res);
+    bool ds18b20(const Options &opts, Result &res);
+    bool h3lis331dl(const Options &opts, Result &res);
+    bool lsm9ds0(const Options &opts, Result &res);
+}
+}
@@ -0,0 +1,1200 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include <mraa/common.h>
+#include <mraa/i2c.h>
+#include <mraa/spi.h>
+#include <mraa/gpio.h>
+#include <mraa/uart_ow.h>
+
+#include "upm_utilities.h"
+#include "upm_sim.hpp"
+
+using namespace upm::sim;
+
+// The MRAA contexts are opaque to drivers, so the simulation is free
+// to define them.
+struct _i2c {
+    int bus;
+    uint8_t addr;
+};
+
+struct _spi {
+    int bus;
+};
+
+struct _gpio {
+    int pin;
+    mraa_gpio_edge_t edge;
+    void (*isr)(void *);
+    void *isrArgs;
+};
+
+struct _mraa_uart_ow {
+    int uart;
+    size_t searchPos;
+    // NULL means all devices (skip ROM)
+    OneWireDevice *selected;
+};
+
+namespace {
+    std::recursive_mutex simLock;
+
+    std::map<std::pair<int, uint8_t>, Device *> i2cDevices;
+    std::map<int, Device *> spiDevices;
+    std::map<int, std::vector<OneWireDevice *> > owDevices;
+    std::map<int, int> gpioLevels;
+    std::vector<_gpio *> gpioContexts;
+
+    Stats globalStats;
+    FILE *traceFile = NULL;
+
+    void account(Stats *devStats, int rd, int wr, bool ok)
+    {
+        Stats *all[2] = { &globalStats, devStats };
+
+        for (int i = 0; i < 2; i++)
+        {
+            if (!all[i])
+                continue;
+
+            all[i]->transactions++;
+            all[i]->bytesRead += rd;
+            all[i]->bytesWritten += wr;
+            if (!ok)
+                all[i]->errors++;
+        }
+    }
+
+    void traceBytes(const uint8_t *data, int len)
+    {
+        for (int i = 0; i < len; i++)
+            fprintf(traceFile, " %02x", data[i]);
+    }
+
+    // one line per transaction:
+    //   <bus type> <bus> [<addr>] <op> <tx bytes> [: <rx bytes>]
+    void trace(const char *type, int bus, int addr, char op,
+               const uint8_t *tx, int txLen, const uint8_t *rx, int rxLen)
+    {
+        if (!traceFile)
+            return;
+
+        fprintf(traceFile, "%s %d", type, bus);
+        if (addr >= 0)
+            fprintf(traceFile, " %02x", addr);
+        fprintf(traceFile, " %c", op);
+
+        traceBytes(tx, txLen);
+        if (op == 'X')
+            fprintf(traceFile, " :");
+        traceBytes(rx, rxLen);
+        fprintf(traceFile, "\n");
+    }
+
+    // run a (possibly combined) I2C transaction against the device at
+    // the context's current address
+    bool i2cXfer(mraa_i2c_context ctx, const uint8_t *tx, int txLen,
+                 uint8_t *rx, int rxLen)
+    {
+        std::lock_guard<std::recursive_mutex> lock(simLock);
+
+        if (!ctx)
+            return false;
+
+        std::map<std::pair<int, uint8_t>, Device *>::iterator it =
+            i2cDevices.find(std::make_pair(ctx->bus, ctx->addr));
+
+        if (it == i2cDevices.end())
+        {
+            // nobody home, address NAK
+            account(NULL, 0, 0, false);
+            return false;
+        }
+
+        Device *dev = it->second;
+        bool ok = true;
+
+        if (txLen)
+            ok = dev->write(tx, txLen);
+        if (ok && rxLen)
+            ok = dev->read(rx, rxLen);
+
+        account(&dev->stats, (ok) ? rxLen : 0, txLen, ok);
+
+        char op = (txLen && rxLen) ? 'X' : ((txLen) ? 'W' : 'R');
+        trace("i2c", ctx->bus, ctx->addr, op, tx, txLen, rx, (ok) ? rxLen : 0);
+
+        return ok;
+    }
+
+    bool spiXfer(mraa_spi_context ctx, const uint8_t *tx, uint8_t *rx,
+                 int len)
+    {
+        std::lock_guard<std::recursive_mutex> lock(simLock);
+
+        if (!ctx)
+            return false;
+
+        std::map<int, Device *>::iterator it = spiDevices.find(ctx->bus);
+
+        if (it == spiDevices.end())
+        {
+            // floating MISO
+            memset(rx, 0xff, len);
+            account(NULL, len, len, true);
+            return true;
+        }
+
+        Device *dev = it->second;
+        bool ok = dev->transfer(tx, rx, len);
+
+        account(&dev->stats, len, len, ok);
+        trace("spi", ctx->bus, -1, 'X', tx, len, rx, len);
+
+        return ok;
+    }
+
+    std::vector<OneWireDevice *> &owBus(mraa_uart_ow_context ctx)
+    {
+        return owDevices[ctx->uart];
+    }
+
+    // account one-wire traffic against the selected device(s)
+    void owAccount(mraa_uart_ow_context ctx, int rd, int wr, bool ok)
+    {
+        if (ctx->selected)
+            account(&ctx->selected->stats, rd, wr, ok);
+        else
+            account(NULL, rd, wr, ok);
+    }
+
+    bool parseHex(std::istringstream &in, std::vector<uint8_t> &out,
+                  bool stopAtColon)
+    {
+        std::string tok;
+
+        while (in >> tok)
+        {
+            if (tok == ":")
+                return stopAtColon;
+
+            out.push_back((uint8_t)strtoul(tok.c_str(), NULL, 16));
+        }
+
+        return !stopAtColon;
+    }
+}
+
+//
+// Device
+//
+
+bool Device::transfer(const uint8_t *tx, uint8_t *rx, int len)
+{
+    if (len < 1)
+        return true;
+
+    memset(rx, 0, len);
+
+    if (tx[0] & 0x80)
+    {
+        uint8_t reg = tx[0] & 0x7f;
+
+        if (!write(&reg, 1))
+            return false;
+
+        return (len > 1) ? read(rx + 1, len - 1) : true;
+    }
+
+    return write(tx, len);
+}
+
+//
+// RegisterDevice
+//
+
+RegisterDevice::RegisterDevice(int pages, int pageReg) :
+    m_regs(256 * pages, 0), m_readOnly(256 * pages, false),
+    m_pages(pages), m_pageReg(pageReg), m_page(0), m_ptr(0),
+    m_autoIncFlag(0), m_autoInc(true)
+{
+}
+
+bool RegisterDevice::write(const uint8_t *data, int len)
+{
+    if (len < 1)
+        return true;
+
+    // first byte is the register pointer, anything after it is data
+    m_ptr = data[0];
+    m_autoInc = true;
+    if (m_autoIncFlag)
+    {
+        m_autoInc = (m_ptr & m_autoIncFlag) != 0;
+        m_ptr &= ~m_autoIncFlag;
+    }
+
+    for (int i = 1; i < len; i++)
+    {
+        uint8_t reg = m_autoInc ? m_ptr++ : m_ptr;
+
+        if (m_pageReg >= 0 && reg == m_pageReg)
+        {
+            if (data[i] < m_pages)
+                m_page = data[i];
+
+            // the page register is visible in every page
+            for (int p = 0; p < m_pages; p++)
+                m_regs[(p * 256) + reg] = data[i];
+        }
+        else if (!m_readOnly[(m_page * 256) + reg])
+            m_regs[(m_page * 256) + reg] = data[i];
+
+        if (m_writeHook)
+            m_writeHook(*this, reg, data[i]);
+    }
+
+    return true;
+}
+
+bool RegisterDevice::read(uint8_t *data, int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        uint8_t reg = m_autoInc ? m_ptr++ : m_ptr;
+
+        if (m_readHook)
+            m_readHook(*this, reg);
+
+        data[i] = m_regs[(m_page * 256) + reg];
+    }
+
+    return true;
+}
+
+uint8_t RegisterDevice::get(uint8_t reg, int page) const
+{
+    if (page < 0)
+        page = m_page;
+
+    return m_regs[(page * 256) + reg];
+}
+
+void RegisterDevice::set(uint8_t reg, uint8_t val, int page)
+{
+    if (page < 0)
+        page = m_page;
+
+    m_regs[(page * 256) + reg] = val;
+}
+
+void RegisterDevice::set(uint8_t reg, const uint8_t *vals, int len, int page)
+{
+    for (int i = 0; i < len; i++)
+        set((uint8_t)(reg + i), vals[i], page);
+}
+
+void RegisterDevice::setReadOnly(uint8_t reg, bool ro)
+{
+    for (int p = 0; p < m_pages; p++)
+        m_readOnly[(p * 256) + reg] = ro;
+}
+
+//
+// TraceDevice
+//
+
+TraceDevice::TraceDevice() : m_pos(0), m_loop(true), m_mismatches(0)
+{
+}
+
+int TraceDevice::loadI2c(const std::string &path, int bus, uint8_t addr)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "i2c %d %02x", bus, addr);
+
+    return load(path, key);
+}
+
+int TraceDevice::loadSpi(const std::string &path, int bus)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "spi %d", bus);
+
+    return load(path, key);
+}
+
+int TraceDevice::load(const std::string &path, const std::string &key)
+{
+    std::ifstream file(path.c_str());
+    std::string line;
+
+    m_records.clear();
+    m_pos = 0;
+    m_mismatches = 0;
+
+    while (std::getline(file, line))
+    {
+        if (line.compare(0, key.size(), key) != 0
+            || line.size() < key.size() + 2
+            || line[key.size()] != ' ')
+            continue;
+
+        std::istringstream in(line.substr(key.size() + 1));
+        Record rec;
+
+        if (!(in >> rec.op))
+            continue;
+
+        switch (rec.op)
+        {
+        case 'W':
+            parseHex(in, rec.tx, false);
+            break;
+        case 'R':
+            parseHex(in, rec.rx, false);
+            break;
+        case 'X':
+            if (!parseHex(in, rec.tx, true))
+                continue;
+            parseHex(in, rec.rx, false);
+            break;
+        default:
+            continue;
+        }
+
+        m_records.push_back(rec);
+    }
+
+    return (int)m_records.size();
+}
+
+const TraceDevice::Record *TraceDevice::next(char op)
+{
+    if (m_pos >= m_records.size())
+    {
+        if (!m_loop || m_records.empty())
+            return NULL;
+        m_pos = 0;
+    }
+
+    const Record *rec = &m_records[m_pos];
+
+    // a combined write/read shows up as write() then read()
+    if (op == 'W' && rec->op == 'X')
+        return rec;
+
+    m_pos++;
+
+    if (rec->op != op)
+    {
+        m_mismatches++;
+        return NULL;
+    }
+
+    return rec;
+}
+
+bool TraceDevice::write(const uint8_t *data, int len)
+{
+    const Record *rec = next('W');
+
+    if (!rec)
+        return false;
+
+    if ((int)rec->tx.size() != len || memcmp(&rec->tx[0], data, len))
+        m_mismatches++;
+
+    return true;
+}
+
+bool TraceDevice::read(uint8_t *data, int len)
+{
+    const Record *rec = NULL;
+
+    if (m_pos < m_records.size() && m_records[m_pos].op == 'X')
+        rec = &m_records[m_pos++];
+    else
+        rec = next('R');
+
+    if (!rec)
+        return false;
+
+    if ((int)rec->rx.size() != len)
+        m_mismatches++;
+
+    memset(data, 0, len);
+    memcpy(data, &rec->rx[0],
+           ((int)rec->rx.size() < len) ? rec->rx.size() : len);
+
+    return true;
+}
+
+bool TraceDevice::transfer(const uint8_t *tx, uint8_t *rx, int len)
+{
+    const Record *rec = next('X');
+
+    if (!rec)
+        return false;
+
+    if ((int)rec->tx.size() != len || memcmp(&rec->tx[0], tx, len))
+        m_mismatches++;
+
+    memset(rx, 0, len);
+    memcpy(rx, &rec->rx[0],
+           ((int)rec->rx.size() < len) ? rec->rx.size() : len);
+
+    return true;
+}
+
+//
+// OneWireDevice
+//
+
+OneWireDevice::OneWireDevice(const uint8_t romCode[8])
+{
+    memcpy(m_rom, romCode, sizeof(m_rom));
+}
+
+//
+// Simulation control
+//
+
+void upm::sim::attachI2c(int bus, uint8_t addr, Device *dev)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    i2cDevices[std::make_pair(bus, addr)] = dev;
+}
+
+void upm::sim::attachSpi(int bus, Device *dev)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    spiDevices[bus] = dev;
+}
+
+void upm::sim::attachOneWire(int uart, OneWireDevice *dev)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    owDevices[uart].push_back(dev);
+}
+
+void upm::sim::reset()
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    i2cDevices.clear();
+    spiDevices.clear();
+    owDevices.clear();
+    gpioLevels.clear();
+    globalStats = Stats();
+}
+
+void upm::sim::setGpio(int pin, int value)
+{
+    std::vector<std::pair<void (*)(void *), void *> > isrs;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(simLock);
+
+        int old = gpioLevels[pin];
+        value = (value) ? 1 : 0;
+        gpioLevels[pin] = value;
+
+        if (old == value)
+            return;
+
+        for (size_t i = 0; i < gpioContexts.size(); i++)
+        {
+            _gpio *g = gpioContexts[i];
+
+            if (g->pin != pin || !g->isr)
+                continue;
+
+            if (g->edge == MRAA_GPIO_EDGE_BOTH
+                || (g->edge == MRAA_GPIO_EDGE_RISING && value)
+                || (g->edge == MRAA_GPIO_EDGE_FALLING && !value))
+                isrs.push_back(std::make_pair(g->isr, g->isrArgs));
+        }
+    }
+
+    // run the handlers unlocked, they will likely touch the bus
+    for (size_t i = 0; i < isrs.size(); i++)
+        isrs[i].first(isrs[i].second);
+}
+
+int upm::sim::getGpio(int pin)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    return gpioLevels[pin];
+}
+
+const Stats &upm::sim::stats()
+{
+    return globalStats;
+}
+
+void upm::sim::resetStats()
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    globalStats = Stats();
+}
+
+bool upm::sim::startRecording(const std::string &path)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    if (traceFile)
+        fclose(traceFile);
+
+    traceFile = fopen(path.c_str(), "w");
+
+    return (traceFile != NULL);
+}
+
+void upm::sim::stopRecording()
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    if (traceFile)
+        fclose(traceFile);
+    traceFile = NULL;
+}
+
+uint8_t upm::sim::crc8(const uint8_t *data, int len)
+{
+    uint8_t crc = 0;
+
+    for (int i = 0; i < len; i++)
+    {
+        uint8_t byte = data[i];
+
+        for (int j = 0; j < 8; j++)
+        {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix)
+                crc ^= 0x8c;
+            byte >>= 1;
+        }
+    }
+
+    return crc;
+}
+
+//
+// MRAA C API
+//
+
+extern "C" {
+
+mraa_result_t mraa_init(void)
+{
+    return MRAA_SUCCESS;
+}
+
+// I2C
+
+mraa_i2c_context mraa_i2c_init(int bus)
+{
+    mraa_i2c_context ctx = new _i2c;
+
+    ctx->bus = bus;
+    ctx->addr = 0;
+
+    return ctx;
+}
+
+mraa_i2c_context mraa_i2c_init_raw(unsigned int bus)
+{
+    return mraa_i2c_init((int)bus);
+}
+
+mraa_result_t mraa_i2c_frequency(mraa_i2c_context dev, mraa_i2c_mode_t mode)
+{
+    return (dev) ? MRAA_SUCCESS : MRAA_ERROR_INVALID_HANDLE;
+}
+
+mraa_result_t mraa_i2c_address(mraa_i2c_context dev, uint8_t address)
+{
+    if (!dev)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    dev->addr = address;
+
+    return MRAA_SUCCESS;
+}
+
+int mraa_i2c_read(mraa_i2c_context dev, uint8_t *data, int length)
+{
+    return (i2cXfer(dev, NULL, 0, data, length)) ? length : -1;
+}
+
+int mraa_i2c_read_byte(mraa_i2c_context dev)
+{
+    uint8_t data;
+
+    return (i2cXfer(dev, NULL, 0, &data, 1)) ? data : -1;
+}
+
+int mraa_i2c_read_byte_data(mraa_i2c_context dev, const uint8_t command)
+{
+    uint8_t data;
+
+    return (i2cXfer(dev, &command, 1, &data, 1)) ? data : -1;
+}
+
+int mraa_i2c_read_word_data(mraa_i2c_context dev, const uint8_t command)
+{
+    uint8_t data[2];
+
+    if (!i2cXfer(dev, &command, 1, data, 2))
+        return -1;
+
+    return data[0] | (data[1] << 8);
+}
+
+int mraa_i2c_read_bytes_data(mraa_i2c_context dev, uint8_t command,
+                             uint8_t *data, int length)
+{
+    return (i2cXfer(dev, &command, 1, data, length)) ? length : -1;
+}
+
+mraa_result_t mraa_i2c_write(mraa_i2c_context dev, const uint8_t *data,
+                             int length)
+{
+    return (i2cXfer(dev, data, length, NULL, 0))
+        ? MRAA_SUCCESS : MRAA_ERROR_UNSPECIFIED;
+}
+
+mraa_result_t mraa_i2c_write_byte(mraa_i2c_context dev, const uint8_t data)
+{
+    return mraa_i2c_write(dev, &data, 1);
+}
+
+mraa_result_t mraa_i2c_write_byte_data(mraa_i2c_context dev,
+                                       const uint8_t data,
+                                       const uint8_t command)
+{
+    uint8_t buf[2] = { command, data };
+
+    return mraa_i2c_write(dev, buf, 2);
+}
+
+mraa_result_t mraa_i2c_write_word_data(mraa_i2c_context dev,
+                                       const uint16_t data,
+                                       const uint8_t command)
+{
+    uint8_t buf[3] = { command, (uint8_t)(data & 0xff),
+                       (uint8_t)(data >> 8) };
+
+    return mraa_i2c_write(dev, buf, 3);
+}
+
+mraa_result_t mraa_i2c_stop(mraa_i2c_context dev)
+{
+    delete dev;
+
+    return MRAA_SUCCESS;
+}
+
+// SPI
+
+mraa_spi_context mraa_spi_init(int bus)
+{
+    mraa_spi_context ctx = new _spi;
+
+    ctx->bus = bus;
+
+    return ctx;
+}
+
+mraa_spi_context mraa_spi_init_raw(unsigned int bus, unsigned int cs)
+{
+    return mraa_spi_init((int)bus);
+}
+
+mraa_result_t mraa_spi_mode(mraa_spi_context dev, mraa_spi_mode_t mode)
+{
+    return (dev) ? MRAA_SUCCESS : MRAA_ERROR_INVALID_HANDLE;
+}
+
+mraa_result_t mraa_spi_frequency(mraa_spi_context dev, int hz)
+{
+    return (dev) ? MRAA_SUCCESS : MRAA_ERROR_INVALID_HANDLE;
+}
+
+mraa_result_t mraa_spi_lsbmode(mraa_spi_context dev, mraa_boolean_t lsb)
+{
+    return (dev) ? MRAA_SUCCESS : MRAA_ERROR_INVALID_HANDLE;
+}
+
+mraa_result_t mraa_spi_bit_per_word(mraa_spi_context dev, unsigned int bits)
+{
+    return (dev) ? MRAA_SUCCESS : MRAA_ERROR_INVALID_HANDLE;
+}
+
+int mraa_spi_write(mraa_spi_context dev, uint8_t data)
+{
+    uint8_t rx;
+
+    return (spiXfer(dev, &data, &rx, 1)) ? rx : -1;
+}
+
+int mraa_spi_write_word(mraa_spi_context dev, uint16_t data)
+{
+    uint8_t tx[2] = { (uint8_t)(data & 0xff), (uint8_t)(data >> 8) };
+    uint8_t rx[2];
+
+    return (spiXfer(dev, tx, rx, 2)) ? (rx[0] | (rx[1] << 8)) : -1;
+}
+
+uint8_t *mraa_spi_write_buf(mraa_spi_context dev, uint8_t *data, int length)
+{
+    uint8_t *rx = (uint8_t *)malloc(length);
+
+    if (rx && !spiXfer(dev, data, rx, length))
+    {
+        free(rx);
+        return NULL;
+    }
+
+    return rx;
+}
+
+mraa_result_t mraa_spi_transfer_buf(mraa_spi_context dev, uint8_t *data,
+                                    uint8_t *rxbuf, int length)
+{
+    std::vector<uint8_t> rx(length);
+
+    if (!spiXfer(dev, data, &rx[0], length))
+        return MRAA_ERROR_UNSPECIFIED;
+
+    if (rxbuf)
+        memcpy(rxbuf, &rx[0], length);
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_spi_stop(mraa_spi_context dev)
+{
+    delete dev;
+
+    return MRAA_SUCCESS;
+}
+
+// GPIO
+
+mraa_gpio_context mraa_gpio_init(int pin)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    mraa_gpio_context ctx = new _gpio;
+
+    ctx->pin = pin;
+    ctx->edge = MRAA_GPIO_EDGE_NONE;
+    ctx->isr = NULL;
+    ctx->isrArgs = NULL;
+
+    gpioContexts.push_back(ctx);
+
+    return ctx;
+}
+
+mraa_gpio_context mraa_gpio_init_raw(int gpiopin)
+{
+    return mraa_gpio_init(gpiopin);
+}
+
+mraa_result_t mraa_gpio_dir(mraa_gpio_context dev, mraa_gpio_dir_t dir)
+{
+    if (!dev)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    if (dir == MRAA_GPIO_OUT_HIGH)
+        upm::sim::setGpio(dev->pin, 1);
+    else if (dir == MRAA_GPIO_OUT_LOW)
+        upm::sim::setGpio(dev->pin, 0);
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_mode(mraa_gpio_context dev, mraa_gpio_mode_t mode)
+{
+    return (dev) ? MRAA_SUCCESS : MRAA_ERROR_INVALID_HANDLE;
+}
+
+mraa_result_t mraa_gpio_edge_mode(mraa_gpio_context dev,
+                                  mraa_gpio_edge_t mode)
+{
+    if (!dev)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    dev->edge = mode;
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_isr(mraa_gpio_context dev, mraa_gpio_edge_t edge,
+                            void (*fptr)(void *), void *args)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    if (!dev)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    dev->edge = edge;
+    dev->isr = fptr;
+    dev->isrArgs = args;
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_isr_exit(mraa_gpio_context dev)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    if (!dev)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    dev->isr = NULL;
+    dev->isrArgs = NULL;
+
+    return MRAA_SUCCESS;
+}
+
+int mraa_gpio_read(mraa_gpio_context dev)
+{
+    if (!dev)
+        return -1;
+
+    return upm::sim::getGpio(dev->pin);
+}
+
+mraa_result_t mraa_gpio_write(mraa_gpio_context dev, int value)
+{
+    if (!dev)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    upm::sim::setGpio(dev->pin, value);
+
+    return MRAA_SUCCESS;
+}
+
+int mraa_gpio_get_pin(mraa_gpio_context dev)
+{
+    return (dev) ? dev->pin : -1;
+}
+
+mraa_result_t mraa_gpio_close(mraa_gpio_context dev)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    for (size_t i = 0; i < gpioContexts.size(); i++)
+    {
+        if (gpioContexts[i] == dev)
+        {
+            gpioContexts.erase(gpioContexts.begin() + i);
+            break;
+        }
+    }
+
+    delete dev;
+
+    return MRAA_SUCCESS;
+}
+
+// UART one-wire
+
+mraa_uart_ow_context mraa_uart_ow_init(int uart)
+{
+    mraa_uart_ow_context ctx = new _mraa_uart_ow;
+
+    ctx->uart = uart;
+    ctx->searchPos = 0;
+    ctx->selected = NULL;
+
+    return ctx;
+}
+
+mraa_result_t mraa_uart_ow_stop(mraa_uart_ow_context dev)
+{
+    delete dev;
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_uart_ow_reset(mraa_uart_ow_context dev)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    if (!dev)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    dev->selected = NULL;
+    bool present = !owBus(dev).empty();
+
+    owAccount(dev, 0, 0, present);
+
+    return (present) ? MRAA_SUCCESS : MRAA_ERROR_UART_OW_NO_DEVICES;
+}
+
+mraa_result_t mraa_uart_ow_rom_search(mraa_uart_ow_context dev,
+                                      mraa_boolean_t start, uint8_t *id)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    if (!dev || !id)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    std::vector<OneWireDevice *> &bus = owBus(dev);
+
+    if (start)
+        dev->searchPos = 0;
+
+    // reset plus search ROM command, then 64 read/read/write triplets
+    dev->selected = NULL;
+    owAccount(dev, 16, 9, true);
+
+    if (dev->searchPos >= bus.size())
+        return MRAA_ERROR_UART_OW_NO_DEVICES;
+
+    memcpy(id, bus[dev->searchPos++]->romCode(), MRAA_UART_OW_ROMCODE_SIZE);
+
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_uart_ow_command(mraa_uart_ow_context dev,
+                                   uint8_t command, uint8_t *id)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    if (!dev)
+        return MRAA_ERROR_INVALID_HANDLE;
+
+    std::vector<OneWireDevice *> &bus = owBus(dev);
+
+    if (bus.empty())
+    {
+        owAccount(dev, 0, 0, false);
+        return MRAA_ERROR_UART_OW_NO_DEVICES;
+    }
+
+    // reset, then match ROM (0x55) + romcode or skip ROM (0xcc), then
+    // the command itself
+    dev->selected = NULL;
+
+    if (id)
+    {
+        for (size_t i = 0; i < bus.size(); i++)
+            if (!memcmp(bus[i]->romCode(), id, MRAA_UART_OW_ROMCODE_SIZE))
+                dev->selected = bus[i];
+
+        if (!dev->selected)
+        {
+            owAccount(dev, 0, 10, false);
+            return MRAA_ERROR_UART_OW_DATA_ERROR;
+        }
+
+        dev->selected->command(command);
+    }
+    else
+    {
+        for (size_t i = 0; i < bus.size(); i++)
+            bus[i]->command(command);
+    }
+
+    owAccount(dev, 0, (id) ? 10 : 2, true);
+
+    return MRAA_SUCCESS;
+}
+
+int mraa_uart_ow_read_byte(mraa_uart_ow_context dev)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    if (!dev)
+        return -1;
+
+    std::vector<OneWireDevice *> &bus = owBus(dev);
+    uint8_t byte = 0xff;
+
+    // the bus is wired-AND
+    if (dev->selected)
+        byte = dev->selected->readByte();
+    else
+        for (size_t i = 0; i < bus.size(); i++)
+            byte &= bus[i]->readByte();
+
+    owAccount(dev, 1, 0, true);
+
+    return byte;
+}
+
+int mraa_uart_ow_write_byte(mraa_uart_ow_context dev, uint8_t byte)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    if (!dev)
+        return -1;
+
+    std::vector<OneWireDevice *> &bus = owBus(dev);
+
+    if (dev->selected)
+        dev->selected->writeByte(byte);
+    else
+        for (size_t i = 0; i < bus.size(); i++)
+            bus[i]->writeByte(byte);
+
+    owAccount(dev, 0, 1, true);
+
+    return byte;
+}
+
+int mraa_uart_ow_bit(mraa_uart_ow_context dev, uint8_t bit)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+
+    if (!dev)
+        return -1;
+
+    std::vector<OneWireDevice *> &bus = owBus(dev);
+    int rv = bit;
+
+    // writing a 1 is a read slot
+    if (bit)
+    {
+        if (dev->selected)
+            rv = dev->selected->readBit();
+        else
+            for (size_t i = 0; i < bus.size(); i++)
+                rv &= bus[i]->readBit();
+    }
+
+    owAccount(dev, 0, 0, true);
+
+    return rv;
+}
+
+uint8_t mraa_uart_ow_crc8(uint8_t *buffer, uint16_t length)
+{
+    return upm::sim::crc8(buffer, length);
+}
+
+//
+// upm_utilities delays and clocks.  Delays are accounted but never
+// sleep, so time-to-complete in a simulation is CPU time only.  The
+// clock is the monotonic clock advanced by every simulated delay.
+//
+
+static uint64_t virtualNs = 0;
+
+static void simDelay(uint64_t ns)
+{
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+    globalStats.delayNs += ns;
+    virtualNs += ns;
+}
+
+static uint64_t simNow()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    std::lock_guard<std::recursive_mutex> lock(simLock);
+    return ((uint64_t)now.tv_sec * 1000000000) + now.tv_nsec + virtualNs;
+}
+
+void upm_delay(uint32_t time)
+{
+    simDelay((uint64_t)time * 1000000000);
+}
+
+void upm_delay_ms(uint32_t time)
+{
+    simDelay((uint64_t)time * 1000000);
+}
+
+void upm_delay_us(uint32_t time)
+{
+    simDelay((uint64_t)time * 1000);
+}
+
+void upm_delay_ns(uint64_t time)
+{
+    simDelay(time);
+}
+
+void upm_delay_until_ns(upm_clock_t *clock, uint64_t period)
+{
+    uint64_t deadline = ((uint64_t)clock->tv_sec * 1000000000)
+        + clock->tv_nsec + period;
+    uint64_t now = simNow();
+
+    clock->tv_sec = deadline / 1000000000;
+    clock->tv_nsec = deadline % 1000000000;
+
+    if (deadline > now)
+        simDelay(deadline - now);
+}
+
+upm_clock_t upm_clock_deadline_us(uint32_t time)
+{
+    uint64_t deadline = simNow() + (uint64_t)time * 1000;
+    upm_clock_t clock;
+
+    clock.tv_sec = deadline / 1000000000;
+    clock.tv_nsec = deadline % 1000000000;
+
+    return clock;
+}
+
+upm_clock_t upm_clock_init(void)
+{
+    uint64_t now = simNow();
+    upm_clock_t clock;
+
+    clock.tv_sec = now / 1000000000;
+    clock.tv_nsec = now % 1000000000;
+
+    return clock;
+}
+
+uint64_t upm_elapsed_ns(const upm_clock_t *clock)
+{
+    return simNow() - (((uint64_t)clock->tv_sec * 1000000000)
+                       + clock->tv_nsec);
+}
+
+uint64_t upm_elapsed_us(const upm_clock_t *clock)
+{
+    return upm_elapsed_ns(clock) / 1000;
+}
+
+uint64_t upm_elapsed_ms(const upm_clock_t *clock)
+{
+    return upm_elapsed_ns(clock) / 1000000;
+}
+
+}
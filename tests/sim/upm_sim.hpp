@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Simulated bus layer for running UPM drivers without hardware.
+ *
+ * The upm_sim library provides its own implementation of the MRAA C
+ * I2C, SPI, GPIO and UART one-wire entry points (and of the
+ * upm_delay*() and upm_clock*() utilities).  Link driver sources
+ * against upm_sim instead of libmraa/libupmc-utilities and every bus
+ * access lands on a simulated device attached with the functions
+ * below.  Delays are accounted for, but do not sleep; the clock is
+ * advanced by them instead.
+ */
+namespace upm {
+namespace sim {
+
+    /* Bus traffic counters */
+    struct Stats {
+        uint64_t transactions;
+        uint64_t bytesRead;
+        uint64_t bytesWritten;
+        uint64_t errors;
+        uint64_t delayNs;
+
+        Stats() : transactions(0), bytesRead(0), bytesWritten(0),
+                  errors(0), delayNs(0) {}
+
+        uint64_t bytes() const { return bytesRead + bytesWritten; }
+    };
+
+    /*
+     * Base class for a simulated I2C/SPI device.  I2C transactions
+     * are delivered as a write phase and an optional read phase (for
+     * a combined write/repeated-start/read transaction).  SPI
+     * transfers are delivered as full duplex buffers.
+     */
+    class Device {
+    public:
+        virtual ~Device() {}
+
+        /* Host wrote len bytes to the device.  Return false to NAK. */
+        virtual bool write(const uint8_t *data, int len) = 0;
+
+        /* Host reads len bytes from the device.  Return false to NAK. */
+        virtual bool read(uint8_t *data, int len) = 0;
+
+        /* Full duplex SPI transfer.  The default maps a register
+         * access (bit 7 of the first byte set for reads) onto
+         * write()/read(). */
+        virtual bool transfer(const uint8_t *tx, uint8_t *rx, int len);
+
+        Stats stats;
+    };
+
+    /*
+     * A register map device.  Registers auto-increment on multi-byte
+     * accesses.  An optional page register selects between banks of
+     * 256 registers, and hooks can be installed to script behavior
+     * (status bits, self-clearing commands, data generation).
+     */
+    class RegisterDevice : public Device {
+    public:
+        typedef std::function<void (RegisterDevice &dev, uint8_t reg,
+                                    uint8_t val)> write_hook_t;
+        typedef std::function<void (RegisterDevice &dev, uint8_t reg)>
+            read_hook_t;
+
+        RegisterDevice(int pages = 1, int pageReg = -1);
+
+        bool write(const uint8_t *data, int len);
+        bool read(uint8_t *data, int len);
+
+        /* Direct register access, bypassing hooks and counters */
+        uint8_t get(uint8_t reg, int page = -1) const;
+        void set(uint8_t reg, uint8_t val, int page = -1);
+        void set(uint8_t reg, const uint8_t *vals, int len, int page = -1);
+
+        /* Make reg ignore host writes */
+        void setReadOnly(uint8_t reg, bool ro = true);
+
+        /* Only auto-increment the register pointer if the register
+         * address has flag set (0x80 on most ST sensors).  The flag
+         * is not part of the address. */
+        void setAutoIncrementFlag(uint8_t flag) { m_autoIncFlag = flag; }
+
+        /* Called after the host writes a register */
+        void onWrite(write_hook_t hook) { m_writeHook = hook; }
+
+        /* Called before the host reads a register */
+        void onRead(read_hook_t hook) { m_readHook = hook; }
+
+        int page() const { return m_page; }
+
+    private:
+        std::vector<uint8_t> m_regs;
+        std::vector<bool> m_readOnly;
+        int m_pages;
+        int m_pageReg;
+        int m_page;
+        uint8_t m_ptr;
+        uint8_t m_autoIncFlag;
+        bool m_autoInc;
+        write_hook_t m_writeHook;
+        read_hook_t m_readHook;
+    };
+
+    /*
+     * Replays a trace previously captured with startRecording().  Only
+     * the records matching the bus/address given to load() are used.
+     * Reads return the recorded data in order, writes are compared
+     * against the recording and counted in mismatches().
+     */
+    class TraceDevice : public Device {
+    public:
+        TraceDevice();
+
+        /* Load the records for an I2C device.  Returns the number of
+         * records loaded. */
+        int loadI2c(const std::string &path, int bus, uint8_t addr);
+
+        /* Load the records for a SPI device */
+        int loadSpi(const std::string &path, int bus);
+
+        bool write(const uint8_t *data, int len);
+        bool read(uint8_t *data, int len);
+        bool transfer(const uint8_t *tx, uint8_t *rx, int len);
+
+        /* Restart from the first record */
+        void rewind() { m_pos = 0; }
+
+        /* When true (the default), rewind once the trace runs out */
+        void setLoop(bool loop) { m_loop = loop; }
+
+        unsigned int mismatches() const { return m_mismatches; }
+
+    private:
+        struct Record {
+            char op;
+            std::vector<uint8_t> tx;
+            std::vector<uint8_t> rx;
+        };
+
+        int load(const std::string &path, const std::string &key);
+        const Record *next(char op);
+
+        std::vector<Record> m_records;
+        size_t m_pos;
+        bool m_loop;
+        unsigned int m_mismatches;
+    };
+
+    /*
+     * Base class for a simulated one-wire device.  The bus handles
+     * reset, ROM search and ROM matching; the device sees function
+     * commands and the data bytes/bits that follow them.
+     */
+    class OneWireDevice {
+    public:
+        OneWireDevice(const uint8_t romCode[8]);
+        virtual ~OneWireDevice() {}
+
+        virtual void command(uint8_t cmd) = 0;
+        virtual uint8_t readByte() = 0;
+        virtual void writeByte(uint8_t byte) = 0;
+        virtual int readBit() { return 1; }
+
+        const uint8_t *romCode() const { return m_rom; }
+
+        Stats stats;
+
+    private:
+        uint8_t m_rom[8];
+    };
+
+    /* Attach a device to an I2C bus/address, SPI bus or one-wire
+     * UART.  The simulation does not take ownership. */
+    void attachI2c(int bus, uint8_t addr, Device *dev);
+    void attachSpi(int bus, Device *dev);
+    void attachOneWire(int uart, OneWireDevice *dev);
+
+    /* Detach all devices and forget GPIO state */
+    void reset();
+
+    /* Drive a GPIO input, running any installed ISR on a matching edge */
+    void setGpio(int pin, int value);
+
+    /* Current level of a GPIO */
+    int getGpio(int pin);
+
+    /* Global counters across all buses */
+    const Stats &stats();
+    void resetStats();
+
+    /* Write every bus transaction to path (see TraceDevice) */
+    bool startRecording(const std::string &path);
+    void stopRecording();
+
+    /* Dallas/Maxim CRC8 as used on the one-wire bus */
+    uint8_t crc8(const uint8_t *data, int len);
+}
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "upm_event_queue.hpp"
+
+using namespace upm;
+
+static MotionEvent event(MOTION_EVENT_T type, uint8_t source)
+{
+    MotionEvent e;
+    e.type = type;
+    e.source = source;
+    e.timestamp = MotionEvent::now();
+    return e;
+}
+
+/* Events come out in order, and an empty queue returns at once */
+TEST(event_queue, order)
+{
+    EventQueue<MotionEvent> q;
+    MotionEvent e;
+
+    q.push(event(MOTION_EVENT_TAP, 1));
+    q.push(event(MOTION_EVENT_FREEFALL, 2));
+    ASSERT_EQ(2u, q.size());
+
+    ASSERT_TRUE(q.pop(e));
+    ASSERT_EQ(MOTION_EVENT_TAP, e.type);
+    ASSERT_EQ(1, e.source);
+    ASSERT_TRUE(q.pop(e));
+    ASSERT_EQ(MOTION_EVENT_FREEFALL, e.type);
+    ASSERT_FALSE(q.pop(e));
+}
+
+/* A full queue drops the oldest events and counts them */
+TEST(event_queue, overflow)
+{
+    EventQueue<MotionEvent> q(2);
+    MotionEvent e;
+
+    /* there would be nothing to drop */
+    ASSERT_THROW(EventQueue<MotionEvent>(0), std::invalid_argument);
+
+    for (int i = 0; i < 5; i++)
+        q.push(event(MOTION_EVENT_MOTION, i));
+
+    ASSERT_EQ(2u, q.size());
+    ASSERT_EQ(3u, q.dropped());
+    ASSERT_TRUE(q.pop(e));
+    ASSERT_EQ(3, e.source);
+}
+
+/* A callback receives the events instead of the queue */
+TEST(event_queue, callback)
+{
+    EventQueue<MotionEvent> q;
+    std::vector<uint8_t> seen;
+    MotionEvent e;
+
+    q.setCallback([&seen](const MotionEvent &ev) { seen.push_back(ev.source); });
+    q.push(event(MOTION_EVENT_SHAKE, 7));
+    ASSERT_EQ(1u, seen.size());
+    ASSERT_EQ(7, seen[0]);
+    ASSERT_EQ(0u, q.size());
+
+    q.setCallback(EventQueue<MotionEvent>::Callback());
+    q.push(event(MOTION_EVENT_SHAKE, 8));
+    ASSERT_TRUE(q.pop(e));
+    ASSERT_EQ(8, e.source);
+}
+
+/* pop() waits for an event from another thread, or times out */
+TEST(event_queue, wait)
+{
+    EventQueue<MotionEvent> q;
+    MotionEvent e;
+
+    ASSERT_FALSE(q.pop(e, 10));
+
+    std::thread t([&q]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        q.push(event(MOTION_EVENT_ORIENTATION, 3));
+    });
+    ASSERT_TRUE(q.pop(e, -1));
+    ASSERT_EQ(MOTION_EVENT_ORIENTATION, e.type);
+    t.join();
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "gtest/gtest.h"
+#include "upm_fifo_decode.h"
+
+UPM_FIFO_DECODER_XYZ16(decode_8b, 8)
+UPM_FIFO_DECODER_XYZ16(decode_12b, 12)
+UPM_FIFO_DECODER_XYZ16(decode_16b, 16)
+
+/* Two left justified frames, with junk in the unused low bits */
+static const uint8_t frames[12] = {
+    0x1f, 0x40,  0x0f, 0xc0,  0x00, 0x80,
+    0xf5, 0x7f,  0xff, 0xff,  0x10, 0x00
+};
+
+/* Decoders shift out the unused bits and keep the sign */
+TEST(fifo_decode, resolutions)
+{
+    float out[6];
+
+    decode_12b(frames, 2, 1.0, out);
+    EXPECT_EQ(1025.0, out[0]);
+    EXPECT_EQ(-1024.0, out[1]);
+    EXPECT_EQ(-2048.0, out[2]);
+    EXPECT_EQ(2047.0, out[3]);
+    EXPECT_EQ(-1.0, out[4]);
+    EXPECT_EQ(1.0, out[5]);
+
+    decode_8b(frames, 2, 0.5, out);
+    EXPECT_EQ(32.0, out[0]);
+    EXPECT_EQ(-32.0, out[1]);
+    EXPECT_EQ(-64.0, out[2]);
+
+    decode_16b(frames, 1, 2.0, out);
+    EXPECT_EQ(2.0 * 0x401f, out[0]);
+    EXPECT_EQ(2.0 * (0xc00f - 0x10000), out[1]);
+}
+
+/* Only the requested frames are written */
+TEST(fifo_decode, frame_count)
+{
+    float out[6] = { 7, 7, 7, 7, 7, 7 };
+
+    decode_12b(frames, 1, 1.0, out);
+    EXPECT_EQ(1025.0, out[0]);
+    EXPECT_EQ(7.0, out[3]);
+}
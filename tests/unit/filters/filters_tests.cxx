@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "upm_filters.hpp"
+
+using namespace upm;
+
+/* Running median against sorting the window, including window changes */
+TEST(filters, moving_median)
+{
+    MovingMedian<float, 2, 16> f(7);
+    std::vector<float> hist;
+
+    srand(1);
+    for (int i = 0; i < 500; i++)
+    {
+        if (i == 250)
+        {
+            f.setWindow(16);
+            hist.clear();
+        }
+
+        float in[2] = { (float)(rand() % 100), -1 };
+        float out[2];
+        f.filter(in, out);
+
+        hist.push_back(in[0]);
+        if (hist.size() > f.getWindow())
+            hist.erase(hist.begin());
+        std::vector<float> s(hist);
+        std::sort(s.begin(), s.end());
+
+        ASSERT_EQ(out[0], s[(s.size() - 1) / 2]) << "sample " << i;
+        ASSERT_EQ(out[1], -1);
+    }
+
+    EXPECT_THROW(f.setWindow(17), std::invalid_argument);
+}
+
+/* Moving average fills up, then slides */
+TEST(filters, moving_average)
+{
+    MovingAverage<float, 1, 4> f(3);
+    float in[] = { 3, 6, 9, 12 }, out;
+
+    f.filter(&in[0], &out);
+    EXPECT_FLOAT_EQ(out, 3);
+    f.filter(&in[1], &out);
+    EXPECT_FLOAT_EQ(out, 4.5);
+    f.filter(&in[2], &out);
+    EXPECT_FLOAT_EQ(out, 6);
+    f.filter(&in[3], &out);
+    EXPECT_FLOAT_EQ(out, 9);
+}
+
+/* Low pass keeps DC and removes the Nyquist frequency */
+TEST(filters, biquad)
+{
+    Biquad<double, 2> f = Biquad<double, 2>::lowPass(100, 5);
+    double out[2] = { 0, 0 };
+
+    for (int i = 0; i < 400; i++)
+    {
+        double in[2] = { 1, (i & 1) ? 1.0 : -1.0 };
+        f.filter(in, out);
+    }
+    EXPECT_NEAR(out[0], 1, 1e-6);
+    EXPECT_NEAR(out[1], 0, 1e-2);
+}
+
+/* One euro smooths noise at rest, alpha-beta follows a ramp */
+TEST(filters, one_euro_alpha_beta)
+{
+    OneEuro<float, 1> e(100, 1, 0);
+    float in, out = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        in = (i & 1) ? 1.0f : -1.0f;
+        e.filter(&in, &out);
+    }
+    EXPECT_LT(std::fabs(out), 0.1);
+
+    AlphaBeta<float, 1> ab(100, 0.5, 0.1);
+    for (int i = 0; i < 500; i++)
+    {
+        in = i * 0.02f;
+        ab.filter(&in, &out);
+    }
+    EXPECT_NEAR(out, in, 0.01);
+    EXPECT_NEAR(ab.getRate(0), 2.0, 0.01);
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+#include "upm_init_program.hpp"
+
+using namespace upm;
+
+namespace
+{
+    enum { CMD_SLEEP, CMD_SCALE };
+
+    const InitCommand cmds[] = {
+        { "writeByte", "ii", INIT_WRITE8, 0 },
+        { "writeWord", "ii", INIT_WRITE16LE, 0 },
+        { "sleep", "", INIT_CALL, CMD_SLEEP },
+        { "scale", "f", INIT_CALL, CMD_SCALE },
+    };
+}
+
+/* Adjacent register writes are merged up to the burst size */
+TEST(init_program, merge_bursts)
+{
+    InitProgram prog("writeByte:0x10:1,writeByte:0x11:2,writeWord:0x12:0x0403,"
+                     "writeByte:0x14:5,writeByte:0x20:6", cmds, 4, 4);
+
+    const std::vector<InitOp> &ops = prog.ops();
+    ASSERT_EQ(3u, ops.size());
+    EXPECT_EQ(0x10, ops[0].reg);
+    EXPECT_EQ((std::vector<uint8_t>{ 1, 2, 3, 4 }), ops[0].data);
+    /* full burst, then a gap */
+    EXPECT_EQ(0x14, ops[1].reg);
+    EXPECT_EQ(0x20, ops[2].reg);
+    EXPECT_EQ(1u, ops[2].data.size());
+}
+
+/* Commands keep their order and converted arguments */
+TEST(init_program, commands)
+{
+    InitProgram prog("writeByte:1:2,sleep:,scale:2.5,writeByte:2:3", cmds, 4,
+                     32);
+    int calls = 0;
+    size_t writes = 0;
+
+    prog.run([&](uint8_t, const uint8_t *, size_t) { writes++; },
+             [&](const InitOp &op) {
+                 calls++;
+                 if (op.id == CMD_SCALE) {
+                     EXPECT_FLOAT_EQ(2.5, op.floatArg(0));
+                 }
+             });
+
+    EXPECT_EQ(2, calls);
+    /* the call in between keeps the writes apart */
+    EXPECT_EQ(2u, writes);
+}
+
+/* Bad tokens throw before anything runs */
+TEST(init_program, errors)
+{
+    EXPECT_THROW(InitProgram("bogus:1", cmds, 4), std::invalid_argument);
+    EXPECT_THROW(InitProgram("writeByte:1", cmds, 4), std::invalid_argument);
+    EXPECT_THROW(InitProgram("writeByte:1:0x100", cmds, 4),
+                 std::invalid_argument);
+    EXPECT_THROW(InitProgram("scale:abc", cmds, 4), std::invalid_argument);
+}
+
+/* The same string and table give the same program */
+TEST(init_program, cache)
+{
+    InitProgram::Ptr a = InitProgram::compile("writeByte:1:2", cmds, 32);
+    InitProgram::Ptr b = InitProgram::compile("writeByte:1:2", cmds, 32);
+    InitProgram::Ptr c = InitProgram::compile("writeByte:1:3", cmds, 32);
+
+    EXPECT_EQ(a.get(), b.get());
+    EXPECT_NE(a.get(), c.get());
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2018 Intel Corporation.
+ *
+ * This program and the accompanying materials are made available under the
+ * terms of the The MIT License which is available at
+ * https://opensource.org/licenses/MIT.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "gtest/gtest.h"
+#include "upm_regmap.hpp"
+
+using namespace upm;
+
+namespace
+{
+    /* Register file counting bus transactions */
+    class FakeBus
+    {
+        public:
+            FakeBus() : reads(0), writes(0) { memset(regs, 0, sizeof(regs)); }
+
+            void readRegs(uint8_t reg, uint8_t *buf, int len)
+            {
+                reads++;
+                memcpy(buf, regs + reg, len);
+            }
+
+            void writeRegs(uint8_t reg, const uint8_t *buf, int len)
+            {
+                writes++;
+                memcpy(regs + reg, buf, len);
+            }
+
+            uint8_t regs[256];
+            int reads;
+            int writes;
+    };
+
+    typedef regmap::Field<0x20, 4, 3> Odr;
+    typedef regmap::Bit<0x20, 0> Enable;
+    typedef regmap::Reg<0x21, regmap::WO> Cmd;
+    typedef regmap::Field<0x28, 0, 16, regmap::RO,
+                          regmap::LITTLE, true> OutX;
+    typedef regmap::Field<0x2a, 0, 16, regmap::RO,
+                          regmap::LITTLE, true> OutY;
+    typedef regmap::Field<0x30, 4, 12, regmap::RO, regmap::BIG> Temp;
+    typedef regmap::Field<0x32, 0, 12, regmap::RO,
+                          regmap::LITTLE, true> Signed12;
+}
+
+/* Field geometry is computed at compile time */
+TEST(regmap, field_geometry)
+{
+    EXPECT_EQ(0x70u, Odr::mask);
+    EXPECT_EQ(1u, Odr::bytes);
+    EXPECT_FALSE(Odr::whole);
+    EXPECT_TRUE(Cmd::whole);
+    EXPECT_EQ(2u, OutX::bytes);
+    EXPECT_EQ(0x29u, OutX::last);
+    EXPECT_EQ(4u, (regmap::Block<OutX, OutY>::size));
+}
+
+/* Little endian signed fields are sign extended */
+TEST(regmap, decode_signed)
+{
+    FakeBus bus;
+    bus.regs[0x28] = 0x38;
+    bus.regs[0x29] = 0xff;
+    bus.regs[0x32] = 0xf0;
+    bus.regs[0x33] = 0x0f;
+
+    EXPECT_EQ(-200, regmap::read<OutX>(bus));
+    EXPECT_EQ(-16, regmap::read<Signed12>(bus));
+}
+
+/* Big endian fields are assembled high byte first */
+TEST(regmap, decode_big_endian)
+{
+    FakeBus bus;
+    bus.regs[0x30] = 0xab;
+    bus.regs[0x31] = 0xc0;
+
+    EXPECT_EQ(0xabcu, regmap::read<Temp>(bus));
+}
+
+/* Partial fields are read, modified and written back */
+TEST(regmap, write_read_modify_write)
+{
+    FakeBus bus;
+    bus.regs[0x20] = 0x8f;
+
+    regmap::write<Odr>(bus, 5);
+    EXPECT_EQ(0xdf, bus.regs[0x20]);
+    EXPECT_EQ(1, bus.reads);
+    EXPECT_EQ(1, bus.writes);
+
+    regmap::write<Enable>(bus, 0);
+    EXPECT_EQ(0xde, bus.regs[0x20]);
+
+    // values wider than the field are truncated
+    regmap::write<Odr>(bus, 0xff);
+    EXPECT_EQ(0xfe, bus.regs[0x20]);
+}
+
+/* Whole registers are written without reading them first */
+TEST(regmap, write_whole)
+{
+    FakeBus bus;
+
+    regmap::write<Cmd>(bus, 0xb6);
+    EXPECT_EQ(0xb6, bus.regs[0x21]);
+    EXPECT_EQ(0, bus.reads);
+    EXPECT_EQ(1, bus.writes);
+}
+
+/* A block transfers all of its registers in one transaction */
+TEST(regmap, block_burst)
+{
+    FakeBus bus;
+    bus.regs[0x28] = 0x64;
+    bus.regs[0x29] = 0x00;
+    bus.regs[0x2a] = 0xe8;
+    bus.regs[0x2b] = 0x03;
+
+    regmap::Block<OutX, OutY> out;
+    out.read(bus);
+
+    EXPECT_EQ(1, bus.reads);
+    EXPECT_EQ(100, out.get<OutX>());
+    EXPECT_EQ(1000, out.get<OutY>());
+
+    regmap::Block<Odr, Enable, Cmd> ctrl;
+    ctrl.set<Odr>(3);
+    ctrl.set<Enable>(1);
+    ctrl.set<Cmd>(0x11);
+    ctrl.write(bus);
+
+    EXPECT_EQ(1, bus.writes);
+    EXPECT_EQ(0x31, bus.regs[0x20]);
+    EXPECT_EQ(0x11, bus.regs[0x21]);
+}
@@ -9,12 +9,28 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <fstream>
+#include <mutex>
+#include <string>
 #include <thread>
 
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 #include "gtest/gtest.h"
 #include "upm_utilities.h"
 #include "upm_utilities.hpp"
+#include "upm_bus_stats.h"
+#include "upm_bus_stats.hpp"
+#include "upm_reg_cache.h"
+#include "upm_iio_stream.h"
+#include "upm_aio_sampler.h"
+#include "upm_bringup.hpp"
+#include "upm_cal_store.h"
 
 /* Average over AVG_CNT iterations */
 #define AVG_CNT 5
@@ -153,3 +169,539 @@ TEST_F(utilities_unit, test_upm_ugm3_to_aqi)
 {
     EXPECT_EQ(upm_ugm3_to_aqi(10), 41);
 }
+
+/* Test the bus latency histogram percentiles */
+TEST_F(utilities_unit, test_upm_bus_hist_percentile)
+{
+    upm_bus_hist_t hist;
+    upm_bus_hist_init(&hist);
+
+    /* Empty histogram */
+    EXPECT_EQ(upm_bus_hist_percentile(&hist, 50.0), 0);
+    EXPECT_EQ(upm_bus_hist_min(&hist), 0);
+
+    /* 1us .. 100us, in 1us steps */
+    for (int i = 1; i <= 100; i++)
+        upm_bus_hist_record(&hist, i * 1000);
+
+    EXPECT_EQ(hist.count, 100);
+    EXPECT_EQ(upm_bus_hist_min(&hist), 1000);
+    EXPECT_EQ(hist.max_ns, 100000);
+    EXPECT_EQ(upm_bus_hist_mean(&hist), 50500);
+
+    /* Log-linear buckets are accurate to 1/8 */
+    EXPECT_NEAR(upm_bus_hist_percentile(&hist, 50.0), 50000, 50000 / 8);
+    EXPECT_NEAR(upm_bus_hist_percentile(&hist, 90.0), 90000, 90000 / 8);
+    EXPECT_EQ(upm_bus_hist_percentile(&hist, 100.0), 100000);
+}
+
+/* Test bus statistics registration and the C++ snapshot */
+TEST_F(utilities_unit, test_upm_bus_stats)
+{
+    upm_bus_stats_t *stats = upm_bus_stats_register("test", 1, 0x40);
+    ASSERT_TRUE(stats != NULL);
+
+    upm_bus_stats_record(stats, 2000, 6, 1, 1);
+    upm_bus_stats_record(stats, 4000, 0, 2, 0);
+
+    std::vector<upm::BusStats> list = upm::getBusStats();
+    ASSERT_EQ(list.size(), 1);
+    EXPECT_EQ(list[0].name, "test");
+    EXPECT_EQ(list[0].bus, 1);
+    EXPECT_EQ(list[0].addr, 0x40);
+    EXPECT_EQ(list[0].transactions, 2);
+    EXPECT_EQ(list[0].bytesRead, 6);
+    EXPECT_EQ(list[0].bytesWritten, 3);
+    EXPECT_EQ(list[0].errors, 1);
+    EXPECT_EQ(list[0].latencyMin, 2000);
+    EXPECT_EQ(list[0].latencyMax, 4000);
+
+    upm::resetBusStats();
+    EXPECT_EQ(upm::getBusStats()[0].transactions, 0);
+
+    /* a genuine 0ns sample is the minimum */
+    upm_bus_stats_record(stats, 0, 1, 1, 1);
+    EXPECT_EQ(upm::getBusStats()[0].latencyMin, 0);
+    upm_bus_stats_record(stats, 3000, 1, 1, 1);
+    EXPECT_EQ(upm::getBusStats()[0].latencyMin, 0);
+
+    upm_bus_stats_unregister(stats);
+    EXPECT_TRUE(upm::getBusStats().empty());
+}
+
+/* Fake 8-bit register map for the shadow register cache tests */
+struct fake_regs
+{
+    uint8_t regs[256];
+    int reads;
+    int writes;
+};
+
+static upm_result_t fake_read(void *ctx, uint8_t reg, uint8_t *val)
+{
+    fake_regs *f = (fake_regs *)ctx;
+    f->reads++;
+    *val = f->regs[reg];
+    return UPM_SUCCESS;
+}
+
+static upm_result_t fake_write(void *ctx, uint8_t reg, uint8_t val)
+{
+    fake_regs *f = (fake_regs *)ctx;
+    f->writes++;
+    f->regs[reg] = val;
+    return UPM_SUCCESS;
+}
+
+/* Test read-modify-write through the shadow register cache */
+TEST_F(utilities_unit, test_upm_reg_cache_update_bits)
+{
+    fake_regs f = {};
+    upm_reg_cache_t cache;
+
+    f.regs[0x10] = 0xf0;
+    f.regs[0x20] = 0xf0;
+
+    upm_reg_cache_init(&cache);
+    upm_reg_cache_set_nonvolatile(&cache, 0x10, 0x1f);
+
+    /* First access reads the register, later ones do not */
+    EXPECT_EQ(upm_reg_cache_update_bits(&cache, 0x10, 0x0f, 0x05,
+                                        fake_read, fake_write, &f),
+              UPM_SUCCESS);
+    EXPECT_EQ(upm_reg_cache_update_bits(&cache, 0x10, 0xf0, 0x30,
+                                        fake_read, fake_write, &f),
+              UPM_SUCCESS);
+    EXPECT_EQ(f.regs[0x10], 0x35);
+    EXPECT_EQ(f.reads, 1);
+    EXPECT_EQ(f.writes, 2);
+
+    /* A write that changes nothing is skipped */
+    upm_reg_cache_update_bits(&cache, 0x10, 0x0f, 0x05,
+                              fake_read, fake_write, &f);
+    EXPECT_EQ(f.writes, 2);
+
+    /* Volatile registers are always read and written */
+    upm_reg_cache_update_bits(&cache, 0x20, 0x0f, 0x00,
+                              fake_read, fake_write, &f);
+    EXPECT_EQ(f.reads, 2);
+    EXPECT_EQ(f.writes, 3);
+
+    /* Invalidation forces a new read */
+    upm_reg_cache_invalidate_all(&cache);
+    uint8_t val;
+    EXPECT_FALSE(upm_reg_cache_get(&cache, 0x10, &val));
+    upm_reg_cache_update_bits(&cache, 0x10, 0x0f, 0x05,
+                              fake_read, fake_write, &f);
+    EXPECT_EQ(f.reads, 3);
+    EXPECT_TRUE(upm_reg_cache_get(&cache, 0x10, &val));
+    EXPECT_EQ(val, 0x35);
+}
+
+/* Fake IIO device: a sysfs directory and a file standing in for the
+ * character device */
+class fake_iio
+{
+    public:
+        fake_iio()
+        {
+            char tmpl[] = "/tmp/upm_iio_XXXXXX";
+            dir = mkdtemp(tmpl);
+            mkdir((dir + "/scan_elements").c_str(), 0755);
+            mkdir((dir + "/buffer").c_str(), 0755);
+            devnode = dir + "/dev";
+            write("dev", "");
+        }
+
+        ~fake_iio()
+        {
+            std::string cmd = "rm -rf " + dir;
+            EXPECT_EQ(system(cmd.c_str()), 0);
+        }
+
+        void write(const std::string &attr, const std::string &value)
+        {
+            std::ofstream(dir + "/" + attr) << value;
+        }
+
+        std::string read(const std::string &attr)
+        {
+            std::string value;
+            std::ifstream(dir + "/" + attr) >> value;
+            return value;
+        }
+
+        void element(const std::string &name, int index,
+                     const std::string &type, bool enabled = true)
+        {
+            write("scan_elements/in_" + name + "_en", enabled ? "1\n" : "0\n");
+            write("scan_elements/in_" + name + "_index",
+                  std::to_string(index) + "\n");
+            write("scan_elements/in_" + name + "_type", type + "\n");
+        }
+
+        void scans(const uint8_t *data, size_t len)
+        {
+            std::ofstream(devnode, std::ios::app | std::ios::binary)
+                .write((const char *)data, len);
+        }
+
+        std::string dir;
+        std::string devnode;
+};
+
+/* Layout, scale, mount matrix and timestamps of a 3 axis device */
+TEST_F(utilities_unit, test_upm_iio_stream_read)
+{
+    fake_iio iio;
+    iio.element("accel_x", 0, "le:s16/16>>0");
+    iio.element("accel_y", 1, "le:s16/16>>0");
+    iio.element("accel_z", 2, "le:s16/16>>0");
+    iio.element("timestamp", 3, "le:s64/64>>0");
+    iio.element("accel_w", 4, "le:s16/16>>0", false);
+    iio.write("in_accel_scale", "0.5\n");
+    iio.write("in_mount_matrix", "0, 1, 0; 1, 0, 0; 0, 0, -1\n");
+
+    // x, y, z, padding to 8 bytes, 64 bit timestamp
+    const uint8_t data[] = {
+        0x02, 0x00, 0xfc, 0xff, 0x10, 0x00, 0, 0,
+        0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x04, 0x00, 0x06, 0x00, 0xf8, 0xff, 0, 0,
+        0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    };
+    iio.scans(data, sizeof(data));
+
+    upm_iio_stream_context dev =
+        upm_iio_stream_init_path(iio.dir.c_str(), iio.devnode.c_str());
+    ASSERT_TRUE(dev != NULL);
+
+    EXPECT_EQ(upm_iio_stream_enable(dev, 64), UPM_SUCCESS);
+    EXPECT_EQ(iio.read("buffer/length"), "64");
+    EXPECT_EQ(iio.read("buffer/enable"), "1");
+
+    ASSERT_EQ(upm_iio_stream_open(dev), UPM_SUCCESS);
+    ASSERT_EQ(upm_iio_stream_num_channels(dev), 4);
+    EXPECT_EQ(upm_iio_stream_find_channel(dev, "accel_z"), 2);
+    EXPECT_EQ(upm_iio_stream_find_channel(dev, "accel_w"), -1);
+    EXPECT_EQ(dev->scan_size, 16u);
+
+    float x[8], y[8], z[8];
+    float *out[] = { x, y, z, NULL };
+    int64_t ts[8];
+
+    ASSERT_EQ(upm_iio_stream_read(dev, out, ts, 8, 0), 2);
+
+    // the mount matrix swaps x and y and inverts z
+    EXPECT_FLOAT_EQ(x[0], -2.0);
+    EXPECT_FLOAT_EQ(y[0], 1.0);
+    EXPECT_FLOAT_EQ(z[0], -8.0);
+    EXPECT_FLOAT_EQ(x[1], 3.0);
+    EXPECT_FLOAT_EQ(y[1], 2.0);
+    EXPECT_FLOAT_EQ(z[1], 4.0);
+    EXPECT_EQ(ts[0], 1);
+    EXPECT_EQ(ts[1], 2);
+
+    // nothing more available
+    EXPECT_EQ(upm_iio_stream_read(dev, out, ts, 8, 0), 0);
+
+    EXPECT_EQ(upm_iio_stream_disable(dev), UPM_SUCCESS);
+    EXPECT_EQ(iio.read("buffer/enable"), "0");
+
+    upm_iio_stream_close(dev);
+}
+
+/* Shifted, big endian and partial scans */
+TEST_F(utilities_unit, test_upm_iio_stream_generic)
+{
+    fake_iio iio;
+    iio.element("magn_x", 0, "le:s12/16>>4");
+    iio.element("temp", 1, "be:u10/16>>0");
+    iio.write("in_temp_offset", "-512\n");
+    iio.write("in_temp_scale", "0.25\n");
+
+    // x = -1, temp = 1023 and x = 2047, temp = 0, then half a scan
+    const uint8_t data[] = {
+        0xf0, 0xff, 0x03, 0xff,
+        0xf0, 0x7f, 0x00, 0x00,
+        0x10, 0x00,
+    };
+    iio.scans(data, sizeof(data));
+
+    upm_iio_stream_context dev =
+        upm_iio_stream_init_path(iio.dir.c_str(), iio.devnode.c_str());
+    ASSERT_TRUE(dev != NULL);
+
+    float x[4], t[4];
+    float *out[] = { x, t };
+
+    ASSERT_EQ(upm_iio_stream_read(dev, out, NULL, 4, 0), 2);
+    EXPECT_FLOAT_EQ(x[0], -1.0);
+    EXPECT_FLOAT_EQ(t[0], (1023 - 512) * 0.25);
+    EXPECT_FLOAT_EQ(x[1], 2047.0);
+    EXPECT_FLOAT_EQ(t[1], -512 * 0.25);
+
+    // the rest of the incomplete scan arrives
+    const uint8_t rest[] = { 0x02, 0x00 };
+    iio.scans(rest, sizeof(rest));
+
+    ASSERT_EQ(upm_iio_stream_read(dev, out, NULL, 4, 0), 1);
+    EXPECT_FLOAT_EQ(x[0], 1.0);
+    EXPECT_FLOAT_EQ(t[0], (512 - 512) * 0.25);
+
+    upm_iio_stream_close(dev);
+}
+
+/* Fake analog source: a sine wave advanced one step per read */
+struct fake_aio {
+    int reads;
+    double freq;
+    double rate;
+};
+
+static upm_result_t fake_aio_read(void *ctx, float *value)
+{
+    fake_aio *f = (fake_aio *)ctx;
+    *value = 512 + 100 * sin(2 * M_PI * f->freq * f->reads++ / f->rate);
+    return UPM_SUCCESS;
+}
+
+/* FFT of a pure tone */
+TEST_F(utilities_unit, test_upm_fft)
+{
+    float re[64], im[64];
+    for (int i = 0; i < 64; i++)
+    {
+        re[i] = cos(2 * M_PI * 5 * i / 64);
+        im[i] = 0;
+    }
+
+    ASSERT_EQ(upm_fft(re, im, 64), UPM_SUCCESS);
+    EXPECT_NEAR(re[5], 32.0, 1e-3);
+    EXPECT_NEAR(re[59], 32.0, 1e-3);
+    EXPECT_NEAR(re[4], 0.0, 1e-3);
+    EXPECT_NEAR(im[5], 0.0, 1e-3);
+
+    EXPECT_EQ(upm_fft(re, im, 48), UPM_ERROR_INVALID_SIZE);
+}
+
+/* Samples taken on the deadline grid, statistics and spectrum */
+TEST_F(utilities_unit, test_upm_aio_sampler_capture)
+{
+    fake_aio f = { 0, 62.5, 2000.0 };
+    upm_aio_sampler_context dev =
+        upm_aio_sampler_init(fake_aio_read, &f, 2000.0, 256);
+    ASSERT_TRUE(dev != NULL);
+
+    /* a capture can't be stopped, so it can't be open ended */
+    EXPECT_EQ(upm_aio_sampler_capture(dev, NULL, 0), UPM_ERROR_INVALID_PARAMETER);
+
+    /* 192 samples at 2 kHz take 95.5 ms, however long the reads take */
+    float out[192];
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(upm_aio_sampler_capture(dev, out, 192), UPM_SUCCESS);
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    EXPECT_GE(us, 95500);
+    EXPECT_LT(us, 125000);
+    EXPECT_EQ(f.reads, 192);
+    EXPECT_FLOAT_EQ(out[8], 612.0);
+
+    /* 192 samples are 6 whole periods */
+    upm_aio_stats_t stats;
+    upm_aio_sampler_get_stats(dev, &stats);
+    EXPECT_EQ(stats.count, 192u);
+    EXPECT_NEAR(stats.mean, 512.0, 1.0);
+    EXPECT_NEAR(stats.ac_rms, 100 / sqrt(2.0), 0.1);
+    EXPECT_NEAR(stats.max, 612.0, 0.01);
+    EXPECT_NEAR(stats.min, 412.0, 0.01);
+    EXPECT_NEAR(stats.peak, 100.0, 1.0);
+
+    /* bins of 128 samples at 2 kHz are 15.625 Hz apart, the tone is bin 4 */
+    float mag[65];
+    EXPECT_EQ(upm_aio_sampler_spectrum(dev, mag, 512), UPM_ERROR_INVALID_SIZE);
+    ASSERT_EQ(upm_aio_sampler_spectrum(dev, mag, 128), UPM_SUCCESS);
+    EXPECT_NEAR(mag[4], 100.0, 1.0);
+    EXPECT_NEAR(upm_spectrum_peak(mag, 128, 2000.0), 62.5, 0.5);
+
+    upm_aio_sampler_reset_stats(dev);
+    upm_aio_sampler_get_stats(dev, &stats);
+    EXPECT_EQ(stats.count, 0u);
+
+    upm_aio_sampler_close(dev);
+}
+
+/* Background acquisition */
+TEST_F(utilities_unit, test_upm_aio_sampler_background)
+{
+    fake_aio f = { 0, 50.0, 1000.0 };
+    upm_aio_sampler_context dev =
+        upm_aio_sampler_init(fake_aio_read, &f, 1000.0, 64);
+    ASSERT_TRUE(dev != NULL);
+
+    ASSERT_EQ(upm_aio_sampler_start(dev), UPM_SUCCESS);
+    EXPECT_EQ(upm_aio_sampler_capture(dev, NULL, 1), UPM_ERROR_NOT_SUPPORTED);
+    EXPECT_EQ(upm_aio_sampler_set_rate(dev, 500.0), UPM_ERROR_NOT_SUPPORTED);
+
+    float buf[64];
+    int total = 0;
+    while (total < 100)
+    {
+        int n = upm_aio_sampler_read(dev, buf, 64, 1000);
+        ASSERT_GT(n, 0);
+        EXPECT_FLOAT_EQ(buf[0], 512 + 100 * sin(2 * M_PI * 50 * total / 1000.0));
+        total += n;
+    }
+
+    upm_aio_sampler_stop(dev);
+    EXPECT_EQ(upm_aio_sampler_read(dev, buf, 64, -1), f.reads - total);
+
+    upm_aio_stats_t stats;
+    upm_aio_sampler_get_stats(dev, &stats);
+    EXPECT_EQ(stats.count, (uint64_t)f.reads);
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_GT(stats.envelope, 50.0);
+
+    upm_aio_sampler_close(dev);
+}
+
+/* Test waiting for a deadline set in advance */
+TEST_F(utilities_unit, test_upm_clock_deadline_us)
+{
+    upm_clock_t clock = upm_clock_init();
+    upm_clock_t deadline = upm_clock_deadline_us(50000);
+
+    /* work done before waiting counts towards the deadline */
+    upm_delay_ms(20);
+    upm_delay_until_ns(&deadline, 0);
+    EXPECT_NEAR(upm_elapsed_ms(&clock), 50, time_range.count());
+
+    /* a passed deadline does not wait */
+    clock = upm_clock_init();
+    upm_delay_until_ns(&deadline, 0);
+    EXPECT_EQ(upm_elapsed_ms(&clock), 0);
+}
+
+/* Test device bring-up ordering and concurrency */
+TEST_F(utilities_unit, test_upm_bringup)
+{
+    std::mutex lock;
+    std::vector<std::string> order;
+    auto dev = [&](const std::string &name, int ms) {
+        return [&, name, ms]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+            std::lock_guard<std::mutex> guard(lock);
+            order.push_back(name);
+        };
+    };
+
+    upm::BringUp b;
+    b.add("a0", "i2c:0", dev("a0", 50));
+    b.add("a1", "i2c:0", dev("a1", 10));
+    b.add("b0", "i2c:1", dev("b0", 50));
+    b.add("c0", "spi:0", dev("c0", 10), {"a1"});
+    b.add("bad", "", []() { throw std::runtime_error("no device"); });
+    b.add("d0", "", dev("d0", 10), {"bad"});
+    EXPECT_THROW(b.add("a0", "", dev("a0", 0)), std::invalid_argument);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<upm::BringUpResult> r = b.run();
+    auto elapsed = to_ms(std::chrono::steady_clock::now() - start);
+
+    ASSERT_EQ(r.size(), 6u);
+    /* i2c:0 then spi:0 is the longest chain, 70ms instead of 130ms */
+    EXPECT_LT(elapsed.count(), 110);
+
+    /* same bus in order, waits respected */
+    auto pos = [&](const std::string &name) {
+        return std::find(order.begin(), order.end(), name) - order.begin();
+    };
+    EXPECT_LT(pos("a0"), pos("a1"));
+    EXPECT_LT(pos("a1"), pos("c0"));
+    EXPECT_GE(r[3].startMs, r[1].startMs + r[1].initMs);
+
+    EXPECT_TRUE(r[0].ok);
+    EXPECT_FALSE(r[4].ok);
+    EXPECT_EQ(r[4].error, "no device");
+    EXPECT_FALSE(r[5].ok);
+    EXPECT_EQ(r[5].error, "skipped, bad failed");
+    EXPECT_EQ(pos("d0"), (long)order.size());
+
+    EXPECT_EQ(upm::BringUp::busKey("a:0,i:1:0x40"), "i2c:1");
+    EXPECT_EQ(upm::BringUp::busKey("g:7"), "");
+}
+
+/* Save, load, batch and recover the calibration store */
+TEST_F(utilities_unit, test_upm_cal_store)
+{
+    char path[] = "/tmp/upm_cal_store_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    unlink(path);
+
+    float bias[3] = {0.01f, -0.02f, 0.03f}, got[3];
+    uint8_t bno[22] = {1, 2, 3};
+    const char *gyro = "l3gd20/l3gd20/i2c-1/6a";
+    const char *compass = "mmc35240/mmc35240/i2c-1/30";
+
+    /* off: nothing found, nothing written */
+    ASSERT_EQ(upm_cal_store_set_path(NULL), UPM_SUCCESS);
+    EXPECT_FALSE(upm_cal_store_enabled());
+    EXPECT_EQ(upm_cal_store_save(gyro, bias, sizeof(bias)),
+              UPM_SUCCESS);
+    EXPECT_EQ(upm_cal_store_load(gyro, got, sizeof(got)),
+              UPM_ERROR_NO_DATA);
+
+    ASSERT_EQ(upm_cal_store_set_path(path), UPM_SUCCESS);
+    EXPECT_TRUE(upm_cal_store_enabled());
+    EXPECT_EQ(upm_cal_store_load(gyro, got, sizeof(got)),
+              UPM_ERROR_NO_DATA);
+
+    EXPECT_EQ(upm_cal_store_save(gyro, bias, sizeof(bias)),
+              UPM_SUCCESS);
+    EXPECT_EQ(upm_cal_store_load(gyro, got, sizeof(got)),
+              UPM_SUCCESS);
+    EXPECT_EQ(memcmp(bias, got, sizeof(bias)), 0);
+    EXPECT_EQ(upm_cal_store_load(gyro, got, 2 * sizeof(float)),
+              UPM_ERROR_INVALID_SIZE);
+
+    /* the latest of several queued saves wins, other keys are kept */
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        bno[21] = i;
+        EXPECT_EQ(upm_cal_store_save_async("bno055/a0/i2c-1/28", bno,
+                                           sizeof(bno)), UPM_SUCCESS);
+    }
+    EXPECT_EQ(upm_cal_store_flush(), UPM_SUCCESS);
+
+    uint8_t gotBno[22];
+    EXPECT_EQ(upm_cal_store_load("bno055/a0/i2c-1/28", gotBno,
+                                 sizeof(gotBno)), UPM_SUCCESS);
+    EXPECT_EQ(gotBno[21], 9);
+    EXPECT_EQ(upm_cal_store_load(gyro, got, sizeof(got)),
+              UPM_SUCCESS);
+
+    /* a damaged file reads as empty and is replaced on the next save */
+    {
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekp(10);
+        f.put('x');
+    }
+    EXPECT_EQ(upm_cal_store_load(gyro, got, sizeof(got)),
+              UPM_ERROR_NO_DATA);
+    EXPECT_EQ(upm_cal_store_save(compass, bias, sizeof(bias)),
+              UPM_SUCCESS);
+    EXPECT_EQ(upm_cal_store_load(compass, got, sizeof(got)),
+              UPM_SUCCESS);
+
+    upm_cal_store_set_path(NULL);
+    unlink(path);
+    unlink((std::string(path) + ".lock").c_str());
+
+    /* IIO keys need a device that exists */
+    char key[UPM_CAL_STORE_MAX_KEY + 1];
+    EXPECT_EQ(upm_cal_store_iio_key("l3gd20", -1, key, sizeof(key)),
+              UPM_ERROR_INVALID_PARAMETER);
+    EXPECT_EQ(upm_cal_store_iio_key("l3gd20", 9999, key, sizeof(key)),
+              UPM_ERROR_NO_DATA);
+}